@@ -39,6 +39,8 @@ add_library(maat_python MODULE
   bindings/python/py_settings.cpp
   bindings/python/py_solver.cpp
   bindings/python/py_stats.cpp
+  bindings/python/py_symptr.cpp
+  bindings/python/py_trace.cpp
   bindings/python/py_value.cpp
   bindings/python/util.cpp
 
@@ -54,6 +54,9 @@ static PyObject* MaatEngine_run(PyObject* self, PyObject* args){
         return NULL;
     }
     try{
+        // Don't hold the GIL while emulating, Python callbacks take it back.
+        // See MaatEngine::run() for which engines can run concurrently
+        ReleaseGIL release_gil;
         res = as_engine_object(self).engine->run(max_instr);
     }catch(symbolic_exception& e){
         return PyErr_Format(PyExc_RuntimeError, "%s", e.what());
@@ -72,6 +75,9 @@ static PyObject* MaatEngine_run_from(PyObject* self, PyObject* args){
         return NULL;
     }
     try{ 
+        // Don't hold the GIL while emulating, Python callbacks take it back.
+        // See MaatEngine::run() for which engines can run concurrently
+        ReleaseGIL release_gil;
         res = as_engine_object(self).engine->run_from(addr, max_instr);
     }catch(symbolic_exception& e){
         return PyErr_Format(PyExc_RuntimeError, "%s", e.what());
@@ -344,8 +350,8 @@ static PyObject* MaatEngine_get_inst_bytes(PyObject* self, PyObject* args){
 };
 
 static PyMethodDef MaatEngine_methods[] = {
-    {"run", (PyCFunction)MaatEngine_run, METH_VARARGS, "Continue to run code from current location"},
-    {"run_from", (PyCFunction)MaatEngine_run_from, METH_VARARGS, "Run code from a given address"},
+    {"run", (PyCFunction)MaatEngine_run, METH_VARARGS, "Continue to run code from current location. The GIL is released meanwhile, so engines that don't share expressions can run in parallel threads"},
+    {"run_from", (PyCFunction)MaatEngine_run_from, METH_VARARGS, "Run code from a given address. The GIL is released meanwhile, so engines that don't share expressions can run in parallel threads"},
     {"take_snapshot", (PyCFunction)MaatEngine_take_snapshot, METH_NOARGS, "Take a snapshot of the symbolic engine"},
     {"restore_snapshot", (PyCFunction)MaatEngine_restore_snapshot, METH_VARARGS | METH_KEYWORDS, "Restore a snapshot of the symbolic engine"},
     {"load", (PyCFunction)MaatEngine_load, METH_VARARGS | METH_KEYWORDS, "Load an executable"},
@@ -360,11 +366,13 @@ static PyMemberDef MaatEngine_members[] = {
     {"cpu", T_OBJECT_EX, offsetof(MaatEngine_Object, cpu), READONLY, "Emulated CPU"},
     {"mem", T_OBJECT_EX, offsetof(MaatEngine_Object, mem), READONLY, "Memory Engine"},
     {"hooks", T_OBJECT_EX, offsetof(MaatEngine_Object, hooks), READONLY, "Event Hooks Manager"},
+    {"trace", T_OBJECT_EX, offsetof(MaatEngine_Object, trace), READONLY, "Coverage and Execution Trace Recorder"},
     {"info", T_OBJECT_EX, offsetof(MaatEngine_Object, info), READONLY, "Symbolic Engine Info"},
     {"path", T_OBJECT_EX, offsetof(MaatEngine_Object, path), READONLY, "Path Manager"},
     {"env", T_OBJECT_EX, offsetof(MaatEngine_Object, env), READONLY, "Environment Manager"},
     //{"stats", T_OBJECT_EX, offsetof(MaatEngine_Object, stats), READONLY, "Runtime statistics"},
     {"settings", T_OBJECT_EX, offsetof(MaatEngine_Object, settings), READONLY, "Symbolic Engine Settings"},
+    {"symptr_policies", T_OBJECT_EX, offsetof(MaatEngine_Object, symptr_policies), READONLY, "Symbolic Pointer Policies"},
     {"process", T_OBJECT_EX, offsetof(MaatEngine_Object, process), READONLY, "Process Info"},
     {NULL}
 };
@@ -426,9 +434,11 @@ void _clear_MaatEngine_attributes(MaatEngine_Object* obj)
     MAAT_PY_CLEAR(as_engine_object(obj).cpu)
     MAAT_PY_CLEAR(as_engine_object(obj).vars)
     MAAT_PY_CLEAR(as_engine_object(obj).hooks) 
+    MAAT_PY_CLEAR(as_engine_object(obj).trace)
     MAAT_PY_CLEAR(as_engine_object(obj).path)
     MAAT_PY_CLEAR(as_engine_object(obj).env)
     MAAT_PY_CLEAR(as_engine_object(obj).settings)
+    MAAT_PY_CLEAR(as_engine_object(obj).symptr_policies)
     MAAT_PY_CLEAR(as_engine_object(obj).process)
 }
 
@@ -445,11 +455,13 @@ void _init_MaatEngine_attributes(MaatEngine_Object* object)
         object->engine->vars
     );
     object->mem = PyMemEngine_FromMemEngine(object->engine->mem.get(), true);
-    object->hooks = PyEventManager_FromEventManager(&(object->engine->hooks), true);
+    object->hooks = PyEventManager_FromEventManager(&(object->engine->hooks), true, object->engine->arch.get());
+    object->trace = PyTraceRecorder_FromTraceRecorder(&(object->engine->trace), true);
     object->info = PyInfo_FromInfoAndArch(&(object->engine->info), true, &(*object->engine->arch));
     object->path = PyPath_FromPath(object->engine->path.get(), true);
     object->env = PyEnv_FromEnvEmulator(object->engine->env.get(), true);
     object->settings = PySettings_FromSettings(&(object->engine->settings), true);
+    object->symptr_policies = PySymPtrPolicies_FromSymPtrPolicies(&(object->engine->symptr_policies), true);
     object->process = PyProcessInfo_FromProcessInfo(object->engine->process.get(), true);
     // TODO: object->log ....
 }
@@ -29,6 +29,53 @@ static PyObject* EventManager_repr(PyObject* self)
     return EventManager_str(self);
 }
 
+// Hold a reference to a python object, released with the GIL held
+static std::shared_ptr<PyObject> _py_ref(PyObject* obj)
+{
+    Py_XINCREF(obj);
+    return std::shared_ptr<PyObject>(obj, [](PyObject* o){
+        PyGILState_STATE gil_state = PyGILState_Ensure();
+        Py_XDECREF(o);
+        PyGILState_Release(gil_state);
+    });
+}
+
+/* Wrap a python callback into a native callback that receives batches
+ * of events. The python callback is called with the engine and a list
+ * of Info objects, one per event */
+static event::EventCallback _batch_callback(PyObject* cb, PyObject* data, Arch* arch)
+{
+    std::shared_ptr<PyObject> py_cb = _py_ref(cb);
+    std::shared_ptr<PyObject> py_data = _py_ref(data);
+    return event::EventCallback(
+        [py_cb, py_data, arch](MaatEngine& engine, const event::event_batch_t& batch, void*)
+        {
+            // The engine might be running with the GIL released
+            PyGILState_STATE gil_state = PyGILState_Ensure();
+            event::Action res = event::Action::ERROR;
+            PyObject* list = PyList_New(batch.size());
+            if (list == NULL)
+            {
+                PyGILState_Release(gil_state);
+                throw runtime_exception("Failed to create list of events for python callback");
+            }
+            for (size_t i = 0; i < batch.size(); i++)
+                PyList_SET_ITEM(list, i, PyInfo_FromInfoAndArch(new info::Info(batch[i]), false, arch));
+
+            PyObject* result = nullptr;
+            if (py_data.get() == nullptr)
+                result = PyObject_CallFunctionObjArgs(py_cb.get(), engine.self_python_wrapper_object, list, NULL);
+            else
+                result = PyObject_CallFunctionObjArgs(py_cb.get(), engine.self_python_wrapper_object, list, py_data.get(), NULL);
+            res = event::action_from_python_result(engine, result);
+            Py_XDECREF(result);
+            Py_DECREF(list);
+            PyGILState_Release(gil_state);
+            return res;
+        }
+    );
+}
+
 static PyObject* EventManager_add(PyObject* self, PyObject*args, PyObject* keywords)
 {
     int int_event, int_when;
@@ -40,21 +87,59 @@ static PyObject* EventManager_add(PyObject* self, PyObject*args, PyObject* keywo
                         filter_max = 0xffffffffffffffff;
     PyObject* callbacks = NULL;
     PyObject* callback_data = NULL;
+    PyObject* regs = NULL;
+    int int_values = (int)event::ValueFilter::ANY;
+    Py_ssize_t batch_size = 0;
     std::vector<event::EventCallback> callbacks_list;
+    std::set<reg_t> regs_set;
 
-    char* keywd[] = {"", "", "name", "filter", "callbacks", "data", "group", NULL};
+    char* keywd[] = {"", "", "name", "filter", "callbacks", "data", "group", "regs", "values", "batch", NULL};
 
     if( !PyArg_ParseTupleAndKeywords(
-        args, keywords, "ii|s(KK)OOs", keywd, &int_event, &int_when, &name, &filter_min, &filter_max, &callbacks, &callback_data, &group))
+        args, keywords, "ii|s(KK)OOsOin", keywd, &int_event, &int_when, &name, &filter_min, &filter_max, &callbacks, &callback_data, &group, &regs, &int_values, &batch_size))
     {
         PyErr_Clear();
         if( !PyArg_ParseTupleAndKeywords(
-        args, keywords, "ii|sOOOs", keywd, &int_event, &int_when, &name, &filter, &callbacks, &callback_data, &group))
+        args, keywords, "ii|sOOOsOin", keywd, &int_event, &int_when, &name, &filter, &callbacks, &callback_data, &group, &regs, &int_values, &batch_size))
         {
             return NULL;
         }
     }
 
+    if (batch_size < 0)
+    {
+        return PyErr_Format(PyExc_ValueError, "'batch' parameter can not be negative");
+    }
+
+    // Get registers to monitor
+    if (regs != NULL)
+    {
+        if (not PyList_Check(regs))
+        {
+            return PyErr_Format(PyExc_TypeError, "'regs' parameter must be a list of register names");
+        }
+        if (as_event_object(self).arch == nullptr)
+        {
+            return PyErr_Format(PyExc_RuntimeError, "Can not translate register names for this event manager");
+        }
+        for (int i = 0; i < PyList_Size(regs); i++)
+        {
+            PyObject* reg = PyList_GetItem(regs, i);
+            if (not PyUnicode_Check(reg))
+            {
+                return PyErr_Format(PyExc_TypeError, "Register number %d is not a string", i);
+            }
+            try
+            {
+                regs_set.insert(as_event_object(self).arch->reg_num(std::string(PyUnicode_AsUTF8(reg))));
+            }
+            catch(const std::exception& e)
+            {
+                return PyErr_Format(PyExc_ValueError, "%s", e.what());
+            }
+        }
+    }
+
     // Check callbacks list
     if (callbacks != NULL)
     {
@@ -70,7 +155,10 @@ static PyObject* EventManager_add(PyObject* self, PyObject*args, PyObject* keywo
             {
                 return PyErr_Format(PyExc_TypeError, "Callback number %d is not a callable object", i);
             }
-            callbacks_list.push_back(event::EventCallback(cb, callback_data));
+            if (batch_size > 0)
+                callbacks_list.push_back(_batch_callback(cb, callback_data, as_event_object(self).arch));
+            else
+                callbacks_list.push_back(event::EventCallback(cb, callback_data));
         }
     }
 
@@ -94,12 +182,37 @@ static PyObject* EventManager_add(PyObject* self, PyObject*args, PyObject* keywo
         addr_filter = event::AddrFilter(PyLong_AsUnsignedLongLong(filter));
     }
 
+    // Check native filters before adding the hook
+    if (not regs_set.empty() and not event::is_reg_event(event))
+    {
+        return PyErr_Format(PyExc_ValueError, "'regs' can only be used with register events");
+    }
+    if (
+        int_values != (int)event::ValueFilter::ANY
+        and int_values != (int)event::ValueFilter::ABSTRACT
+        and int_values != (int)event::ValueFilter::CONCRETE
+    )
+    {
+        return PyErr_Format(PyExc_ValueError, "'values' must be a VALUES enum member");
+    }
+    if (
+        int_values != (int)event::ValueFilter::ANY
+        and not event::is_reg_event(event)
+        and not event::is_mem_event(event)
+    )
+    {
+        return PyErr_Format(PyExc_ValueError, "'values' can only be used with register and memory events");
+    }
+
     // Add hook
     try
     { 
-        as_event_object(self).manager->add(
+        event::EventManager::hook_t hook = as_event_object(self).manager->add(
             event, when, callbacks_list, std::string(name), addr_filter, std::string(group)
         );
+        hook->set_reg_filter(regs_set);
+        hook->set_value_filter((event::ValueFilter)int_values);
+        hook->set_batch_size(batch_size);
     }
     catch(const event_exception& e)
     {
@@ -247,7 +360,7 @@ static PyTypeObject EventManager_Type = {
 };
 
 
-PyObject* PyEventManager_FromEventManager(event::EventManager* m, bool is_ref)
+PyObject* PyEventManager_FromEventManager(event::EventManager* m, bool is_ref, Arch* arch)
 {
     EventManager_Object* object;
     
@@ -258,6 +371,7 @@ PyObject* PyEventManager_FromEventManager(event::EventManager* m, bool is_ref)
     {
         object->manager = m;
         object->is_ref = is_ref;
+        object->arch = arch;
     }
     return (PyObject*)object;
 }
@@ -296,6 +410,15 @@ void init_event(PyObject* module)
 
     PyObject* when_class = create_class(PyUnicode_FromString("WHEN"), PyTuple_New(0), when_enum);
     PyModule_AddObject(module, "WHEN", when_class);
+
+    // VALUES enum
+    PyObject* values_enum = PyDict_New();
+    PyDict_SetItemString(values_enum, "ANY", PyLong_FromLong((int)event::ValueFilter::ANY));
+    PyDict_SetItemString(values_enum, "ABSTRACT", PyLong_FromLong((int)event::ValueFilter::ABSTRACT));
+    PyDict_SetItemString(values_enum, "CONCRETE", PyLong_FromLong((int)event::ValueFilter::CONCRETE));
+
+    PyObject* values_class = create_class(PyUnicode_FromString("VALUES"), PyTuple_New(0), values_enum);
+    PyModule_AddObject(module, "VALUES", values_class);
 }
 
 } // namespace py
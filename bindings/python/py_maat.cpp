@@ -23,6 +23,11 @@ PyMethodDef module_methods[] = {
     {"ITE", (PyCFunction)maat_ITE, METH_VARARGS, "Create an If-Then-Else expression from a Constraint and two abstract expressions"},
     // Engine
     {"MaatEngine", (PyCFunction)maat_MaatEngine, METH_VARARGS, "Create a new DSE engine"},
+    // Symbolic pointers
+    {"DefaultSymPtrPolicy", (PyCFunction)maat_DefaultSymPtrPolicy, METH_VARARGS, "Create a policy honouring the symptr engine settings"},
+    {"MinSymPtrPolicy", (PyCFunction)maat_MinSymPtrPolicy, METH_VARARGS, "Create a policy concretizing symbolic pointers to their minimal value"},
+    {"ConcolicSymPtrPolicy", (PyCFunction)maat_ConcolicSymPtrPolicy, METH_VARARGS, "Create a policy concretizing concolic pointers to their concolic value"},
+    {"SymbolicSymPtrPolicy", (PyCFunction)maat_SymbolicSymPtrPolicy, METH_VARARGS, "Create a policy keeping symbolic pointers symbolic within a maximal range"},
     // Solver
     {"Solver", (PyCFunction)maat_Solver, METH_NOARGS, "Create a constraint solver"},
     // SimpleStateManager
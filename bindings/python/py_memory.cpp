@@ -167,6 +167,8 @@ static PyObject* MemEngine_write(PyObject* self, PyObject* args, PyObject* keywo
     Py_ssize_t data_len;
     PyObject* arg2 = nullptr;
     PyObject* arg3 = nullptr;
+    Py_buffer buffer;
+    PyBufferGuard buffer_guard;
     int ignore_flags = 0; // Default False 
 
     char * keywds[] = {"", "", "", "ignore_flags", NULL};
@@ -209,16 +211,21 @@ static PyObject* MemEngine_write(PyObject* self, PyObject* args, PyObject* keywo
                     (bool)ignore_flags
                 );
         // (addr, buffer, nb_bytes)
-        }else if( PyBytes_Check(arg2) ){
-            PyBytes_AsStringAndSize(arg2, &data, &data_len);
-            if( arg3 != nullptr){
-                if( !PyLong_Check(arg3)){
-                    return PyErr_Format(PyExc_TypeError, "MemEngine.write(): 3rd argument must be int");
-                }
-                // Optional length argument, parse it
-                if(PyLong_AsSsize_t(arg3) < data_len){
-                    data_len = PyLong_AsSsize_t(arg3);
-                }
+        // Accept any bytes-like object (bytes, bytearray, memoryview, ...)
+        // and write its contents directly without intermediate copies
+        }else if( PyObject_CheckBuffer(arg2) ){
+            if( arg3 != nullptr && !PyLong_Check(arg3)){
+                return PyErr_Format(PyExc_TypeError, "MemEngine.write(): 3rd argument must be int");
+            }
+            if( PyObject_GetBuffer(arg2, &buffer, PyBUF_C_CONTIGUOUS) != 0 ){
+                return NULL;
+            }
+            buffer_guard.guard(&buffer);
+            data = (char*)buffer.buf;
+            data_len = buffer.len;
+            // Optional length argument, parse it
+            if( arg3 != nullptr && PyLong_AsSsize_t(arg3) < data_len){
+                data_len = PyLong_AsSsize_t(arg3);
             }
             if (not val_addr.is_none())
                 as_mem_object(self).mem->write_buffer(
@@ -237,13 +244,106 @@ static PyObject* MemEngine_write(PyObject* self, PyObject* args, PyObject* keywo
         }else{
             return PyErr_Format(PyExc_TypeError, "MemEngine.write(): got wrong types for arguments");
         }
-    }catch(mem_exception e){
+    }catch(const mem_exception& e){
         return PyErr_Format(PyExc_RuntimeError, "%s", e.what());
     }
 
     Py_RETURN_NONE;
 }
 
+// Get the segment containing the whole range [addr, addr+nb_bytes-1]
+static std::shared_ptr<MemSegment> _get_segment_for_range(MemEngine* mem, addr_t addr, Py_ssize_t nb_bytes)
+{
+    std::shared_ptr<MemSegment> segment = mem->get_segment_containing(addr);
+    if (segment == nullptr)
+    {
+        throw mem_exception(Fmt()
+            << "Address 0x" << std::hex << addr << " is not mapped in memory"
+            >> Fmt::to_str
+        );
+    }
+    if (nb_bytes > 0 and addr + nb_bytes - 1 > segment->end)
+    {
+        throw mem_exception(Fmt()
+            << "Range 0x" << std::hex << addr << "-0x" << addr + nb_bytes - 1
+            << " is not contained in a single memory segment"
+            >> Fmt::to_str
+        );
+    }
+    return segment;
+}
+
+static PyObject* MemEngine_view(PyObject* self, PyObject* args)
+{
+    unsigned long long addr;
+    Py_ssize_t nb_bytes;
+    std::shared_ptr<MemSegment> segment;
+    PyObject* buffer;
+
+    if( !PyArg_ParseTuple(args, "Kn", &addr, &nb_bytes)){
+        return NULL;
+    }
+    if( nb_bytes < 0 ){
+        return PyErr_Format(PyExc_ValueError, "view(): number of bytes can not be negative");
+    }
+
+    try{
+        segment = _get_segment_for_range(as_mem_object(self).mem, addr, nb_bytes);
+    }catch(const mem_exception& e){
+        return PyErr_Format(PyExc_RuntimeError, "%s", e.what());
+    }
+
+    buffer = PyMemView_FromSegment(self, segment, addr, nb_bytes);
+    if( buffer == NULL ){
+        return PyErr_Format(PyExc_RuntimeError, "%s", "Failed to create memory view");
+    }
+    return buffer;
+}
+
+static PyObject* MemEngine_abstract_bitmap(PyObject* self, PyObject* args)
+{
+    unsigned long long addr;
+    Py_ssize_t nb_bytes;
+    std::shared_ptr<MemSegment> segment;
+    PyObject* bytes;
+    char* bitmap;
+
+    if( !PyArg_ParseTuple(args, "Kn", &addr, &nb_bytes)){
+        return NULL;
+    }
+    if( nb_bytes < 0 ){
+        return PyErr_Format(PyExc_ValueError, "abstract_bitmap(): number of bytes can not be negative");
+    }
+
+    try{
+        segment = _get_segment_for_range(as_mem_object(self).mem, addr, nb_bytes);
+    }catch(const mem_exception& e){
+        return PyErr_Format(PyExc_RuntimeError, "%s", e.what());
+    }
+
+    bytes = PyBytes_FromStringAndSize(NULL, nb_bytes);
+    if( bytes == NULL ){
+        return PyErr_Format(PyExc_RuntimeError, "%s", "Failed to create python bytes");
+    }
+    bitmap = PyBytes_AS_STRING(bytes);
+
+    // Fill the bitmap with runs of concrete and abstract bytes
+    addr_t end = addr + nb_bytes;
+    addr_t curr = addr;
+    while (curr < end)
+    {
+        addr_t until = std::min(segment->is_concrete_until(curr, end-curr), end);
+        memset(bitmap + (curr-addr), 0, until-curr);
+        curr = until;
+        if (curr >= end)
+            break;
+        until = std::min(segment->is_abstract_until(curr, end-curr), end);
+        memset(bitmap + (curr-addr), 1, until-curr);
+        curr = until;
+    }
+    return bytes;
+}
+
 PyObject* MemEngine_make_concolic(PyObject* self, PyObject* args){
     unsigned long long addr;
     unsigned int nb_elems, elem_size;
@@ -288,14 +388,40 @@ PyObject* MemEngine_make_symbolic(PyObject* self, PyObject* args){
 }
 
 
+PyObject* MemEngine_make_tainted(PyObject* self, PyObject* args){
+    unsigned long long addr;
+    unsigned int nb_elems, elem_size;
+    char * name = "";
+    std::string res_name;
+    
+    if( ! PyArg_ParseTuple(args, "KII|s", &addr, &nb_elems, &elem_size, &name)){
+        return NULL;
+    }
+
+    try{
+        res_name = as_mem_object(self).mem->make_tainted(addr, nb_elems, elem_size, std::string(name));
+    }catch(mem_exception e){
+        return PyErr_Format(PyExc_RuntimeError, "%s", e.what());
+    }catch(var_context_exception e){
+        return PyErr_Format(PyExc_RuntimeError, "%s", e.what());
+    }
+
+    if (res_name.empty())
+        Py_RETURN_NONE;
+    return PyUnicode_FromString(res_name.c_str());
+}
+
 static PyMethodDef MemEngine_methods[] = {
     {"map", (PyCFunction)MemEngine_map, METH_VARARGS | METH_KEYWORDS, "Map a memory region"},
     {"read", (PyCFunction)MemEngine_read, METH_VARARGS, "Reads memory into an expression"},
     {"read_buffer", (PyCFunction)MemEngine_read_buffer, METH_VARARGS, "Reads a buffer in memory"},
     {"read_str", (PyCFunction)MemEngine_read_str, METH_VARARGS, "Reads a concrete string in memory"},
     {"write", (PyCFunction)MemEngine_write, METH_VARARGS | METH_KEYWORDS, "Write a value/expression/buffer into memory"},
+    {"view", (PyCFunction)MemEngine_view, METH_VARARGS, "Get a read-only view over concrete memory, without copying it. Supports len(), indexing and the buffer protocol (memoryview(), bytes())"},
+    {"abstract_bitmap", (PyCFunction)MemEngine_abstract_bitmap, METH_VARARGS, "Get bytes set to 1 for abstract bytes in a memory range and to 0 for concrete ones"},
     {"make_concolic", (PyCFunction)MemEngine_make_concolic, METH_VARARGS, "Make a memory area concolic"},
     {"make_symbolic", (PyCFunction)MemEngine_make_symbolic, METH_VARARGS, "Make a memory area purely symbolic"},
+    {"make_tainted", (PyCFunction)MemEngine_make_tainted, METH_VARARGS, "Make a memory area tainted. Without a name, concrete contents only get shadow taint and stay concrete"},
     {NULL, NULL, 0, NULL}
 };
 
@@ -360,6 +486,123 @@ PyObject* PyMemEngine_FromMemEngine(MemEngine* mem, bool is_ref)
     return (PyObject*)object;
 }
 
+// ============= MemView ===============
+
+static void MemView_dealloc(PyObject* self){
+    delete as_memview_object(self).segment;
+    as_memview_object(self).segment = nullptr;
+    Py_XDECREF(as_memview_object(self).mem);
+    Py_TYPE(self)->tp_free((PyObject *)self);
+};
+
+/* Return a pointer to the viewed memory. The MemEngine extends segments
+ * only if their concrete memory doesn't move, so the pointer stays valid
+ * as long as the view holds the segment */
+static uint8_t* _memview_data(MemView_Object& obj)
+{
+    return (*obj.segment)->raw_mem_at(obj.addr);
+}
+
+static int MemView_getbuffer(PyObject* self, Py_buffer* view, int flags)
+{
+    MemView_Object& obj = as_memview_object(self);
+    // Views are read-only so that all writes go through the MemEngine
+    // and are recorded for snapshots
+    return PyBuffer_FillInfo(view, self, _memview_data(obj), obj.size, 1, flags);
+}
+
+static PyBufferProcs MemView_as_buffer = {
+    MemView_getbuffer,                        /* bf_getbuffer */
+    0                                         /* bf_releasebuffer */
+};
+
+static Py_ssize_t MemView_len(PyObject* self)
+{
+    return as_memview_object(self).size;
+}
+
+static PyObject* MemView_subscript(PyObject* self, PyObject* key)
+{
+    MemView_Object& obj = as_memview_object(self);
+    uint8_t* data = _memview_data(obj);
+
+    if( PyIndex_Check(key) ){
+        Py_ssize_t i = PyNumber_AsSsize_t(key, PyExc_IndexError);
+        if( i == -1 and PyErr_Occurred() )
+            return NULL;
+        if( i < 0 )
+            i += obj.size;
+        if( i < 0 or i >= obj.size )
+            return PyErr_Format(PyExc_IndexError, "MemView index out of range");
+        return PyLong_FromLong(data[i]);
+    }
+    else if( PySlice_Check(key) ){
+        Py_ssize_t start, stop, step, len;
+        if( PySlice_GetIndicesEx(key, obj.size, &start, &stop, &step, &len) < 0 )
+            return NULL;
+        if( step == 1 )
+            return PyBytes_FromStringAndSize((char*)data + start, len);
+        PyObject* res = PyBytes_FromStringAndSize(NULL, len);
+        if( res == NULL )
+            return NULL;
+        char* bytes = PyBytes_AsString(res);
+        for( Py_ssize_t i = 0; i < len; i++, start += step )
+            bytes[i] = data[start];
+        return res;
+    }
+    return PyErr_Format(PyExc_TypeError, "MemView indices must be integers or slices");
+}
+
+static PyMappingMethods MemView_as_mapping = {
+    MemView_len,                              /* mp_length */
+    MemView_subscript,                        /* mp_subscript */
+    0                                         /* mp_ass_subscript */
+};
+
+/* Type description for python MemView objects */
+static PyTypeObject MemView_Type = {
+    PyVarObject_HEAD_INIT(NULL, 0)
+    "MemView",                                /* tp_name */
+    sizeof(MemView_Object),                   /* tp_basicsize */
+    0,                                        /* tp_itemsize */
+    (destructor)MemView_dealloc,              /* tp_dealloc */
+    0,                                        /* tp_print */
+    0,                                        /* tp_getattr */
+    0,                                        /* tp_setattr */
+    0,                                        /* tp_reserved */
+    0,                                        /* tp_repr */
+    0,                                        /* tp_as_number */
+    0,                                        /* tp_as_sequence */
+    &MemView_as_mapping,                      /* tp_as_mapping */
+    0,                                        /* tp_hash  */
+    0,                                        /* tp_call */
+    0,                                        /* tp_str */
+    0,                                        /* tp_getattro */
+    0,                                        /* tp_setattro */
+    &MemView_as_buffer,                       /* tp_as_buffer */
+    Py_TPFLAGS_DEFAULT,                       /* tp_flags */
+    "Read-only view over concrete memory",    /* tp_doc */
+};
+
+/* Constructors */
+PyObject* PyMemView_FromSegment(PyObject* mem, std::shared_ptr<MemSegment> segment, addr_t addr, Py_ssize_t size)
+{
+    MemView_Object* object;
+
+    // Create object
+    PyType_Ready(&MemView_Type);
+    object = PyObject_New(MemView_Object, &MemView_Type);
+    if( object != nullptr ){
+        // Keep the memory engine alive as long as the view exists
+        Py_INCREF(mem);
+        object->mem = mem;
+        object->segment = new std::shared_ptr<MemSegment>(segment);
+        object->addr = addr;
+        object->size = size;
+    }
+    return (PyObject*)object;
+}
+
 void init_memory(PyObject* module)
 {
     /* MEM enum */
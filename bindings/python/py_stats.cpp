@@ -62,6 +62,9 @@ MAAT_DEFINE_STATS_GETTER(executed_insts)
 MAAT_DEFINE_STATS_GETTER(executed_ir_insts)
 MAAT_DEFINE_STATS_GETTER(lifted_insts)
 MAAT_DEFINE_STATS_GETTER(created_exprs)
+MAAT_DEFINE_STATS_GETTER(simplify_memo_hits)
+MAAT_DEFINE_STATS_GETTER(simplify_memo_misses)
+MAAT_DEFINE_STATS_GETTER(simplify_memo_hit_rate)
 MAAT_DEFINE_STATS_GETTER(solver_total_time)
 MAAT_DEFINE_STATS_GETTER(solver_average_time)
 MAAT_DEFINE_STATS_GETTER(solver_calls_count)
@@ -78,6 +81,9 @@ static PyGetSetDef Stats_getset[] = {
     MAAT_GETDEF(executed_insts, "Total number of assembly instructions symbolically executed"),
     MAAT_GETDEF(lifted_insts, "Total number of assembly instructions lifted to IR"),
     MAAT_GETDEF(executed_ir_insts, "Total number of IR instructions executed"),
+    MAAT_GETDEF(simplify_memo_hits, "Number of simplifications answered by the simplification memo"),
+    MAAT_GETDEF(simplify_memo_misses, "Number of simplifications not found in the simplification memo"),
+    MAAT_GETDEF(simplify_memo_hit_rate, "Percentage of simplifications answered by the simplification memo"),
     MAAT_GETDEF(solver_total_time, "Total time spend solving symbolic constraints (in milliseconds)"),
     MAAT_GETDEF(solver_average_time, "Average time spend solving symbolic constraints (in milliseconds)"),
     MAAT_GETDEF(solver_calls_count, "Total number of calls to the solver"),
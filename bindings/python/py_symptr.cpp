@@ -0,0 +1,215 @@
+#include "python_bindings.hpp"
+
+namespace maat{
+namespace py{
+
+// ================== SymPtrPolicy ==================
+static void SymPtrPolicy_dealloc(PyObject* self)
+{
+    delete as_symptr_policy_object(self).policy;
+    as_symptr_policy_object(self).policy = nullptr;
+    Py_TYPE(self)->tp_free((PyObject *)self);
+};
+
+static PyTypeObject SymPtrPolicy_Type = {
+    PyVarObject_HEAD_INIT(NULL, 0)
+    "SymPtrPolicy",                           /* tp_name */
+    sizeof(SymPtrPolicy_Object),              /* tp_basicsize */
+    0,                                        /* tp_itemsize */
+    (destructor)SymPtrPolicy_dealloc,         /* tp_dealloc */
+    0,                                        /* tp_print */
+    0,                                        /* tp_getattr */
+    0,                                        /* tp_setattr */
+    0,                                        /* tp_reserved */
+    0,                                        /* tp_repr */
+    0,                                        /* tp_as_number */
+    0,                                        /* tp_as_sequence */
+    0,                                        /* tp_as_mapping */
+    0,                                        /* tp_hash  */
+    0,                                        /* tp_call */
+    0,                                        /* tp_str */
+    0,                                        /* tp_getattro */
+    0,                                        /* tp_setattro */
+    0,                                        /* tp_as_buffer */
+    Py_TPFLAGS_DEFAULT,                       /* tp_flags */
+    "Policy for memory accesses through symbolic pointers", /* tp_doc */
+    0,                                        /* tp_traverse */
+    0,                                        /* tp_clear */
+    0,                                        /* tp_richcompare */
+    0,                                        /* tp_weaklistoffset */
+    0,                                        /* tp_iter */
+    0,                                        /* tp_iternext */
+    0,                                        /* tp_methods */
+    0,                                        /* tp_members */
+    0,                                        /* tp_getset */
+    0,                                        /* tp_base */
+    0,                                        /* tp_dict */
+    0,                                        /* tp_descr_get */
+    0,                                        /* tp_descr_set */
+    0,                                        /* tp_dictoffset */
+    0,                                        /* tp_init */
+    0,                                        /* tp_alloc */
+    0,                                        /* tp_new */
+};
+
+PyObject* get_SymPtrPolicy_Type()
+{
+    return (PyObject*)&SymPtrPolicy_Type;
+}
+
+PyObject* PySymPtrPolicy_FromSymPtrPolicy(std::shared_ptr<SymPtrPolicy> policy)
+{
+    SymPtrPolicy_Object* object;
+
+    // Create object
+    PyType_Ready(&SymPtrPolicy_Type);
+    object = PyObject_New(SymPtrPolicy_Object, &SymPtrPolicy_Type);
+    if (object != nullptr)
+    {
+        object->policy = new std::shared_ptr<SymPtrPolicy>(policy);
+    }
+    return (PyObject*)object;
+}
+
+PyObject* maat_DefaultSymPtrPolicy(PyObject* self, PyObject* args)
+{
+    if (!PyArg_ParseTuple(args, ""))
+        return NULL;
+    return PySymPtrPolicy_FromSymPtrPolicy(std::make_shared<DefaultSymPtrPolicy>());
+}
+
+PyObject* maat_MinSymPtrPolicy(PyObject* self, PyObject* args)
+{
+    if (!PyArg_ParseTuple(args, ""))
+        return NULL;
+    return PySymPtrPolicy_FromSymPtrPolicy(std::make_shared<MinSymPtrPolicy>());
+}
+
+PyObject* maat_ConcolicSymPtrPolicy(PyObject* self, PyObject* args)
+{
+    if (!PyArg_ParseTuple(args, ""))
+        return NULL;
+    return PySymPtrPolicy_FromSymPtrPolicy(std::make_shared<ConcolicSymPtrPolicy>());
+}
+
+PyObject* maat_SymbolicSymPtrPolicy(PyObject* self, PyObject* args)
+{
+    unsigned long long max_range;
+    if (!PyArg_ParseTuple(args, "K", &max_range))
+        return NULL;
+    try
+    {
+        return PySymPtrPolicy_FromSymPtrPolicy(std::make_shared<SymbolicSymPtrPolicy>(max_range));
+    }
+    catch(const runtime_exception& e)
+    {
+        return PyErr_Format(PyExc_RuntimeError, "%s", e.what());
+    }
+}
+
+// ================== SymPtrPolicies ==================
+static void SymPtrPolicies_dealloc(PyObject* self)
+{
+    if (! as_symptr_policies_object(self).is_ref)
+    {
+        delete as_symptr_policies_object(self).policies;
+    }
+    as_symptr_policies_object(self).policies = nullptr;
+    Py_TYPE(self)->tp_free((PyObject *)self);
+};
+
+static PyObject* SymPtrPolicies_set_default(PyObject* self, PyObject* args)
+{
+    PyObject* policy;
+    if (!PyArg_ParseTuple(args, "O!", get_SymPtrPolicy_Type(), &policy))
+        return NULL;
+    as_symptr_policies_object(self).policies->set_default(
+        *as_symptr_policy_object(policy).policy
+    );
+    Py_RETURN_NONE;
+};
+
+static PyObject* SymPtrPolicies_add(PyObject* self, PyObject* args)
+{
+    unsigned long long min, max;
+    PyObject* policy;
+    if (!PyArg_ParseTuple(args, "KKO!", &min, &max, get_SymPtrPolicy_Type(), &policy))
+        return NULL;
+    as_symptr_policies_object(self).policies->add(
+        min, max, *as_symptr_policy_object(policy).policy
+    );
+    Py_RETURN_NONE;
+};
+
+static PyObject* SymPtrPolicies_clear(PyObject* self)
+{
+    as_symptr_policies_object(self).policies->clear();
+    Py_RETURN_NONE;
+};
+
+static PyMethodDef SymPtrPolicies_methods[] = {
+    {"set_default", (PyCFunction)SymPtrPolicies_set_default, METH_VARARGS, "Set the policy used for pointers matching no address range"},
+    {"add", (PyCFunction)SymPtrPolicies_add, METH_VARARGS, "Use a policy for pointers in an address range (bounds included)"},
+    {"clear", (PyCFunction)SymPtrPolicies_clear, METH_NOARGS, "Remove all address ranges. The default policy is kept"},
+    {NULL, NULL, 0, NULL}
+};
+
+static PyTypeObject SymPtrPolicies_Type = {
+    PyVarObject_HEAD_INIT(NULL, 0)
+    "SymPtrPolicies",                         /* tp_name */
+    sizeof(SymPtrPolicies_Object),            /* tp_basicsize */
+    0,                                        /* tp_itemsize */
+    (destructor)SymPtrPolicies_dealloc,       /* tp_dealloc */
+    0,                                        /* tp_print */
+    0,                                        /* tp_getattr */
+    0,                                        /* tp_setattr */
+    0,                                        /* tp_reserved */
+    0,                                        /* tp_repr */
+    0,                                        /* tp_as_number */
+    0,                                        /* tp_as_sequence */
+    0,                                        /* tp_as_mapping */
+    0,                                        /* tp_hash  */
+    0,                                        /* tp_call */
+    0,                                        /* tp_str */
+    0,                                        /* tp_getattro */
+    0,                                        /* tp_setattro */
+    0,                                        /* tp_as_buffer */
+    Py_TPFLAGS_DEFAULT,                       /* tp_flags */
+    "Symbolic pointer policies for different address ranges", /* tp_doc */
+    0,                                        /* tp_traverse */
+    0,                                        /* tp_clear */
+    0,                                        /* tp_richcompare */
+    0,                                        /* tp_weaklistoffset */
+    0,                                        /* tp_iter */
+    0,                                        /* tp_iternext */
+    SymPtrPolicies_methods,                   /* tp_methods */
+    0,                                        /* tp_members */
+    0,                                        /* tp_getset */
+    0,                                        /* tp_base */
+    0,                                        /* tp_dict */
+    0,                                        /* tp_descr_get */
+    0,                                        /* tp_descr_set */
+    0,                                        /* tp_dictoffset */
+    0,                                        /* tp_init */
+    0,                                        /* tp_alloc */
+    0,                                        /* tp_new */
+};
+
+/* Constructors */
+PyObject* PySymPtrPolicies_FromSymPtrPolicies(SymPtrPolicies* policies, bool is_ref)
+{
+    SymPtrPolicies_Object* object;
+
+    // Create object
+    PyType_Ready(&SymPtrPolicies_Type);
+    object = PyObject_New(SymPtrPolicies_Object, &SymPtrPolicies_Type);
+    if (object != nullptr)
+    {
+        object->policies = policies;
+        object->is_ref = is_ref;
+    }
+    return (PyObject*)object;
+}
+
+} // namespace py
+} // namespace maat
@@ -0,0 +1,223 @@
+#include "python_bindings.hpp"
+
+namespace maat{
+namespace py{
+
+static void TraceRecorder_dealloc(PyObject* self)
+{
+    if (! as_trace_object(self).is_ref)
+    {
+        delete ((TraceRecorder_Object*)self)->trace;
+    }
+    as_trace_object(self).trace = nullptr;
+    Py_TYPE(self)->tp_free((PyObject *)self);
+};
+
+static PyObject* TraceRecorder_enable_coverage(PyObject* self, PyObject* args, PyObject* keywords)
+{
+    unsigned long long size = TraceRecorder::default_bitmap_size;
+    static char *kwlist[] = {"size", NULL};
+
+    if (! PyArg_ParseTupleAndKeywords(args, keywords, "|K", kwlist, &size)){
+        return NULL;
+    }
+    try
+    {
+        as_trace_object(self).trace->enable_coverage(size);
+    }
+    catch(const std::exception& e)
+    {
+        return PyErr_Format(PyExc_RuntimeError, "%s", e.what());
+    }
+    Py_RETURN_NONE;
+};
+
+static PyObject* TraceRecorder_disable_coverage(PyObject* self)
+{
+    as_trace_object(self).trace->disable_coverage();
+    Py_RETURN_NONE;
+};
+
+static PyObject* TraceRecorder_reset_coverage(PyObject* self)
+{
+    as_trace_object(self).trace->reset_coverage();
+    Py_RETURN_NONE;
+};
+
+static PyObject* TraceRecorder_coverage_bitmap(PyObject* self)
+{
+    const std::vector<uint8_t>& bitmap = as_trace_object(self).trace->coverage_bitmap();
+    return PyBytes_FromStringAndSize((const char*)bitmap.data(), bitmap.size());
+};
+
+static PyObject* TraceRecorder_nb_covered_edges(PyObject* self)
+{
+    return PyLong_FromSize_t(as_trace_object(self).trace->nb_covered_edges());
+};
+
+static PyObject* TraceRecorder_enable_trace(PyObject* self, PyObject* args, PyObject* keywords)
+{
+    unsigned long long ring_size = TraceRecorder::default_ring_size;
+    const char* filename = nullptr;
+    static char *kwlist[] = {"ring_size", "file", NULL};
+
+    if (! PyArg_ParseTupleAndKeywords(args, keywords, "|Kz", kwlist, &ring_size, &filename)){
+        return NULL;
+    }
+    try
+    {
+        as_trace_object(self).trace->enable_trace(
+            ring_size,
+            filename == nullptr ? "" : std::string(filename)
+        );
+    }
+    catch(const std::exception& e)
+    {
+        return PyErr_Format(PyExc_RuntimeError, "%s", e.what());
+    }
+    Py_RETURN_NONE;
+};
+
+static PyObject* TraceRecorder_disable_trace(PyObject* self)
+{
+    as_trace_object(self).trace->disable_trace();
+    Py_RETURN_NONE;
+};
+
+static PyObject* TraceRecorder_clear_trace(PyObject* self)
+{
+    as_trace_object(self).trace->clear_trace();
+    Py_RETURN_NONE;
+};
+
+static PyObject* TraceRecorder_flush(PyObject* self)
+{
+    as_trace_object(self).trace->flush();
+    Py_RETURN_NONE;
+};
+
+static PyObject* TraceRecorder_trace(PyObject* self)
+{
+    std::vector<TraceRecord> records = as_trace_object(self).trace->trace();
+    PyObject* list = PyList_New(records.size());
+    if (list == NULL)
+        return PyErr_Format(PyExc_RuntimeError, "%s", "Failed to create new python list");
+
+    for (int i = 0; i < records.size(); i++)
+    {
+        const TraceRecord& r = records[i];
+        // Records are (pc, branch_taken, mem_addr) tuples where branch_taken and
+        // mem_addr are None if the instruction didn't branch or access memory
+        PyObject* taken = Py_None;
+        if (r.flags & TraceRecord::BRANCH)
+            taken = (r.flags & TraceRecord::BRANCH_TAKEN) ? Py_True : Py_False;
+        Py_INCREF(taken);
+        PyObject* mem_addr = Py_None;
+        if (r.flags & (TraceRecord::MEM_READ | TraceRecord::MEM_WRITE))
+            mem_addr = PyLong_FromUnsignedLongLong(r.mem_addr);
+        else
+            Py_INCREF(Py_None);
+        PyObject* pc = PyLong_FromUnsignedLongLong(r.pc);
+        // Note: PyTuple_Pack increments the ref count on objects
+        PyList_SET_ITEM(list, i, PyTuple_Pack(3, pc, taken, mem_addr));
+        Py_DECREF(pc);
+        Py_DECREF(taken);
+        Py_DECREF(mem_addr);
+    }
+    return list;
+};
+
+static PyObject* TraceRecorder_get_coverage_enabled(PyObject* self, void* closure)
+{
+    return PyBool_FromLong(as_trace_object(self).trace->coverage_enabled());
+}
+
+static PyObject* TraceRecorder_get_trace_enabled(PyObject* self, void* closure)
+{
+    return PyBool_FromLong(as_trace_object(self).trace->trace_enabled());
+}
+
+static PyObject* TraceRecorder_get_nb_records(PyObject* self, void* closure)
+{
+    return PyLong_FromUnsignedLongLong(as_trace_object(self).trace->nb_records());
+}
+
+static PyMethodDef TraceRecorder_methods[] = {
+    {"enable_coverage", (PyCFunction)TraceRecorder_enable_coverage, METH_VARARGS | METH_KEYWORDS, "Start recording basic block edges coverage in a bitmap"},
+    {"disable_coverage", (PyCFunction)TraceRecorder_disable_coverage, METH_NOARGS, "Stop recording coverage"},
+    {"reset_coverage", (PyCFunction)TraceRecorder_reset_coverage, METH_NOARGS, "Clear the coverage bitmap"},
+    {"coverage_bitmap", (PyCFunction)TraceRecorder_coverage_bitmap, METH_NOARGS, "Get the coverage bitmap as bytes"},
+    {"nb_covered_edges", (PyCFunction)TraceRecorder_nb_covered_edges, METH_NOARGS, "Get the number of non-null entries in the coverage bitmap"},
+    {"enable_trace", (PyCFunction)TraceRecorder_enable_trace, METH_VARARGS | METH_KEYWORDS, "Start recording an execution trace in a ring buffer and optionally a binary file"},
+    {"disable_trace", (PyCFunction)TraceRecorder_disable_trace, METH_NOARGS, "Stop recording the execution trace"},
+    {"clear_trace", (PyCFunction)TraceRecorder_clear_trace, METH_NOARGS, "Clear the trace ring buffer"},
+    {"flush", (PyCFunction)TraceRecorder_flush, METH_NOARGS, "Write pending records to the trace file"},
+    {"trace", (PyCFunction)TraceRecorder_trace, METH_NOARGS, "Get the records in the trace ring buffer as (pc, branch_taken, mem_addr) tuples"},
+    {NULL, NULL, 0, NULL}
+};
+
+static PyGetSetDef TraceRecorder_getset[] = {
+    {"coverage_enabled", TraceRecorder_get_coverage_enabled, NULL, "True if coverage is being recorded", NULL},
+    {"trace_enabled", TraceRecorder_get_trace_enabled, NULL, "True if the execution trace is being recorded", NULL},
+    {"nb_records", TraceRecorder_get_nb_records, NULL, "Total number of records since the trace was enabled", NULL},
+    {NULL}
+};
+
+static PyTypeObject TraceRecorder_Type = {
+    PyVarObject_HEAD_INIT(NULL, 0)
+    "TraceRecorder",                          /* tp_name */
+    sizeof(TraceRecorder_Object),             /* tp_basicsize */
+    0,                                        /* tp_itemsize */
+    (destructor)TraceRecorder_dealloc,        /* tp_dealloc */
+    0,                                        /* tp_print */
+    0,                                        /* tp_getattr */
+    0,                                        /* tp_setattr */
+    0,                                        /* tp_reserved */
+    0,                                        /* tp_repr */
+    0,                                        /* tp_as_number */
+    0,                                        /* tp_as_sequence */
+    0,                                        /* tp_as_mapping */
+    0,                                        /* tp_hash  */
+    0,                                        /* tp_call */
+    0,                                        /* tp_str */
+    0,                                        /* tp_getattro */
+    0,                                        /* tp_setattro */
+    0,                                        /* tp_as_buffer */
+    Py_TPFLAGS_DEFAULT,                       /* tp_flags */
+    "Native coverage and execution trace recorder", /* tp_doc */
+    0,                                        /* tp_traverse */
+    0,                                        /* tp_clear */
+    0,                                        /* tp_richcompare */
+    0,                                        /* tp_weaklistoffset */
+    0,                                        /* tp_iter */
+    0,                                        /* tp_iternext */
+    TraceRecorder_methods,                    /* tp_methods */
+    0,                                        /* tp_members */
+    TraceRecorder_getset,                     /* tp_getset */
+    0,                                        /* tp_base */
+    0,                                        /* tp_dict */
+    0,                                        /* tp_descr_get */
+    0,                                        /* tp_descr_set */
+    0,                                        /* tp_dictoffset */
+    0,                                        /* tp_init */
+    0,                                        /* tp_alloc */
+    0,                                        /* tp_new */
+};
+
+/* Constructors */
+PyObject* PyTraceRecorder_FromTraceRecorder(TraceRecorder* trace, bool is_ref)
+{
+    TraceRecorder_Object* object;
+
+    // Create object
+    PyType_Ready(&TraceRecorder_Type);
+    object = PyObject_New(TraceRecorder_Object, &TraceRecorder_Type);
+    if (object != nullptr){
+        object->trace = trace;
+        object->is_ref = is_ref;
+    }
+    return (PyObject*)object;
+}
+
+} // namespace py
+} // namespace maat
@@ -85,6 +85,11 @@ static PyObject* Value_is_symbolic(PyObject* self, PyObject* args){
         return PyErr_Format(PyExc_RuntimeError, "Value isn't bound to a VarContext");
 }
 
+static PyObject* Value_is_tainted(PyObject* self)
+{
+    return PyBool_FromLong((*(as_value_object(self).value)).is_tainted());
+}
+
 static PyObject* Value_as_uint(PyObject* self, PyObject* args)
 {
     PyObject* varctx = nullptr;
@@ -238,6 +243,7 @@ static PyMethodDef Value_methods[] =
     {"is_concolic", (PyCFunction)Value_is_concolic, METH_VARARGS, "Check whether the value is concolic"},
     {"is_concrete", (PyCFunction)Value_is_concrete, METH_VARARGS, "Check whether the value is concrete"},
     {"is_symbolic", (PyCFunction)Value_is_symbolic, METH_VARARGS, "Check whether the value is symbolic"},
+    {"is_tainted", (PyCFunction)Value_is_tainted, METH_NOARGS, "Check whether at least one bit of the value is tainted"},
     {"as_int", (PyCFunction)Value_as_int, METH_VARARGS, "Concretize the value interpreted as a signed value"},
     {"as_uint", (PyCFunction)Value_as_uint, METH_VARARGS, "Concretize the value interpreted as an unsigned value"},
     {"as_float", (PyCFunction)Value_as_float, METH_VARARGS, "Concretize the value interpreted as a floating point value"},
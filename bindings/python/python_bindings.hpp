@@ -20,6 +20,36 @@ namespace py
 PyObject* create_class(PyObject* name, PyObject* bases, PyObject* dict);
 std::optional<std::filesystem::path> get_maat_module_directory();
 
+/** \brief Release the GIL for the lifetime of the object. Python callbacks
+ * executed meanwhile re-acquire it (see EventCallback::execute()). The GIL
+ * is restored when the object is destroyed, including during exception
+ * unwinding, so Python errors can safely be raised afterwards */
+class ReleaseGIL
+{
+private:
+    PyThreadState* _state;
+public:
+    ReleaseGIL(): _state(PyEval_SaveThread()) {}
+    ~ReleaseGIL() { PyEval_RestoreThread(_state); }
+    ReleaseGIL(const ReleaseGIL& other) = delete;
+    ReleaseGIL& operator=(const ReleaseGIL& other) = delete;
+};
+
+/** \brief Release a Py_buffer obtained with PyObject_GetBuffer() when the
+ * object is destroyed, including during exception unwinding */
+class PyBufferGuard
+{
+private:
+    Py_buffer* _buffer;
+public:
+    PyBufferGuard(): _buffer(nullptr) {}
+    ~PyBufferGuard() { if (_buffer != nullptr) PyBuffer_Release(_buffer); }
+    PyBufferGuard(const PyBufferGuard& other) = delete;
+    PyBufferGuard& operator=(const PyBufferGuard& other) = delete;
+    /// Release 'buffer' when the guard is destroyed
+    void guard(Py_buffer* buffer) { _buffer = buffer; }
+};
+
 // ================= Arch =======================
 void init_arch(PyObject* module);
 
@@ -77,6 +107,17 @@ typedef struct{
 PyObject* PyMemEngine_FromMemEngine(MemEngine* mem, bool is_ref);
 #define as_mem_object(x) (*((MemEngine_Object*)x))
 
+/// Read-only buffer over the concrete memory of a segment
+typedef struct{
+    PyObject_HEAD
+    PyObject* mem; ///< The MemEngine python object the view was created from
+    std::shared_ptr<MemSegment>* segment;
+    addr_t addr;
+    Py_ssize_t size;
+} MemView_Object;
+PyObject* PyMemView_FromSegment(PyObject* mem, std::shared_ptr<MemSegment> segment, addr_t addr, Py_ssize_t size);
+#define as_memview_object(x) (*((MemView_Object*)x))
+
 // ================== Events ==================
 void init_event(PyObject* module);
 
@@ -84,8 +125,9 @@ typedef struct{
     PyObject_HEAD
     event::EventManager* manager;
     bool is_ref;
+    Arch* arch; ///< Used to translate register names, can be null
 } EventManager_Object;
-PyObject* PyEventManager_FromEventManager(event::EventManager* m, bool is_ref);
+PyObject* PyEventManager_FromEventManager(event::EventManager* m, bool is_ref, Arch* arch=nullptr);
 #define as_event_object(x) (*((EventManager_Object*)x))
 
 // =================== Engine ====================
@@ -99,11 +141,13 @@ typedef struct{
     PyObject* cpu; 
     PyObject* mem; 
     PyObject* hooks;
+    PyObject* trace;
     PyObject* info;
     PyObject* path;
     PyObject* env;
     // PyObject* stats;
     PyObject* settings;
+    PyObject* symptr_policies;
     PyObject* process;
 } MaatEngine_Object;
 PyObject* get_MaatEngine_Type();
@@ -174,6 +218,36 @@ PyObject* PyCPU_FromCPUAndArchAndVarContext(
 // ====================== Loader ========================
 void init_loader(PyObject* module);
 
+// ====================== TraceRecorder ======================
+typedef struct{
+    PyObject_HEAD
+    TraceRecorder* trace;
+    bool is_ref;
+} TraceRecorder_Object;
+PyObject* PyTraceRecorder_FromTraceRecorder(TraceRecorder* trace, bool is_ref);
+#define as_trace_object(x)  (*((TraceRecorder_Object*)x))
+
+// ====================== Symbolic pointers ======================
+typedef struct{
+    PyObject_HEAD
+    std::shared_ptr<SymPtrPolicy>* policy;
+} SymPtrPolicy_Object;
+PyObject* get_SymPtrPolicy_Type();
+PyObject* PySymPtrPolicy_FromSymPtrPolicy(std::shared_ptr<SymPtrPolicy> policy);
+PyObject* maat_DefaultSymPtrPolicy(PyObject* self, PyObject* args);
+PyObject* maat_MinSymPtrPolicy(PyObject* self, PyObject* args);
+PyObject* maat_ConcolicSymPtrPolicy(PyObject* self, PyObject* args);
+PyObject* maat_SymbolicSymPtrPolicy(PyObject* self, PyObject* args);
+#define as_symptr_policy_object(x)  (*((SymPtrPolicy_Object*)x))
+
+typedef struct{
+    PyObject_HEAD
+    SymPtrPolicies* policies;
+    bool is_ref;
+} SymPtrPolicies_Object;
+PyObject* PySymPtrPolicies_FromSymPtrPolicies(SymPtrPolicies* policies, bool is_ref);
+#define as_symptr_policies_object(x)  (*((SymPtrPolicies_Object*)x))
+
 // ====================== Settings ======================
 typedef struct{
     PyObject_HEAD
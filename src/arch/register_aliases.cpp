@@ -14,6 +14,50 @@ inline void __attribute__((always_inline)) _set_flag_from_bit(
     ctx.set(reg, concat(Value(8-nb_bits, 0), extract(val, nb_bits-1+bit, bit)));
 }
 
+// Flags of EFLAGS/RFLAGS as (register, bit, number of bits)
+using flag_layout_t = std::vector<std::tuple<ir::reg_t, int, int>>;
+
+static const flag_layout_t x86_flag_layout{
+    {X86::CF, 0, 1}, {X86::PF, 2, 1}, {X86::AF, 4, 1}, {X86::ZF, 6, 1},
+    {X86::SF, 7, 1}, {X86::TF, 8, 1}, {X86::IF, 9, 1}, {X86::DF, 10, 1},
+    {X86::OF, 11, 1}, {X86::IOPL, 12, 2}, {X86::NT, 14, 1}, {X86::RF, 16, 1},
+    {X86::VM, 17, 1}, {X86::AC, 18, 1}, {X86::VIF, 19, 1}, {X86::VIP, 20, 1},
+    {X86::ID, 21, 1}
+};
+
+static const flag_layout_t x64_flag_layout{
+    {X64::CF, 0, 1}, {X64::PF, 2, 1}, {X64::AF, 4, 1}, {X64::ZF, 6, 1},
+    {X64::SF, 7, 1}, {X64::TF, 8, 1}, {X64::IF, 9, 1}, {X64::DF, 10, 1},
+    {X64::OF, 11, 1}, {X64::IOPL, 12, 2}, {X64::NT, 14, 1}, {X64::RF, 16, 1},
+    {X64::VM, 17, 1}, {X64::AC, 18, 1}, {X64::VIF, 19, 1}, {X64::VIP, 20, 1},
+    {X64::ID, 21, 1}
+};
+
+// Build the flags register directly as a number when all flags are
+// concrete, keeping their shadow taint. Return false if at least one
+// flag is symbolic
+static bool _get_concrete_flags(
+    CPUContext& ctx,
+    const flag_layout_t& layout,
+    size_t size,
+    Value& res
+)
+{
+    ucst_t flags = 0x2; // Bit 1 is always set
+    ucst_t taint = 0;
+    for (const auto& [reg, bit, nb_bits] : layout)
+    {
+        const Value& val = ctx.get(reg);
+        if (val.is_abstract())
+            return false;
+        flags |= (val.as_uint() & cst_mask(nb_bits)) << bit;
+        taint |= (val.shadow_taint() & cst_mask(nb_bits)) << bit;
+    }
+    res = Value(size, flags);
+    res.set_shadow_taint(taint);
+    return true;
+}
+
 void x86_alias_setter(CPUContext& ctx, ir::reg_t reg, const Value& val)
 {
     if (reg == X86::EFLAGS)
@@ -45,6 +89,8 @@ Value x86_alias_getter(CPUContext& ctx, ir::reg_t reg)
     Value res;
     if (reg == X86::EFLAGS)
     {
+        if (_get_concrete_flags(ctx, x86_flag_layout, 32, res))
+            return res;
         res = extract(ctx.get(X86::CF),0,0);
         res.set_concat(Value(1,1), res);
         res.set_concat(extract(ctx.get(X86::PF),0,0), res);
@@ -106,6 +152,8 @@ Value x64_alias_getter(CPUContext& ctx, ir::reg_t reg)
     Value res;
     if (reg == X64::RFLAGS)
     {
+        if (_get_concrete_flags(ctx, x64_flag_layout, 64, res))
+            return res;
         res = extract(ctx.get(X64::CF),0,0);
         res.set_concat(Value(1,1), res);
         res.set_concat(extract(ctx.get(X64::PF),0,0), res);
@@ -152,5 +200,16 @@ void CPUContext::init_alias_getset(Arch::Type arch)
     }
 }
 
+std::set x86_lazy_regs{X86::CF, X86::PF, X86::AF, X86::ZF, X86::SF, X86::OF};
+std::set x64_lazy_regs{X64::CF, X64::PF, X64::AF, X64::ZF, X64::SF, X64::OF};
+
+void CPUContext::init_lazy_regs(Arch::Type arch)
+{
+    if (arch == Arch::Type::X86)
+        lazy_regs = x86_lazy_regs;
+    else if (arch == Arch::Type::X64)
+        lazy_regs = x64_lazy_regs;
+}
+
 } // namespace ir
 } // namespace maat
\ No newline at end of file
@@ -90,7 +90,10 @@ void X86_PMINUB_handler(MaatEngine& engine, const ir::Inst& inst, ir::ProcessedI
             concat(extract(src2, i+7, i), res)
         );
     }
-    pinst.res.set_overwrite(pinst.out.value(), res, inst.out.lb);
+    if (pinst.out.value().size() == res->size)
+        pinst.res = res;
+    else
+        pinst.res.set_overwrite(pinst.out.value(), res, inst.out.lb);
 }
 
 void X86_CPUID_handler(MaatEngine& engine, const ir::Inst& inst, ir::ProcessedInst& pinst)
@@ -482,7 +485,7 @@ void EVM_MLOAD_handler(MaatEngine& engine, const ir::Inst& inst, ir::ProcessedIn
 void EVM_MSTORE_handler(MaatEngine& engine, const ir::Inst& inst, ir::ProcessedInst& pinst)
 {
     env::EVM::contract_t contract = env::EVM::get_contract_for_engine(engine);
-    contract->memory.expand_if_needed(pinst.in1.value(), inst.in[2].size()/8);
+    contract->memory.prepare_write(pinst.in1.value(), inst.in[2].size()/8);
     // Note: calling process_store() should not be done from outside the MaatEngine
     // but here it's a hacky way to trigger the whole memory processing with handling of
     // symbolic pointers and triggering of event hooks
@@ -524,7 +527,10 @@ void EVM_SLOAD_handler(MaatEngine& engine, const ir::Inst& inst, ir::ProcessedIn
 {
     env::EVM::contract_t contract = env::EVM::get_contract_for_engine(engine);
     // Set result but don't push, push is done by next PCODE instruction
-    pinst.res = contract->storage->read(pinst.in1.value());
+    pinst.res = contract->storage->read(
+        pinst.in1.value(),
+        &env::EVM::get_ethereum(engine)->keccak_helper
+    );
 }
 
 void EVM_SSTORE_handler(MaatEngine& engine, const ir::Inst& inst, ir::ProcessedInst& pinst)
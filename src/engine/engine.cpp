@@ -65,6 +65,7 @@ MaatEngine::MaatEngine(Arch::Type _arch, env::OS os): env(nullptr), _uid(++_uid_
     // Initialize all registers to their proper bit-size with value 0
     cpu = ir::CPU(arch->nb_regs);
     cpu.ctx().init_alias_getset(arch->type);
+    cpu.ctx().init_lazy_regs(arch->type);
     for (reg_t reg = 0; reg < arch->nb_regs; reg++)
         cpu.ctx().set(reg, Number(arch->reg_size(reg), 0));
     // Initialize some variables for execution statefullness
@@ -92,7 +93,9 @@ MaatEngine::MaatEngine(
         throw runtime_exception("MaatEngine: duplication of snapshots manager not yet implemented");
     else
         snapshots = std::make_shared<SnapshotManager<Snapshot>>();
-    simplifier = other.simplifier;
+    // Don't share the simplifier, its memo and dispatch table are
+    // updated while simplifying
+    simplifier = std::make_shared<ExprSimplifier>(*other.simplifier);
     callother_handlers = other.callother_handlers;
     arch = other.arch;
     symbols = std::make_shared<SymbolManager>();
@@ -109,6 +112,7 @@ MaatEngine::MaatEngine(
             vars, arch->bits(), snapshots, other.mem->endianness()
         );
     cpu = other.cpu;
+    symptr_policies = other.symptr_policies;
     // hooks
     if (duplicate.count("hooks"))
         hooks = other.hooks;
@@ -176,6 +180,24 @@ if (statement != true)\
 }
 
 info::Stop MaatEngine::run(int max_inst)
+{
+    info::Stop res = _run(max_inst);
+    // Pass events recorded by hooks in batch mode to their callbacks
+    // before returning to the user
+    if (hooks.has_pending_events())
+    {
+        if (hooks.flush(*this) == event::Action::ERROR)
+        {
+            log.error("Error executing event callback, aborting...");
+            info.reset();
+            info.stop = info::Stop::FATAL;
+            return info.stop;
+        }
+    }
+    return res;
+}
+
+info::Stop MaatEngine::_run(int max_inst)
 {
     bool next_inst = true;
     // True if max_instr argument was specified (!= 0)
@@ -461,6 +483,10 @@ info::Stop MaatEngine::run(int max_inst)
         // Record executed instruction in statistics
         MaatStats::instance().inc_executed_insts();
 
+        // Record executed instruction in coverage and trace
+        if (trace.is_enabled())
+            trace.record_inst(asm_inst->addr());
+
         // Update PC for NOPs....
         if (asm_inst->instructions().empty())
         {
@@ -554,6 +580,8 @@ bool MaatEngine::process_branch(
                 // find to which IR inst id we have to loop back !
                 cpu.ctx().set(arch->pc(), in0);
                 branch_type = MaatEngine::branch_native;
+                if (trace.is_enabled())
+                    trace.record_branch(true);
                 if (hooks.has_hooks(Event::BRANCH, When::AFTER))
                 {
                     info.addr = asm_inst.addr();
@@ -573,6 +601,8 @@ bool MaatEngine::process_branch(
             // Branch to in0
             cpu.ctx().set(arch->pc(), in0);
             branch_type = MaatEngine::branch_native;
+            if (trace.is_enabled())
+                trace.record_branch(true);
             if (hooks.has_hooks(Event::BRANCH, When::AFTER))
             {
                 info.addr = asm_inst.addr();
@@ -644,6 +674,9 @@ bool MaatEngine::process_branch(
                 taken = (in1.as_uint(*vars) != 0);
             }
 
+            if (trace.is_enabled() and not pcode_rela)
+                trace.record_branch(taken);
+
             // Perform the branch
             if (taken) // branch taken
             {
@@ -721,28 +754,33 @@ bool MaatEngine::resolve_addr_param(
     const Value& addr = addr_param.value();
     Value loaded;
     bool do_abstract_load = true;
+    ValueSet range;
     int load_size = param.size()%8 == 0 ? param.size()/8 : (param.size()/8) + 1;
 
-    if (
-        addr.is_concrete(*vars)
-        or (
-            addr.is_concolic(*vars) and
-            not settings.symptr_read
-        )
-    )
+    if (addr.is_concrete(*vars))
     {
         do_abstract_load = false;
         addr_param.auxilliary = addr.as_number(*vars);
     }
-    else if (addr.is_symbolic(*vars) and not settings.symptr_read)
-    {
-        info.stop = info::Stop::FATAL;
-        log.fatal("MaatEngine::resolve_addr_param(): trying to read from symbolic pointer, but symptr_read option is disabled");
-        return false;
-    }
     else
     {
-        addr_param.auxilliary = addr;
+        SymPtrPolicy::Result ptr = symptr_policies.get(addr, *vars).resolve(*this, addr, false);
+        if (ptr.action == SymPtrPolicy::Result::Action::ERROR)
+        {
+            info.stop = info::Stop::FATAL;
+            log.fatal("MaatEngine::resolve_addr_param(): ", ptr.error);
+            return false;
+        }
+        else if (ptr.action == SymPtrPolicy::Result::Action::CONCRETE)
+        {
+            do_abstract_load = false;
+            addr_param.auxilliary = Number(addr.size(), ptr.addr);
+        }
+        else
+        {
+            addr_param.auxilliary = addr;
+            range = ptr.range;
+        }
     }
 
     try
@@ -763,18 +801,13 @@ bool MaatEngine::resolve_addr_param(
         if (do_abstract_load)
         {
             Expr load_addr = simplifier->simplify(addr_param.auxilliary.as_expr());
-            ValueSet range = load_addr->value_set();
-            if (settings.symptr_refine_range)
-            {
-                MaatStats::instance().start_refine_symptr_read();
-                range = refine_value_set(load_addr);
-                MaatStats::instance().done_refine_symptr_read();
-            }
             mem_engine.symbolic_ptr_read(loaded, load_addr, range, load_size, settings);
         }
         else
         {
             mem_engine.read(loaded, addr_param.auxilliary.as_uint(*vars), load_size);
+            if (trace.is_enabled())
+                trace.record_mem_access(addr_param.auxilliary.as_uint(*vars), false);
         }
         // P-code can load a number of bits that's not a multiple of 8.
         // If that's the case, readjust the loaded value size by trimming
@@ -875,32 +908,37 @@ bool MaatEngine::process_store(
     bool do_abstract_store = true;
     addr_t concrete_store_addr = 0;
     Expr abstract_store_addr = nullptr;
+    ValueSet range;
     Value to_store = pinst.in2.value();
 
     // Get address and value to store
     if (inst.op == ir::Op::STORE or treat_as_pcode_store)
     {
-        if (
-            addr.is_concrete(*vars)
-            or (
-                addr.is_concolic(*vars) and
-                not settings.symptr_write
-            )
-        )
+        if (addr.is_concrete(*vars))
         {
             do_abstract_store = false;
             // WARNING: this truncates addresses on more than 64 bits...
             concrete_store_addr = addr.as_number(*vars).get_ucst();
         }
-        else if (addr.is_symbolic(*vars) and not settings.symptr_write)
-        {
-            log.fatal("MaatEngine::process_store(): trying to write at symbolic pointer but symptr_write option is disabled");
-            info.stop = info::Stop::FATAL;
-            return false;
-        }
-        else // symbolic address and symbolic writes enabled
+        else
         {
-            abstract_store_addr = addr.as_expr();
+            SymPtrPolicy::Result ptr = symptr_policies.get(addr, *vars).resolve(*this, addr, true);
+            if (ptr.action == SymPtrPolicy::Result::Action::ERROR)
+            {
+                log.fatal("MaatEngine::process_store(): ", ptr.error);
+                info.stop = info::Stop::FATAL;
+                return false;
+            }
+            else if (ptr.action == SymPtrPolicy::Result::Action::CONCRETE)
+            {
+                do_abstract_store = false;
+                concrete_store_addr = ptr.addr;
+            }
+            else
+            {
+                abstract_store_addr = addr.as_expr();
+                range = ptr.range;
+            }
         }
         to_store = pinst.in2.value();
     }
@@ -930,18 +968,13 @@ bool MaatEngine::process_store(
         if (do_abstract_store)
         {
             abstract_store_addr = simplifier->simplify(abstract_store_addr);
-            ValueSet range = abstract_store_addr->value_set();
-            if (settings.symptr_refine_range)
-            {
-                MaatStats::instance().start_refine_symptr_write();
-                range = refine_value_set(abstract_store_addr);
-                MaatStats::instance().done_refine_symptr_write();
-            }
             mem_engine.symbolic_ptr_write(abstract_store_addr, range, to_store, settings, &mem_alert, true);
         }
         else
         {
             mem_engine.write(concrete_store_addr, to_store, &mem_alert, true);
+            if (trace.is_enabled())
+                trace.record_mem_access(concrete_store_addr, true);
         }
         // Mem write event
         if (hooks.has_hooks({Event::MEM_W, Event::MEM_RW}, When::AFTER))
@@ -1123,8 +1156,8 @@ MaatEngine::snapshot_t MaatEngine::take_snapshot()
     snapshot.pending_ir_state = current_ir_state;
     snapshot.info = info;
     snapshot.process = std::make_shared<ProcessInfo>(*process);
-    snapshot.page_permissions = mem->page_manager.regions();
-    snapshot.mem_mappings = mem->mappings.get_maps();
+    snapshot.page_permissions = mem->page_manager.shared_regions();
+    snapshot.mem_mappings = mem->mappings.shared_maps();
     snapshot.path = path->take_snapshot();
     snapshot.env = env->take_snapshot();
     // Snapshot ID is its index in the snapshots list
@@ -1186,11 +1219,22 @@ void MaatEngine::restore_last_snapshot(bool remove)
     mem->symbolic_mem_engine.restore_snapshot(snapshot.symbolic_mem);
     info = snapshot.info;
     process = snapshot.process;
-    mem->page_manager.set_regions(std::move(snapshot.page_permissions));
-    mem->mappings.set_maps(std::move(snapshot.mem_mappings));
+    mem->page_manager.set_regions(snapshot.page_permissions);
+    mem->mappings.set_maps(snapshot.mem_mappings);
     path->restore_snapshot(snapshot.path);
     env->restore_snapshot(snapshot.env, remove);
-    // Restore memory segments
+    // Restore memory segments. Extensions are undone first, in reverse
+    // order, so that segments created since the snapshot get back the
+    // start address they are deleted by
+    for (
+        auto it = snapshot.extended_segments.rbegin();
+        it != snapshot.extended_segments.rend();
+        it++
+    )
+    {
+        mem->shrink_segment(it->first, it->second);
+    }
+    snapshot.extended_segments.clear();
     for (addr_t start : snapshot.created_segments)
     {
         mem->delete_segment(start);
@@ -1217,6 +1261,7 @@ void MaatEngine::restore_last_snapshot(bool remove)
         );
     }
     snapshot.saved_mem.clear();
+    snapshot.dirty_mem_lines.clear();
 
     // If remove, destroy the snapshot
     if (remove)
@@ -1276,7 +1321,7 @@ unsigned int _solver_check_time(solver::Solver& solver, bool& check, unsigned in
 ValueSet MaatEngine::refine_value_set(Expr e)
 {
     ucst_t max, min, tmp, new_min, new_max;
-    std::set<std::string> var_list;
+    VarSet var_list;
     bool check;
     unsigned int tmp_timeout = settings.symptr_refine_timeout/2;
     unsigned int used_time = 0;
@@ -1290,7 +1335,7 @@ ValueSet MaatEngine::refine_value_set(Expr e)
     if (solver == nullptr)
     {
         // No solver backend
-        res.set(new_min, new_max, 1);
+        res = e->value_set();
         return res;
     }
 
@@ -1406,6 +1451,7 @@ ValueSet MaatEngine::refine_value_set(Expr e)
 
     // Return refined range
     res.set(new_min, new_max, e->value_set().stride);
+    res.set_known_bits(e->value_set().known_zeros, e->value_set().known_ones);
     return res;
 }
 
@@ -1507,6 +1553,7 @@ void MaatEngine::load(serial::Deserializer& d)
       >> cpu >> env >> symbols >> process
       >> info >> settings;
     cpu.ctx().init_alias_getset(arch->type);
+    cpu.ctx().init_lazy_regs(arch->type);
     // Lifter(s)
     size_t tmp_size;
     d >> bits(tmp_size);
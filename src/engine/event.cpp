@@ -1,5 +1,7 @@
 #include "maat/event.hpp"
 #include "maat/engine.hpp"
+#include <algorithm>
+#include <iterator>
 
 namespace maat
 {
@@ -55,6 +57,7 @@ bool is_exec_event(Event event)
 EventCallback::EventCallback():
     type(EventCallback::Type::NONE),
     native_cb(nullptr),
+    native_batch_cb(nullptr),
     native_cb_data(nullptr)
 {
 #ifdef MAAT_PYTHON_BINDINGS
@@ -66,6 +69,19 @@ EventCallback::EventCallback():
 EventCallback::EventCallback(native_cb_t cb, void* cb_data):
     type(EventCallback::Type::NATIVE),
     native_cb(cb),
+    native_batch_cb(nullptr),
+    native_cb_data(cb_data)
+{
+#ifdef MAAT_PYTHON_BINDINGS
+    python_cb = nullptr;
+    python_cb_data = nullptr;
+#endif
+}
+
+EventCallback::EventCallback(native_batch_cb_t cb, void* cb_data):
+    type(EventCallback::Type::NATIVE_BATCH),
+    native_cb(nullptr),
+    native_batch_cb(cb),
     native_cb_data(cb_data)
 {
 #ifdef MAAT_PYTHON_BINDINGS
@@ -77,7 +93,7 @@ EventCallback::EventCallback(native_cb_t cb, void* cb_data):
 #ifdef MAAT_PYTHON_BINDINGS
 EventCallback::EventCallback(python_cb_t cb, PyObject* cb_data):
     type(EventCallback::Type::PYTHON),
-    native_cb(nullptr), native_cb_data(nullptr),
+    native_cb(nullptr), native_batch_cb(nullptr), native_cb_data(nullptr),
     python_cb(cb), python_cb_data(cb_data)
 
 {
@@ -100,6 +116,7 @@ EventCallback& EventCallback::operator=(const EventCallback& other)
 {
     type = other.type;
     native_cb = other.native_cb;
+    native_batch_cb = other.native_batch_cb;
     native_cb_data = other.native_cb_data;
 #ifdef MAAT_PYTHON_BINDINGS
     python_cb = other.python_cb;
@@ -114,6 +131,7 @@ EventCallback& EventCallback::operator=(EventCallback&& other)
 {
     type = other.type;
     native_cb = other.native_cb;
+    native_batch_cb = other.native_batch_cb;
     native_cb_data = other.native_cb_data;
 #ifdef MAAT_PYTHON_BINDINGS
     python_cb = other.python_cb;
@@ -141,6 +159,32 @@ bool is_valid_action(int action)
             or action == (int)Action::ERROR;
 }
 
+#ifdef MAAT_PYTHON_BINDINGS
+Action action_from_python_result(MaatEngine& engine, PyObject* result)
+{
+    if (result == NULL) // Callback failed
+    {
+        // TODO: log error properly
+        std::cout << "Error in python callback: ";
+        PyErr_Print(); // No PyErr_ print to string in Python's API ???
+        PyErr_Clear();
+        return Action::ERROR;
+    }
+    else if (result == Py_None)
+        return Action::CONTINUE;
+    else if (PyLong_Check(result))
+    {
+        int int_res = PyLong_AsLong(result);
+        if (is_valid_action(int_res))
+            return (Action)int_res;
+        engine.log.fatal("Python callback didn't return a valid action");
+        return Action::ERROR;
+    }
+    engine.log.fatal("Python callback didn't return a valid action (wrong object type)");
+    return Action::ERROR;
+}
+#endif
+
 Action EventCallback::execute(MaatEngine& engine) const
 {
     if (type == EventCallback::Type::NATIVE)
@@ -159,6 +203,8 @@ Action EventCallback::execute(MaatEngine& engine) const
     {
         Action res = Action::CONTINUE;
 #ifdef MAAT_PYTHON_BINDINGS
+            // The engine might be running with the GIL released
+            PyGILState_STATE gil_state = PyGILState_Ensure();
             // Build args list
             PyObject* argslist = nullptr;
             // Note: PyTuple_Pack does increment the ref count on objects
@@ -168,59 +214,55 @@ Action EventCallback::execute(MaatEngine& engine) const
                 argslist = PyTuple_Pack(2, engine.self_python_wrapper_object, python_cb_data);
 
             if( argslist == NULL )
+            {
+                PyGILState_Release(gil_state);
                 throw runtime_exception("EventCallback::execute(): failed to create args tuple for python callback");
+            }
 
             Py_INCREF(argslist);
             PyObject* result = PyObject_CallObject(python_cb, argslist);
             Py_DECREF(argslist);
-            if (result != NULL)
-            {
-                if (result == Py_None)
-                {
-                    res = Action::CONTINUE;
-                }
-                else if (PyLong_Check(result))
-                {
-                    int int_res = PyLong_AsLong(result);
-                    if (not is_valid_action(int_res))
-                    {
-                        engine.log.fatal("Python callback didn't return a valid action");
-                        res = Action::ERROR;
-                    }
-                    else
-                        res = (Action)int_res;
-                }
-                else
-                {
-                    engine.log.fatal("Python callback didn't return a valid action (wrong object type)");
-                    res = Action::ERROR;
-                }
-            }
-            else // Callback failed, returned NULL
-            {
-                // TODO: log error properly
-                std::cout << "Error in python callback: ";
-                PyErr_Print(); // No PyErr_ print to string in Python's API ???
-                PyErr_Clear();
-                res = Action::ERROR;
-            }
+            res = action_from_python_result(engine, result);
             Py_XDECREF(result);
+            PyGILState_Release(gil_state);
 #endif
             return res;
     }
+    else if (type == EventCallback::Type::NATIVE_BATCH)
+    {
+        throw runtime_exception("EventCallback::execute(): batch callback called without events");
+    }
     else
     {
         throw runtime_exception("EventCallback::execute(): called for unsupported callback type!");
     }
 }
 
+Action EventCallback::execute(MaatEngine& engine, const event_batch_t& batch) const
+{
+    if (type != EventCallback::Type::NATIVE_BATCH)
+        return execute(engine);
+
+    try
+    {
+        return native_batch_cb(engine, batch, native_cb_data);
+    }
+    catch (const std::exception& e)
+    {
+        engine.log.error("Caught exception in event callback: ", e.what());
+        return Action::ERROR;
+    }
+}
+
 EventHook::EventHook(int id, Event event, std::string name, AddrFilter filter, std::string group):
     _id(id),
     event(event),
     name(name),
     filter(filter),
     group(group),
-    enabled(true)
+    enabled(true),
+    _value_filter(ValueFilter::ANY),
+    _batch_size(0)
 {}
 
 int EventHook::id()
@@ -230,6 +272,16 @@ int EventHook::id()
 
 bool EventHook::check_filter(MaatEngine& engine)
 {
+    if (
+        not _regs.empty()
+        and is_reg_event(event)
+        and _regs.count(engine.info.reg_access->reg) == 0
+    )
+        return false;
+
+    if (_value_filter != ValueFilter::ANY and not check_value_filter(engine))
+        return false;
+
     if (not filter.is_active())
         return true; // If filter not set, we monitor all addresses by default!
 
@@ -251,9 +303,29 @@ bool EventHook::check_filter(MaatEngine& engine)
     return true;
 }
 
+bool EventHook::check_value_filter(MaatEngine& engine)
+{
+    bool is_abstract = false;
+    if (is_reg_event(event))
+    {
+        const info::RegAccess& access = *engine.info.reg_access;
+        is_abstract = access.value.is_abstract() or access.new_value.is_abstract();
+    }
+    else if (is_mem_event(event))
+    {
+        const info::MemAccess& access = *engine.info.mem_access;
+        // The value is not known yet before memory reads
+        is_abstract = access.addr.is_abstract()
+            or (not access.value.is_none() and access.value.is_abstract());
+    }
+    else
+        return true;
+
+    return is_abstract == (_value_filter == ValueFilter::ABSTRACT);
+}
+
 Action EventHook::trigger(MaatEngine& engine)
 {
-    Action res = Action::CONTINUE;
     // First filter the event
     if (not check_filter(engine))
     {
@@ -264,11 +336,46 @@ Action EventHook::trigger(MaatEngine& engine)
     {
         return Action::HALT;
     }
+    // In batch mode, record the event and wait for the batch to be full
+    if (_batch_size > 0)
+    {
+        _batch.push_back(engine.info);
+        if (_batch.size() < _batch_size)
+            return Action::CONTINUE;
+        // Move the events out of the hook like flush() does, in case
+        // callbacks trigger the hook again
+        event_batch_t batch;
+        std::swap(batch, _batch);
+        _batch.reserve(_batch_size);
+        return _execute_callbacks(engine, &batch);
+    }
     // Hook has callbacks, execute them
+    return _execute_callbacks(engine, nullptr);
+}
+
+Action EventHook::flush(MaatEngine& engine)
+{
+    if (_batch.empty())
+        return Action::CONTINUE;
+
+    // Move the events out of the hook in case callbacks trigger
+    // the hook again
+    event_batch_t batch;
+    std::swap(batch, _batch);
+    info::Stop stop = engine.info.stop;
+    Action res = _execute_callbacks(engine, &batch);
+    if (res != Action::ERROR)
+        engine.info.stop = stop;
+    return res;
+}
+
+Action EventHook::_execute_callbacks(MaatEngine& engine, const event_batch_t* batch)
+{
+    Action res = Action::CONTINUE;
     for (const EventCallback& cb : _callbacks)
     {
         engine.info.stop = info::Stop::HOOK;
-        switch (cb.execute(engine))
+        switch (batch == nullptr ? cb.execute(engine) : cb.execute(engine, *batch))
         {
             case Action::CONTINUE:
                 break;
@@ -323,6 +430,30 @@ void EventHook::add_callback(EventCallback cb)
     _callbacks.push_back(cb);
 }
 
+void EventHook::set_reg_filter(const std::set<reg_t>& regs)
+{
+    if (not regs.empty() and not is_reg_event(event))
+        throw event_exception("EventHook::set_reg_filter(): register filters can only be set on register events");
+    _regs = regs;
+}
+
+void EventHook::set_value_filter(ValueFilter filter)
+{
+    if (filter != ValueFilter::ANY and not is_reg_event(event) and not is_mem_event(event))
+        throw event_exception("EventHook::set_value_filter(): value filters can only be set on register and memory events");
+    _value_filter = filter;
+}
+
+void EventHook::set_batch_size(size_t batch_size)
+{
+    _batch_size = batch_size;
+}
+
+const event_batch_t& EventHook::pending_events() const
+{
+    return _batch;
+}
+
 std::ostream& operator<<(std::ostream& os, const EventHook& h)
 {
     os << std::dec << h._id;
@@ -362,12 +493,99 @@ std::ostream& operator<<(std::ostream& os, const EventHook& h)
             os << std::hex << " [0x" << *h.filter.addr_min << "-0x" << *h.filter.addr_max << "]";
     }
 
+    if (not h._regs.empty())
+        os << " (" << std::dec << h._regs.size() << " registers)";
+
+    if (h._value_filter == ValueFilter::ABSTRACT)
+        os << " (abstract values)";
+    else if (h._value_filter == ValueFilter::CONCRETE)
+        os << " (concrete values)";
+
+    if (h._batch_size > 0)
+        os << " (batches of " << std::dec << h._batch_size << ")";
+
     if (!h.enabled)
         os << " (disabled)";
 
     return os;
 }
 
+AddrHookIndex::AddrHookIndex(): ranges_dirty(false)
+{}
+
+bool AddrHookIndex::can_index(const EventHook& hook)
+{
+    return hook.filter.is_active();
+}
+
+void AddrHookIndex::add(hook_t hook)
+{
+    if (not can_index(*hook))
+        throw event_exception("AddrHookIndex::add(): hook doesn't have an active address filter");
+
+    if (hook->filter.addr_max.has_value())
+    {
+        ranges.push_back(hook);
+        ranges_dirty = true;
+    }
+    else
+    {
+        points[*hook->filter.addr_min].push_back(hook);
+    }
+}
+
+void AddrHookIndex::_sort_ranges()
+{
+    std::sort(
+        ranges.begin(), ranges.end(),
+        [](const hook_t& a, const hook_t& b)
+        {
+            return *a->filter.addr_min < *b->filter.addr_min;
+        }
+    );
+    ranges_max.resize(ranges.size());
+    addr_t max = 0;
+    for (size_t i = 0; i < ranges.size(); i++)
+    {
+        max = std::max(max, *ranges[i]->filter.addr_max);
+        ranges_max[i] = max;
+    }
+    ranges_dirty = false;
+}
+
+void AddrHookIndex::get(addr_t addr, std::vector<hook_t>& res)
+{
+    if (not points.empty())
+    {
+        auto it = points.find(addr);
+        if (it != points.end())
+            res.insert(res.end(), it->second.begin(), it->second.end());
+    }
+
+    if (ranges.empty())
+        return;
+
+    if (ranges_dirty)
+        _sort_ranges();
+
+    // Find the last range whose lower bound is <= addr, then walk
+    // backwards as long as some previous range can still include addr
+    auto it = std::upper_bound(
+        ranges.begin(), ranges.end(), addr,
+        [](addr_t a, const hook_t& h){ return a < *h->filter.addr_min; }
+    );
+    for (int i = (it - ranges.begin()) - 1; i >= 0 and ranges_max[i] >= addr; i--)
+    {
+        if (*ranges[i]->filter.addr_max >= addr)
+            res.push_back(ranges[i]);
+    }
+}
+
+bool AddrHookIndex::empty() const
+{
+    return points.empty() and ranges.empty();
+}
+
 
 EventManager::EventManager(): _id_cnt(0)
 {
@@ -384,6 +602,11 @@ EventManager::EventManager(): _id_cnt(0)
         {Event::BRANCH, {{When::BEFORE, {}}, {When::AFTER, {}} }},
         {Event::PATH, {{When::BEFORE, {}}, {When::AFTER, {}} }}
     };
+    exec_index = 
+    {
+        {When::BEFORE, AddrHookIndex()},
+        {When::AFTER, AddrHookIndex()}
+    };
 }
 
 void EventManager::disable_group(std::string group)
@@ -467,8 +690,32 @@ const std::list<EventManager::hook_t>& EventManager::get_all()
     return all_hooks;
 }
 
+bool EventManager::has_pending_events() const
+{
+    for (auto& hook : all_hooks)
+        if (hook->enabled and not hook->_batch.empty())
+            return true;
+    return false;
+}
 
-void EventManager::add(
+Action EventManager::flush(MaatEngine& engine)
+{
+    Action res = Action::CONTINUE;
+    for (auto& hook : all_hooks)
+    {
+        // Disabled hooks keep their pending events until they are enabled again
+        if (not hook->is_enabled())
+            continue;
+        Action tmp = hook->flush(engine);
+        if (tmp == Action::ERROR)
+            return tmp;
+        res = merge_actions(res, tmp);
+    }
+    return res;
+}
+
+
+EventManager::hook_t EventManager::add(
     event::Event event,
     event::When when,
     std::string name,
@@ -481,11 +728,11 @@ void EventManager::add(
         _id_cnt++, event,
         name, filter, group
     );
-    all_hooks.push_back(h);
-    hook_map.at(event).at(when).push_back(h);
+    _add_hook(h, when);
+    return h;
 }
 
-void EventManager::add(
+EventManager::hook_t EventManager::add(
     event::Event event,
     event::When when,
     EventCallback callback,
@@ -500,11 +747,11 @@ void EventManager::add(
         name, filter, group
     );
     h->add_callback(callback);
-    all_hooks.push_back(h);
-    hook_map.at(event).at(when).push_back(h);
+    _add_hook(h, when);
+    return h;
 }
 
-void EventManager::add(
+EventManager::hook_t EventManager::add(
     event::Event event,
     event::When when,
     const std::vector<EventCallback>& callbacks,
@@ -520,8 +767,19 @@ void EventManager::add(
     );
     for (auto& cb : callbacks)
         h->add_callback(cb);
-    all_hooks.push_back(h);
-    hook_map.at(event).at(when).push_back(h);
+    _add_hook(h, when);
+    return h;
+}
+
+void EventManager::_add_hook(EventManager::hook_t hook, When when)
+{
+    all_hooks.push_back(hook);
+    // EXEC hooks monitoring specific addresses don't need to be checked
+    // on every instruction, so we index them by address
+    if (is_exec_event(hook->event) and AddrHookIndex::can_index(*hook))
+        exec_index.at(when).add(hook);
+    else
+        hook_map.at(hook->event).at(when).push_back(hook);
 }
 
 void EventManager::_check_unique_name(const std::string& str)
@@ -749,10 +1007,11 @@ Action EventManager::_trigger_hooks(
     return res;
 }
 
-Action EventManager::_trigger_hooks(Event event, When when, MaatEngine& engine)
+template <typename T>
+static inline Action _trigger_hook_list(T& hooks, MaatEngine& engine)
 {
     Action res = Action::CONTINUE;
-    for (EventManager::hook_t& hook : hook_map[event][when])
+    for (EventManager::hook_t& hook : hooks)
     {
         if (not hook->is_enabled())
             continue;
@@ -765,16 +1024,67 @@ Action EventManager::_trigger_hooks(Event event, When when, MaatEngine& engine)
     return res;
 }
 
+Action EventManager::_trigger_hooks(Event event, When when, MaatEngine& engine)
+{
+    if (is_exec_event(event) and not exec_index[when].empty())
+        return _trigger_exec_hooks(when, engine);
+
+    return _trigger_hook_list(hook_map[event][when], engine);
+}
+
+Action EventManager::_trigger_exec_hooks(When when, MaatEngine& engine)
+{
+    // Reuse the scratch buffers to avoid allocating on every instruction.
+    // They are moved out during the callbacks in case hooks are
+    // triggered again from a callback
+    std::vector<hook_t> indexed, hooks;
+    std::swap(indexed, _exec_scratch_indexed);
+    std::swap(hooks, _exec_scratch_merged);
+
+    Action res;
+    exec_index[when].get(engine.info.addr.value(), indexed);
+    std::list<hook_t>& unfiltered = hook_map[Event::EXEC][when];
+    auto by_id = [](const hook_t& a, const hook_t& b){ return a->id() < b->id(); };
+    if (indexed.empty())
+        res = _trigger_hook_list(unfiltered, engine);
+    else
+    {
+        // Trigger hooks in the order they were added, like for other events.
+        // Unfiltered hooks are already in that order
+        if (indexed.size() > 1)
+            std::sort(indexed.begin(), indexed.end(), by_id);
+        if (unfiltered.empty())
+            res = _trigger_hook_list(indexed, engine);
+        else
+        {
+            std::merge(
+                indexed.begin(), indexed.end(),
+                unfiltered.begin(), unfiltered.end(),
+                std::back_inserter(hooks), by_id
+            );
+            res = _trigger_hook_list(hooks, engine);
+        }
+    }
+
+    indexed.clear();
+    hooks.clear();
+    std::swap(indexed, _exec_scratch_indexed);
+    std::swap(hooks, _exec_scratch_merged);
+    return res;
+}
+
 bool EventManager::has_hooks(const std::vector<Event>& events, When when)
 {
     for (auto& e : events)
-        if (not hook_map[e][when].empty())
+        if (has_hooks(e, when))
             return true;
     return false;       
 }
 
 bool EventManager::has_hooks(Event event, When when)
 {
+    if (is_exec_event(event) and not exec_index[when].empty())
+        return true;
     return not hook_map[event][when].empty();
 }
 
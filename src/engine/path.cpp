@@ -3,9 +3,36 @@
 namespace maat
 {
     
+// Return true if both constraints are structurally identical
+static bool same_constraint(const Constraint& c1, const Constraint& c2)
+{
+    if (c1 == c2)
+        return true;
+    if (c1->type != c2->type)
+        return false;
+    if (c1->type == ConstraintType::AND or c1->type == ConstraintType::OR)
+        return same_constraint(c1->left_constr, c2->left_constr)
+            and same_constraint(c1->right_constr, c2->right_constr);
+    return c1->left_expr->eq(c2->left_expr) and c1->right_expr->eq(c2->right_expr);
+}
+
 void PathManager::add(Constraint constraint)
 {
+    // Constraints that are always true don't restrict the path
+    if (constraint->is_tautology())
+        return;
+
+    // Don't record the same constraint twice
+    hash_t hash = constraint->hash();
+    auto range = _constraints_by_hash.equal_range(hash);
+    for (auto it = range.first; it != range.second; it++)
+    {
+        if (same_constraint(it->second, constraint))
+            return;
+    }
+
     _constraints.push_back(constraint);
+    _constraints_by_hash.emplace(hash, constraint);
 }
 
 PathManager::path_snapshot_t PathManager::take_snapshot()
@@ -17,7 +44,21 @@ void PathManager::restore_snapshot(path_snapshot_t snap)
 {
     unsigned int idx(snap);
     if (idx < _constraints.size())
+    {
+        for (auto c = _constraints.begin() + idx; c != _constraints.end(); c++)
+        {
+            auto range = _constraints_by_hash.equal_range((*c)->hash());
+            for (auto it = range.first; it != range.second; it++)
+            {
+                if (it->second == *c)
+                {
+                    _constraints_by_hash.erase(it);
+                    break;
+                }
+            }
+        }
         _constraints.resize(idx);
+    }
 }
 
 const std::vector<Constraint>& PathManager::constraints()
@@ -29,7 +70,7 @@ PathManager::IteratorWrapper PathManager::_constraints_iterator()
 {
     return PathManager::IteratorWrapper(
                 PathManager::iterator::Type::REGULAR,
-                std::set<std::string>(),
+                VarSet(),
                 &_constraints
             );
 }
@@ -39,7 +80,7 @@ PathManager::IteratorWrapper PathManager::get_constraints_containing(
 ){
     return PathManager::IteratorWrapper(
                 PathManager::iterator::Type::RELATED,
-                vars,
+                VarSet(vars),
                 &_constraints
             );
 }
@@ -47,13 +88,13 @@ PathManager::IteratorWrapper PathManager::get_constraints_containing(
 std::unordered_set<Constraint> PathManager::get_related_constraints(
     const Constraint& constraint
 ) const {
-    return _get_related_constraints(constraint->contained_vars());
+    return _get_related_constraints(constraint->contained_var_ids());
 }
 
 std::unordered_set<Constraint> PathManager::get_related_constraints(
     const Expr& expr
 ) const {
-    std::set<std::string> vars;
+    VarSet vars;
     expr->get_vars(vars);
     return _get_related_constraints(vars);
 }
@@ -65,7 +106,7 @@ std::unordered_set<Constraint> PathManager::get_related_constraints(
 }
 
 std::unordered_set<Constraint> PathManager::_get_related_constraints(
-    std::set<std::string> vars
+    VarSet vars
 ) const {
     std::unordered_set<Constraint> res;
     bool changed = true;
@@ -80,8 +121,7 @@ std::unordered_set<Constraint> PathManager::_get_related_constraints(
                 {
                     res.insert(constraint);
                     // Add potential new variables to the variables closure
-                    for (const auto& v : constraint->contained_vars())
-                        vars.insert(v);
+                    vars.insert(constraint->contained_var_ids());
                     changed = true;
                 }
             }
@@ -103,6 +143,9 @@ void PathManager::dump(serial::Serializer& s) const
 void PathManager::load(serial::Deserializer& d)
 {
     d >> _constraints;
+    _constraints_by_hash.clear();
+    for (const auto& constraint : _constraints)
+        _constraints_by_hash.emplace(constraint->hash(), constraint);
 }
 
 
@@ -47,11 +47,21 @@ void Snapshot::add_saved_mem(SavedMemState&& content)
     saved_mem.push_back(content);
 }
 
+bool Snapshot::add_dirty_mem_line(addr_t line)
+{
+    return dirty_mem_lines.insert(line).second;
+}
+
 void Snapshot::add_created_segment(ucst_t segment_start)
 {
     created_segments.push_back(segment_start);
 }
 
+void Snapshot::add_extended_segment(addr_t segment_start, addr_t segment_end)
+{
+    extended_segments.push_back(std::make_pair(segment_start, segment_end));
+}
+
 uid_t Snapshot::class_uid() const
 {
     return serial::ClassId::SNAPSHOT;
@@ -60,15 +70,26 @@ uid_t Snapshot::class_uid() const
 void Snapshot::dump(serial::Serializer& s) const
 {
     s << cpu << bits(symbolic_mem) << saved_mem << container_bits(created_segments)
-      << pending_ir_state << page_permissions << mem_mappings
+      << container_bits(extended_segments)
+      << pending_ir_state << *page_permissions << *mem_mappings
       << bits(path) << info << process << bits(env);
 }
 
 void Snapshot::load(serial::Deserializer& d)
 {
+    std::list<PageSet> permissions;
+    std::list<MemMap> mappings;
     d >> cpu >> bits(symbolic_mem) >> saved_mem >> container_bits(created_segments)
-      >> pending_ir_state >> page_permissions >> mem_mappings
+      >> container_bits(extended_segments)
+      >> pending_ir_state >> permissions >> mappings
       >> bits(path) >> info >> process >> bits(env);
+    page_permissions = std::make_shared<const std::list<PageSet>>(std::move(permissions));
+    mem_mappings = std::make_shared<const std::list<MemMap>>(std::move(mappings));
+    // Saved memory chunks never cross a line boundary so the dirty lines
+    // can be recomputed from them
+    dirty_mem_lines.clear();
+    for (const SavedMemState& saved : saved_mem)
+        dirty_mem_lines.insert(saved.addr & ~(saved_mem_line_size-1));
 }
 
 } // namespace maat
@@ -0,0 +1,180 @@
+#include "maat/symptr.hpp"
+#include "maat/engine.hpp"
+#include "maat/stats.hpp"
+
+namespace maat
+{
+
+SymPtrPolicy::Result SymPtrPolicy::concrete(addr_t addr)
+{
+    return Result{Result::Action::CONCRETE, addr, ValueSet(), ""};
+}
+
+SymPtrPolicy::Result SymPtrPolicy::symbolic(const ValueSet& range)
+{
+    return Result{Result::Action::SYMBOLIC, 0, range, ""};
+}
+
+SymPtrPolicy::Result SymPtrPolicy::error(const std::string& error)
+{
+    return Result{Result::Action::ERROR, 0, ValueSet(), error};
+}
+
+SymPtrPolicy::Result SymPtrPolicy::concretize(MaatEngine& engine, const Value& addr, addr_t value)
+{
+    if (engine.settings.record_path_constraints)
+        engine.path->add(addr.as_expr() == exprcst(addr.size(), value));
+    return concrete(value);
+}
+
+Expr SymPtrPolicy::simplify(MaatEngine& engine, Expr e)
+{
+    return engine.simplifier->simplify(e);
+}
+
+SymPtrPolicy::Result DefaultSymPtrPolicy::resolve(MaatEngine& engine, const Value& addr, bool is_write)
+{
+    bool allowed = is_write ? engine.settings.symptr_write : engine.settings.symptr_read;
+    if (not allowed)
+    {
+        if (addr.is_concolic(*engine.vars))
+            // WARNING: this truncates addresses on more than 64 bits...
+            return concrete(addr.as_number(*engine.vars).get_ucst());
+        else if (is_write)
+            return error("trying to write at symbolic pointer but symptr_write option is disabled");
+        else
+            return error("trying to read from symbolic pointer, but symptr_read option is disabled");
+    }
+
+    Expr e = simplify(engine, addr.as_expr());
+    ValueSet range = e->value_set();
+    // Don't call the solver if the value set is already small enough
+    if (engine.settings.symptr_refine_range and range.range() > engine.settings.symptr_max_range)
+    {
+        if (is_write)
+            MaatStats::instance().start_refine_symptr_write();
+        else
+            MaatStats::instance().start_refine_symptr_read();
+        range = engine.refine_value_set(e);
+        if (is_write)
+            MaatStats::instance().done_refine_symptr_write();
+        else
+            MaatStats::instance().done_refine_symptr_read();
+    }
+    return symbolic(range);
+}
+
+SymPtrPolicy::Result MinSymPtrPolicy::resolve(MaatEngine& engine, const Value& addr, bool)
+{
+    Expr e = simplify(engine, addr.as_expr());
+    ValueSet range = e->value_set();
+    if (engine.settings.symptr_refine_range and not range.is_cst())
+        range = engine.refine_value_set(e);
+    return concretize(engine, addr, range.min);
+}
+
+SymPtrPolicy::Result ConcolicSymPtrPolicy::resolve(MaatEngine& engine, const Value& addr, bool is_write)
+{
+    if (addr.is_concolic(*engine.vars))
+        return concretize(engine, addr, addr.as_number(*engine.vars).get_ucst());
+    return MinSymPtrPolicy::resolve(engine, addr, is_write);
+}
+
+SymbolicSymPtrPolicy::SymbolicSymPtrPolicy(addr_t max_range): _max_range(max_range)
+{
+    if (max_range == 0)
+        throw runtime_exception("SymbolicSymPtrPolicy(): max_range can't be zero");
+}
+
+SymPtrPolicy::Result SymbolicSymPtrPolicy::resolve(MaatEngine& engine, const Value& addr, bool)
+{
+    // Difference between the lowest and highest address of the range
+    addr_t span = _max_range - 1;
+    Expr e = simplify(engine, addr.as_expr());
+    ValueSet range = e->value_set();
+    if (range.range() <= span)
+        return symbolic(range);
+
+    addr_t min, max;
+    if (addr.is_concolic(*engine.vars))
+    {
+        // Center the range on the concolic value, staying in the value set
+        addr_t val = addr.as_number(*engine.vars).get_ucst();
+        min = val - range.min < span/2 ? range.min : val - span/2;
+        min -= (min - range.min) % range.stride; // Stay aligned on the stride
+        if (range.max - min < span)
+        {
+            min = range.max - span;
+            // Align up so that the range still fits in the value set
+            min += (range.stride - (min - range.min) % range.stride) % range.stride;
+        }
+    }
+    else
+    {
+        if (engine.settings.symptr_refine_range)
+        {
+            range = engine.refine_value_set(e);
+            if (range.range() <= span)
+                return symbolic(range);
+        }
+        min = range.min;
+    }
+    max = min + span - (span % range.stride);
+    return symbolic(ValueSet(range.size, min, max, range.stride));
+}
+
+SymPtrPolicies::SymPtrPolicies():
+    _default(std::make_shared<DefaultSymPtrPolicy>())
+{}
+
+void SymPtrPolicies::set_default(std::shared_ptr<SymPtrPolicy> policy)
+{
+    if (policy == nullptr)
+        throw runtime_exception("SymPtrPolicies::set_default(): policy can't be null");
+    _default = policy;
+}
+
+void SymPtrPolicies::add(addr_t min, addr_t max, std::shared_ptr<SymPtrPolicy> policy)
+{
+    if (policy == nullptr)
+        throw runtime_exception("SymPtrPolicies::add(): policy can't be null");
+    if (min > max)
+        throw runtime_exception(Fmt()
+            << "SymPtrPolicies::add(): invalid range 0x" << std::hex << min
+            << "-0x" << max >> Fmt::to_str
+        );
+    _regions.push_back(region_t{min, max, policy});
+}
+
+void SymPtrPolicies::clear()
+{
+    _regions.clear();
+}
+
+SymPtrPolicy& SymPtrPolicies::get(const Value& addr, const VarContext& vars)
+{
+    if (_regions.empty())
+        return *_default;
+
+    addr_t min, max;
+    if (addr.is_concolic(vars))
+    {
+        min = addr.as_number(vars).get_ucst();
+        max = min;
+    }
+    else
+    {
+        ValueSet range = addr.as_expr()->value_set();
+        min = range.min;
+        max = range.max;
+    }
+    // Regions added last take precedence
+    for (auto it = _regions.rbegin(); it != _regions.rend(); it++)
+    {
+        if (it->min <= min and max <= it->max)
+            return *it->policy;
+    }
+    return *_default;
+}
+
+} // namespace maat
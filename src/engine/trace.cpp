@@ -0,0 +1,222 @@
+#include "maat/trace.hpp"
+#include "maat/exception.hpp"
+#include <algorithm>
+
+namespace maat
+{
+
+// Number of records buffered before writing them to the trace file
+static constexpr size_t trace_file_buffer_records = 4096;
+
+void TraceRecord::to_raw(uint8_t* buf) const
+{
+    for (int i = 0; i < 8; i++)
+    {
+        buf[i] = (uint8_t)(pc >> (i*8));
+        buf[8+i] = (uint8_t)(mem_addr >> (i*8));
+    }
+    buf[16] = flags;
+}
+
+TraceRecorder::TraceRecorder():
+    _coverage_enabled(false),
+    _trace_enabled(false),
+    _bitmap_shift(0),
+    _prev_loc(0),
+    _block_start(true),
+    _ring_size(0),
+    _ring_next(0),
+    _nb_records(0),
+    _file(nullptr)
+{
+    _reset_current();
+}
+
+TraceRecorder::~TraceRecorder()
+{
+    flush();
+}
+
+void TraceRecorder::enable_coverage(size_t bitmap_size)
+{
+    if (bitmap_size < 2 or (bitmap_size & (bitmap_size-1)) != 0)
+        throw runtime_exception("TraceRecorder::enable_coverage(): bitmap size must be a power of two greater than 1");
+
+    if (_bitmap.size() != bitmap_size)
+    {
+        _bitmap.assign(bitmap_size, 0);
+        // Shift used to keep only the top bits of the block address hash
+        _bitmap_shift = 64;
+        while (bitmap_size > 1)
+        {
+            _bitmap_shift--;
+            bitmap_size >>= 1;
+        }
+    }
+    _prev_loc = 0;
+    _block_start = true;
+    _coverage_enabled = true;
+}
+
+void TraceRecorder::disable_coverage()
+{
+    _coverage_enabled = false;
+}
+
+bool TraceRecorder::coverage_enabled() const
+{
+    return _coverage_enabled;
+}
+
+const std::vector<uint8_t>& TraceRecorder::coverage_bitmap() const
+{
+    return _bitmap;
+}
+
+size_t TraceRecorder::nb_covered_edges() const
+{
+    return _bitmap.size() - std::count(_bitmap.begin(), _bitmap.end(), 0);
+}
+
+void TraceRecorder::reset_coverage()
+{
+    std::fill(_bitmap.begin(), _bitmap.end(), 0);
+    _prev_loc = 0;
+    _block_start = true;
+}
+
+void TraceRecorder::enable_trace(size_t ring_size, const std::string& filename)
+{
+    flush();
+    _ring.clear();
+    _ring.reserve(ring_size);
+    _ring_size = ring_size;
+    _ring_next = 0;
+    _nb_records = 0;
+    _file = nullptr;
+    if (not filename.empty())
+    {
+        _file = std::make_shared<std::ofstream>(filename, std::ios::out | std::ios::binary | std::ios::trunc);
+        if (not _file->is_open())
+        {
+            _file = nullptr;
+            throw runtime_exception(
+                Fmt() << "TraceRecorder::enable_trace(): failed to open trace file: "
+                << filename >> Fmt::to_str
+            );
+        }
+        _file_buffer.reserve(trace_file_buffer_records*TraceRecord::raw_size);
+    }
+    _reset_current();
+    _trace_enabled = true;
+}
+
+void TraceRecorder::disable_trace()
+{
+    flush();
+    _file = nullptr;
+    _trace_enabled = false;
+}
+
+bool TraceRecorder::trace_enabled() const
+{
+    return _trace_enabled;
+}
+
+std::vector<TraceRecord> TraceRecorder::trace() const
+{
+    std::vector<TraceRecord> res;
+    if (_ring.size() < _ring_size)
+    {
+        // Ring buffer didn't wrap yet
+        res = _ring;
+    }
+    else
+    {
+        res.reserve(_ring.size());
+        res.insert(res.end(), _ring.begin() + _ring_next, _ring.end());
+        res.insert(res.end(), _ring.begin(), _ring.begin() + _ring_next);
+    }
+    return res;
+}
+
+uint64_t TraceRecorder::nb_records() const
+{
+    return _nb_records;
+}
+
+void TraceRecorder::clear_trace()
+{
+    _ring.clear();
+    _ring_next = 0;
+}
+
+void TraceRecorder::flush()
+{
+    if (_file != nullptr and not _file_buffer.empty())
+    {
+        _file->write((const char*)_file_buffer.data(), _file_buffer.size());
+        _file->flush();
+    }
+    _file_buffer.clear();
+}
+
+void TraceRecorder::record_branch(bool taken)
+{
+    _current.flags |= TraceRecord::BRANCH;
+    if (taken)
+        _current.flags |= TraceRecord::BRANCH_TAKEN;
+}
+
+void TraceRecorder::record_mem_access(addr_t addr, bool is_write)
+{
+    _current.mem_addr = addr;
+    _current.flags |= is_write ? TraceRecord::MEM_WRITE : TraceRecord::MEM_READ;
+}
+
+void TraceRecorder::record_inst(addr_t pc)
+{
+    if (_coverage_enabled and _block_start)
+    {
+        // Fibonacci hashing of the block address
+        addr_t cur_loc = (pc * 0x9e3779b97f4a7c15ULL) >> _bitmap_shift;
+        // Saturate hit counts so that hot edges don't wrap back to 0
+        uint8_t& hits = _bitmap[cur_loc ^ _prev_loc];
+        hits += (hits != 0xff);
+        _prev_loc = cur_loc >> 1;
+    }
+    // Next instruction starts a new block if this one branched
+    _block_start = _current.flags & TraceRecord::BRANCH;
+
+    if (_trace_enabled)
+    {
+        _current.pc = pc;
+        if (_ring_size > 0)
+        {
+            if (_ring.size() < _ring_size)
+                _ring.push_back(_current);
+            else
+                _ring[_ring_next] = _current;
+            _ring_next = (_ring_next + 1) % _ring_size;
+        }
+        if (_file != nullptr)
+        {
+            size_t offset = _file_buffer.size();
+            _file_buffer.resize(offset + TraceRecord::raw_size);
+            _current.to_raw(_file_buffer.data() + offset);
+            if (_file_buffer.size() >= trace_file_buffer_records*TraceRecord::raw_size)
+                flush();
+        }
+        _nb_records++;
+    }
+    _reset_current();
+}
+
+void TraceRecorder::_reset_current()
+{
+    _current.pc = 0;
+    _current.mem_addr = 0;
+    _current.flags = 0;
+}
+
+} // namespace maat
@@ -2,6 +2,8 @@
 #include "maat/engine.hpp"
 #include "sha3.hpp"
 #include <algorithm>
+#include <sstream>
+#include <unordered_set>
 
 namespace maat{
 namespace env{
@@ -66,6 +68,8 @@ void Stack::pop(int n)
     {
         if (size() == 0)
             throw env_exception("EVM::Stack::pop(): stack is empty");
+        if (_journal_enabled)
+            _journal.push_back(UndoOp{UndoOp::Type::POP, 0, _stack.back()});
         _stack.pop_back();
     }
 }
@@ -73,13 +77,51 @@ void Stack::pop(int n)
 void Stack::set(const Value& value, int pos)
 {
     int idx = _pos_to_idx(pos);
+    if (_journal_enabled)
+        _journal.push_back(UndoOp{UndoOp::Type::SET, idx, _stack[idx]});
     _stack[idx] = value;
 }
 void Stack::push(const Value& value)
 {
+    if (_journal_enabled)
+        _journal.push_back(UndoOp{UndoOp::Type::PUSH, 0, Value()});
     _stack.push_back(value);
 }
 
+size_t Stack::journal_mark()
+{
+    _journal_enabled = true;
+    return _journal.size();
+}
+
+void Stack::rewind(size_t mark)
+{
+    // Undo modifications in reverse order
+    while (_journal.size() > mark)
+    {
+        UndoOp& undo = _journal.back();
+        switch (undo.type)
+        {
+            case UndoOp::Type::PUSH:
+                _stack.pop_back();
+                break;
+            case UndoOp::Type::POP:
+                _stack.push_back(undo.prev_value);
+                break;
+            case UndoOp::Type::SET:
+                _stack[undo.idx] = undo.prev_value;
+                break;
+        }
+        _journal.pop_back();
+    }
+}
+
+void Stack::clear_journal()
+{
+    _journal.clear();
+    _journal_enabled = false;
+}
+
 serial::uid_t Stack::class_uid() const
 {
     return serial::ClassId::EVM_STACK;
@@ -88,11 +130,24 @@ serial::uid_t Stack::class_uid() const
 void Stack::dump(serial::Serializer& s) const
 {
     s << _stack;
+    // Journal
+    s << bits(_journal_enabled) << bits(_journal.size());
+    for (const auto& undo : _journal)
+        s << bits(undo.type) << bits(undo.idx) << undo.prev_value;
 }
 
 void Stack::load(serial::Deserializer& d)
 {
-   d >> _stack;
+    size_t tmp_size;
+    d >> _stack;
+    // Journal
+    d >> bits(_journal_enabled) >> bits(tmp_size);
+    _journal.clear();
+    for (size_t i = 0; i < tmp_size; i++)
+    {
+        UndoOp& undo = _journal.emplace_back();
+        d >> bits(undo.type) >> bits(undo.idx) >> undo.prev_value;
+    }
 }
 
 std::ostream& operator<<(std::ostream& os, const Stack& stack)
@@ -104,7 +159,8 @@ std::ostream& operator<<(std::ostream& os, const Stack& stack)
 }
 
 Memory::Memory(std::shared_ptr<VarContext> ctx)
-:_size(0), _limit(0), _alloc_size(0x1000), _mem(ctx, 64, nullptr, Endian::BIG), _varctx(ctx)
+:_size(0), _limit(0), _alloc_size(0x1000), _mem(ctx, 64, nullptr, Endian::BIG),
+ _journal_enabled(false), _varctx(ctx)
 {};
 
 MemEngine& Memory::mem()
@@ -125,7 +181,7 @@ Value Memory::read(const Value& addr, size_t nb_bytes)
 
 void Memory::write(const Value& addr, const Value& val)
 {
-    expand_if_needed(addr, val.size()/8);
+    prepare_write(addr, val.size()/8);
     _mem.write(addr, val);
 }
 
@@ -186,6 +242,39 @@ void Memory::expand_if_needed(const Value& addr, size_t nb_bytes)
     }
 }
 
+void Memory::prepare_write(const Value& addr, size_t nb_bytes)
+{
+    expand_if_needed(addr, nb_bytes);
+    if (not _journal_enabled or nb_bytes == 0)
+        return;
+    // expand_if_needed() rejects symbolic addresses
+    addr_t a = addr.as_uint(*_varctx);
+    _journal.push_back(UndoWrite{a, _mem.read(a, nb_bytes)});
+}
+
+size_t Memory::journal_mark()
+{
+    _journal_enabled = true;
+    return _journal.size();
+}
+
+void Memory::rewind(size_t mark)
+{
+    // Undo writes in reverse order
+    while (_journal.size() > mark)
+    {
+        UndoWrite& undo = _journal.back();
+        _mem.write(undo.addr, undo.prev_value, nullptr, true);
+        _journal.pop_back();
+    }
+}
+
+void Memory::clear_journal()
+{
+    _journal.clear();
+    _journal_enabled = false;
+}
+
 serial::uid_t Memory::class_uid() const
 {
     return serial::ClassId::EVM_MEMORY;
@@ -194,22 +283,181 @@ serial::uid_t Memory::class_uid() const
 void Memory::dump(serial::Serializer& s) const
 {
     s << _mem << bits(_size) << bits(_limit) << bits(_alloc_size) << _varctx;
+    // Journal
+    s << bits(_journal_enabled) << bits(_journal.size());
+    for (const auto& undo : _journal)
+        s << bits(undo.addr) << undo.prev_value;
 }
 
 void Memory::load(serial::Deserializer& d)
 {
-   d >> _mem >> bits(_size) >> bits(_limit) >> bits(_alloc_size) >> _varctx;
+    size_t tmp_size;
+    d >> _mem >> bits(_size) >> bits(_limit) >> bits(_alloc_size) >> _varctx;
+    // Journal
+    d >> bits(_journal_enabled) >> bits(tmp_size);
+    _journal.clear();
+    for (size_t i = 0; i < tmp_size; i++)
+    {
+        UndoWrite& undo = _journal.emplace_back();
+        d >> bits(undo.addr) >> undo.prev_value;
+    }
 }
 
 
 Storage::Storage(std::shared_ptr<VarContext> ctx)
-: _varctx(ctx), _has_symbolic_addresses(false)
+: _varctx(ctx), _has_symbolic_addresses(false), _index_dirty(false), _journal_enabled(false)
 {};
 
 
 
-Value Storage::read(const Value& addr)
+// Return true if 'val' doesn't contain symbolic variables
+static bool _is_constant(const Value& val)
+{
+    return not val.is_abstract() or val.as_expr()->var_ids().empty();
+}
+
+// Return bits 'high' to 'low' of 'e', looking through concatenations
+static Expr _extract_through_concat(Expr e, size_t high, size_t low)
+{
+    while (e->is_type(ExprType::CONCAT))
+    {
+        size_t low_size = e->args[1]->size;
+        if (high < low_size)
+            e = e->args[1];
+        else if (low >= low_size)
+        {
+            e = e->args[0];
+            high -= low_size;
+            low -= low_size;
+        }
+        else
+            break;
+    }
+    if (low == 0 and high == e->size-1)
+        return e;
+    return extract(e, high, low);
+}
+
+/* Decompose a storage address of the form 'hash + offset', where 'hash' is
+ * a symbolic KECCAK result, which is how mappings and dynamic arrays are
+ * laid out in storage. Return false if the address doesn't have this form */
+static bool _decompose_hash_address(
+    const Value& addr,
+    const KeccakHelper& keccak,
+    std::string& hash_name,
+    Number& offset
+)
+{
+    if (not addr.is_abstract())
+        return false;
+    Expr e = addr.as_expr();
+    Expr hash;
+    offset = Number(addr.size(), 0);
+    if (e->is_type(ExprType::VAR))
+        hash = e;
+    else if (e->is_type(ExprType::BINOP, Op::ADD))
+    {
+        for (int i = 0; i < 2; i++)
+        {
+            if (e->args[i]->is_type(ExprType::VAR) and e->args[1-i]->is_type(ExprType::CST))
+            {
+                hash = e->args[i];
+                offset = e->args[1-i]->as_number();
+            }
+        }
+    }
+    if (hash == nullptr or not keccak.get_preimage(hash->name()).has_value())
+        return false;
+    hash_name = hash->name();
+    return true;
+}
+
+/* Return true if two hash pre-images are provably different, i.e. they have
+ * different sizes or one of their 256-bit words is constant in both and differs */
+static bool _provably_different_preimages(const Value& p1, const Value& p2)
+{
+    if (p1.size() != p2.size())
+        return true;
+    Expr e1 = p1.as_expr(), e2 = p2.as_expr();
+    for (size_t low = 0; low < p1.size(); low += 256)
+    {
+        size_t high = std::min(low + 256, p1.size()) - 1;
+        Expr w1 = _extract_through_concat(e1, high, low);
+        Expr w2 = _extract_through_concat(e2, high, low);
+        if (
+            w1->var_ids().empty() and w2->var_ids().empty()
+            and not w1->as_number().equal_to(w2->as_number())
+        )
+            return true;
+    }
+    return false;
+}
+
+/* Return true if storage addresses 'a1' and 'a2' can't be equal. Hashes of
+ * different pre-images are assumed to never collide, like the Solidity
+ * storage layout does */
+static bool _storage_addresses_differ(const Value& a1, const Value& a2, const KeccakHelper* keccak)
+{
+    if (_is_constant(a1) and _is_constant(a2))
+        return not a1.as_number().equal_to(a2.as_number());
+    if (keccak == nullptr)
+        return false;
+    std::string h1, h2;
+    Number off1, off2;
+    if (
+        not _decompose_hash_address(a1, *keccak, h1, off1)
+        or not _decompose_hash_address(a2, *keccak, h2, off2)
+    )
+        return false;
+    if (h1 == h2)
+        return not off1.equal_to(off2);
+    return _provably_different_preimages(
+        *keccak->get_preimage(h1),
+        *keccak->get_preimage(h2)
+    );
+}
+
+void Storage::_update_index()
+{
+    if (not _index_dirty)
+        return;
+    _last_write_idx.clear();
+    _abstract_writes.clear();
+    for (size_t i = 0; i < writes_history.size(); i++)
+    {
+        const Value& addr = writes_history[i].first;
+        _last_write_idx[addr] = i;
+        if (addr.is_abstract())
+            _abstract_writes.push_back(i);
+    }
+    _index_dirty = false;
+}
+
+void Storage::_record_history(const Value& addr, const Value& val)
+{
+    writes_history.push_back(std::make_pair(addr, val));
+    if (_index_dirty)
+        return;
+    size_t idx = writes_history.size()-1;
+    _last_write_idx[addr] = idx;
+    if (addr.is_abstract())
+        _abstract_writes.push_back(idx);
+}
+
+// Apply previous write 'history_idx' to the value 'res' read at 'addr'
+void Storage::_apply_write(Value& res, const Value& addr, size_t history_idx, const KeccakHelper* keccak) const
+{
+    const Value& prev_addr = writes_history[history_idx].first;
+    const Value& prev_val = writes_history[history_idx].second;
+    if (_storage_addresses_differ(prev_addr, addr, keccak))
+        return;
+    res.set_ITE(prev_addr, ITECond::EQ, addr, prev_val, res);
+}
+
+Value Storage::read(const Value& addr, const KeccakHelper* keccak)
 {
+    _update_index();
+
     // First see if we have an address that matches
     auto base = _storage.find(addr);
     Value res;
@@ -217,39 +465,36 @@ Value Storage::read(const Value& addr)
         res = Value(256, 0);
     else
         res = base->second;
-    
-    auto cmp = [](const Number& a, const Number& b) { return a.less_than(b);};
-    std::set<Number, decltype(cmp)> seen_concrete_addresses(cmp);
 
-    // Then apply potential previous symbolic writes
-    for (auto it = writes_history.rbegin(); it != writes_history.rend(); it++)
-    {
-        const Value& prev_addr = it->first;
-        const Value& prev_val = it->second;
-        // If write address is same as 'addr', don't need to go further
-        if (prev_addr.eq(addr))
-            break;
+    // Only writes that happened after the last write to 'addr' can
+    // overwrite its value
+    size_t start = 0;
+    auto last = _last_write_idx.find(addr);
+    if (last != _last_write_idx.end())
+        start = last->second + 1;
 
-        // If write address is concrete and was already seen, don't 
-        // take older writes into account
-        if (not prev_addr.is_abstract())
+    // Then apply potential later writes, from the oldest to the most recent
+    // so that the most recent write takes precedence
+    if (not addr.is_abstract())
+    {
+        // Concrete address, only writes to abstract addresses can alias it
+        for (
+            auto it = std::lower_bound(_abstract_writes.begin(), _abstract_writes.end(), start);
+            it != _abstract_writes.end();
+            it++
+        )
+            _apply_write(res, addr, *it, keccak);
+    }
+    else
+    {
+        for (size_t i = start; i < writes_history.size(); i++)
         {
-            if (seen_concrete_addresses.count(prev_addr.as_number(*_varctx)) > 0)
+            const Value& prev_addr = writes_history[i].first;
+            // Older writes to a concrete address are overwritten by the last one
+            if (not prev_addr.is_abstract() and _last_write_idx[prev_addr] != i)
                 continue;
-            else
-                seen_concrete_addresses.insert(prev_addr.as_number(*_varctx));
+            _apply_write(res, addr, i, keccak);
         }
-
-        // If both addresses are concrete and different, skip this one
-        if (
-            not prev_addr.is_abstract() and
-            not addr.is_abstract() and
-            not prev_addr.as_number(*_varctx).equal_to(addr.as_number(*_varctx))            
-        )
-            continue;
-
-        // Else add ITE clause
-        res.set_ITE(prev_addr, ITECond::EQ, addr, prev_val, res);
     }
 
     return res;
@@ -263,21 +508,68 @@ void Storage::write(const Value& addr, const Value& val, const Settings& setting
     {
         // Concrete or concolic without symptr enabled
         Value concrete_addr(addr.as_number(*_varctx));
+        _record_undo(concrete_addr);
         _storage[concrete_addr] = val;
         // We only care recording concrete address writes when there are
         // already symbolic writes that could be overwritten
         if (_has_symbolic_addresses)
-            writes_history.push_back(std::make_pair(concrete_addr, val));
+            _record_history(concrete_addr, val);
     }
     else
     {
         // Concolic or symbolic, with symptr enabled
+        _record_undo(addr);
         _storage[addr] = val;
-        writes_history.push_back(std::make_pair(addr, val));
+        _record_history(addr, val);
         _has_symbolic_addresses = true;
     }
 }
 
+void Storage::_record_undo(const Value& addr)
+{
+    if (not _journal_enabled)
+        return;
+    UndoWrite& undo = _journal.emplace_back();
+    undo.addr = addr;
+    auto prev = _storage.find(addr);
+    if (prev != _storage.end())
+        undo.prev_value = prev->second;
+    undo.history_size = writes_history.size();
+    undo.had_symbolic_addresses = _has_symbolic_addresses;
+}
+
+size_t Storage::journal_mark()
+{
+    _journal_enabled = true;
+    return _journal.size();
+}
+
+void Storage::rewind(size_t mark)
+{
+    // Undo writes in reverse order
+    while (_journal.size() > mark)
+    {
+        UndoWrite& undo = _journal.back();
+        if (undo.prev_value.has_value())
+            _storage[undo.addr] = *undo.prev_value;
+        else
+            _storage.erase(undo.addr);
+        writes_history.erase(
+            writes_history.begin() + undo.history_size,
+            writes_history.end()
+        );
+        _has_symbolic_addresses = undo.had_symbolic_addresses;
+        _index_dirty = true;
+        _journal.pop_back();
+    }
+}
+
+void Storage::clear_journal()
+{
+    _journal.clear();
+    _journal_enabled = false;
+}
+
 Storage::const_iterator Storage::begin() const
 {
     return _storage.begin();
@@ -301,20 +593,39 @@ void Storage::dump(serial::Serializer& s) const
     s << bits(tmp_size);
     for (const auto& p : writes_history)
         s << p.first << p.second;
+    // Journal
+    s << bits(_journal_enabled);
+    tmp_size = _journal.size();
+    s << bits(tmp_size);
+    for (const auto& undo : _journal)
+    {
+        s   << undo.addr << undo.prev_value << bits(undo.history_size)
+            << bits(undo.had_symbolic_addresses);
+    }
 }
 
 void Storage::load(serial::Deserializer& d)
 {
     d >> _storage >> _varctx >> bits(_has_symbolic_addresses);
+    _index_dirty = true;
     // History
     size_t tmp_size;
     d >> bits(tmp_size);
-    for (int i = 0; i < tmp_size; i++)
+    for (size_t i = 0; i < tmp_size; i++)
     {
         Value v1, v2;
         d >> v1 >> v2;
         writes_history.push_back(std::make_pair(v1, v2));
     }
+    // Journal
+    d >> bits(_journal_enabled) >> bits(tmp_size);
+    _journal.clear();
+    for (size_t i = 0; i < tmp_size; i++)
+    {
+        UndoWrite& undo = _journal.emplace_back();
+        d   >> undo.addr >> undo.prev_value >> bits(undo.history_size)
+            >> bits(undo.had_symbolic_addresses);
+    }
 }
 
 
@@ -568,6 +879,46 @@ void Contract::fork_from(const Contract& other)
     balance = Value(256, 0);
 }
 
+Contract::Mark Contract::journal_mark()
+{
+    Mark mark;
+    mark.balance = balance;
+    mark.address = address;
+    mark.stack_mark = stack.journal_mark();
+    mark.memory_mark = memory.journal_mark();
+    mark.memory_size = memory._size;
+    mark.storage = storage;
+    mark.transaction = transaction;
+    mark.outgoing_transaction = outgoing_transaction;
+    mark.result_from_last_call = result_from_last_call;
+    mark.consumed_gas = consumed_gas;
+    mark.code_size = code_size;
+    return mark;
+}
+
+void Contract::rewind(const Mark& mark)
+{
+    balance = mark.balance;
+    address = mark.address;
+    stack.rewind(mark.stack_mark);
+    memory.rewind(mark.memory_mark);
+    // Memory pages allocated after the mark are kept, the journal restored
+    // their content to zero
+    memory._size = mark.memory_size;
+    storage = mark.storage;
+    transaction = mark.transaction;
+    outgoing_transaction = mark.outgoing_transaction;
+    result_from_last_call = mark.result_from_last_call;
+    consumed_gas = mark.consumed_gas;
+    code_size = mark.code_size;
+}
+
+void Contract::clear_journal()
+{
+    stack.clear_journal();
+    memory.clear_journal();
+}
+
 serial::uid_t Contract::class_uid() const
 {
     return serial::ClassId::EVM_CONTRACT;
@@ -624,7 +975,7 @@ void _append_EVM_code(MaatEngine& engine, const std::vector<Value>& code)
 }
 
 KeccakHelper::KeccakHelper()
-: _symbolic_hash_prefix("keccak_hash"), allow_symbolic_hashes(true)
+: _symbolic_hash_prefix("keccak_hash"), _journal_enabled(false), allow_symbolic_hashes(true)
 {}
 
 const std::string& KeccakHelper::symbolic_hash_prefix() const 
@@ -632,10 +983,64 @@ const std::string& KeccakHelper::symbolic_hash_prefix() const
     return _symbolic_hash_prefix;
 }
 
+std::optional<Value> KeccakHelper::get_preimage(const std::string& hash_name) const
+{
+    auto it = _preimages.find(hash_name);
+    if (it == _preimages.end())
+        return std::nullopt;
+    return it->second;
+}
+
+size_t KeccakHelper::journal_mark()
+{
+    _journal_enabled = true;
+    return _journal.size();
+}
+
+void KeccakHelper::rewind(size_t mark)
+{
+    // Forget hashes in reverse order
+    while (_journal.size() > mark)
+    {
+        UndoInsert& undo = _journal.back();
+        known_hashes.erase(undo.hash_input);
+        if (not undo.preimage.empty())
+            _preimages.erase(undo.preimage);
+        _journal.pop_back();
+    }
+}
+
+void KeccakHelper::clear_journal()
+{
+    _journal.clear();
+    _journal_enabled = false;
+}
+
+void KeccakHelper::_record_insert(const Value& hash_input, const std::string& preimage)
+{
+    if (_journal_enabled)
+        _journal.push_back(UndoInsert{hash_input, preimage});
+}
+
+std::string KeccakHelper::_new_hash_name(VarContext& ctx) const
+{
+    // Purely symbolic hashes are not set in 'ctx', so also check that
+    // the name isn't already used by a previous hash
+    std::string res = _symbolic_hash_prefix;
+    for (int i = 1; ctx.contains(res) or _preimages.count(res) > 0; i++)
+    {
+        std::stringstream ss;
+        ss << _symbolic_hash_prefix << "(" << std::dec << i << ")";
+        res = ss.str();
+    }
+    return res;
+}
+
 Value KeccakHelper::apply(VarContext& ctx, const Value& val, uint8_t* raw_bytes)
 {
     // Check if the value hash already been hashed
     Value res;
+    std::string preimage;
     auto it = known_hashes.find(val);
     if (it != known_hashes.end())
         return it->second;
@@ -648,9 +1053,15 @@ Value KeccakHelper::apply(VarContext& ctx, const Value& val, uint8_t* raw_bytes)
     {
         Value concrete_hash = _do_keccak256(raw_bytes, val.size()/8);
         Value concrete_value = Value(val.as_number(ctx));
-        res = exprvar(256, ctx.new_name_from(_symbolic_hash_prefix));
+        preimage = _new_hash_name(ctx);
+        res = exprvar(256, preimage);
+        _preimages.emplace(preimage, val);
         // Also record concrete hash mapping
-        known_hashes[concrete_value] = concrete_hash;
+        if (known_hashes.count(concrete_value) == 0)
+        {
+            known_hashes[concrete_value] = concrete_hash;
+            _record_insert(concrete_value);
+        }
         // Set concrete hash result in varctx
         ctx.set(res.as_expr()->name(), concrete_hash.as_number());
     }
@@ -658,9 +1069,12 @@ Value KeccakHelper::apply(VarContext& ctx, const Value& val, uint8_t* raw_bytes)
     {
         if (not allow_symbolic_hashes)
             throw env_exception("KeccakHelper::apply(): got symbolic value but symbolic hashes are disabled");
-        res = exprvar(256, ctx.new_name_from(_symbolic_hash_prefix));
+        preimage = _new_hash_name(ctx);
+        res = exprvar(256, preimage);
+        _preimages.emplace(preimage, val);
     }
     known_hashes[val] = res;
+    _record_insert(val, preimage);
     return res;
 }
 
@@ -671,12 +1085,25 @@ serial::uid_t KeccakHelper::class_uid() const
 
 void KeccakHelper::dump(serial::Serializer& s) const
 {
-    s << bits(allow_symbolic_hashes) << _symbolic_hash_prefix << known_hashes;
+    s << bits(allow_symbolic_hashes) << _symbolic_hash_prefix << known_hashes << _preimages;
+    // Journal
+    s << bits(_journal_enabled) << bits(_journal.size());
+    for (const auto& undo : _journal)
+        s << undo.hash_input << undo.preimage;
 }
 
 void KeccakHelper::load(serial::Deserializer& d)
 {
-    d >> bits(allow_symbolic_hashes) >> _symbolic_hash_prefix >> known_hashes;
+    size_t tmp_size;
+    d >> bits(allow_symbolic_hashes) >> _symbolic_hash_prefix >> known_hashes >> _preimages;
+    // Journal
+    d >> bits(_journal_enabled) >> bits(tmp_size);
+    _journal.clear();
+    for (size_t i = 0; i < tmp_size; i++)
+    {
+        UndoInsert& undo = _journal.emplace_back();
+        d >> undo.hash_input >> undo.preimage;
+    }
 }
 
 Value _do_keccak256(uint8_t* in, int size)
@@ -713,7 +1140,11 @@ EthereumEmulator& EthereumEmulator::operator=(const EthereumEmulator& other)
     current_block_timestamp = other.current_block_timestamp;
     static_flag = other.static_flag;
     gas_price = other.gas_price;
-    // We don't copy snapshots !!!
+    // We don't copy snapshots !!! So don't keep the journals of the copied
+    // runtimes either. Storages are shared with 'other' and keep theirs
+    for (const auto& [uid, contract] : _contracts)
+        contract->clear_journal();
+    keccak_helper.clear_journal();
     return *this;
 }
 
@@ -810,7 +1241,7 @@ void EthereumEmulator::load(serial::Deserializer& d)
     // Contracts
     size_t tmp_size;
     d >> bits(tmp_size);
-    for (int i = 0; i < tmp_size; i++)
+    for (size_t i = 0; i < tmp_size; i++)
     {
         contract_t contract;
         int uid;
@@ -819,22 +1250,141 @@ void EthereumEmulator::load(serial::Deserializer& d)
     }
 }
 
+serial::uid_t EthereumEmulator::Snapshot::class_uid() const
+{
+    return serial::ClassId::EVM_SNAPSHOT;
+}
+
+void EthereumEmulator::Snapshot::dump(serial::Serializer& s) const
+{
+    s   << bits(uid_cnt) << current_block_number << current_block_timestamp
+        << bits(static_flag) << gas_price << bits(allow_symbolic_hashes)
+        << bits(keccak_mark);
+    s << bits(storage_marks.size());
+    for (const auto& [storage, mark] : storage_marks)
+        s << storage << bits(mark);
+    s << bits(contract_marks.size());
+    for (const auto& [uid, mark] : contract_marks)
+    {
+        s   << bits(uid) << mark.balance << mark.address << bits(mark.stack_mark)
+            << bits(mark.memory_mark) << bits(mark.memory_size) << mark.storage
+            << mark.transaction << mark.outgoing_transaction
+            << mark.result_from_last_call << mark.consumed_gas
+            << bits(mark.code_size);
+    }
+}
+
+void EthereumEmulator::Snapshot::load(serial::Deserializer& d)
+{
+    size_t tmp_size;
+    d   >> bits(uid_cnt) >> current_block_number >> current_block_timestamp
+        >> bits(static_flag) >> gas_price >> bits(allow_symbolic_hashes)
+        >> bits(keccak_mark);
+    d >> bits(tmp_size);
+    storage_marks.clear();
+    for (size_t i = 0; i < tmp_size; i++)
+    {
+        auto& [storage, mark] = storage_marks.emplace_back();
+        d >> storage >> bits(mark);
+    }
+    d >> bits(tmp_size);
+    contract_marks.clear();
+    for (size_t i = 0; i < tmp_size; i++)
+    {
+        auto& [uid, mark] = contract_marks.emplace_back();
+        d   >> bits(uid) >> mark.balance >> mark.address >> bits(mark.stack_mark)
+            >> bits(mark.memory_mark) >> bits(mark.memory_size) >> mark.storage
+            >> mark.transaction >> mark.outgoing_transaction
+            >> mark.result_from_last_call >> mark.consumed_gas
+            >> bits(mark.code_size);
+    }
+}
+
 EnvEmulator::snapshot_t EthereumEmulator::take_snapshot()
 {
-    _snapshots.push_back(
-        std::make_shared<EthereumEmulator>(*this)
-    );
+    Snapshot& snapshot = _snapshots.emplace_back();
+    snapshot.uid_cnt = _uid_cnt;
+    snapshot.current_block_number = current_block_number;
+    snapshot.current_block_timestamp = current_block_timestamp;
+    snapshot.static_flag = static_flag;
+    snapshot.gas_price = gas_price;
+    snapshot.allow_symbolic_hashes = keccak_helper.allow_symbolic_hashes;
+    snapshot.keccak_mark = keccak_helper.journal_mark();
+    // Only record the state of runtimes and the journal position of
+    // storages, which can be shared between runtimes
+    std::unordered_set<Storage*> seen;
+    for (const auto& [uid, contract] : _contracts)
+    {
+        snapshot.contract_marks.push_back(
+            std::make_pair(uid, contract->journal_mark())
+        );
+        if (contract->storage == nullptr or not seen.insert(contract->storage.get()).second)
+            continue;
+        snapshot.storage_marks.push_back(
+            std::make_pair(contract->storage, contract->storage->journal_mark())
+        );
+    }
     return _snapshots.size()-1;
 }
 
+void EthereumEmulator::_restore_last_snapshot()
+{
+    Snapshot& snapshot = _snapshots.back();
+
+    // Undo storage writes
+    for (const auto& [storage, mark] : snapshot.storage_marks)
+        storage->rewind(mark);
+
+    // Remove contracts created after the snapshot
+    for (auto it = _contracts.begin(); it != _contracts.end(); )
+    {
+        if (it->first >= snapshot.uid_cnt)
+            it = _contracts.erase(it);
+        else
+            it++;
+    }
+
+    // Restore runtimes in place, so that references to them stay valid
+    for (const auto& [uid, mark] : snapshot.contract_marks)
+        get_contract_by_uid(uid)->rewind(mark);
+
+    keccak_helper.rewind(snapshot.keccak_mark);
+    keccak_helper.allow_symbolic_hashes = snapshot.allow_symbolic_hashes;
+    current_block_number = snapshot.current_block_number;
+    current_block_timestamp = snapshot.current_block_timestamp;
+    static_flag = snapshot.static_flag;
+    gas_price = snapshot.gas_price;
+}
+
+void EthereumEmulator::_clear_journals()
+{
+    for (const auto& [uid, contract] : _contracts)
+    {
+        contract->clear_journal();
+        if (contract->storage != nullptr)
+            contract->storage->clear_journal();
+    }
+    keccak_helper.clear_journal();
+}
+
 void EthereumEmulator::restore_snapshot(snapshot_t snapshot, bool remove)
 {
-    while (snapshot+1 < _snapshots.size())
-        _snapshots.pop_back();
+    if (snapshot < 0 or (size_t)snapshot >= _snapshots.size())
+        throw snapshot_exception("EthereumEmulator::restore_snapshot(): called with invalid snapshot parameter!");
 
-    *this = std::move(*_snapshots.back());
+    // Rewind and delete more recent snapshots
+    while ((size_t)snapshot+1 < _snapshots.size())
+    {
+        _restore_last_snapshot();
+        _snapshots.pop_back();
+    }
+    _restore_last_snapshot();
     if (remove)
         _snapshots.pop_back();
+
+    // No need to keep journals if there are no more snapshots
+    if (_snapshots.empty())
+        _clear_journals();
 }
 
 
@@ -878,7 +1428,7 @@ void new_evm_runtime(
 std::vector<uint8_t> hex_string_to_bytes(const std::vector<char>& in)
 {
     std::vector<uint8_t> res;
-    for(int i = 0; i < in.size(); i+=2)
+    for(size_t i = 0; i < in.size(); i+=2)
     {
         uint8_t val = std::stoul(std::string(in.data()+i, 2), nullptr, 16);
         res.push_back(val);
@@ -0,0 +1,430 @@
+#include "maat/batch_eval.hpp"
+#include "maat/exception.hpp"
+
+namespace maat
+{
+
+// Values are stored like in Number: sign-extended from their size to 64 bits
+static inline ucst_t sext(ucst_t val, size_t size)
+{
+    unsigned int shift = 64 - size;
+    return (ucst_t)((cst_t)(val << shift) >> shift);
+}
+
+static inline ucst_t size_mask(size_t size)
+{
+    return size == 64 ? 0xffffffffffffffff : (((ucst_t)1 << size) - 1);
+}
+
+BatchEvaluator::BatchEvaluator(): _nb_slots(0), _nb_lanes(0) {}
+
+BatchEvaluator::slot_t BatchEvaluator::_emit(
+    Opcode op,
+    size_t size,
+    std::initializer_list<slot_t> in,
+    ucst_t param,
+    ExprObject* expr
+){
+    Instr instr{op, size, _nb_slots++, {0, 0, 0, 0}, param, expr};
+    int i = 0;
+    for (slot_t s : in)
+        instr.in[i++] = s;
+    _tape.push_back(instr);
+    return instr.out;
+}
+
+std::optional<BatchEvaluator::slot_t> BatchEvaluator::_compile(const Expr& e)
+{
+    auto it = _slots.find(e.get());
+    if (it != _slots.end())
+        return it->second;
+
+    // Wider values can't be stored on the tape, the parent expression
+    // will be evaluated with a fallback
+    if (e->size > 64)
+        return std::nullopt;
+
+    std::optional<slot_t> res;
+    switch (e->type)
+    {
+        case ExprType::CST:
+            res = _emit(Opcode::CST, e->size, {}, sext(e->as_number().get_cst(), e->size));
+            break;
+        case ExprType::VAR:
+            res = _emit(Opcode::VAR, e->size, {}, std::static_pointer_cast<ExprVar>(e)->id());
+            break;
+        case ExprType::UNOP:
+        {
+            std::optional<slot_t> arg = _compile(e->args[0]);
+            if (not arg.has_value())
+                break;
+            if (e->op() == Op::NEG)
+                res = _emit(Opcode::NEG, e->size, {*arg});
+            else if (e->op() == Op::NOT)
+                res = _emit(Opcode::NOT, e->size, {*arg});
+            break;
+        }
+        case ExprType::BINOP:
+        {
+            Opcode op;
+            switch (e->op())
+            {
+                case Op::ADD: op = Opcode::ADD; break;
+                case Op::MUL: op = Opcode::MUL; break;
+                case Op::DIV: op = Opcode::DIV; break;
+                case Op::SDIV: op = Opcode::SDIV; break;
+                case Op::MOD: op = Opcode::MOD; break;
+                case Op::SMOD: op = Opcode::SMOD; break;
+                case Op::AND: op = Opcode::AND; break;
+                case Op::OR: op = Opcode::OR; break;
+                case Op::XOR: op = Opcode::XOR; break;
+                case Op::SHL: op = Opcode::SHL; break;
+                case Op::SHR: op = Opcode::SHR; break;
+                case Op::SAR: op = Opcode::SAR; break;
+                default: op = Opcode::FALLBACK; break;
+            }
+            if (op == Opcode::FALLBACK)
+                break;
+            std::optional<slot_t> left = _compile(e->args[0]);
+            std::optional<slot_t> right = _compile(e->args[1]);
+            if (left.has_value() and right.has_value())
+                res = _emit(op, e->size, {*left, *right});
+            break;
+        }
+        case ExprType::EXTRACT:
+        {
+            if (not e->args[2]->is_type(ExprType::CST))
+                break;
+            std::optional<slot_t> arg = _compile(e->args[0]);
+            if (arg.has_value())
+                res = _emit(Opcode::EXTRACT, e->size, {*arg}, e->args[2]->cst());
+            break;
+        }
+        case ExprType::CONCAT:
+        {
+            std::optional<slot_t> high = _compile(e->args[0]);
+            std::optional<slot_t> low = _compile(e->args[1]);
+            if (high.has_value() and low.has_value())
+                res = _emit(Opcode::CONCAT, e->size, {*high, *low}, e->args[1]->size);
+            break;
+        }
+        case ExprType::ITE:
+        {
+            ITECond cond = e->cond_op();
+            if (cond == ITECond::FEQ or cond == ITECond::FLT or cond == ITECond::FLE)
+                break;
+            std::optional<slot_t> in[4];
+            bool ok = true;
+            for (int i = 0; i < 4; i++)
+            {
+                in[i] = _compile(e->args[i]);
+                ok = ok and in[i].has_value();
+            }
+            if (ok)
+                res = _emit(Opcode::ITE, e->size, {*in[0], *in[1], *in[2], *in[3]}, (ucst_t)cond);
+            break;
+        }
+        default:
+            break;
+    }
+
+    if (not res.has_value())
+        res = _emit(Opcode::FALLBACK, e->size, {}, 0, e.get());
+    _slots[e.get()] = *res;
+    _exprs.push_back(e);
+    return res;
+}
+
+BatchEvaluator::slot_t BatchEvaluator::_compile(const Constraint& c)
+{
+    if (c->type == ConstraintType::AND or c->type == ConstraintType::OR)
+    {
+        slot_t left = _compile(c->left_constr);
+        slot_t right = _compile(c->right_constr);
+        return _emit(
+            c->type == ConstraintType::AND ? Opcode::LAND : Opcode::LOR,
+            1, {left, right}
+        );
+    }
+
+    std::optional<slot_t> left = _compile(c->left_expr);
+    std::optional<slot_t> right = _compile(c->right_expr);
+    if (not left.has_value() or not right.has_value())
+    {
+        throw expression_exception(
+            "BatchEvaluator: constraints on expressions bigger than 64 bits are not supported"
+        );
+    }
+    Opcode op;
+    switch (c->type)
+    {
+        case ConstraintType::EQ: op = Opcode::EQ; break;
+        case ConstraintType::NEQ: op = Opcode::NEQ; break;
+        case ConstraintType::LE: op = Opcode::SLE; break;
+        case ConstraintType::LT: op = Opcode::SLT; break;
+        case ConstraintType::ULE: op = Opcode::LE; break;
+        case ConstraintType::ULT: op = Opcode::LT; break;
+        default:
+            throw runtime_exception("BatchEvaluator: got unknown constraint type");
+    }
+    return _emit(op, 1, {*left, *right});
+}
+
+size_t BatchEvaluator::add(const Expr& e)
+{
+    std::optional<slot_t> slot = _compile(e);
+    if (not slot.has_value())
+    {
+        throw expression_exception(
+            Fmt() << "BatchEvaluator::add(): can not evaluate expression on "
+            << std::dec << e->size << " bits (maximum is 64)"
+            >> Fmt::to_str
+        );
+    }
+    _outputs.push_back(std::make_pair(*slot, e->size));
+    return _outputs.size()-1;
+}
+
+size_t BatchEvaluator::add(const Constraint& c)
+{
+    _outputs.push_back(std::make_pair(_compile(c), 1));
+    _constraint_outputs.push_back(_outputs.size()-1);
+    return _outputs.size()-1;
+}
+
+void BatchEvaluator::evaluate(const std::vector<VarContext>& ctxs)
+{
+    _nb_lanes = ctxs.size();
+    _lanes.resize((size_t)_nb_slots * _nb_lanes);
+    for (const Instr& instr : _tape)
+        _execute(instr, ctxs);
+}
+
+void BatchEvaluator::_execute(const Instr& instr, const std::vector<VarContext>& ctxs)
+{
+    const size_t n = _nb_lanes;
+    const size_t size = instr.size;
+    ucst_t* out = _lanes.data() + (size_t)instr.out*n;
+    const ucst_t* a = _lanes.data() + (size_t)instr.in[0]*n;
+    const ucst_t* b = _lanes.data() + (size_t)instr.in[1]*n;
+    const ucst_t mask = size_mask(size);
+
+    // Loops below are written so that the compiler can vectorize them
+    switch (instr.op)
+    {
+        case Opcode::CST:
+            for (size_t i = 0; i < n; i++)
+                out[i] = instr.param;
+            break;
+        case Opcode::VAR:
+            for (size_t i = 0; i < n; i++)
+            {
+                try
+                {
+                    out[i] = sext(ctxs[i].get_as_number((var_id_t)instr.param).get_cst(), size);
+                }
+                catch (const var_context_exception& e)
+                {
+                    throw expression_exception(
+                        Fmt() << "Concretization error: " << e.what() >> Fmt::to_str
+                    );
+                }
+            }
+            break;
+        case Opcode::FALLBACK:
+            for (size_t i = 0; i < n; i++)
+                out[i] = sext(instr.expr->as_number(ctxs[i]).get_cst(), size);
+            break;
+        case Opcode::NEG:
+            for (size_t i = 0; i < n; i++)
+                out[i] = sext(-a[i], size);
+            break;
+        case Opcode::NOT:
+            for (size_t i = 0; i < n; i++)
+                out[i] = ~a[i];
+            break;
+        case Opcode::ADD:
+            for (size_t i = 0; i < n; i++)
+                out[i] = sext(a[i] + b[i], size);
+            break;
+        case Opcode::MUL:
+            for (size_t i = 0; i < n; i++)
+                out[i] = sext(a[i] * b[i], size);
+            break;
+        case Opcode::AND:
+            for (size_t i = 0; i < n; i++)
+                out[i] = a[i] & b[i];
+            break;
+        case Opcode::OR:
+            for (size_t i = 0; i < n; i++)
+                out[i] = a[i] | b[i];
+            break;
+        case Opcode::XOR:
+            for (size_t i = 0; i < n; i++)
+                out[i] = a[i] ^ b[i];
+            break;
+        case Opcode::DIV:
+            for (size_t i = 0; i < n; i++)
+            {
+                ucst_t d = b[i] & mask;
+                out[i] = d == 0 ? 0xffffffffffffffff : sext((a[i] & mask) / d, size);
+            }
+            break;
+        case Opcode::MOD:
+            for (size_t i = 0; i < n; i++)
+            {
+                ucst_t d = b[i] & mask;
+                out[i] = d == 0 ? a[i] : sext((a[i] & mask) % d, size);
+            }
+            break;
+        case Opcode::SDIV:
+            for (size_t i = 0; i < n; i++)
+            {
+                cst_t x = (cst_t)a[i], d = (cst_t)b[i];
+                if (d == 0)
+                    out[i] = sext(x < 0 ? 1 : 0xffffffffffffffff, size);
+                else if (d == -1)
+                    out[i] = sext(-a[i], size);
+                else
+                    out[i] = sext((ucst_t)(x / d), size);
+            }
+            break;
+        case Opcode::SMOD:
+            for (size_t i = 0; i < n; i++)
+            {
+                cst_t x = (cst_t)a[i], d = (cst_t)b[i];
+                if (d == 0)
+                    out[i] = a[i];
+                else if (d == -1)
+                    out[i] = 0;
+                else
+                    out[i] = sext((ucst_t)(x % d), size);
+            }
+            break;
+        case Opcode::SHL:
+            for (size_t i = 0; i < n; i++)
+            {
+                ucst_t shift = b[i] & mask;
+                out[i] = shift >= size ? 0 : sext(a[i] << shift, size);
+            }
+            break;
+        case Opcode::SHR:
+            for (size_t i = 0; i < n; i++)
+            {
+                ucst_t shift = b[i] & mask;
+                out[i] = shift >= size ? 0 : sext((a[i] & mask) >> shift, size);
+            }
+            break;
+        case Opcode::SAR:
+            for (size_t i = 0; i < n; i++)
+            {
+                ucst_t shift = b[i] & mask;
+                if (shift >= size)
+                    shift = 63;
+                out[i] = (ucst_t)((cst_t)a[i] >> shift);
+            }
+            break;
+        case Opcode::EXTRACT:
+            for (size_t i = 0; i < n; i++)
+                out[i] = sext(a[i] >> instr.param, size);
+            break;
+        case Opcode::CONCAT:
+        {
+            const ucst_t low_mask = size_mask(instr.param);
+            for (size_t i = 0; i < n; i++)
+                out[i] = sext((a[i] << instr.param) | (b[i] & low_mask), size);
+            break;
+        }
+        case Opcode::ITE:
+        {
+            const ucst_t* if_true = _lanes.data() + (size_t)instr.in[2]*n;
+            const ucst_t* if_false = _lanes.data() + (size_t)instr.in[3]*n;
+            for (size_t i = 0; i < n; i++)
+            {
+                bool cond;
+                switch ((ITECond)instr.param)
+                {
+                    case ITECond::EQ: cond = a[i] == b[i]; break;
+                    case ITECond::LT: cond = a[i] < b[i]; break;
+                    case ITECond::LE: cond = a[i] <= b[i]; break;
+                    case ITECond::SLT: cond = (cst_t)a[i] < (cst_t)b[i]; break;
+                    case ITECond::SLE: cond = (cst_t)a[i] <= (cst_t)b[i]; break;
+                    default:
+                        throw runtime_exception("BatchEvaluator: unsupported ITE condition");
+                }
+                out[i] = cond ? if_true[i] : if_false[i];
+            }
+            break;
+        }
+        // Unsigned comparisons work on sign-extended values as long as
+        // both operands have the same size
+        case Opcode::EQ:
+            for (size_t i = 0; i < n; i++)
+                out[i] = a[i] == b[i];
+            break;
+        case Opcode::NEQ:
+            for (size_t i = 0; i < n; i++)
+                out[i] = a[i] != b[i];
+            break;
+        case Opcode::LT:
+            for (size_t i = 0; i < n; i++)
+                out[i] = a[i] < b[i];
+            break;
+        case Opcode::LE:
+            for (size_t i = 0; i < n; i++)
+                out[i] = a[i] <= b[i];
+            break;
+        case Opcode::SLT:
+            for (size_t i = 0; i < n; i++)
+                out[i] = (cst_t)a[i] < (cst_t)b[i];
+            break;
+        case Opcode::SLE:
+            for (size_t i = 0; i < n; i++)
+                out[i] = (cst_t)a[i] <= (cst_t)b[i];
+            break;
+        case Opcode::LAND:
+            for (size_t i = 0; i < n; i++)
+                out[i] = a[i] & b[i];
+            break;
+        case Opcode::LOR:
+            for (size_t i = 0; i < n; i++)
+                out[i] = a[i] | b[i];
+            break;
+        default:
+            throw runtime_exception("BatchEvaluator: got unknown opcode");
+    }
+}
+
+size_t BatchEvaluator::nb_contexts() const
+{
+    return _nb_lanes;
+}
+
+ucst_t BatchEvaluator::get(size_t idx, size_t ctx_idx) const
+{
+    if (idx >= _outputs.size() or ctx_idx >= _nb_lanes)
+    {
+        throw expression_exception(
+            Fmt() << "BatchEvaluator::get(): no value for output " << std::dec << idx
+            << " in context " << ctx_idx
+            >> Fmt::to_str
+        );
+    }
+    const auto& [slot, size] = _outputs[idx];
+    return _lanes[(size_t)slot*_nb_lanes + ctx_idx] & size_mask(size);
+}
+
+std::vector<bool> BatchEvaluator::satisfied() const
+{
+    std::vector<bool> res(_nb_lanes, true);
+    for (size_t idx : _constraint_outputs)
+    {
+        const ucst_t* values = _lanes.data() + (size_t)_outputs[idx].first*_nb_lanes;
+        for (size_t i = 0; i < _nb_lanes; i++)
+            if (values[i] == 0)
+                res[i] = false;
+    }
+    return res;
+}
+
+} // namespace maat
@@ -3,16 +3,17 @@
 #include <iostream>
 #include <set>
 #include <algorithm>
+#include <functional>
 
 namespace maat
 {
 
 ConstraintObject::ConstraintObject()
-:left_expr(nullptr), right_expr(nullptr), left_constr(nullptr), right_constr(nullptr)
+:_hashed(false), _hash(0), left_expr(nullptr), right_expr(nullptr), left_constr(nullptr), right_constr(nullptr)
 {}
 
 ConstraintObject::ConstraintObject(ConstraintType t, Expr l, Expr r):
-    type(t), left_expr(l), right_expr(r), 
+    _hashed(false), _hash(0), type(t), left_expr(l), right_expr(r), 
     left_constr(nullptr), right_constr(nullptr)
 {
     if( l->size != r->size )
@@ -28,7 +29,7 @@ ConstraintObject::ConstraintObject(ConstraintType t, Expr l, Expr r):
 }
 
 ConstraintObject::ConstraintObject(ConstraintType t, Constraint l, Constraint r):
-    type(t), left_expr(nullptr), right_expr(nullptr), 
+    _hashed(false), _hash(0), type(t), left_expr(nullptr), right_expr(nullptr), 
     left_constr(l), right_constr(r)
 {}
 
@@ -58,13 +59,20 @@ Constraint ConstraintObject::invert()
 }
 
 const std::set<std::string>& ConstraintObject::contained_vars()
+{
+    if (not _contained_vars.has_value())
+        _contained_vars = contained_var_ids().names();
+    return *_contained_vars;
+}
+
+const VarSet& ConstraintObject::contained_var_ids()
 {
     // We already computed the set of contained vars
-    if (_contained_vars.has_value())
-        return *_contained_vars;
+    if (_contained_var_ids.has_value())
+        return *_contained_var_ids;
 
     // We need to compute the set of containted vars
-    _contained_vars.emplace();
+    _contained_var_ids.emplace();
     switch (type)
     {
     case ConstraintType::EQ:
@@ -73,54 +81,92 @@ const std::set<std::string>& ConstraintObject::contained_vars()
         case ConstraintType::LT:
         case ConstraintType::ULE:
         case ConstraintType::ULT:
-            left_expr->get_vars(*_contained_vars);
-            right_expr->get_vars(*_contained_vars);
+            left_expr->get_vars(*_contained_var_ids);
+            right_expr->get_vars(*_contained_var_ids);
             break;
         case ConstraintType::AND:
         case ConstraintType::OR:
-            std::set_union(
-                left_constr->contained_vars().begin(),
-                left_constr->contained_vars().end(),
-                right_constr->contained_vars().begin(),
-                right_constr->contained_vars().end(),
-                std::inserter(*_contained_vars, _contained_vars->begin())
-            );
+            _contained_var_ids->insert(left_constr->contained_var_ids());
+            _contained_var_ids->insert(right_constr->contained_var_ids());
             break;
         default:
-            throw runtime_exception("ConstraintObject::contained_vars() got unknown constraint type");
+            throw runtime_exception("ConstraintObject::contained_var_ids() got unknown constraint type");
     }
-    return *_contained_vars;
+    return *_contained_var_ids;
+}
+
+bool ConstraintObject::contains_vars(const std::set<std::string>& vars)
+{
+    return contains_vars(VarSet(vars));
 }
 
-// Inspired from https://en.cppreference.com/w/cpp/algorithm/set_intersection
-template<class InputIt1, class InputIt2>
-bool fast_set_intersect(
-    InputIt1 first1, InputIt1 last1,
-    InputIt2 first2, InputIt2 last2
-)
+bool ConstraintObject::contains_vars(const VarSet& vars)
 {
-    while (first1 != last1 && first2 != last2) 
+    return contained_var_ids().intersects(vars);
+}
+
+// Combine two hashes (taken from boost::hash_combine)
+static inline hash_t combine_hash(hash_t seed, hash_t h)
+{
+    return seed ^ (h + 0x9e3779b9 + (seed << 6) + (seed >> 2));
+}
+
+hash_t ConstraintObject::hash()
+{
+    if (_hashed)
+        return _hash;
+
+    _hash = static_cast<hash_t>(type);
+    switch (type)
     {
-        if (*first1 < *first2)
-            ++first1;
-        else  
-        {
-            if (*first2 == *first1)
-                return true; // Same string, sets intersect!
-            else
-                ++first2;
-        }
+        case ConstraintType::AND:
+        case ConstraintType::OR:
+            _hash = combine_hash(_hash, left_constr->hash());
+            _hash = combine_hash(_hash, right_constr->hash());
+            break;
+        default:
+            _hash = combine_hash(_hash, left_expr->hash());
+            _hash = combine_hash(_hash, right_expr->hash());
+            break;
     }
-    return false;
+    _hashed = true;
+    return _hash;
 }
 
-bool ConstraintObject::contains_vars(const std::set<std::string>& vars)
+bool ConstraintObject::is_tautology()
 {
-    const auto& s = contained_vars();
-    return fast_set_intersect(
-        s.begin(), s.end(),
-        vars.begin(), vars.end()
-    );
+    switch (type)
+    {
+        case ConstraintType::AND:
+            return left_constr->is_tautology() and right_constr->is_tautology();
+        case ConstraintType::OR:
+            return left_constr->is_tautology() or right_constr->is_tautology();
+        default:
+            break;
+    }
+
+    // Comparing an expression with itself
+    if (left_expr->eq(right_expr))
+        return type == ConstraintType::EQ
+            or type == ConstraintType::LE
+            or type == ConstraintType::ULE;
+
+    // Comparing two constants
+    if (not left_expr->is_type(ExprType::CST) or not right_expr->is_type(ExprType::CST))
+        return false;
+    const Number& left = left_expr->as_number();
+    const Number& right = right_expr->as_number();
+    switch (type)
+    {
+        case ConstraintType::EQ: return left.equal_to(right);
+        case ConstraintType::NEQ: return not left.equal_to(right);
+        case ConstraintType::LE: return left.slessequal_than(right);
+        case ConstraintType::LT: return left.sless_than(right);
+        case ConstraintType::ULE: return left.lessequal_than(right);
+        case ConstraintType::ULT: return left.less_than(right);
+        default:
+            throw runtime_exception("ConstraintObject::is_tautology() got unknown constraint type");
+    }
 }
 
 serial::uid_t ConstraintObject::class_uid() const
@@ -85,6 +85,7 @@ hash_t exprhash(void* hash_in, int len, uint32_t seed)
 
 
 /* Implementation of Expr* classes */
+
 ExprObject::ExprObject(ExprType t, size_t _size, bool _is_simp, Taint _t, ucst_t _tm):
     type(t),
     size(_size),
@@ -127,6 +128,10 @@ void ExprObject::load(Deserializer& d)
         >> bits(_status) >> bits(_status_ctx_id)
         >> bits(type) >> bits(size)
         >> args;
+    // Variable versions are specific to the current process
+    _concrete_ctx_version = invalid_ctx_version;
+    _status_ctx_version = invalid_ctx_version;
+    _vars_version_ctx_id = -1;
 }
 
 uid_t ExprObject::class_uid() const 
@@ -270,6 +275,115 @@ void ExprObject::get_vars(std::set<std::string>& vars)
     }
 }
 
+void ExprObject::get_vars(VarSet& vars)
+{
+    vars.insert(var_ids());
+}
+
+const VarSet& ExprObject::var_ids()
+{
+    return *_get_var_ids();
+}
+
+const std::shared_ptr<const VarSet>& ExprObject::_get_var_ids()
+{
+    static const std::shared_ptr<const VarSet> no_vars = std::make_shared<const VarSet>();
+
+    if (_var_ids != nullptr)
+        return _var_ids;
+
+    if (type == ExprType::VAR)
+    {
+        std::shared_ptr<VarSet> res = std::make_shared<VarSet>();
+        res->insert(static_cast<ExprVar*>(this)->id());
+        _var_ids = res;
+        return _var_ids;
+    }
+
+    // Share the set of the arguments when possible, so that only expressions
+    // combining several variables own a new set
+    std::shared_ptr<VarSet> res = nullptr;
+    for (auto& arg : args)
+    {
+        const std::shared_ptr<const VarSet>& arg_vars = arg->_get_var_ids();
+        if (arg_vars->empty() or arg_vars == _var_ids)
+            continue;
+        else if (_var_ids == nullptr)
+            _var_ids = arg_vars;
+        else
+        {
+            if (res == nullptr)
+            {
+                res = std::make_shared<VarSet>(*_var_ids);
+                _var_ids = res;
+            }
+            res->insert(*arg_vars);
+        }
+    }
+    if (_var_ids == nullptr)
+        _var_ids = no_vars;
+    return _var_ids;
+}
+
+uint64_t ExprObject::_get_vars_version(const VarContext& ctx)
+{
+    if (_vars_version_ctx_id == (int)ctx.id)
+        return _vars_version;
+    if (type == ExprType::VAR)
+        _vars_version = ctx.version(static_cast<ExprVar*>(this)->id());
+    else
+    {
+        _vars_version = 0;
+        for (auto& arg : args)
+            _vars_version = std::max(_vars_version, arg->_get_vars_version(ctx));
+    }
+    _vars_version_ctx_id = ctx.id;
+    return _vars_version;
+}
+
+bool ExprObject::_concrete_up_to_date(const VarContext& ctx)
+{
+    if (_concrete_ctx_id == ctx.id)
+        return true;
+    // The context changed, but maybe not the variables of this expression
+    if (
+        _concrete_ctx_version != invalid_ctx_version
+        and _get_vars_version(ctx) == _concrete_ctx_version
+    )
+    {
+        _concrete_ctx_id = ctx.id;
+        return true;
+    }
+    return false;
+}
+
+void ExprObject::_concrete_computed(const VarContext& ctx)
+{
+    _concrete_ctx_id = ctx.id;
+    _concrete_ctx_version = _get_vars_version(ctx);
+}
+
+bool ExprObject::_status_up_to_date(const VarContext& ctx)
+{
+    if (_status_ctx_id == ctx.id)
+        return true;
+    if (
+        _status_ctx_version != invalid_ctx_version
+        and _get_vars_version(ctx) == _status_ctx_version
+    )
+    {
+        _status_ctx_id = ctx.id;
+        return true;
+    }
+    return false;
+}
+
+void ExprObject::_status_computed(const VarContext& ctx)
+{
+    _status_ctx_id = ctx.id;
+    _status_ctx_version = _get_vars_version(ctx);
+}
+
 bool ExprObject::is_symbolic(const VarContext& ctx)
 {
     return status(ctx) == ExprStatus::SYMBOLIC;
@@ -424,7 +538,7 @@ hash_t ExprCst::hash()
         {
             char _cst_string[500];  // Enough to store the string representation
                                     // of a number on 512 bits
-            mpz_get_str(_cst_string, 36, _concrete.mpz_.get_mpz_t()); // Base 36 to be quicker
+            mpz_get_str(_cst_string, 36, _concrete.get_mpz().get_mpz_t()); // Base 36 to be quicker
             _hash = exprhash(hash_in, prepare_hash_with_str(hash_in, _cst_string), size); 
         }
         _hashed = true;
@@ -469,7 +583,7 @@ ValueSet& ExprCst::value_set()
 
 
 // ==================================
-ExprVar::ExprVar(): ExprObject(ExprType::NONE, 0) {};
+ExprVar::ExprVar(): ExprObject(ExprType::NONE, 0), _id(0) {};
 
 ExprVar::ExprVar(size_t s, std::string n, Taint t): ExprObject(ExprType::VAR, s, true, t), _name(n)
 {
@@ -477,6 +591,7 @@ ExprVar::ExprVar(size_t s, std::string n, Taint t): ExprObject(ExprType::VAR, s,
     {
         throw expression_exception("Variable name is too long!");
     }
+    _id = VarTable::id(_name);
     _value_set.set_all();
     _value_set_computed = true;
 }
@@ -491,6 +606,7 @@ void ExprVar::load(Deserializer& d)
 {
     ExprObject::load(d);
     d >> _name;
+    _id = VarTable::id(_name);
 }
 
 uid_t ExprVar::class_uid() const {return ClassId::EXPR_VAR;}
@@ -511,6 +627,11 @@ const std::string& ExprVar::name()
 {
     return _name;
 }
+
+var_id_t ExprVar::id() const
+{
+    return _id;
+}
  
 void ExprVar::print(std::ostream& os)
 {
@@ -528,13 +649,13 @@ const Number& ExprVar::concretize(const VarContext* ctx)
     {
         throw expression_exception("Cannot concretize symbolic variable without supplying a context");
     }
-    else if( _concrete_ctx_id != ctx->id )
+    else if( not _concrete_up_to_date(*ctx) )
     {
         try
         {
-            _concrete_ctx_id = ctx->id;
-            _concrete = ctx->get_as_number(_name);
+            _concrete = ctx->get_as_number(_id);
             _concrete.size = this->size; // Ajust size because VarContext doesn't keep size info
+            _concrete_computed(*ctx);
         }
         catch (const var_context_exception& e)
         {
@@ -548,10 +669,10 @@ const Number& ExprVar::concretize(const VarContext* ctx)
 
 ExprStatus ExprVar::status(const VarContext& ctx)
 {
-    if( ctx.id != _status_ctx_id )
+    if( not _status_up_to_date(ctx) )
     {
-        _status = ctx.contains(_name)? ExprStatus::CONCOLIC : ExprStatus::SYMBOLIC;
-        _status_ctx_id = ctx.id;
+        _status = ctx.contains(_id)? ExprStatus::CONCOLIC : ExprStatus::SYMBOLIC;
+        _status_computed(ctx);
     }
     return _status;
 }
@@ -725,7 +846,7 @@ bool ExprUnop::is_tainted(ucst_t mask)
 
 const Number& ExprUnop::concretize(const VarContext* ctx)
 {
-    if( ctx != nullptr && _concrete_ctx_id == ctx->id )
+    if( ctx != nullptr && _concrete_up_to_date(*ctx) )
         return _concrete;
     else
     {
@@ -744,17 +865,17 @@ const Number& ExprUnop::concretize(const VarContext* ctx)
     }
     if( ctx != nullptr )
     {
-        _concrete_ctx_id = ctx->id; 
+        _concrete_computed(*ctx);
     }
     return _concrete;
 }
 
 ExprStatus ExprUnop::status(const VarContext& ctx)
 {
-    if( ctx.id != _status_ctx_id )
+    if( not _status_up_to_date(ctx) )
     {
         _status = args[0]->status(ctx);
-        _status_ctx_id = ctx.id;
+        _status_computed(ctx);
     }
     return _status;
 }
@@ -963,7 +1084,7 @@ bool ExprBinop::is_tainted(ucst_t mask)
 
 const maat::Number& ExprBinop::concretize(const VarContext* ctx)
 {
-    if( ctx != nullptr && _concrete_ctx_id == ctx->id )
+    if( ctx != nullptr && _concrete_up_to_date(*ctx) )
         return _concrete;
     else
     {
@@ -1007,7 +1128,7 @@ const maat::Number& ExprBinop::concretize(const VarContext* ctx)
     }
     if( ctx != nullptr )
     {
-        _concrete_ctx_id = ctx->id;
+        _concrete_computed(*ctx);
     }
     return _concrete;
 }
@@ -1038,6 +1159,7 @@ ValueSet& ExprBinop::value_set()
             break;
         case Op::SDIV:
             _value_set.set_all(); // Not supported
+            break;
         case Op::AND: 
             _value_set.set_and(arg0_vs, arg1_vs);
             break;
@@ -1077,10 +1199,10 @@ ValueSet& ExprBinop::value_set()
 
 ExprStatus ExprBinop::status(const VarContext& ctx)
 {
-    if( ctx.id != _status_ctx_id )
+    if( not _status_up_to_date(ctx) )
     {
         _status = args[0]->status(ctx) | args[1]->status(ctx);
-        _status_ctx_id = ctx.id;
+        _status_computed(ctx);
     }
     return _status;
 }
@@ -1174,7 +1296,7 @@ const maat::Number& ExprExtract::concretize(const VarContext* ctx)
     ucst_t high, low;
     ucst_t mask;
     
-    if( ctx != nullptr && _concrete_ctx_id == ctx->id )
+    if( ctx != nullptr && _concrete_up_to_date(*ctx) )
         return _concrete;
     
     high = (ctx != nullptr) ? args[1]->as_uint(*ctx) : args[1]->as_uint();
@@ -1182,7 +1304,7 @@ const maat::Number& ExprExtract::concretize(const VarContext* ctx)
     if (ctx != nullptr)
     {
         _concrete.set_extract(args[0]->as_number(*ctx), high, low);
-        _concrete_ctx_id = ctx->id;
+        _concrete_computed(*ctx);
     }
     else
     {
@@ -1193,10 +1315,10 @@ const maat::Number& ExprExtract::concretize(const VarContext* ctx)
 
 ExprStatus ExprExtract::status(const VarContext& ctx)
 {
-    if( ctx.id != _status_ctx_id )
+    if( not _status_up_to_date(ctx) )
     {
         _status = args[0]->status(ctx);
-        _status_ctx_id = ctx.id;
+        _status_computed(ctx);
     }
     return _status;
 }
@@ -1208,7 +1330,7 @@ ValueSet& ExprExtract::value_set(){
         return _value_set;
     }
     // Not yet computed
-    _value_set.set_all();
+    _value_set.set_extract(args[0]->value_set(), args[1]->cst(), args[2]->cst());
     _value_set_computed = true;
     return _value_set;
 }
@@ -1277,13 +1399,13 @@ bool ExprConcat::is_tainted(ucst_t mask)
 const maat::Number& ExprConcat::concretize(const VarContext* ctx)
 {
     cst_t upper, lower; 
-    if( ctx != nullptr && _concrete_ctx_id == ctx->id )
+    if( ctx != nullptr && _concrete_up_to_date(*ctx) )
         return _concrete;
 
     if (ctx != nullptr)
     {
         _concrete.set_concat(args[0]->as_number(*ctx), args[1]->as_number(*ctx)); 
-        _concrete_ctx_id = ctx->id;
+        _concrete_computed(*ctx);
     }
     else
     {
@@ -1295,10 +1417,10 @@ const maat::Number& ExprConcat::concretize(const VarContext* ctx)
 
 ExprStatus ExprConcat::status(const VarContext& ctx)
 {
-    if( ctx.id != _status_ctx_id )
+    if( not _status_up_to_date(ctx) )
     {
         _status = args[0]->status(ctx) | args[1]->status(ctx);
-        _status_ctx_id = ctx.id;
+        _status_computed(ctx);
     }
     return _status;
 }
@@ -1434,7 +1556,7 @@ bool ExprITE::is_tainted(ucst_t mask)
 
 const maat::Number& ExprITE::concretize(const VarContext* ctx)
 {
-    if( ctx != nullptr && _concrete_ctx_id == ctx->id )
+    if( ctx != nullptr && _concrete_up_to_date(*ctx) )
     {
         return _concrete;
     }
@@ -1445,7 +1567,7 @@ const maat::Number& ExprITE::concretize(const VarContext* ctx)
         else
             _concrete = (ctx!=nullptr)? if_false()->as_number(*ctx) : if_false()->as_number();
         if( ctx != nullptr )
-            _concrete_ctx_id = ctx->id;
+            _concrete_computed(*ctx);
     }
     return _concrete;
 }
@@ -1465,10 +1587,10 @@ ValueSet& ExprITE::value_set()
 
 ExprStatus ExprITE::status(const VarContext& ctx)
 {
-    if( ctx.id != _status_ctx_id )
+    if( not _status_up_to_date(ctx) )
     {
         _status = args[0]->status(ctx) | args[1]->status(ctx) | args[2]->status(ctx) | args[3]->status(ctx);
-        _status_ctx_id = ctx.id;
+        _status_computed(ctx);
     }
     return _status;
 }
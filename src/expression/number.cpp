@@ -12,25 +12,26 @@ void mpz_init_force_signed(mpz_t& res, const Number& src)
     if (not src.is_mpz())
         throw expression_exception("mpz_force_signed(): shouldn't be called with regular Number!");
     
+    mpz_class val = src.get_mpz();
     mpz_init(res);
-    int bit = mpz_tstbit(src.mpz_.get_mpz_t(), src.size-1);
+    int bit = mpz_tstbit(val.get_mpz_t(), src.size-1);
     if (bit == 0)
-        mpz_set(res, src.mpz_.get_mpz_t()); // Unsigned, keep the same value
+        mpz_set(res, val.get_mpz_t()); // Unsigned, keep the same value
     else
     {
         mpz_t tmp;
         mpz_init(tmp);
         mpz_setbit(tmp, src.size);
-        mpz_sub(tmp, tmp, src.mpz_.get_mpz_t());
+        mpz_sub(tmp, tmp, val.get_mpz_t());
         mpz_neg(res, tmp);
         mpz_clear(tmp);
     }
 }
 
 // TODO(boyan): is setting mpz to zero causing memory allocation here ???
-Number::Number(): size(0), cst_(-1), mpz_(0){}
+Number::Number(): size(0), cst_(-1){}
 
-Number::Number(size_t bits): size(bits), cst_(0), mpz_(0){}
+Number::Number(size_t bits): size(bits), cst_(0){}
 
 Number::Number(size_t bits, const std::string& value, int base): size(bits), cst_(0)
 {
@@ -39,6 +40,97 @@ Number::Number(size_t bits, const std::string& value, int base): size(bits), cst
 
 Number::~Number(){}
 
+Number::Number(const Number& x): size(x.size), cst_(x.cst_), _wide(x._wide)
+{
+    // Small numbers don't need their mpz to be copied
+    if (x.is_mpz() and x._mpz != nullptr)
+        _mpz = std::make_unique<mpz_class>(*x._mpz);
+}
+
+Number& Number::operator=(const Number& x)
+{
+    if (this == &x)
+        return *this;
+    size = x.size;
+    cst_ = x.cst_;
+    _wide = x._wide;
+    if (x.is_mpz())
+    {
+        if (x._mpz == nullptr)
+            _mpz.reset();
+        else if (_mpz == nullptr)
+            _mpz = std::make_unique<mpz_class>(*x._mpz);
+        else
+            *_mpz = *x._mpz; // Re-use the existing allocation
+    }
+    return *this;
+}
+
+mpz_class& Number::mpz()
+{
+    if (_mpz == nullptr)
+        _mpz = std::make_unique<mpz_class>(0);
+    return *_mpz;
+}
+
+const mpz_class& Number::mpz() const
+{
+    static const mpz_class zero(0);
+    return _mpz == nullptr ? zero : *_mpz;
+}
+
+bool Number::_is_wide() const
+{
+    return size > 64 and size <= 256;
+}
+
+mpz_class Number::get_mpz() const
+{
+    if (size <= 64)
+        return mpz_class((unsigned long int)get_ucst());
+    else if (_is_wide())
+        return _wide.to_mpz();
+    else
+        return mpz();
+}
+
+UInt256 Number::_get_u256() const
+{
+    if (size <= 64)
+        return UInt256(get_ucst());
+    else if (_is_wide())
+        return _wide;
+    else
+        return UInt256::from_mpz(mpz());
+}
+
+void Number::_set_u256(const UInt256& val)
+{
+    if (size <= 64)
+        set_cst(val.limbs[0]);
+    else if (_is_wide())
+    {
+        _wide = val;
+        _wide.truncate(size);
+    }
+    else
+    {
+        mpz() = val.to_mpz();
+        adjust_mpz();
+    }
+}
+
+void Number::_set_mpz_value(const mpz_class& val)
+{
+    if (size <= 256)
+        _set_u256(UInt256::from_mpz(val));
+    else
+    {
+        mpz() = val;
+        adjust_mpz();
+    }
+}
+
 uid_t Number::class_uid() const {return ClassId::NUMBER;}
 
 void Number::dump(Serializer& s) const
@@ -76,22 +168,10 @@ void Number::load(Deserializer& d)
 
 void Number::adjust_mpz()
 {
-    mpz_t tmp;
-    if (!is_mpz())
+    if (size <= 256)
         return;
-
-    mpz_init_set(tmp, mpz_.get_mpz_t());
-    mpz_ = mpz_class(0);
-
-    // Copy bit by bit
-    for (unsigned int i = 0; i < size; i++)
-    {
-        if (mpz_tstbit(tmp, i) == 1)
-            mpz_setbit(mpz_.get_mpz_t(), i);
-        else
-            mpz_clrbit(mpz_.get_mpz_t(), i);
-    }
-    mpz_clear(tmp);
+    // Keep the 'size' lower bits, as a positive value
+    mpz_fdiv_r_2exp(mpz().get_mpz_t(), mpz().get_mpz_t(), size);
 }
 
 cst_t __number_cst_mask(size_t size)
@@ -149,22 +229,21 @@ void Number::set(cst_t val)
 {
     cst_ = val;
     if (is_mpz())
-    {
-        mpz_ = mpz_class((unsigned long int)val);
-        adjust_mpz();
-    }
+        set_mpz(val);
 }
 
 cst_t Number::get_cst() const
 {
     if (!is_mpz())
         return cst_;
+    else if (_is_wide())
+        return _wide.limbs[0];
     else
     {
         cst_t res = 0;
         for (int i = (sizeof(cst_t)*8) -1; i >= 0; i--)
         {
-            res = (res<<1) + mpz_tstbit(mpz_.get_mpz_t(), i);
+            res = (res<<1) + mpz_tstbit(mpz().get_mpz_t(), i);
         }
         return res;
     }
@@ -174,12 +253,14 @@ ucst_t Number::get_ucst() const
 {
     if (!is_mpz())
         return __number_cst_unsign_trunc(size, cst_);
+    else if (_is_wide())
+        return _wide.limbs[0];
     else
     {
         cst_t res = 0;
         for (int i = (sizeof(cst_t)*8) -1; i >= 0; i--)
         {
-            res = (res<<1) + mpz_tstbit(mpz_.get_mpz_t(), i);
+            res = (res<<1) + mpz_tstbit(mpz().get_mpz_t(), i);
         }
         return __number_cst_unsign_trunc(size, res);
     }
@@ -188,16 +269,14 @@ ucst_t Number::get_ucst() const
 /// Set the number to multiprecision value 'val'
 void Number::set_mpz(cst_t val)
 {
-    mpz_ = mpz_class((unsigned long int)val);
-    adjust_mpz();
+    _set_u256(UInt256((ucst_t)val));
 }
 
 void Number::set_mpz(const std::string& val, int base)
 {
     if (base < 2 or base > 62)
         throw expression_exception("Number::set_mpz() needs a base between 2 and 62");
-    mpz_ = mpz_class(val, base);
-    adjust_mpz();
+    _set_mpz_value(mpz_class(val, base));
 }
 
 void Number::set_neg(const Number& n)
@@ -205,9 +284,11 @@ void Number::set_neg(const Number& n)
     size = n.size;
     if (n.size <= 64)
         set_cst(-1 * n.cst_);
+    else if (_is_wide())
+        _set_u256(-n._wide);
     else
     {
-        mpz_ = - n.mpz_;
+        mpz() = - n.mpz();
         adjust_mpz();
     }
 }
@@ -217,9 +298,11 @@ void Number::set_not(const Number& n)
     size = n.size;
     if (n.size <= 64)
         set_cst(~(ucst_t)(n.cst_));
+    else if (_is_wide())
+        _set_u256(~n._wide);
     else
     {
-        mpz_ = ~ n.mpz_;
+        mpz() = ~ n.mpz();
         adjust_mpz();
     }
 }
@@ -229,9 +312,11 @@ void Number::set_add(const Number& n1, const Number& n2)
     size = n1.size;
     if (size <= 64)
         set_cst(n1.cst_ + n2.cst_);
+    else if (_is_wide())
+        _set_u256(n1._wide + n2._wide);
     else
     {
-        mpz_ = n1.mpz_ + n2.mpz_;
+        mpz() = n1.mpz() + n2.mpz();
         adjust_mpz();
     }
 }
@@ -241,9 +326,11 @@ void Number::set_sub(const Number& n1, const Number& n2)
     size = n1.size;
     if (size <= 64)
         set_cst(n1.cst_ - n2.cst_);
+    else if (_is_wide())
+        _set_u256(n1._wide - n2._wide);
     else
     {
-        mpz_ = n1.mpz_ - n2.mpz_;
+        mpz() = n1.mpz() - n2.mpz();
         adjust_mpz();
     }
 }
@@ -253,9 +340,11 @@ void Number::set_and(const Number& n1, const Number& n2)
     size = n1.size;
     if (size <= 64)
         set_cst((ucst_t)n1.cst_ & (ucst_t)n2.cst_);
+    else if (_is_wide())
+        _set_u256(n1._wide & n2._wide);
     else
     {
-        mpz_ = n1.mpz_ & n2.mpz_;
+        mpz() = n1.mpz() & n2.mpz();
     }
 }
 
@@ -266,9 +355,13 @@ void Number::set_mul(const Number& n1, const Number& n2)
     {
         set_cst((ucst_t)n1.cst_ * (ucst_t)n2.cst_);
     }
+    else if (_is_wide())
+    {
+        _set_u256(n1._wide * n2._wide);
+    }
     else
     {
-        mpz_ = n1.mpz_ * n2.mpz_;
+        mpz() = n1.mpz() * n2.mpz();
         adjust_mpz();
     }
 }
@@ -280,13 +373,35 @@ void Number::set_xor(const Number& n1, const Number& n2)
     {
         set_cst(n1.cst_ ^ n2.cst_);
     }
+    else if (_is_wide())
+    {
+        _set_u256(n1._wide ^ n2._wide);
+    }
     else
     {
-        mpz_ = n1.mpz_ ^ n2.mpz_;
+        mpz() = n1.mpz() ^ n2.mpz();
         adjust_mpz();
     }
 }
 
+// Helpers for signed operations on wide numbers. Return the absolute
+// value of 'val' interpreted as a signed number on 'size' bits
+static UInt256 u256_abs(const UInt256& val, size_t size, bool& is_neg)
+{
+    is_neg = val.get_bit(size-1);
+    if (not is_neg)
+        return val;
+    UInt256 res = -val;
+    res.truncate(size);
+    return res;
+}
+
+static void u256_check_div(const UInt256& val)
+{
+    if (val.is_zero())
+        throw expression_exception("Number: division by zero");
+}
+
 void Number::set_rem(const Number& n1, const Number& n2)
 {
     size = n1.size;
@@ -294,9 +409,16 @@ void Number::set_rem(const Number& n1, const Number& n2)
     {
         set_cst(__number_cst_unsign_trunc(n1.size, n1.cst_) % __number_cst_unsign_trunc(n2.size, n2.cst_));
     }
+    else if (_is_wide())
+    {
+        UInt256 q, r;
+        u256_check_div(n2._wide);
+        UInt256::divmod(n1._wide, n2._wide, q, r);
+        _set_u256(r);
+    }
     else
     {
-        mpz_mod(mpz_.get_mpz_t(), n1.mpz_.get_mpz_t(), n2.mpz_.get_mpz_t());
+        mpz_mod(mpz().get_mpz_t(), n1.mpz().get_mpz_t(), n2.mpz().get_mpz_t());
         adjust_mpz();
     }
 }
@@ -308,12 +430,23 @@ void Number::set_srem(const Number& n1, const Number& n2)
     {
         set_cst(__number_cst_sign_extend(n1.size, n1.cst_) % __number_cst_sign_extend(n2.size, n2.cst_));
     }
+    else if (_is_wide())
+    {
+        bool neg1, neg2;
+        UInt256 a = u256_abs(n1._wide, size, neg1);
+        UInt256 b = u256_abs(n2._wide, size, neg2);
+        UInt256 q, r;
+        u256_check_div(b);
+        UInt256::divmod(a, b, q, r);
+        // The remainder has the sign of the dividend
+        _set_u256(neg1 ? -r : r);
+    }
     else
     {
         mpz_t tmp1, tmp2;
         mpz_init_force_signed(tmp1, n1);
         mpz_init_force_signed(tmp2, n2);
-        mpz_tdiv_r(mpz_.get_mpz_t(), tmp1, tmp2);
+        mpz_tdiv_r(mpz().get_mpz_t(), tmp1, tmp2);
         adjust_mpz();
         mpz_clear(tmp1);
         mpz_clear(tmp2);
@@ -341,13 +474,24 @@ void Number::set_exp(const Number& n1, const Number& n2)
     {
         set_cst(uint_pow(n1.get_ucst(), n2.get_ucst()));
     }
+    else if (_is_wide())
+    {
+        UInt256 base = n1._wide, exp = n2._get_u256(), result(1);
+        for (unsigned int i = 0; i < 256; i++)
+        {
+            if (exp.get_bit(i))
+                result = result * base;
+            base = base * base;
+        }
+        _set_u256(result);
+    }
     else
     {
         mpz_t mpz_mod;
         mpz_init_set_ui(mpz_mod, 1);
         mpz_mul_2exp(mpz_mod, mpz_mod, size);
 
-        mpz_powm(mpz_.get_mpz_t(), n1.mpz_.get_mpz_t(), n2.mpz_.get_mpz_t(), mpz_mod);
+        mpz_powm(mpz().get_mpz_t(), n1.mpz().get_mpz_t(), n2.mpz().get_mpz_t(), mpz_mod);
         adjust_mpz();
 
         mpz_clear(mpz_mod);
@@ -366,9 +510,17 @@ void Number::set_shl(const Number& n1, const Number& n2)
             tmp = ((ucst_t)n1.cst_) << ((ucst_t)n2.cst_);
         set_cst(tmp);
     }
+    else if (_is_wide())
+    {
+        UInt256 shift = n2._get_u256();
+        if (shift.less_than(size))
+            _set_u256(n1._wide << shift.limbs[0]);
+        else
+            _set_u256(UInt256());
+    }
     else
     {
-        mpz_mul_2exp(mpz_.get_mpz_t(), n1.mpz_.get_mpz_t(), n2.get_cst());
+        mpz_mul_2exp(mpz().get_mpz_t(), n1.mpz().get_mpz_t(), n2.get_cst());
         adjust_mpz();
     }
 }
@@ -385,9 +537,17 @@ void Number::set_shr(const Number& n1, const Number& n2)
             tmp = n1.get_ucst() >> n2.get_ucst();
         set_cst(tmp);
     }
+    else if (_is_wide())
+    {
+        UInt256 shift = n2._get_u256();
+        if (shift.less_than(size))
+            _set_u256(n1._wide >> shift.limbs[0]);
+        else
+            _set_u256(UInt256());
+    }
     else
     {
-        mpz_fdiv_q_2exp(mpz_.get_mpz_t(), n1.mpz_.get_mpz_t(), n2.get_cst()); // shr is a div by power of two
+        mpz_fdiv_q_2exp(mpz().get_mpz_t(), n1.mpz().get_mpz_t(), n2.get_cst()); // shr is a div by power of two
         adjust_mpz();
     }
 }
@@ -411,26 +571,42 @@ void Number::set_sar(const Number& n1, const Number& n2)
         }
         set_cst(tmp);
     }
+    else if (_is_wide())
+    {
+        UInt256 shift = n2._get_u256();
+        bool is_neg = n1._wide.get_bit(size-1);
+        UInt256 tmp;
+        if (shift.less_than(size))
+        {
+            tmp = n1._wide >> shift.limbs[0];
+            // Fill the shifted bits with the sign bit
+            if (is_neg)
+                tmp = tmp | ~UInt256::ones(size - shift.limbs[0]);
+        }
+        else if (is_neg)
+            tmp = UInt256::ones(size);
+        _set_u256(tmp);
+    }
     else
     {
-        mpz_ = 0;
-        unsigned int shift = mpz_get_ui(n2.mpz_.get_mpz_t());
+        mpz() = 0;
+        unsigned int shift = mpz_get_ui(n2.mpz().get_mpz_t());
         unsigned int i;
         // Copy bits
         for (i = 0; i < size-shift; i++)
         {
-            if (mpz_tstbit(n1.mpz_.get_mpz_t(), i + shift) == 1)
-                mpz_setbit(mpz_.get_mpz_t(), i);
+            if (mpz_tstbit(n1.mpz().get_mpz_t(), i + shift) == 1)
+                mpz_setbit(mpz().get_mpz_t(), i);
             else
-                mpz_clrbit(mpz_.get_mpz_t(), i);
+                mpz_clrbit(mpz().get_mpz_t(), i);
         }
         // Set the shifted mask to 0 or 0xffff....
-        if (mpz_tstbit(n1.mpz_.get_mpz_t(), n1.size-1) == 1)
+        if (mpz_tstbit(n1.mpz().get_mpz_t(), n1.size-1) == 1)
             for (i = 0; i < shift; i++)
-                mpz_setbit(mpz_.get_mpz_t(), size-1-i);
+                mpz_setbit(mpz().get_mpz_t(), size-1-i);
         else 
             for (i = 0; i < shift; i++)
-                mpz_clrbit(mpz_.get_mpz_t(), size-1-i);
+                mpz_clrbit(mpz().get_mpz_t(), size-1-i);
         // Adjust
         adjust_mpz();
     }
@@ -443,9 +619,13 @@ void Number::set_or(const Number& n1, const Number& n2)
     {
         set_cst(n1.cst_ | n2.cst_);
     }
+    else if (_is_wide())
+    {
+        _set_u256(n1._wide | n2._wide);
+    }
     else
     {
-        mpz_ = n1.mpz_ | n2.mpz_;
+        mpz() = n1.mpz() | n2.mpz();
     }
 }
 
@@ -459,13 +639,24 @@ void Number::set_sdiv(const Number& n1, const Number& n2)
             __number_cst_sign_extend(n2.size, n2.get_cst())
         );
     }
+    else if (_is_wide())
+    {
+        bool neg1, neg2;
+        UInt256 a = u256_abs(n1._wide, size, neg1);
+        UInt256 b = u256_abs(n2._wide, size, neg2);
+        UInt256 q, r;
+        u256_check_div(b);
+        UInt256::divmod(a, b, q, r);
+        // Truncate the quotient towards zero
+        _set_u256(neg1 != neg2 ? -q : q);
+    }
     else
     {
         
         mpz_t tmp1, tmp2;
         mpz_init_force_signed(tmp1, n1);
         mpz_init_force_signed(tmp2, n2);
-        mpz_tdiv_q(mpz_.get_mpz_t(), tmp1, tmp2);
+        mpz_tdiv_q(mpz().get_mpz_t(), tmp1, tmp2);
         adjust_mpz();
         mpz_clear(tmp1);
         mpz_clear(tmp2);
@@ -481,10 +672,17 @@ void Number::set_div(const Number& n1, const Number& n2)
         ucst_t t2 = n2.get_ucst();
         set_cst(t1 / t2);
     }
+    else if (_is_wide())
+    {
+        UInt256 q, r;
+        u256_check_div(n2._wide);
+        UInt256::divmod(n1._wide, n2._wide, q, r);
+        _set_u256(q);
+    }
     else
     {
         // TODO: this is signed division, not unsigned ???
-        mpz_fdiv_q(mpz_.get_mpz_t(), n1.mpz_.get_mpz_t(), n2.mpz_.get_mpz_t());
+        mpz_fdiv_q(mpz().get_mpz_t(), n1.mpz().get_mpz_t(), n2.mpz().get_mpz_t());
         adjust_mpz();
     }
 }
@@ -505,28 +703,18 @@ void Number::set_extract(const Number& n, unsigned int high, unsigned int low)
         size = tmp_size;
         set_cst(tmp);
     }
+    else if (n._is_wide())
+    {
+        UInt256 tmp = n._wide >> low;
+        size = tmp_size;
+        _set_u256(tmp);
+    }
     else
     {
-        mpz_t tmp;
-        mpz_init_set_ui(tmp, 0); // init tmp mpz
-        // Copy bit by bit
-        for (unsigned int i = 0; i < tmp_size; i++)
-        {
-            if (mpz_tstbit(n.mpz_.get_mpz_t(), i+low) == 1)
-                mpz_setbit(tmp, i);
-            else
-                mpz_clrbit(tmp, i);
-        }
-
+        mpz_class tmp;
+        mpz_fdiv_q_2exp(tmp.get_mpz_t(), n.mpz().get_mpz_t(), low);
         size = tmp_size;
-        mpz_ = mpz_class(tmp);
-        mpz_clear(tmp); // clear tmp mpz
-        // adjust_mpz(); no need to adjust, we set bits manually
-        // If result size on 64 bits or less, transform into cst, not mpz 
-        if (this->size <= 64)
-        {
-            set_cst(mpz_get_ui(mpz_.get_mpz_t()));
-        }
+        _set_mpz_value(tmp);
     }
 }
 
@@ -544,36 +732,26 @@ void Number::set_concat(const Number& n1, const Number& n2)
         size = tmp_size;
         set_cst(tmp);
     }
+    else if (tmp_size <= 256)
+    {
+        UInt256 tmp = (n1._get_u256() << n2.size) | n2._get_u256();
+        size = tmp_size;
+        _set_u256(tmp);
+    }
     else
     {
         // Need to create a tmp mpz in case *this is n1 or n2...
-        mpz_class tmp_mpz(0);
-        // Set higher (set then shift)
-        if (n1.is_mpz())
-            tmp_mpz = n1.mpz_;
-        else
-            tmp_mpz = mpz_class((unsigned long int)n1.get_ucst());
+        mpz_class tmp_mpz = n1.get_mpz();
         mpz_mul_2exp(tmp_mpz.get_mpz_t(), tmp_mpz.get_mpz_t(), n2.size); // shift left
         // Set lower
-        if (n2.is_mpz())
-        {
-            mpz_ = tmp_mpz | n2.mpz_;
-        }
-        else
-        {
-            mpz_t t1;
-            mpz_init_set_ui(t1, (ucst_t)n2.get_ucst());
-            mpz_ior(mpz_.get_mpz_t(), tmp_mpz.get_mpz_t(), t1);
-            mpz_clear(t1);
-        }
+        tmp_mpz |= n2.get_mpz();
         size = tmp_size;
-        adjust_mpz();
+        _set_mpz_value(tmp_mpz);
     }
 }
 
 void Number::set_popcount(int dest_size, const Number& n)
 {
-    size = dest_size;
     ucst_t res = 0;
     if (n.size <= 64)
     {
@@ -582,15 +760,17 @@ void Number::set_popcount(int dest_size, const Number& n)
             res += (n.cst_ >> i) & 1;
         }
     }
+    else if (n._is_wide())
+    {
+        res = n._wide.popcount();
+    }
     else
     {
-        for (int i = 0; i < n.size; i++)
-        {
-            res += mpz_tstbit(n.mpz_.get_mpz_t(), i);
-        }
+        res = mpz_popcount(n.mpz().get_mpz_t());
     }
 
     // Assign res
+    size = dest_size;
     if (size <= 64)
         set_cst(res);
     else
@@ -599,55 +779,58 @@ void Number::set_popcount(int dest_size, const Number& n)
 
 void Number::set_zext(int ext_size, const Number& n)
 {
-    this->size = ext_size;
     if (ext_size <= 64)
     {
         cst_t tmp =  ((ucst_t)__number_cst_unsign_trunc(n.size, n.cst_));
+        this->size = ext_size;
         set_cst(tmp);
     }
+    else if (ext_size <= 256)
+    {
+        UInt256 tmp = n._get_u256();
+        this->size = ext_size;
+        _set_u256(tmp);
+    }
     else
     {
-        if (n.is_mpz())
-            mpz_ = n.mpz_;
-        else
-            mpz_ = (unsigned long int)n.get_ucst();
-        // Extend higher bits to zero
-        for (unsigned int i = n.size; i < ext_size; i++)
-        {
-                mpz_clrbit(mpz_.get_mpz_t(), i);
-        }
+        mpz_class tmp = n.get_mpz();
+        this->size = ext_size;
+        _set_mpz_value(tmp);
     }
 }
 
 void Number::set_sext(int ext_size, const Number& n)
 {
-    this->size = ext_size;
     if (ext_size <= 64)
     {
         cst_t tmp =  ((ucst_t)__number_cst_unsign_trunc(n.size, n.cst_));
-        if (tmp & (1U << (n.size-1)))
+        if (tmp & ((ucst_t)1 << (n.size-1)))
         {
             // hsb is 1 add mask
             tmp |= (__number_cst_mask(ext_size - n.size) << n.size);
         }
+        this->size = ext_size;
         set_cst(tmp);
     }
+    else if (ext_size <= 256)
+    {
+        UInt256 tmp = n._get_u256();
+        tmp.sign_extend(n.size);
+        this->size = ext_size;
+        _set_u256(tmp);
+    }
     else
     {
-        if (n.is_mpz())
-            mpz_ = n.mpz_;
-        else
-            mpz_ = (unsigned long int)n.get_ucst();
-        // Extend higher bits
-        bool hsb_set = mpz_tstbit(mpz_.get_mpz_t(), n.size-1);
-        for (unsigned int i = n.size; i < ext_size; i++)
+        mpz_class tmp = n.get_mpz();
+        // Negative values are normalized by _set_mpz_value()
+        if (mpz_tstbit(tmp.get_mpz_t(), n.size-1))
         {
-            if (hsb_set)
-                mpz_setbit(mpz_.get_mpz_t(), i);
-            else
-                mpz_clrbit(mpz_.get_mpz_t(), i);
+            mpz_class high;
+            mpz_setbit(high.get_mpz_t(), n.size);
+            tmp -= high;
         }
-        adjust_mpz();
+        this->size = ext_size;
+        _set_mpz_value(tmp);
     }
 }
 
@@ -657,11 +840,15 @@ void Number::set_mask(int mask_size)
     {
         set_cst(__number_cst_mask(mask_size));
     }
+    else if (_is_wide())
+    {
+        _set_u256(_wide | UInt256::ones(mask_size));
+    }
     else
     {
         for (unsigned int i = 0; i < mask_size; i++)
         {
-                mpz_setbit(mpz_.get_mpz_t(), i);
+                mpz_setbit(mpz().get_mpz_t(), i);
         }
     }
 }
@@ -688,11 +875,18 @@ void Number::set_overwrite(const Number& n1, const Number& n2, int lb)
         this->size = n1.size;
         set_cst(res);
     }
+    else if (n1._is_wide())
+    {
+        UInt256 mask = ~(UInt256::ones(n2.size) << lb);
+        UInt256 res = (n1._wide & mask) | (n2._get_u256() << lb);
+        this->size = n1.size;
+        _set_u256(res);
+    }
     else
     {
         // Make copies in case n1 or n2 is a reference to 'this'
-        mpz_class tmp = n1.mpz_;
-        mpz_class tmp2 = n2.is_mpz() ? n2.mpz_ : (unsigned long int)n2.get_ucst();
+        mpz_class tmp = n1.mpz();
+        mpz_class tmp2 = n2.get_mpz();
         for (int i = 0; i < n2.size; i++)
         {
             if (mpz_tstbit(tmp2.get_mpz_t(), i) == 1)
@@ -704,7 +898,7 @@ void Number::set_overwrite(const Number& n1, const Number& n2, int lb)
                 mpz_clrbit(tmp.get_mpz_t(), i + lb);
             }
         }
-        mpz_ = tmp;
+        mpz() = tmp;
         this->size = n1.size;
     }
 }
@@ -715,6 +909,15 @@ bool Number::sless_than(const Number& other) const
     {
         return (cst_t)cst_ < (cst_t)other.cst_;
     }
+    else if (_is_wide())
+    {
+        int sign1 = _wide.get_bit(size-1);
+        int sign2 = other._wide.get_bit(size-1);
+        if (sign1 != sign2)
+            return sign1 > sign2;
+        // Same sign, two's complement values compare like unsigned values
+        return _wide < other._wide;
+    }
     else
     {
         // mpz_cmp returns a positive value if op1 > op2, 
@@ -747,39 +950,14 @@ bool Number::less_than(const Number& other) const
     {
         return (ucst_t)cst_ < (ucst_t)other.cst_;
     }
+    else if (_is_wide())
+    {
+        return _wide < other._wide;
+    }
     else
-    {   
-        // TODO(boyan): might work with a simple mpz_cmp() if we interpret everything
-        // as unsigned... instead of the if cases below
-        if (mpz_sgn(mpz_.get_mpz_t()) == -1)
-        {
-            // this is a negative number
-            if (mpz_sgn(other.mpz_.get_mpz_t()) == -1)
-            {
-                // both are negative, so the bigger one is also
-                // the bigger one when interpreted as unsigned
-                return mpz_cmp(mpz_.get_mpz_t(), other.mpz_.get_mpz_t()) < 0;
-            }
-            else
-            {
-                // other one is positive so this one will be bigger (MSB == 1)
-                return false;
-            }
-        }
-        else
-        {
-            // this is a positive number
-            if (mpz_sgn(other.mpz_.get_mpz_t()) == -1)
-            {
-                // other is negative and will always be bigger (MSB == 1)
-                return true;
-            }
-            else
-            {
-                // both are positive
-                return mpz_cmp(mpz_.get_mpz_t(), other.mpz_.get_mpz_t()) < 0;
-            }
-        }
+    {
+        // Values are kept positive by adjust_mpz()
+        return mpz_cmp(mpz().get_mpz_t(), other.mpz().get_mpz_t()) < 0;
     }
 }
 
@@ -802,11 +980,15 @@ bool Number::equal_to(const Number& other) const
     {
         return (cst_t)cst_ == (cst_t)other.cst_;
     }
+    else if (_is_wide())
+    {
+        return _wide == other._wide;
+    }
     else
     {
         // mpz_cmp returns a positive value if op1 > op2, 
         // zero if op1 = op2, or a negative value if op1 < op2
-        return mpz_cmp(mpz_.get_mpz_t(), other.mpz_.get_mpz_t()) == 0;
+        return mpz_cmp(mpz().get_mpz_t(), other.mpz().get_mpz_t()) == 0;
     }
 }
 
@@ -815,8 +997,10 @@ bool Number::is_null() const
 {
     if (size <= 64)
         return cst_ == 0;
+    else if (_is_wide())
+        return _wide.is_zero();
     else
-        return mpz_cmp_ui(mpz_.get_mpz_t(), 0) == 0;
+        return mpz_cmp_ui(mpz().get_mpz_t(), 0) == 0;
 }
 
 bool Number::is_mpz() const
@@ -839,9 +1023,9 @@ void Number::print(std::ostream& os, bool decimal) const
     {
         char str[1000];  // Enough to store the string representation
                         // of a number on 512 bits
-        //mpz_get_str(str, 16,n. mpz_); // Base 16
+        //mpz_get_str(str, 16,n. mpz()); // Base 16
         const char* fmt = decimal? __dec_format : __hex_format; 
-        gmp_snprintf(str, sizeof(str), fmt, mpz_.get_mpz_t());
+        gmp_snprintf(str, sizeof(str), fmt, get_mpz().get_mpz_t());
         if (not decimal)
             os << "0x";
         os << std::string(str);
@@ -1,5 +1,6 @@
 #include "maat/simplification.hpp"
 #include "maat/exception.hpp"
+#include "maat/stats.hpp"
 #include <iostream>
 #include <algorithm>
 #include <iterator>
@@ -8,18 +9,136 @@
 namespace maat
 {
 
+/* SimplificationMemo implementation */
+
+SimplificationMemo::SimplificationMemo(size_t capacity)
+{
+    size_t size = 1;
+    while (size < capacity)
+        size <<= 1;
+    _entries.resize(size, Entry{nullptr, nullptr});
+    _mask = size-1;
+}
+
+// Return true if 'e1' and 'e2' have the same structure. Distinct memory
+// read objects never match
+static bool _same_structure(const Expr& e1, const Expr& e2)
+{
+    if (e1 == e2)
+        return true;
+    if (
+        e1->type != e2->type
+        or e1->size != e2->size
+        or e1->hash() != e2->hash()
+        or e1->args.size() != e2->args.size()
+    )
+        return false;
+
+    switch (e1->type)
+    {
+        case ExprType::CST:
+            if (not e1->as_number().equal_to(e2->as_number()))
+                return false;
+            break;
+        case ExprType::VAR:
+            if (e1->name() != e2->name())
+                return false;
+            break;
+        case ExprType::UNOP:
+        case ExprType::BINOP:
+            if (e1->op() != e2->op())
+                return false;
+            break;
+        case ExprType::ITE:
+            if (e1->cond_op() != e2->cond_op())
+                return false;
+            break;
+        case ExprType::MEM:
+            return false;
+        default: // Extract and concat are described by their arguments
+            break;
+    }
+
+    for (size_t i = 0; i < e1->args.size(); i++)
+        if (not _same_structure(e1->args[i], e2->args[i]))
+            return false;
+    return true;
+}
+
+Expr SimplificationMemo::get(const Expr& e) const
+{
+    const Entry& entry = _entries[e->hash() & _mask];
+    if (entry.result != nullptr and _same_structure(entry.key, e))
+        return entry.result;
+    return nullptr;
+}
+
+void SimplificationMemo::record(const Expr& e, Expr result)
+{
+    Entry& entry = _entries[e->hash() & _mask];
+    entry.key = e;
+    entry.result = result;
+}
+
+void SimplificationMemo::clear()
+{
+    for (Entry& entry : _entries)
+    {
+        entry.key = nullptr;
+        entry.result = nullptr;
+    }
+}
+
+size_t SimplificationMemo::capacity() const
+{
+    return _entries.size();
+}
+
 /* ExprSimplifier implementation */ 
 
-unsigned int ExprSimplifier::_id_cnt = 0;
+std::atomic<unsigned int> ExprSimplifier::_id_cnt = 0;
 
 ExprSimplifier::ExprSimplifier()
 {
     _id = _id_cnt++; // Get id from static class variable _id_cnt
+    memo = std::make_shared<SimplificationMemo>();
+}
+
+ExprSimplifier::ExprSimplifier(const ExprSimplifier& other):
+    _id(other._id),
+    simplifiers(other.simplifiers),
+    rec_simplifiers(other.rec_simplifiers),
+    patterns(other.patterns),
+    dispatch(other.dispatch),
+    memo(nullptr)
+{
+    // Same simplifications so keep the ID, expressions simplified by
+    // 'other' don't need to be simplified again
+    if (other.memo != nullptr)
+        memo = std::make_shared<SimplificationMemo>(other.memo->capacity());
+}
+
+void ExprSimplifier::set_memo(std::shared_ptr<SimplificationMemo> new_memo)
+{
+    memo = new_memo;
+}
+
+std::shared_ptr<SimplificationMemo> ExprSimplifier::get_memo() const
+{
+    return memo;
 }
 
 void ExprSimplifier::add(ExprSimplifierFunc func)
+{
+    add(func, {SimplifierPattern()});
+}
+
+void ExprSimplifier::add(ExprSimplifierFunc func, std::initializer_list<SimplifierPattern> func_patterns)
 {
     simplifiers.push_back(func);
+    patterns.push_back(func_patterns);
+    // Dispatch table must be computed again
+    dispatch.clear();
 }
 
 
@@ -33,13 +152,65 @@ void ExprSimplifier::add_restruct(RecExprSimplifierFunc func){
 }
 */
 
+static constexpr int nb_expr_types = (int)ExprType::NONE + 1;
+static constexpr int nb_ops = (int)Op::NONE + 1;
+
+uint64_t ExprSimplifier::_candidates(const Expr& e)
+{
+    if (simplifiers.size() > max_dispatched)
+        return ~(uint64_t)0;
+
+    ExprType type = e->type;
+    Op op = (type == ExprType::UNOP or type == ExprType::BINOP) ? e->op() : Op::NONE;
+    ExprType arg0 = e->args.size() > 0 ? e->args[0]->type : ExprType::NONE;
+    ExprType arg1 = e->args.size() > 1 ? e->args[1]->type : ExprType::NONE;
+    size_t idx = (((int)type*nb_ops + (int)op)*nb_expr_types + (int)arg0)*nb_expr_types + (int)arg1;
+
+    if (dispatch.empty())
+        dispatch.resize(nb_expr_types*nb_ops*nb_expr_types*nb_expr_types, 0);
+
+    uint64_t& res = dispatch[idx];
+    if (not (res & dispatch_computed))
+    {
+        // Compute entry the first time we see this kind of expression
+        res = dispatch_computed;
+        for (size_t i = 0; i < simplifiers.size(); i++)
+        {
+            for (const SimplifierPattern& pattern : patterns[i])
+            {
+                if (pattern.matches(type, op, arg0, arg1))
+                {
+                    res |= (uint64_t)1 << i;
+                    break;
+                }
+            }
+        }
+    }
+    return res;
+}
+
 Expr ExprSimplifier::run_simplifiers(Expr e)
 {
     Expr tmp_expr = e; 
 
-    /* Normal functions */ 
-    for(auto func = simplifiers.begin(); func != simplifiers.end(); func++){
-        tmp_expr = (**func)(tmp_expr);
+    /* Normal functions. We only call the functions that can match the
+     * current expression, in the order they were added. When a function
+     * changes the expression, the remaining candidates are computed again */
+    uint64_t candidates = _candidates(tmp_expr);
+    for (size_t i = 0; i < simplifiers.size(); i++)
+    {
+        uint64_t remaining = candidates & (~(uint64_t)0 << i);
+        if (remaining == 0)
+            break;
+        i = __builtin_ctzll(remaining);
+        if (i >= simplifiers.size())
+            break;
+        Expr res = simplifiers[i](tmp_expr);
+        if (res != tmp_expr)
+        {
+            tmp_expr = res;
+            candidates = _candidates(tmp_expr);
+        }
     }
     /* Recursive functions */ 
     for (auto rec_func = rec_simplifiers.begin(); rec_func != rec_simplifiers.end(); rec_func++)
@@ -63,6 +234,22 @@ Expr ExprSimplifier::simplify(Expr e, bool mark_as_simplified)
         return e->_simplified_expr;
     }
 
+    // Look for the result in the memo. Hashes don't include taint so
+    // tainted expressions are not cached
+    bool use_memo = memo != nullptr and not e->args.empty() and not e->is_tainted();
+    if (use_memo)
+    {
+        Expr cached = memo->get(e);
+        if (cached != nullptr)
+        {
+            MaatStats::instance().inc_simplify_memo_hits();
+            if (mark_as_simplified and cached->neq(e))
+                e->_simplified_expr = cached;
+            return cached;
+        }
+        MaatStats::instance().inc_simplify_memo_misses();
+    }
+
     // Simplify util fix point is found
     do
     {
@@ -102,27 +289,76 @@ Expr ExprSimplifier::simplify(Expr e, bool mark_as_simplified)
         tmp_expr->_simplifier_id = _id;
     }
 
+    // The arguments of 'e' might have been simplified in place, so it is
+    // recorded in its current form
+    if (use_memo)
+        memo->record(e, tmp_expr);
+
     return tmp_expr;
 }
 
 std::shared_ptr<ExprSimplifier> NewDefaultExprSimplifier()
 {
+    using P = SimplifierPattern;
+    using T = ExprType;
+    constexpr uint32_t any = SimplifierPattern::any;
+    constexpr uint32_t cst = expr_types(T::CST);
+    constexpr uint32_t mul_ops = expr_ops(Op::MUL, Op::MULH, Op::SMULL, Op::SMULH);
+
     auto simp = std::make_shared<ExprSimplifier>();
-    simp->add(es_constant_folding);
-    simp->add(es_neutral_elements);
-    simp->add(es_absorbing_elements);
-    simp->add(es_arithmetic_properties);
-    simp->add(es_involution);
-    simp->add(es_extract_patterns);
-
-    simp->add(es_basic_transform);
-    simp->add(es_logical_properties);
-    simp->add(es_concat_patterns);
-    simp->add(es_arithmetic_factorize);
-    simp->add(es_basic_ite);
-    simp->add(es_ite_patterns);
+    simp->add(es_constant_folding, {
+        P(expr_types(T::BINOP, T::UNOP, T::EXTRACT, T::CONCAT, T::ITE), any, cst)
+    });
+    simp->add(es_neutral_elements, {
+        P(expr_types(T::BINOP), expr_ops(Op::ADD, Op::MUL, Op::SMULL, Op::AND, Op::OR, Op::XOR), cst),
+        P(expr_types(T::BINOP), expr_ops(Op::DIV, Op::SDIV, Op::SHL, Op::SHR, Op::SAR), any, cst),
+        P(expr_types(T::EXTRACT))
+    });
+    simp->add(es_absorbing_elements, {
+        P(expr_types(T::BINOP), mul_ops | expr_ops(Op::AND, Op::OR, Op::DIV, Op::SDIV), cst),
+        P(expr_types(T::BINOP), expr_ops(Op::SHL, Op::SHR, Op::SAR), any, cst)
+    });
+    simp->add(es_arithmetic_properties, {
+        P(expr_types(T::BINOP), expr_ops(Op::ADD), expr_types(T::UNOP, T::BINOP)),
+        P(expr_types(T::BINOP), expr_ops(Op::ADD), any, expr_types(T::UNOP, T::BINOP))
+    });
+    simp->add(es_involution, {
+        P(expr_types(T::UNOP), expr_ops(Op::NEG, Op::NOT), expr_types(T::UNOP))
+    });
+    simp->add(es_extract_patterns, {
+        P(expr_types(T::EXTRACT))
+    });
+
+    simp->add(es_basic_transform, {
+        P(expr_types(T::BINOP), expr_ops(Op::SHL, Op::SHR), any, cst),
+        P(expr_types(T::UNOP), expr_ops(Op::NEG)),
+        P(expr_types(T::BINOP), expr_ops(Op::ADD), cst, expr_types(T::UNOP)),
+        P(expr_types(T::BINOP), expr_ops(Op::XOR), cst),
+        P(expr_types(T::BINOP), mul_ops | expr_ops(Op::SDIV), cst, expr_types(T::UNOP)),
+        P(expr_types(T::BINOP), mul_ops | expr_ops(Op::SDIV), expr_types(T::UNOP), cst)
+    });
+    simp->add(es_logical_properties, {
+        P(expr_types(T::BINOP), expr_ops(Op::AND, Op::OR, Op::XOR))
+    });
+    simp->add(es_concat_patterns, {
+        P(expr_types(T::CONCAT), any, expr_types(T::EXTRACT), expr_types(T::EXTRACT)),
+        P(expr_types(T::CONCAT), any, any, expr_types(T::ITE)),
+        P(expr_types(T::BINOP), expr_ops(Op::SHR), expr_types(T::CONCAT), cst),
+        P(expr_types(T::BINOP), expr_ops(Op::AND, Op::OR, Op::XOR, Op::NOT), cst, expr_types(T::CONCAT))
+    });
+    simp->add(es_arithmetic_factorize, {
+        P(expr_types(T::BINOP), expr_ops(Op::ADD))
+    });
+    simp->add(es_basic_ite, {
+        P(expr_types(T::ITE))
+    });
+    simp->add(es_ite_patterns, {
+        P(expr_types(T::ITE))
+    });
     //simp->add(es_generic_distribute);
-    simp->add(es_generic_factorize);
+    simp->add(es_generic_factorize, {
+        P(expr_types(T::BINOP), any, expr_types(T::BINOP), expr_types(T::BINOP))
+    });
     //simp->add(es_deep_associative);
     return simp;
 }
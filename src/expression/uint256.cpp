@@ -0,0 +1,342 @@
+#include "maat/uint256.hpp"
+
+namespace maat
+{
+
+typedef unsigned __int128 uint128_t;
+
+bool UInt256::is_zero() const
+{
+    return (limbs[0] | limbs[1] | limbs[2] | limbs[3]) == 0;
+}
+
+int UInt256::get_bit(unsigned int idx) const
+{
+    if (idx >= 256)
+        return 0;
+    return (limbs[idx/64] >> (idx%64)) & 1;
+}
+
+void UInt256::set_bit(unsigned int idx)
+{
+    if (idx < 256)
+        limbs[idx/64] |= (uint64_t)1 << (idx%64);
+}
+
+void UInt256::truncate(size_t bits)
+{
+    for (unsigned int i = 0; i < 4; i++)
+    {
+        if (bits <= i*64)
+            limbs[i] = 0;
+        else if (bits < (i+1)*64)
+            limbs[i] &= ((uint64_t)1 << (bits - i*64)) - 1;
+    }
+}
+
+void UInt256::sign_extend(size_t bits)
+{
+    if (bits == 0 or bits >= 256 or get_bit(bits-1) == 0)
+        return;
+    *this = *this | ~ones(bits);
+}
+
+unsigned int UInt256::popcount() const
+{
+    unsigned int res = 0;
+    for (uint64_t limb : limbs)
+    {
+        for (; limb != 0; limb &= limb - 1)
+            res++;
+    }
+    return res;
+}
+
+bool UInt256::less_than(uint64_t val) const
+{
+    return (limbs[1] | limbs[2] | limbs[3]) == 0 and limbs[0] < val;
+}
+
+bool operator==(const UInt256& a, const UInt256& b)
+{
+    return a.limbs[0] == b.limbs[0] and a.limbs[1] == b.limbs[1]
+        and a.limbs[2] == b.limbs[2] and a.limbs[3] == b.limbs[3];
+}
+
+bool operator!=(const UInt256& a, const UInt256& b)
+{
+    return not (a == b);
+}
+
+bool operator<(const UInt256& a, const UInt256& b)
+{
+    for (int i = 3; i >= 0; i--)
+    {
+        if (a.limbs[i] != b.limbs[i])
+            return a.limbs[i] < b.limbs[i];
+    }
+    return false;
+}
+
+UInt256 operator+(const UInt256& a, const UInt256& b)
+{
+    UInt256 res;
+    uint128_t carry = 0;
+    for (int i = 0; i < 4; i++)
+    {
+        carry += (uint128_t)a.limbs[i] + b.limbs[i];
+        res.limbs[i] = (uint64_t)carry;
+        carry >>= 64;
+    }
+    return res;
+}
+
+UInt256 operator-(const UInt256& a, const UInt256& b)
+{
+    return a + (-b);
+}
+
+UInt256 operator-(const UInt256& a)
+{
+    return ~a + UInt256(1);
+}
+
+UInt256 operator*(const UInt256& a, const UInt256& b)
+{
+    UInt256 res;
+    for (int i = 0; i < 4; i++)
+    {
+        if (a.limbs[i] == 0)
+            continue;
+        uint128_t carry = 0;
+        for (int j = 0; i+j < 4; j++)
+        {
+            carry += (uint128_t)a.limbs[i] * b.limbs[j] + res.limbs[i+j];
+            res.limbs[i+j] = (uint64_t)carry;
+            carry >>= 64;
+        }
+    }
+    return res;
+}
+
+UInt256 operator&(const UInt256& a, const UInt256& b)
+{
+    UInt256 res;
+    for (int i = 0; i < 4; i++)
+        res.limbs[i] = a.limbs[i] & b.limbs[i];
+    return res;
+}
+
+UInt256 operator|(const UInt256& a, const UInt256& b)
+{
+    UInt256 res;
+    for (int i = 0; i < 4; i++)
+        res.limbs[i] = a.limbs[i] | b.limbs[i];
+    return res;
+}
+
+UInt256 operator^(const UInt256& a, const UInt256& b)
+{
+    UInt256 res;
+    for (int i = 0; i < 4; i++)
+        res.limbs[i] = a.limbs[i] ^ b.limbs[i];
+    return res;
+}
+
+UInt256 operator~(const UInt256& a)
+{
+    UInt256 res;
+    for (int i = 0; i < 4; i++)
+        res.limbs[i] = ~a.limbs[i];
+    return res;
+}
+
+UInt256 operator<<(const UInt256& a, unsigned int shift)
+{
+    UInt256 res;
+    if (shift >= 256)
+        return res;
+    unsigned int limb_shift = shift / 64, bit_shift = shift % 64;
+    for (int i = 3; i >= (int)limb_shift; i--)
+    {
+        res.limbs[i] = a.limbs[i-limb_shift] << bit_shift;
+        if (bit_shift != 0 and i > (int)limb_shift)
+            res.limbs[i] |= a.limbs[i-limb_shift-1] >> (64 - bit_shift);
+    }
+    return res;
+}
+
+UInt256 operator>>(const UInt256& a, unsigned int shift)
+{
+    UInt256 res;
+    if (shift >= 256)
+        return res;
+    unsigned int limb_shift = shift / 64, bit_shift = shift % 64;
+    for (unsigned int i = 0; i + limb_shift < 4; i++)
+    {
+        res.limbs[i] = a.limbs[i+limb_shift] >> bit_shift;
+        if (bit_shift != 0 and i + limb_shift + 1 < 4)
+            res.limbs[i] |= a.limbs[i+limb_shift+1] << (64 - bit_shift);
+    }
+    return res;
+}
+
+UInt256 UInt256::ones(size_t bits)
+{
+    UInt256 res;
+    res = ~res;
+    res.truncate(bits);
+    return res;
+}
+
+// Number of leading zeros in a 32-bit digit
+static int nlz32(uint32_t x)
+{
+    int n = 0;
+    if (x == 0)
+        return 32;
+    while ((x & 0x80000000) == 0)
+    {
+        n++;
+        x <<= 1;
+    }
+    return n;
+}
+
+// Knuth's algorithm D on 32-bit digits, adapted from Hacker's Delight (divmnu64).
+// 'u' has 'm' digits, 'v' has 'n' digits, m >= n >= 1 and v[n-1] != 0
+static void divmnu(uint32_t q[], uint32_t r[], const uint32_t u[], const uint32_t v[], int m, int n)
+{
+    const uint64_t b = (uint64_t)1 << 32;
+    uint32_t un[9], vn[8];
+    uint64_t qhat, rhat, p;
+    int64_t t, k;
+    int s, i, j;
+
+    if (n == 1)
+    {
+        uint64_t rem = 0;
+        for (j = m-1; j >= 0; j--)
+        {
+            uint64_t cur = rem*b + u[j];
+            q[j] = cur / v[0];
+            rem = cur - (uint64_t)q[j]*v[0];
+        }
+        r[0] = rem;
+        return;
+    }
+
+    // Normalize so that the highest digit of the divisor has its top bit set
+    s = nlz32(v[n-1]);
+    for (i = n-1; i > 0; i--)
+        vn[i] = (v[i] << s) | (uint32_t)((uint64_t)v[i-1] >> (32-s));
+    vn[0] = v[0] << s;
+    un[m] = (uint32_t)((uint64_t)u[m-1] >> (32-s));
+    for (i = m-1; i > 0; i--)
+        un[i] = (u[i] << s) | (uint32_t)((uint64_t)u[i-1] >> (32-s));
+    un[0] = u[0] << s;
+
+    for (j = m-n; j >= 0; j--)
+    {
+        // Estimate the quotient digit
+        qhat = ((uint64_t)un[j+n]*b + un[j+n-1]) / vn[n-1];
+        rhat = ((uint64_t)un[j+n]*b + un[j+n-1]) - qhat*vn[n-1];
+        while (qhat >= b or qhat*vn[n-2] > b*rhat + un[j+n-2])
+        {
+            qhat--;
+            rhat += vn[n-1];
+            if (rhat >= b)
+                break;
+        }
+        // Multiply and subtract
+        k = 0;
+        for (i = 0; i < n; i++)
+        {
+            p = qhat*vn[i];
+            t = (int64_t)un[i+j] - k - (int64_t)(p & 0xffffffff);
+            un[i+j] = (uint32_t)t;
+            k = (int64_t)(p >> 32) - (t >> 32);
+        }
+        t = (int64_t)un[j+n] - k;
+        un[j+n] = (uint32_t)t;
+
+        q[j] = (uint32_t)qhat;
+        if (t < 0)
+        {
+            // Subtracted too much, add back
+            q[j]--;
+            k = 0;
+            for (i = 0; i < n; i++)
+            {
+                t = (int64_t)un[i+j] + vn[i] + k;
+                un[i+j] = (uint32_t)t;
+                k = t >> 32;
+            }
+            un[j+n] += (uint32_t)k;
+        }
+    }
+
+    // Unnormalize the remainder
+    for (i = 0; i < n-1; i++)
+        r[i] = (un[i] >> s) | (uint32_t)((uint64_t)un[i+1] << (32-s));
+    r[n-1] = un[n-1] >> s;
+}
+
+void UInt256::divmod(const UInt256& a, const UInt256& b, UInt256& quotient, UInt256& remainder)
+{
+    // Fast path when both values fit on 64 bits
+    if ((a.limbs[1] | a.limbs[2] | a.limbs[3] | b.limbs[1] | b.limbs[2] | b.limbs[3]) == 0)
+    {
+        uint64_t x = a.limbs[0], y = b.limbs[0];
+        quotient = UInt256(x / y);
+        remainder = UInt256(x % y);
+        return;
+    }
+    if (a < b)
+    {
+        remainder = a;
+        quotient = UInt256();
+        return;
+    }
+
+    uint32_t u[8], v[8], q[8] = {0}, r[8] = {0};
+    for (int i = 0; i < 4; i++)
+    {
+        u[2*i] = (uint32_t)a.limbs[i];
+        u[2*i+1] = (uint32_t)(a.limbs[i] >> 32);
+        v[2*i] = (uint32_t)b.limbs[i];
+        v[2*i+1] = (uint32_t)(b.limbs[i] >> 32);
+    }
+    int m = 8, n = 8;
+    while (m > 1 and u[m-1] == 0)
+        m--;
+    while (n > 1 and v[n-1] == 0)
+        n--;
+    divmnu(q, r, u, v, m, n);
+
+    for (int i = 0; i < 4; i++)
+    {
+        quotient.limbs[i] = (uint64_t)q[2*i] | ((uint64_t)q[2*i+1] << 32);
+        remainder.limbs[i] = (uint64_t)r[2*i] | ((uint64_t)r[2*i+1] << 32);
+    }
+}
+
+mpz_class UInt256::to_mpz() const
+{
+    mpz_class res;
+    mpz_import(res.get_mpz_t(), 4, -1, sizeof(uint64_t), 0, 0, limbs);
+    return res;
+}
+
+UInt256 UInt256::from_mpz(const mpz_class& val)
+{
+    UInt256 res;
+    mpz_class tmp;
+    // fdiv gives the positive remainder, which is the two's complement
+    // representation for negative values
+    mpz_fdiv_r_2exp(tmp.get_mpz_t(), val.get_mpz_t(), 256);
+    mpz_export(res.limbs, nullptr, -1, sizeof(uint64_t), 0, 0, tmp.get_mpz_t());
+    return res;
+}
+
+} // namespace maat
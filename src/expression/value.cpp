@@ -1,11 +1,177 @@
 #include "maat/value.hpp"
+#include <algorithm>
 
 namespace maat
 {
 
 using serial::bits;
 
-Value::Value(): _expr(nullptr), type(Value::Type::NONE){}
+// Shadow taint helpers. Masks have one bit per bit for values up
+// to 64 bits and one bit per byte for wider values
+namespace
+{
+
+inline unsigned int taint_idx(size_t size, unsigned int bit)
+{
+    if (size <= 64)
+        return bit;
+    return std::min(bit/8, 63U);
+}
+
+inline ucst_t taint_full(size_t size)
+{
+    return cst_mask(size <= 64 ? size : std::min<size_t>((size+7)/8, 64));
+}
+
+// Mask of the shadow bits covering bits 'high' to 'low'
+inline ucst_t taint_range(size_t size, unsigned int high, unsigned int low)
+{
+    unsigned int h = taint_idx(size, high), l = taint_idx(size, low);
+    return (ucst_t)cst_mask(h-l+1) << l;
+}
+
+inline bool taint_in_range(ucst_t t, size_t size, unsigned int high, unsigned int low)
+{
+    return t != 0 and (t & taint_range(size, high, low)) != 0;
+}
+
+// Build a 'size'-bit shadow mask, 'tainted(high, low)' tells whether
+// the bits covered by one shadow bit are tainted
+template<typename F>
+ucst_t taint_build(size_t size, F tainted)
+{
+    ucst_t res = 0;
+    unsigned int unit = size <= 64 ? 1 : 8;
+    unsigned int nb = size <= 64 ? size : std::min<size_t>((size+7)/8, 64);
+    for (unsigned int i = 0; i < nb; i++)
+    {
+        unsigned int low = i*unit;
+        unsigned int high = (i == nb-1)? size-1 : low+unit-1;
+        if (tainted(high, low))
+            res |= (ucst_t)1 << i;
+    }
+    return res;
+}
+
+// Shadow of bits 'high' to 'low' of a 'size'-bit value
+ucst_t taint_extract(ucst_t t, size_t size, unsigned int high, unsigned int low)
+{
+    size_t res_size = high-low+1;
+    if (t == 0)
+        return 0;
+    else if (size <= 64)
+        return (t >> low) & cst_mask(res_size);
+    return taint_build(res_size, [&](unsigned int h, unsigned int l){
+        return taint_in_range(t, size, h+low, l+low);
+    });
+}
+
+// Shadow of a 'dest_size'-bit value holding a 'size'-bit value at bit
+// 'low', and untainted bits everywhere else
+ucst_t taint_place(ucst_t t, size_t size, size_t dest_size, unsigned int low)
+{
+    unsigned int high = low+size-1;
+    if (t == 0)
+        return 0;
+    else if (dest_size <= 64)
+        return t << low;
+    return taint_build(dest_size, [&](unsigned int h, unsigned int l){
+        if (h < low or l > high)
+            return false;
+        return taint_in_range(t, size, std::min(h, high)-low, std::max(l, low)-low);
+    });
+}
+
+// Taint all bits above the lowest tainted bit, used for arithmetic
+// operations where carries propagate towards the most significant bits
+inline ucst_t taint_smear(ucst_t t, size_t size)
+{
+    return (t | (~t+1)) & taint_full(size);
+}
+
+inline ucst_t taint_any(ucst_t t, size_t size)
+{
+    return t == 0 ? 0 : taint_full(size);
+}
+
+// Shift amount, at most 'size'
+inline ucst_t shift_amount(const Number& n, size_t size)
+{
+    if (n.size > 64 and not n.less_than(Number(n.size, size)))
+        return size;
+    return std::min<ucst_t>(n.get_ucst(), size);
+}
+
+// Shifting by a tainted amount taints the whole result
+inline ucst_t taint_shl(const Value& n1, const Value& n2)
+{
+    size_t size = n1.size();
+    if (n2.shadow_taint() != 0)
+        return taint_full(size);
+    ucst_t s = shift_amount(n2.number(), size);
+    if (s == size)
+        return 0;
+    return taint_place(taint_extract(n1.shadow_taint(), size, size-1-s, 0), size-s, size, s);
+}
+
+inline ucst_t taint_shr(const Value& n1, const Value& n2)
+{
+    size_t size = n1.size();
+    if (n2.shadow_taint() != 0)
+        return taint_full(size);
+    ucst_t s = shift_amount(n2.number(), size);
+    if (s == size)
+        return 0;
+    return taint_place(taint_extract(n1.shadow_taint(), size, size-1, s), size-s, size, 0);
+}
+
+inline ucst_t taint_sar(const Value& n1, const Value& n2)
+{
+    size_t size = n1.size();
+    if (n2.shadow_taint() != 0)
+        return taint_full(size);
+    ucst_t s = shift_amount(n2.number(), size);
+    ucst_t res = s == size ? 0 : taint_shr(n1, n2);
+    // Copies of the sign bit
+    if (s != 0 and taint_in_range(n1.shadow_taint(), size, size-1, size-1))
+        res |= taint_range(size, size-1, size-s);
+    return res;
+}
+
+// A bit ANDed with an untainted zero is untainted
+inline ucst_t taint_and(const Number& v1, ucst_t t1, const Number& v2, ucst_t t2)
+{
+    if ((t1 | t2) == 0 or v1.size > 64)
+        return t1 | t2;
+    ucst_t a = v1.get_ucst(), b = v2.get_ucst();
+    return (t1 & (b | t2)) | (t2 & (a | t1));
+}
+
+// A bit ORed with an untainted one is untainted
+inline ucst_t taint_or(const Number& v1, ucst_t t1, const Number& v2, ucst_t t2)
+{
+    if ((t1 | t2) == 0 or v1.size > 64)
+        return t1 | t2;
+    ucst_t a = v1.get_ucst(), b = v2.get_ucst();
+    return ((t1 & (~b | t2)) | (t2 & (~a | t1))) & taint_full(v1.size);
+}
+
+// Untaint bits 'high' to 'low', keeping shadow bits that also cover bits
+// outside of the range
+ucst_t taint_clear(ucst_t t, size_t size, unsigned int high, unsigned int low)
+{
+    if (t == 0)
+        return 0;
+    else if (size <= 64)
+        return t & ~taint_range(size, high, low);
+    return t & ~taint_build(size, [&](unsigned int h, unsigned int l){
+        return l >= low and h <= high;
+    });
+}
+
+} // anonymous namespace
+
+Value::Value(): _expr(nullptr), type(Value::Type::NONE), _taint(0){}
 
 Value::Value(const Expr& expr)
 {
@@ -33,13 +199,15 @@ Value& Value::operator=(const Expr& e)
 {
     _expr = e;
     type = Value::Type::ABSTRACT;
+    _taint = 0;
     return *this;
 }
 
 Value& Value::operator=(Expr&& e)
 {
-    _expr = e;
+    _expr = std::move(e);
     type = Value::Type::ABSTRACT;
+    _taint = 0;
     return *this;
 }
 
@@ -47,13 +215,15 @@ Value& Value::operator=(const Number& n)
 {
     _number = n;
     type = Value::Type::CONCRETE;
+    _taint = 0;
     return *this;
 }
 
 Value& Value::operator=(Number&& n)
 {
-    _number = n;
+    _number = std::move(n);
     type = Value::Type::CONCRETE;
+    _taint = 0;
     return *this;
 }
 
@@ -61,11 +231,13 @@ void Value::set_cst(size_t size, cst_t val)
 {
     _number = Number(size, val);
     type = Value::Type::CONCRETE;
+    _taint = 0;
 }
 
 void Value::set_none()
 {
     type = Value::Type::NONE;
+    _taint = 0;
 }
 
 size_t Value::size() const
@@ -87,6 +259,37 @@ bool Value::is_none() const
     return type == Value::Type::NONE;
 }
 
+bool Value::is_tainted() const
+{
+    if (is_abstract())
+        return _expr->is_tainted();
+    return _taint != 0;
+}
+
+ucst_t Value::shadow_taint() const
+{
+    return _taint;
+}
+
+void Value::set_shadow_taint(ucst_t mask)
+{
+    if (is_abstract())
+        throw expression_exception("Value::set_shadow_taint(): can not be used on abstract values");
+    _taint = mask & taint_full(size());
+}
+
+void Value::add_shadow_taint(unsigned int high, unsigned int low)
+{
+    if (is_abstract())
+        throw expression_exception("Value::add_shadow_taint(): can not be used on abstract values");
+    _taint |= taint_range(size(), high, low);
+}
+
+bool Value::has_shadow_taint(unsigned int high, unsigned int low) const
+{
+    return not is_abstract() and taint_in_range(_taint, size(), high, low);
+}
+
 bool Value::is_symbolic(const VarContext& ctx) const
 {
     return is_abstract() and _expr->is_symbolic(ctx);
@@ -104,7 +307,18 @@ bool Value::is_concrete(const VarContext& ctx) const
 
 Expr Value::as_expr() const
 {
-    return is_abstract()? _expr : exprcst(_number);
+    if (is_abstract())
+        return _expr;
+    Expr res = exprcst(_number);
+    if (_taint != 0)
+    {
+        // Expressions track taint on 64 bits at most
+        if (size() <= 64)
+            res->make_tainted(_taint);
+        else
+            res->make_tainted();
+    }
+    return res;
 }
 
 cst_t Value::as_int() const
@@ -169,8 +383,10 @@ void Value::set_neg(const Value& n)
         *this = -n.expr();
     else
     {
+        ucst_t t = taint_smear(n._taint, n.size());
         _number.set_neg(n.number());
         type = Value::Type::CONCRETE;
+        _taint = t;
     }
 }
 
@@ -180,8 +396,10 @@ void Value::set_not(const Value& n)
         *this = ~n.expr();
     else
     {
+        ucst_t t = n._taint;
         _number.set_not(n.number());
         type = Value::Type::CONCRETE;
+        _taint = t;
     }
 }
 
@@ -193,8 +411,10 @@ void Value::set_add(const Value& n1, const Value& n2)
     }
     else
     {
+        ucst_t t = taint_smear(n1._taint | n2._taint, n1.size());
         _number.set_add(n1.as_number(), n2.as_number());
         type = Value::Type::CONCRETE;
+        _taint = t;
     }
 }
 
@@ -206,8 +426,10 @@ void Value::set_sub(const Value& n1, const Value& n2)
     }
     else
     {
+        ucst_t t = taint_smear(n1._taint | n2._taint, n1.size());
         _number.set_sub(n1.as_number(), n2.as_number());
         type = Value::Type::CONCRETE;
+        _taint = t;
     }
 }
 
@@ -219,8 +441,10 @@ void Value::set_mul(const Value& n1, const Value& n2)
     }
     else
     {
+        ucst_t t = taint_smear(n1._taint | n2._taint, n1.size());
         _number.set_mul(n1.as_number(), n2.as_number());
         type = Value::Type::CONCRETE;
+        _taint = t;
     }
 }
 
@@ -232,8 +456,10 @@ void Value::set_xor(const Value& n1, const Value& n2)
     }
     else
     {
+        ucst_t t = n1._taint | n2._taint;
         _number.set_xor(n1.as_number(), n2.as_number());
         type = Value::Type::CONCRETE;
+        _taint = t;
     }
 }
 
@@ -245,8 +471,10 @@ void Value::set_shl(const Value& n1, const Value& n2)
     }
     else
     {
+        ucst_t t = taint_shl(n1, n2);
         _number.set_shl(n1.as_number(), n2.as_number());
         type = Value::Type::CONCRETE;
+        _taint = t;
     }
 }
 
@@ -258,8 +486,10 @@ void Value::set_shr(const Value& n1, const Value& n2)
     }
     else
     {
+        ucst_t t = taint_shr(n1, n2);
         _number.set_shr(n1.as_number(), n2.as_number());
         type = Value::Type::CONCRETE;
+        _taint = t;
     }
 }
 
@@ -271,8 +501,10 @@ void Value::set_sar(const Value& n1, const Value& n2)
     }
     else
     {
+        ucst_t t = taint_sar(n1, n2);
         _number.set_sar(n1.as_number(), n2.as_number());
         type = Value::Type::CONCRETE;
+        _taint = t;
     }
 }
 
@@ -284,8 +516,10 @@ void Value::set_and(const Value& n1, const Value& n2)
     }
     else
     {
+        ucst_t t = taint_and(n1.number(), n1._taint, n2.number(), n2._taint);
         _number.set_and(n1.as_number(), n2.as_number());
         type = Value::Type::CONCRETE;
+        _taint = t;
     }
 }
 
@@ -297,8 +531,10 @@ void Value::set_or(const Value& n1, const Value& n2)
     }
     else
     {
+        ucst_t t = taint_or(n1.number(), n1._taint, n2.number(), n2._taint);
         _number.set_or(n1.as_number(), n2.as_number());
         type = Value::Type::CONCRETE;
+        _taint = t;
     }
 }
 
@@ -310,8 +546,10 @@ void Value::set_sdiv(const Value& n1, const Value& n2)
     }
     else
     {
+        ucst_t t = taint_any(n1._taint | n2._taint, n1.size());
         _number.set_sdiv(n1.as_number(), n2.as_number());
         type = Value::Type::CONCRETE;
+        _taint = t;
     }
 }
 
@@ -323,8 +561,10 @@ void Value::set_div(const Value& n1, const Value& n2)
     }
     else
     {
+        ucst_t t = taint_any(n1._taint | n2._taint, n1.size());
         _number.set_div(n1.as_number(), n2.as_number());
         type = Value::Type::CONCRETE;
+        _taint = t;
     }
 }
 
@@ -336,8 +576,10 @@ void Value::set_extract(const Value& n, unsigned int high, unsigned int low)
     }
     else
     {
+        ucst_t t = taint_extract(n._taint, n.size(), high, low);
         _number.set_extract(n.as_number(), high, low);
         type = Value::Type::CONCRETE;
+        _taint = t;
     }
 }
 
@@ -349,8 +591,11 @@ void Value::set_concat(const Value& n1, const Value& n2)
     }
     else
     {
+        ucst_t t = taint_place(n1._taint, n1.size(), n1.size()+n2.size(), n2.size())
+            | taint_place(n2._taint, n2.size(), n1.size()+n2.size(), 0);
         _number.set_concat(n1.as_number(), n2.as_number());
         type = Value::Type::CONCRETE;
+        _taint = t;
     }
 }
 
@@ -362,8 +607,10 @@ void Value::set_rem(const Value& n1, const Value& n2)
     }
     else
     {
+        ucst_t t = taint_any(n1._taint | n2._taint, n1.size());
         _number.set_rem(n1.as_number(), n2.as_number());
         type = Value::Type::CONCRETE;
+        _taint = t;
     }
 }
 
@@ -375,8 +622,10 @@ void Value::set_srem(const Value& n1, const Value& n2)
     }
     else
     {
+        ucst_t t = taint_any(n1._taint | n2._taint, n1.size());
         _number.set_srem(n1.as_number(), n2.as_number());
         type = Value::Type::CONCRETE;
+        _taint = t;
     }
 }
 
@@ -390,8 +639,11 @@ void Value::set_overwrite(const Value& n1, const Value& n2, int lb)
     }
     else
     {
+        ucst_t t = taint_clear(n1._taint, n1.size(), lb+n2.size()-1, lb)
+            | taint_place(n2._taint, n2.size(), n1.size(), lb);
         _number.set_overwrite(n1.as_number(), n2.as_number(), lb);
         type = Value::Type::CONCRETE;
+        _taint = t;
     }
 }
 
@@ -410,8 +662,10 @@ void Value::set_popcount(int dest_size, const Value& n)
     }
     else
     {
+        ucst_t t = taint_any(n._taint, dest_size);
         _number.set_popcount(dest_size, n.as_number());
         type = Value::Type::CONCRETE;
+        _taint = t;
     }
 }
 
@@ -437,8 +691,10 @@ void Value::set_zext(int ext_size, const Value& n)
     }
     else
     {
+        ucst_t t = taint_place(n._taint, n.size(), ext_size, 0);
         _number.set_zext(ext_size, n.number());
         type = Value::Type::CONCRETE;
+        _taint = t;
     }
 }
 
@@ -487,8 +743,12 @@ void Value::set_sext(int ext_size, const Value& n)
     }
     else
     {
+        ucst_t t = taint_place(n._taint, n.size(), ext_size, 0);
+        if (taint_in_range(n._taint, n.size(), n.size()-1, n.size()-1))
+            t |= taint_range(ext_size, ext_size-1, n.size());
         _number.set_sext(ext_size, n.number());
         type = Value::Type::CONCRETE;
+        _taint = t;
     }
 }
 
@@ -503,8 +763,10 @@ void Value::set_less_than(const Value& n1, const Value& n2, size_t size)
     }
     else
     {
+        ucst_t t = taint_any(n1._taint | n2._taint, size);
         _number = Number(size, n1.as_number().less_than(n2.as_number()) ? 1 : 0 );
         type = Value::Type::CONCRETE;
+        _taint = t;
     }
 }
 
@@ -519,8 +781,10 @@ void Value::set_lessequal_than(const Value& n1, const Value& n2, size_t size)
     }
     else
     {
+        ucst_t t = taint_any(n1._taint | n2._taint, size);
         _number = Number(size, n1.as_number().lessequal_than(n2.as_number()) ? 1 : 0 );
         type = Value::Type::CONCRETE;
+        _taint = t;
     }
 }
 
@@ -535,8 +799,10 @@ void Value::set_sless_than(const Value& n1, const Value& n2, size_t size)
     }
     else
     {
+        ucst_t t = taint_any(n1._taint | n2._taint, size);
         _number = Number(size, n1.as_number().sless_than(n2.as_number()) ? 1 : 0 );
         type = Value::Type::CONCRETE;
+        _taint = t;
     }
 }
 
@@ -551,8 +817,10 @@ void Value::set_slessequal_than(const Value& n1, const Value& n2, size_t size)
     }
     else
     {
+        ucst_t t = taint_any(n1._taint | n2._taint, size);
         _number = Number(size, n1.as_number().slessequal_than(n2.as_number()) ? 1 : 0 );
         type = Value::Type::CONCRETE;
+        _taint = t;
     }
 }
 
@@ -567,8 +835,10 @@ void Value::set_equal_to(const Value& n1, const Value& n2, size_t size)
     }
     else
     {
+        ucst_t t = taint_any(n1._taint | n2._taint, size);
         _number = Number(size, n1.as_number().equal_to(n2.as_number()) ? 1 : 0 );
         type = Value::Type::CONCRETE;
+        _taint = t;
     }
 }
 
@@ -583,8 +853,10 @@ void Value::set_notequal_to(const Value& n1, const Value& n2, size_t size)
     }
     else
     {
+        ucst_t t = taint_any(n1._taint | n2._taint, size);
         _number = Number(size, n1.as_number().equal_to(n2.as_number()) ? 0 : 1);
         type = Value::Type::CONCRETE;
+        _taint = t;
     }
 }
 
@@ -612,6 +884,7 @@ void Value::set_carry(const Value& n1, const Value& n2, size_t size)
     }
     else
     {
+        ucst_t t = taint_any(n1._taint | n2._taint, size);
         Number tmp(n1.size());
         _number.size = size;
         const Number&   in0 = n1.as_number(),
@@ -622,6 +895,7 @@ void Value::set_carry(const Value& n1, const Value& n2, size_t size)
         else
             _number.set_cst(0);
         type = Value::Type::CONCRETE;
+        _taint = t;
     }
 }
 
@@ -655,6 +929,7 @@ void Value::set_scarry(const Value& n1, const Value& n2, size_t size)
     }
     else
     {
+        ucst_t t = taint_any(n1._taint | n2._taint, size);
         Number tmp(n1.size());
         _number.size = size;
         const Number&   in0 = n1.as_number(),
@@ -682,6 +957,7 @@ void Value::set_scarry(const Value& n1, const Value& n2, size_t size)
             _number.set_cst(0);
         }
         type = Value::Type::CONCRETE;
+        _taint = t;
     }
 }
 
@@ -724,6 +1000,7 @@ void Value::set_sborrow(const Value& n1, const Value& n2, size_t size)
     }
     else
     {
+        ucst_t t = taint_any(n1._taint | n2._taint, size);
         Number tmp;
         _number.size = size;
         const Number&   in0 = n1.as_number(),
@@ -751,6 +1028,7 @@ void Value::set_sborrow(const Value& n1, const Value& n2, size_t size)
             _number.set_cst(0);
         }
         type = Value::Type::CONCRETE;
+        _taint = t;
     }
 }
 
@@ -791,6 +1069,15 @@ void Value::set_subpiece(const Value& n1, const Value& n2, size_t size)
         const Number&   in0 = n1.as_number(),
                         in1 = n2.as_number();
         int trunc = in1.get_cst()*8; // Number of bits to truncate
+        // The truncation amount is a constant in pcode so its taint is ignored
+        ucst_t t = 0;
+        if (size <= (in0.size - trunc))
+            t = taint_extract(n1._taint, in0.size, trunc+size-1, trunc);
+        else
+            t = taint_place(
+                taint_extract(n1._taint, in0.size, in0.size-1, trunc),
+                in0.size-trunc, size, 0
+            );
         if (size < (in0.size - trunc))
         {
             _number.set_extract(
@@ -821,6 +1108,7 @@ void Value::set_subpiece(const Value& n1, const Value& n2, size_t size)
             );
         }
         type = Value::Type::CONCRETE;
+        _taint = t;
     }
 }
 
@@ -838,12 +1126,14 @@ void Value::set_bool_negate(const Value& n, size_t size)
     }
     else
     {
+        ucst_t t = taint_any(n._taint, size);
         _number.size = size;
         if (n.number().is_null())
             _number.set(1);
         else
             _number.set(0);
         type = Value::Type::CONCRETE;
+        _taint = t;
     }
 }
 
@@ -867,6 +1157,7 @@ void Value::set_bool_and(const Value& n1, const Value& n2, size_t size)
     }
     else
     {
+        ucst_t t = taint_any(n1._taint | n2._taint, size);
         _number.size = size;
         if (
             n1.as_number().is_null()
@@ -876,6 +1167,7 @@ void Value::set_bool_and(const Value& n1, const Value& n2, size_t size)
         else
             _number.set(1);
         type = Value::Type::CONCRETE;
+        _taint = t;
     }
 }
 
@@ -899,6 +1191,7 @@ void Value::set_bool_or(const Value& n1, const Value& n2, size_t size)
     }
     else
     {
+        ucst_t t = taint_any(n1._taint | n2._taint, size);
         _number.size = size;
         if (
             !n1.as_number().is_null()
@@ -908,6 +1201,7 @@ void Value::set_bool_or(const Value& n1, const Value& n2, size_t size)
         else
             _number.set(0);
         type = Value::Type::CONCRETE;
+        _taint = t;
     }
 }
 
@@ -937,6 +1231,7 @@ void Value::set_bool_xor(const Value& n1, const Value& n2, size_t size)
     }
     else
     {
+        ucst_t t = taint_any(n1._taint | n2._taint, size);
         _number.size = size;
         if (
             (!n1.as_number().is_null() and n2.as_number().is_null())
@@ -946,6 +1241,7 @@ void Value::set_bool_xor(const Value& n1, const Value& n2, size_t size)
         else
             _number.set(0);
         type = Value::Type::CONCRETE;
+        _taint = t;
     }
 }
 
@@ -972,8 +1268,10 @@ void Value::set_ITE(
             default:
                 throw expression_exception("Value::set_ITE(): got unimplemented ITE condition");
         }
+        ucst_t t = taint_any(c1._taint | c2._taint, if_true.size());
         // Assign result depending on condition
         *this = is_true? if_true : if_false;
+        _taint |= t;
     }
 }
 
@@ -1014,14 +1312,7 @@ Value operator+(const Value& left, const Value& right)
 Value operator+(const Value& left, cst_t right)
 {
     Value res;
-    if (left.is_abstract())
-        res = left.expr()+right;
-    else
-    {
-        Number n(left.size(), right);
-        n.set_add(left.as_number(), n);
-        res = n;
-    }
+    res.set_add(left, Value(left.size(), right));
     return res;
 }
 
@@ -1040,28 +1331,14 @@ Value operator-(const Value& left, const Value& right)
 Value operator-(const Value& left, cst_t right)
 {
     Value res;
-    if (left.is_abstract())
-        res = left.expr()-right;
-    else
-    {
-        Number n(left.size(), right);
-        n.set_sub(left.as_number(), n);
-        res = n;
-    }
+    res.set_sub(left, Value(left.size(), right));
     return res;
 }
 
 Value operator-(cst_t left, const Value& right)
 {
     Value res;
-    if (right.is_abstract())
-        res = left - right.expr();
-    else
-    {
-        Number n(right.size(), left);
-        n.set_sub(n, right.as_number());
-        res = n;
-    }
+    res.set_sub(Value(right.size(), left), right);
     return res;
 }
 
@@ -1075,14 +1352,7 @@ Value operator*(const Value& left, const Value& right)
 Value operator*(const Value& left, cst_t right)
 {
     Value res;
-    if (left.is_abstract())
-        res = left.expr()*right;
-    else
-    {
-        Number n(left.size(), right);
-        n.set_mul(left.as_number(), n);
-        res = n;
-    }
+    res.set_mul(left, Value(left.size(), right));
     return res;
 }
 
@@ -1101,28 +1371,14 @@ Value operator/(const Value& left, const Value& right)
 Value operator/(const Value& left, cst_t right)
 {
     Value res;
-    if (left.is_abstract())
-        res = left.expr()/right;
-    else
-    {
-        Number n(left.size(), right);
-        n.set_div(left.as_number(), n);
-        res = n;
-    }
+    res.set_div(left, Value(left.size(), right));
     return res;
 }
 
 Value operator/(cst_t left, const Value& right)
 {
     Value res;
-    if (right.is_abstract())
-        res = left / right.expr();
-    else
-    {
-        Number n(right.size(), left);
-        n.set_div(n, right.as_number());
-        res = n;
-    }
+    res.set_div(Value(right.size(), left), right);
     return res;
 }
 
@@ -1136,14 +1392,7 @@ Value operator&(const Value& left, const Value& right)
 Value operator&(const Value& left, cst_t right)
 {
     Value res;
-    if (left.is_abstract())
-        res = left.expr()&right;
-    else
-    {
-        Number n(left.size(), right);
-        n.set_and(left.as_number(), n);
-        res = n;
-    }
+    res.set_and(left, Value(left.size(), right));
     return res;
 }
 
@@ -1162,14 +1411,7 @@ Value operator|(const Value& left, const Value& right)
 Value operator|(const Value& left, cst_t right)
 {
     Value res;
-    if (left.is_abstract())
-        res = left.expr() | right;
-    else
-    {
-        Number n(left.size(), right);
-        n.set_or(left.as_number(), n);
-        res = n;
-    }
+    res.set_or(left, Value(left.size(), right));
     return res;
 }
 
@@ -1188,14 +1430,7 @@ Value operator^(const Value& left, const Value& right)
 Value operator^(const Value& left, cst_t right)
 {
     Value res;
-    if (left.is_abstract())
-        res = left.expr() ^ right;
-    else
-    {
-        Number n(left.size(), right);
-        n.set_xor(left.as_number(), n);
-        res = n;
-    }
+    res.set_xor(left, Value(left.size(), right));
     return res;
 }
 
@@ -1214,28 +1449,14 @@ Value operator%(const Value& left, const Value& right)
 Value operator%(const Value& left, cst_t right)
 {
     Value res;
-    if (left.is_abstract())
-        res = left.expr() % right;
-    else
-    {
-        Number n(left.size(), right);
-        n.set_rem(left.as_number(), n);
-        res = n;
-    }
+    res.set_rem(left, Value(left.size(), right));
     return res;
 }
 
 Value operator%(cst_t left, const Value& right)
 {
     Value res;
-    if (right.is_abstract())
-        res = left % right.expr();
-    else
-    {
-        Number n(right.size(), left);
-        n.set_rem(n, right.as_number());
-        res = n;
-    }
+    res.set_rem(Value(right.size(), left), right);
     return res;
 }
 
@@ -1249,28 +1470,14 @@ Value operator>>(const Value& left, const Value& right)
 Value operator>>(const Value& left, cst_t right)
 {
     Value res;
-    if (left.is_abstract())
-        res = left.expr() >> right;
-    else
-    {
-        Number n(left.size(), right);
-        n.set_shr(left.as_number(), n);
-        res = n;
-    }
+    res.set_shr(left, Value(left.size(), right));
     return res;
 }
 
 Value operator>>(cst_t left, const Value& right)
 {
     Value res;
-    if (right.is_abstract())
-        res = left >> right.expr();
-    else
-    {
-        Number n(right.size(), left);
-        n.set_shr(n, right.as_number());
-        res = n;
-    }
+    res.set_shr(Value(right.size(), left), right);
     return res;
 }
 
@@ -1284,28 +1491,14 @@ Value operator<<(const Value& left, const Value& right)
 Value operator<<(const Value& left, cst_t right)
 {
     Value res;
-    if (left.is_abstract())
-        res = left.expr() << right;
-    else
-    {
-        Number n(left.size(), right);
-        n.set_shl(left.as_number(), n);
-        res = n;
-    }
+    res.set_shl(left, Value(left.size(), right));
     return res;
 }
 
 Value operator<<(cst_t left, const Value& right)
 {
     Value res;
-    if (right.is_abstract())
-        res = left << right.expr();
-    else
-    {
-        Number n(right.size(), left);
-        n.set_shl(n, right.as_number());
-        res = n;
-    }
+    res.set_shl(Value(right.size(), left), right);
     return res;
 }
 
@@ -1319,28 +1512,14 @@ Value sar(const Value& arg, const Value& shift)
 Value sar(const Value& arg, cst_t shift)
 {
     Value res;
-    if (arg.is_abstract())
-        res = sar(arg.expr(), shift);
-    else
-    {
-        Number n(arg.size(), shift);
-        n.set_sar(arg.as_number(), n);
-        res = n;
-    }
+    res.set_sar(arg, Value(arg.size(), shift));
     return res;
 }
 
 Value sar(cst_t arg, const Value& shift)
 {
     Value res;
-    if (shift.is_abstract())
-        res = sar(arg, shift.expr());
-    else
-    {
-        Number n(shift.size(), arg);
-        n.set_sar(n, shift.as_number());
-        res = n;
-    }
+    res.set_sar(Value(shift.size(), arg), shift);
     return res;
 }
 
@@ -1354,28 +1533,14 @@ Value smod(const Value& left, const Value& right)
 Value smod(const Value& left, cst_t right)
 {
     Value res;
-    if (left.is_abstract())
-        res = smod(left.expr(), right);
-    else
-    {
-        Number n(left.size(), right);
-        n.set_srem(left.as_number(), n);
-        res = n;
-    }
+    res.set_srem(left, Value(left.size(), right));
     return res;
 }
 
 Value smod(cst_t left, const Value& right)
 {
     Value res;
-    if (right.is_abstract())
-        res = smod(left, right.expr());
-    else
-    {
-        Number n(right.size(), left);
-        n.set_srem(n, right.as_number());
-        res = n;
-    }
+    res.set_srem(Value(right.size(), left), right);
     return res;
 }
 
@@ -1389,84 +1554,42 @@ Value sdiv(const Value& left, const Value& right)
 Value sdiv(const Value& left, cst_t right)
 {
     Value res;
-    if (left.is_abstract())
-        res = sdiv(left.expr(), right);
-    else
-    {
-        Number n(left.size(), right);
-        n.set_sdiv(left.as_number(), n);
-        res = n;
-    }
+    res.set_sdiv(left, Value(left.size(), right));
     return res;
 }
 
 Value sdiv(cst_t left, const Value& right)
 {
     Value res;
-    if (right.is_abstract())
-        res = sdiv(left, right.expr());
-    else
-    {
-        Number n(right.size(), left);
-        n.set_sdiv(n, right.as_number());
-        res = n;
-    }
+    res.set_sdiv(Value(right.size(), left), right);
     return res;
 }
 
 Value operator~(const Value& arg)
 {
     Value res;
-    if (arg.is_abstract())
-        res = ~arg.expr();
-    else
-    {
-        Number n;
-        n.set_not(arg.as_number());
-        res = n;
-    }
+    res.set_not(arg);
     return res;
 }
 
 Value operator-(const Value& arg)
 {
     Value res;
-    if (arg.is_abstract())
-        res = -arg.expr();
-    else
-    {
-        Number n;
-        n.set_neg(arg.as_number());
-        res = n;
-    }
+    res.set_neg(arg);
     return res;
 }
 
 Value extract(const Value& arg, unsigned long higher, unsigned long lower)
 {
     Value res;
-    if (arg.is_abstract())
-        res = extract(arg.expr(), higher, lower);
-    else
-    {
-        Number n;
-        n.set_extract(arg.as_number(), higher, lower);
-        res = n;
-    }
+    res.set_extract(arg, higher, lower);
     return res;
 }
 
 Value concat(const Value& upper, const Value& lower)
 {
     Value res;
-    if (upper.is_abstract() or lower.is_abstract())
-        res = concat(upper.as_expr(), lower.as_expr());
-    else
-    {
-        Number n;
-        n.set_concat(upper.as_number(), lower.as_number());
-        res = n;
-    }
+    res.set_concat(upper, lower);
     return res;
 }
 
@@ -1495,16 +1618,17 @@ void Value::dump(Serializer& s) const
     if (is_abstract())
         s << _expr;
     else
-        s << _number;
+        s << _number << bits(_taint);
 }
 
 void Value::load(Deserializer& d)
 {
     d >> bits(type);
+    _taint = 0;
     if (type == Value::Type::ABSTRACT)
         d >> _expr;
     else
-        d >> _number;
+        d >> _number >> bits(_taint);
 }
 
 
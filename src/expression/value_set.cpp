@@ -6,16 +6,268 @@ namespace maat
 {
 
 using serial::bits;
-    
-ValueSet::ValueSet():size(-1){}
-ValueSet::ValueSet(size_t s):size(s), min(ValueSet::vs_min), max(ValueSet::vs_max), stride(1){}
-ValueSet::ValueSet(size_t si, ucst_t l, ucst_t h, ucst_t s): size(si), min(l), max(h), stride(s){}
+
+// Known bits
+/* ====================================== */
+// Known bits are handled as a value and a mask of unknown bits: a bit
+// is known if it is not set in 'mask', and its value is then given
+// by 'value'. Transfer functions are adapted from the tristate numbers
+// used by the Linux eBPF verifier
+namespace
+{
+struct KnownBits
+{
+    ucst_t value;
+    ucst_t mask;
+};
+
+// Mask of the bits used by values of 'size' bits, or 0 if known bits
+// are not tracked for this size
+inline ucst_t _kb_size_mask(int size)
+{
+    if (size <= 0 or size > 64)
+        return 0;
+    else if (size == 64)
+        return 0xffffffffffffffff;
+    else
+        return ((ucst_t)1 << size) - 1;
+}
+
+inline KnownBits _kb_unknown(int size)
+{
+    return KnownBits{0, _kb_size_mask(size)};
+}
+
+inline KnownBits _kb_cst(ucst_t val, int size)
+{
+    return KnownBits{val & _kb_size_mask(size), 0};
+}
+
+// Get the bits known from both the known bits and the strided
+// interval of a value set
+KnownBits _kb_from_vs(const ValueSet& vs)
+{
+    ucst_t m = _kb_size_mask(vs.size);
+    ucst_t ones = vs.known_ones & m;
+    ucst_t zeros = vs.known_zeros & m;
+    if (m != 0 and vs.min <= vs.max and vs.max <= m)
+    {
+        ucst_t prefix = m;
+        ucst_t diff = vs.min ^ vs.max;
+        if (diff != 0)
+        {
+            // Bits above the highest differing bit are common to
+            // all values in the interval
+            int msb = 63 - __builtin_clzll(diff);
+            prefix = msb == 63 ? 0 : m & ~(((ucst_t)2 << msb) - 1);
+            // Values are congruent to min modulo the highest power
+            // of 2 that divides the stride
+            if (vs.stride > 1)
+                prefix |= (vs.stride & -vs.stride) - 1;
+        }
+        ones |= vs.min & prefix;
+        zeros |= ~vs.min & prefix;
+    }
+    // Conflicting bits mean that the value set is empty, but stay
+    // conservative and forget them
+    ucst_t conflict = ones & zeros;
+    ones &= ~conflict;
+    zeros &= ~conflict;
+    return KnownBits{ones, m & ~(ones | zeros)};
+}
+
+KnownBits _kb_add(KnownBits a, KnownBits b, int size)
+{
+    ucst_t m = _kb_size_mask(size);
+    ucst_t sv = a.value + b.value;
+    ucst_t sm = a.mask + b.mask;
+    ucst_t sigma = sv + sm;
+    ucst_t chi = sigma ^ sv;
+    ucst_t mu = chi | a.mask | b.mask;
+    return KnownBits{sv & ~mu & m, mu & m};
+}
+
+KnownBits _kb_not(KnownBits a, int size)
+{
+    return KnownBits{~(a.value | a.mask) & _kb_size_mask(size), a.mask};
+}
+
+KnownBits _kb_and(KnownBits a, KnownBits b)
+{
+    ucst_t v = a.value & b.value;
+    return KnownBits{v, (a.value | a.mask) & (b.value | b.mask) & ~v};
+}
+
+KnownBits _kb_or(KnownBits a, KnownBits b)
+{
+    ucst_t v = a.value | b.value;
+    return KnownBits{v, (a.mask | b.mask) & ~v};
+}
+
+KnownBits _kb_xor(KnownBits a, KnownBits b)
+{
+    ucst_t mu = a.mask | b.mask;
+    return KnownBits{(a.value ^ b.value) & ~mu, mu};
+}
+
+// Bits that are known and equal in both 'a' and 'b'
+KnownBits _kb_union(KnownBits a, KnownBits b)
+{
+    ucst_t mu = a.mask | b.mask | (a.value ^ b.value);
+    return KnownBits{a.value & ~mu, mu};
+}
+
+KnownBits _kb_shl(KnownBits a, ucst_t shift, int size)
+{
+    ucst_t m = _kb_size_mask(size);
+    if (shift >= (ucst_t)size)
+        return KnownBits{0, 0};
+    return KnownBits{(a.value << shift) & m, (a.mask << shift) & m};
+}
+
+KnownBits _kb_shr(KnownBits a, ucst_t shift, int size)
+{
+    if (shift >= (ucst_t)size)
+        return KnownBits{0, 0};
+    return KnownBits{a.value >> shift, a.mask >> shift};
+}
+
+KnownBits _kb_sar(KnownBits a, ucst_t shift, int size)
+{
+    ucst_t m = _kb_size_mask(size);
+    if (m == 0)
+        return KnownBits{0, 0};
+    if (shift >= (ucst_t)size)
+        shift = size-1;
+    // Sign extend to 64 bits so that the shift inserts the sign bit
+    int ext = 64 - size;
+    cst_t v = (cst_t)(a.value << ext) >> ext;
+    cst_t mask = (cst_t)(a.mask << ext) >> ext;
+    return KnownBits{(ucst_t)(v >> shift) & m, (ucst_t)(mask >> shift) & m};
+}
+
+KnownBits _kb_mul(KnownBits a, KnownBits b, int size)
+{
+    ucst_t m = _kb_size_mask(size);
+    ucst_t acc_v = a.value * b.value;
+    KnownBits acc_m{0, 0};
+    while ((a.value | a.mask) & m)
+    {
+        if (a.value & 1)
+            acc_m = _kb_add(acc_m, KnownBits{0, b.mask & m}, size);
+        else if (a.mask & 1)
+            acc_m = _kb_add(acc_m, KnownBits{0, (b.value | b.mask) & m}, size);
+        a.value >>= 1;
+        a.mask >>= 1;
+        b.value <<= 1;
+        b.mask <<= 1;
+    }
+    return _kb_add(KnownBits{acc_v & m, 0}, acc_m, size);
+}
+
+// Apply a shift by all amounts in the value set 'shift' and merge the results
+template <typename F>
+KnownBits _kb_shift(KnownBits a, ValueSet& shift, int size, F shift_func)
+{
+    // Give up if there are too many possible shift amounts
+    if (shift.min > shift.max or shift.max - shift.min > 64)
+        return _kb_unknown(size);
+    KnownBits res = shift_func(a, shift.min, size);
+    for (ucst_t s = shift.min+1; s <= shift.max and s <= (ucst_t)size; s++)
+        res = _kb_union(res, shift_func(a, s, size));
+    return res;
+}
+
+// Reduced product: tighten the interval with the known bits 'kb'
+// and the known bits with the interval
+void _vs_reduce(ValueSet& vs, KnownBits kb)
+{
+    ucst_t m = _kb_size_mask(vs.size);
+    if (m == 0)
+    {
+        vs.known_zeros = 0;
+        vs.known_ones = 0;
+        return;
+    }
+    // Normalize the interval
+    if (vs.max > m)
+        vs.max = m;
+    if (vs.min > vs.max)
+    {
+        vs.min = 0;
+        vs.max = m;
+        vs.stride = 1;
+    }
+    // Merge with bits known from the interval
+    vs.known_ones = kb.value & m;
+    vs.known_zeros = ~(kb.value | kb.mask) & m;
+    kb = _kb_from_vs(vs);
+    vs.known_ones = kb.value;
+    vs.known_zeros = m & ~(kb.value | kb.mask);
+    if (kb.mask == 0)
+    {
+        vs.set_cst(kb.value);
+        return;
+    }
+    // Bound the interval with the known bits
+    ucst_t bits_min = kb.value;
+    ucst_t bits_max = kb.value | kb.mask;
+    if (vs.min < bits_min)
+        vs.min = bits_min;
+    if (vs.max > bits_max)
+        vs.max = bits_max;
+    if (vs.min > vs.max)
+    {
+        // Empty set, keep what the known bits say
+        vs.min = bits_min;
+        vs.max = bits_max;
+        vs.stride = 1;
+    }
+    // Known low bits give the stride. Only combine it with strides
+    // that are powers of 2 so that the result is still a stride
+    int k = __builtin_ctzll(kb.mask);
+    if (k > 0 and (vs.stride & (vs.stride-1)) == 0)
+    {
+        ucst_t step = (ucst_t)1 << k;
+        ucst_t low = kb.value & (step-1);
+        ucst_t new_min = vs.min + ((low - vs.min) & (step-1));
+        ucst_t new_max = vs.max - ((vs.max - low) & (step-1));
+        if (new_min >= vs.min and new_max <= vs.max and new_min <= new_max)
+        {
+            vs.min = new_min;
+            vs.max = new_max;
+            if (vs.stride < step)
+                vs.stride = step;
+        }
+    }
+}
+} // namespace
+
+// Value sets
+/* ====================================== */
+ValueSet::ValueSet():size(-1), known_zeros(0), known_ones(0){}
+ValueSet::ValueSet(size_t s):size(s), min(ValueSet::vs_min), max(ValueSet::vs_max), stride(1), known_zeros(0), known_ones(0){}
+ValueSet::ValueSet(size_t si, ucst_t l, ucst_t h, ucst_t s): size(si), min(l), max(h), stride(s), known_zeros(0), known_ones(0){}
 
 void ValueSet::set(ucst_t l, ucst_t h, ucst_t s)
 {
     min = l;
     max = h;
     stride = s;
+    known_zeros = 0;
+    known_ones = 0;
+}
+
+void ValueSet::set_known_bits(ucst_t zeros, ucst_t ones)
+{
+    KnownBits kb = _kb_from_vs(*this);
+    ucst_t m = _kb_size_mask(size);
+    ones = (ones & m) | kb.value;
+    zeros = (zeros & m) | (m & ~(kb.value | kb.mask));
+    ucst_t conflict = ones & zeros;
+    ones &= ~conflict;
+    zeros &= ~conflict;
+    _vs_reduce(*this, KnownBits{ones, m & ~(ones | zeros)});
 }
 
 void ValueSet::set_cst(ucst_t val)
@@ -23,6 +275,8 @@ void ValueSet::set_cst(ucst_t val)
     min = val;
     max = val;
     stride = 0;
+    known_ones = val & _kb_size_mask(size);
+    known_zeros = ~val & _kb_size_mask(size);
 }
 
 bool ValueSet::is_cst()
@@ -35,6 +289,8 @@ void ValueSet::set_all()
     min = ValueSet::vs_min;
     max = cst_unsign_trunc(size, ValueSet::vs_max);
     stride = 1;
+    known_zeros = 0;
+    known_ones = 0;
 }
 
 ucst_t ValueSet::range()
@@ -64,17 +320,21 @@ void ValueSet::set_neg(ValueSet& vs)
     // Let A < X < B
     // Then 0 < -X < MAX_INT if A == 0 && B != 0 
     //      -A < -X < -B otherwise
+    KnownBits kb = _kb_add(_kb_not(_kb_from_vs(vs), size), _kb_cst(1, size), size);
     if( vs.min == 0 && vs.max != 0 ){
         set_all();
     }else{
         set(cst_unsign_trunc(size, -(cst_t)vs.max), cst_unsign_trunc(size, -(cst_t)vs.min), vs.stride);
     }
+    _vs_reduce(*this, kb);
 }
 
 void ValueSet::set_not(ValueSet& vs)
 {
     // A < X < B  => ~B < ~X < ~A
+    KnownBits kb = _kb_not(_kb_from_vs(vs), size);
     set(cst_unsign_trunc(size, ~vs.max), cst_unsign_trunc(size, ~vs.min), vs.stride);
+    _vs_reduce(*this, kb);
 }
 
 void ValueSet::set_add(ValueSet& vs1, ValueSet& vs2)
@@ -83,6 +343,7 @@ void ValueSet::set_add(ValueSet& vs1, ValueSet& vs2)
     // Then 0 < X+Y < MAX_INT if A+C < MAX_INT and B+D > MAX_INT (overflow)
     //      A+C < X+Y < B+D otherwise
     // New stride is the gcd of both strides
+    KnownBits kb = _kb_add(_kb_from_vs(vs1), _kb_from_vs(vs2), size);
 
     // Check if overflow when adding biggest numbers
     if( cst_unsign_trunc(size, vs1.max + vs2.max) < vs1.max ){
@@ -106,6 +367,7 @@ void ValueSet::set_add(ValueSet& vs1, ValueSet& vs2)
              vs1.max + vs2.max,
              cst_gcd(vs1.stride, vs2.stride));
     }
+    _vs_reduce(*this, kb);
 }
 
 // Compute the maximal value when propagating strided interval on 
@@ -173,7 +435,9 @@ inline ucst_t _vs_min_or(ValueSet& vs1, ValueSet& vs2 )
 
 void ValueSet::set_or(ValueSet& vs1, ValueSet& vs2)
 {
+    KnownBits kb = _kb_or(_kb_from_vs(vs1), _kb_from_vs(vs2));
     set(_vs_min_or(vs1, vs2), _vs_max_or(vs1, vs2), 1);
+    _vs_reduce(*this, kb);
 }
 
 // Compute the maximal value when propagating strided interval on 
@@ -200,9 +464,11 @@ inline ucst_t _vs_min_and(ucst_t min1, ucst_t max1, ucst_t min2, ucst_t max2 , s
 
 void ValueSet::set_and(ValueSet& vs1, ValueSet& vs2)
 {
+    KnownBits kb = _kb_and(_kb_from_vs(vs1), _kb_from_vs(vs2));
     set(_vs_min_and(vs1.min, vs1.max, vs2.min, vs2.max, size), 
         _vs_max_and(vs1.min, vs1.max, vs2.min, vs2.max, size),
         1);
+    _vs_reduce(*this, kb);
 }
 
 // Compute the maximal value when propagating strided interval on 
@@ -226,12 +492,21 @@ inline ucst_t _vs_min_xor(ValueSet& vs1, ValueSet& vs2 )
 
 void ValueSet::set_xor(ValueSet& vs1, ValueSet& vs2)
 {
+    KnownBits kb = _kb_xor(_kb_from_vs(vs1), _kb_from_vs(vs2));
     set(_vs_min_xor(vs1, vs2), _vs_max_xor(vs1, vs2), 1);
+    _vs_reduce(*this, kb);
 }
 
 void ValueSet::set_mod(ValueSet& vs1, ValueSet& vs2)
 {
+    KnownBits kb = _kb_unknown(size);
+    // Modulo a power of 2 is a mask on the low bits
+    if (vs2.is_cst() and vs2.min != 0 and (vs2.min & (vs2.min-1)) == 0)
+        kb = _kb_and(_kb_from_vs(vs1), _kb_cst(vs2.min-1, size));
+    // The remainder is strictly smaller than the divisor, but
+    // a division by zero returns the dividend
     set(0, vs2.max, 1);
+    _vs_reduce(*this, kb);
 }
 
 void ValueSet::set_smod(ValueSet& vs1, ValueSet& vs2)
@@ -239,10 +514,12 @@ void ValueSet::set_smod(ValueSet& vs1, ValueSet& vs2)
     // It should be possible to refine this result by looking
     // at the sign of the operands
     set(-vs2.max, vs2.max, 1);
+    _vs_reduce(*this, _kb_unknown(size));
 }
 
 void ValueSet::set_shl(ValueSet& vs1, ValueSet& vs2)
 {
+    KnownBits kb = _kb_shift(_kb_from_vs(vs1), vs2, size, _kb_shl);
     if(  vs2.max >= vs1.size ){
         // Max shift sets the value to zero, all possible values
         // (but max can still be known)
@@ -267,10 +544,12 @@ void ValueSet::set_shl(ValueSet& vs1, ValueSet& vs2)
             stride = 1;
         }
     }
+    _vs_reduce(*this, kb);
 }
 
 void ValueSet::set_shr(ValueSet& vs1, ValueSet& vs2)
 {
+    KnownBits kb = _kb_shift(_kb_from_vs(vs1), vs2, size, _kb_shr);
     if( vs2.max >= vs1.size )
         min = 0;
     else
@@ -284,10 +563,12 @@ void ValueSet::set_shr(ValueSet& vs1, ValueSet& vs2)
     }else{
         stride = 1;
     }
+    _vs_reduce(*this, kb);
 }
 
 void ValueSet::set_sar(ValueSet& vs1, ValueSet& vs2)
 {
+    KnownBits kb = _kb_shift(_kb_from_vs(vs1), vs2, size, _kb_sar);
     // !! Shifting by more than the size of the integer
     // results in UB in C99 standard... So we need to test
     // the shift values.
@@ -313,11 +594,13 @@ void ValueSet::set_sar(ValueSet& vs1, ValueSet& vs2)
     }else{
         stride = 1;
     }
+    _vs_reduce(*this, kb);
 }
 
 void ValueSet::set_mul(ValueSet& vs1, ValueSet& vs2)
 {
-    
+    KnownBits kb = _kb_mul(_kb_from_vs(vs1), _kb_from_vs(vs2), size);
+
     if( vs1.is_cst() && vs1.max == 0 ){
         set_cst(0);
     
@@ -342,6 +625,7 @@ void ValueSet::set_mul(ValueSet& vs1, ValueSet& vs2)
              cst_unsign_trunc(size, vs1.max * vs2.max),
              new_stride);
     }
+    _vs_reduce(*this, kb);
 }
 
 void ValueSet::set_mulh(ValueSet& vs1, ValueSet& vs2)
@@ -350,6 +634,7 @@ void ValueSet::set_mulh(ValueSet& vs1, ValueSet& vs2)
     ucst_t new_min = (ucst_t)(((__uint128_t)vs1.min * (__uint128_t)vs2.min) >> size ); 
     ucst_t new_max = (ucst_t)(((__uint128_t)vs1.max * (__uint128_t)vs2.max) >> size );
     set(new_min, new_max, 1);
+    _vs_reduce(*this, _kb_unknown(size));
 }
 
 void ValueSet::set_div(ValueSet& vs1, ValueSet& vs2)
@@ -365,10 +650,20 @@ void ValueSet::set_div(ValueSet& vs1, ValueSet& vs2)
     }
     
     set(new_min, new_max, new_stride);
+    _vs_reduce(*this, _kb_unknown(size));
 }
 
 void ValueSet::set_concat(ValueSet& high, ValueSet& low)
 {
+    KnownBits kb = _kb_unknown(size);
+    if (high.size + low.size <= 64)
+    {
+        KnownBits kb_high = _kb_from_vs(high);
+        KnownBits kb_low = _kb_from_vs(low);
+        kb = _kb_or(_kb_shl(kb_high, low.size, size), kb_low);
+        // Shifted 'high' doesn't cover the low bits
+        kb.mask |= kb_low.mask;
+    }
     ucst_t min = cst_concat(high.min, high.size, low.min, low.size);
     ucst_t max = cst_concat(high.max, high.size, low.max, low.size);
     ucst_t new_stride;
@@ -379,14 +674,33 @@ void ValueSet::set_concat(ValueSet& high, ValueSet& low)
     else
         new_stride = 1;
     set(min, max, new_stride);
+    _vs_reduce(*this, kb);
+}
+
+void ValueSet::set_extract(ValueSet& vs, unsigned int higher, unsigned int lower)
+{
+    KnownBits kb = _kb_unknown(size);
+    if (vs.size <= 64)
+    {
+        KnownBits kb_vs = _kb_from_vs(vs);
+        ucst_t m = _kb_size_mask(size);
+        kb = KnownBits{(kb_vs.value >> lower) & m, (kb_vs.mask >> lower) & m};
+    }
+    set_all();
+    // If no bits above 'higher' can be set, the interval is just shifted
+    if (vs.min <= vs.max and higher < 63 and (vs.max >> (higher+1)) == 0)
+        set(vs.min >> lower, vs.max >> lower, lower == 0 ? vs.stride : 1);
+    _vs_reduce(*this, kb);
 }
 
 void ValueSet::set_union(ValueSet& vs1, ValueSet& vs2)
 {
     ucst_t min, max;
+    KnownBits kb = _kb_union(_kb_from_vs(vs1), _kb_from_vs(vs2));
     min = vs1.min < vs2.min ? vs1.min : vs2.min;
     max = vs1.max > vs2.max ? vs1.max : vs2.max;
-    set(min, max, 1); // TODO: properly analyse resulting stride instead of "1"
+    set(min, max, 1); // Stride is refined from the known bits
+    _vs_reduce(*this, kb);
 }
 
 uid_t ValueSet::class_uid() const
@@ -396,12 +710,12 @@ uid_t ValueSet::class_uid() const
 
 void ValueSet::dump(Serializer& s) const
 {
-    s << bits(size) << bits(min) << bits(max) << bits(stride);
+    s << bits(size) << bits(min) << bits(max) << bits(stride) << bits(known_zeros) << bits(known_ones);
 }
 
 void ValueSet::load(Deserializer& d)
 {
-    d >> bits(size) >> bits(min) >> bits(max) >> bits(stride);
+    d >> bits(size) >> bits(min) >> bits(max) >> bits(stride) >> bits(known_zeros) >> bits(known_ones);
 }
 
 } // namespace maat
@@ -1,6 +1,7 @@
 #include "maat/varcontext.hpp"
 #include "maat/expression.hpp"
 #include "maat/value.hpp"
+#include <algorithm>
 
 namespace maat
 {
@@ -9,7 +10,8 @@ using serial::bits;
 
 // Var Context implementation
 /* ====================================== */
-unsigned int VarContext::_id_cnt = 0;
+std::atomic<unsigned int> VarContext::_id_cnt = 0;
+std::atomic<uint64_t> VarContext::_version_cnt = 0;
 
 VarContext::VarContext(unsigned int i, Endian endian): id(i), _endianness(endian)
 {
@@ -19,29 +21,33 @@ VarContext::VarContext(unsigned int i, Endian endian): id(i), _endianness(endian
 
 void VarContext::set(const std::string& name, cst_t value)
 {
-    if (not contains(name))
-        varmap[name] = Number(64);
-    varmap[name].set_cst(value);
-    id = ++(VarContext::_id_cnt);
+    var_id_t var = VarTable::id(name);
+    if (not contains(var))
+        set(var, Number(64, value));
+    else
+    {
+        _values[var]->set_cst(value);
+        _touch(var);
+        id = ++(VarContext::_id_cnt);
+    }
 }
 
 void VarContext::set(const std::string& name, const Number& number)
 {
-    varmap[name] = number;
+    set(VarTable::id(name), number);
+}
+
+void VarContext::set(var_id_t var, const Number& number)
+{
+    _touch(var);
+    _values[var] = number;
     id = ++(VarContext::_id_cnt);
 }
 
 cst_t VarContext::get(const std::string& name) const
 {
-    std::map<std::string, maat::Number>::const_iterator it;
-    if((it = varmap.find(name)) == varmap.end())
-    {
-        throw var_context_exception(Fmt()
-            << "Variable '"
-            << name << "' has no concrete value in context"
-            >> Fmt::to_str);
-    }
-    if (it->second.size > 64)
+    const maat::Number& res = get_as_number(name);
+    if (res.size > 64)
     {
         throw var_context_exception(Fmt()
             << "Trying to get variable '"
@@ -49,20 +55,32 @@ cst_t VarContext::get(const std::string& name) const
             >> Fmt::to_str);
     }
 
-    return it->second.cst_;
+    return res.cst_;
 }
 
 const maat::Number& VarContext::get_as_number(const std::string& name) const
 {
-    std::map<std::string, maat::Number>::const_iterator it;
-    if((it = varmap.find(name)) == varmap.end())
+    std::optional<var_id_t> var = VarTable::find(name);
+    if (not var.has_value() or not contains(*var))
     {
         throw var_context_exception(Fmt()
             << "Variable '"
             << name << "' has no concrete value in context"
             >> Fmt::to_str);
     }
-    return it->second;
+    return *_values[*var];
+}
+
+const maat::Number& VarContext::get_as_number(var_id_t var) const
+{
+    if (not contains(var))
+    {
+        throw var_context_exception(Fmt()
+            << "Variable '"
+            << VarTable::name(var) << "' has no concrete value in context"
+            >> Fmt::to_str);
+    }
+    return *_values[var];
 }
 
 std::vector<uint8_t> VarContext::get_as_buffer(std::string name, unsigned int elem_size) const
@@ -126,7 +144,8 @@ std::string VarContext::get_as_string(std::string name) const
 
 bool VarContext::contains(const std::string& name) const
 {
-    return varmap.find(name) != varmap.end(); 
+    std::optional<var_id_t> var = VarTable::find(name);
+    return var.has_value() and contains(*var);
 }
 
 std::string VarContext::new_name_from(const std::string& name) const
@@ -233,22 +252,64 @@ std::vector<Value> VarContext::new_concolic_buffer(
 
 void VarContext::remove(const std::string& name)
 {
-    varmap.erase(name);
+    std::optional<var_id_t> var = VarTable::find(name);
+    if (var.has_value())
+        remove(*var);
+    else
+        id = ++(VarContext::_id_cnt);
+}
+
+void VarContext::remove(var_id_t var)
+{
+    if (var < _values.size())
+    {
+        _values[var].reset();
+        _touch(var);
+    }
     id = ++(VarContext::_id_cnt);
 }
 
+void VarContext::_touch(var_id_t var)
+{
+    if (var >= _values.size())
+    {
+        _values.resize(var+1);
+        _versions.resize(var+1, 0);
+    }
+    _versions[var] = ++(VarContext::_version_cnt);
+}
+
+uint64_t VarContext::version(const VarSet& vars) const
+{
+    uint64_t res = 0;
+    vars.for_each([this, &res](var_id_t var){
+        res = std::max(res, version(var));
+    });
+    return res;
+}
+
 void VarContext::update_from(VarContext& other)
 {
-    std::map<std::string, maat::Number>::iterator it; 
-    for( it = other.varmap.begin(); it != other.varmap.end(); it++)
+    for (var_id_t var = 0; var < other._values.size(); var++)
     {
-        varmap[it->first] = it->second;
+        if (other._values[var].has_value())
+        {
+            _touch(var);
+            _values[var] = other._values[var];
+        }
     }
     id = ++(VarContext::_id_cnt);
 }
 
 void VarContext::print(std::ostream& os ) const
 {
+    // Print variables sorted by name
+    std::map<std::string, maat::Number> varmap;
+    for (var_id_t var = 0; var < _values.size(); var++)
+    {
+        if (_values[var].has_value())
+            varmap[VarTable::name(var)] = *_values[var];
+    }
     os << "\n";
     for( auto var : varmap )
     {
@@ -256,7 +317,7 @@ void VarContext::print(std::ostream& os ) const
         {
             char str[500];  // Enough to store the string representation
                             // of a number on 512 bits
-            mpz_get_str(str, 16, var.second.mpz_.get_mpz_t()); // Base 36 to be quicker
+            mpz_get_str(str, 16, var.second.get_mpz().get_mpz_t()); // Base 36 to be quicker
             os << var.first << " : 0x" << std::string(str) << std::endl;
         }
         else
@@ -272,12 +333,11 @@ Endian VarContext::endianness() const
 std::set<std::string> VarContext::contained_vars() const
 {
     std::set<std::string> res;
-    std::transform(
-        varmap.begin(),
-        varmap.end(),
-        std::inserter(res, res.end()),
-        [](auto pair){ return pair.first; }
-    );
+    for (var_id_t var = 0; var < _values.size(); var++)
+    {
+        if (_values[var].has_value())
+            res.insert(VarTable::name(var));
+    }
     return res;
 }
 
@@ -295,18 +355,26 @@ serial::uid_t VarContext::class_uid() const
 
 void VarContext::dump(Serializer& s) const
 {
+    // Variables are serialized by name because IDs are specific
+    // to the current process
+    size_t size = 0;
+    for (const auto& val : _values)
+        if (val.has_value())
+            size++;
     s << bits(_endianness);
-    s << bits(varmap.size()) << bits(id);
-    for (const auto& [key,val] : varmap)
+    s << bits(size) << bits(id);
+    for (var_id_t var = 0; var < _values.size(); var++)
     {
-        s << key << val;
+        if (_values[var].has_value())
+            s << VarTable::name(var) << *_values[var];
     }
 }
 
 void VarContext::load(Deserializer& d)
 {
     size_t size;
-    varmap.clear();
+    _values.clear();
+    _versions.clear();
     d   >> bits(_endianness)
         >> bits(size) >> bits(id);
     for (int i = 0; i < size; i++)
@@ -314,7 +382,9 @@ void VarContext::load(Deserializer& d)
         std::string key;
         Number val;
         d >> key >> val;
-        varmap[key] = val;
+        var_id_t var = VarTable::id(key);
+        _touch(var);
+        _values[var] = val;
     }
 }
 
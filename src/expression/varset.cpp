@@ -0,0 +1,160 @@
+#include "maat/varset.hpp"
+#include "maat/exception.hpp"
+#include <algorithm>
+#include <deque>
+#include <mutex>
+#include <unordered_map>
+
+namespace maat
+{
+
+// Variable names table
+/* ====================================== */
+namespace
+{
+struct VarTableData
+{
+    std::mutex mutex;
+    std::unordered_map<std::string, var_id_t> ids;
+    // Use a deque so that references to names stay valid when adding new ones
+    std::deque<std::string> names;
+};
+
+VarTableData& var_table()
+{
+    static VarTableData table;
+    return table;
+}
+} // namespace
+
+var_id_t VarTable::id(const std::string& name)
+{
+    VarTableData& table = var_table();
+    std::lock_guard<std::mutex> lock(table.mutex);
+    auto it = table.ids.find(name);
+    if (it != table.ids.end())
+        return it->second;
+    var_id_t res = table.names.size();
+    table.names.push_back(name);
+    table.ids[name] = res;
+    return res;
+}
+
+std::optional<var_id_t> VarTable::find(const std::string& name)
+{
+    VarTableData& table = var_table();
+    std::lock_guard<std::mutex> lock(table.mutex);
+    auto it = table.ids.find(name);
+    if (it == table.ids.end())
+        return std::nullopt;
+    return it->second;
+}
+
+const std::string& VarTable::name(var_id_t id)
+{
+    VarTableData& table = var_table();
+    std::lock_guard<std::mutex> lock(table.mutex);
+    if (id >= table.names.size())
+    {
+        throw var_context_exception(Fmt()
+            << "VarTable::name(): unknown variable ID " << std::dec << id
+            >> Fmt::to_str
+        );
+    }
+    return table.names[id];
+}
+
+// Variable sets
+/* ====================================== */
+VarSet::VarSet(): _offset(0) {}
+
+VarSet::VarSet(const std::set<std::string>& names): _offset(0)
+{
+    for (const auto& name : names)
+    {
+        std::optional<var_id_t> id = VarTable::find(name);
+        if (id.has_value())
+            insert(*id);
+    }
+}
+
+void VarSet::_grow(var_id_t first_word, var_id_t last_word)
+{
+    if (_words.empty())
+    {
+        _offset = first_word;
+        _words.assign(last_word - first_word + 1, 0);
+        return;
+    }
+    if (first_word < _offset)
+    {
+        _words.insert(_words.begin(), _offset - first_word, 0);
+        _offset = first_word;
+    }
+    if (last_word >= _offset + _words.size())
+        _words.resize(last_word - _offset + 1, 0);
+}
+
+void VarSet::insert(var_id_t var)
+{
+    var_id_t word = var / 64;
+    _grow(word, word);
+    _words[word - _offset] |= (uint64_t)1 << (var % 64);
+}
+
+void VarSet::insert(const VarSet& other)
+{
+    if (other._words.empty())
+        return;
+    _grow(other._offset, other._offset + other._words.size() - 1);
+    for (size_t i = 0; i < other._words.size(); i++)
+        _words[other._offset - _offset + i] |= other._words[i];
+}
+
+bool VarSet::contains(var_id_t var) const
+{
+    var_id_t word = var / 64;
+    if (word < _offset or word >= _offset + _words.size())
+        return false;
+    return _words[word - _offset] & ((uint64_t)1 << (var % 64));
+}
+
+bool VarSet::intersects(const VarSet& other) const
+{
+    var_id_t start = std::max(_offset, other._offset);
+    var_id_t end = std::min(
+        _offset + (var_id_t)_words.size(),
+        other._offset + (var_id_t)other._words.size()
+    );
+    for (var_id_t word = start; word < end; word++)
+    {
+        if (_words[word - _offset] & other._words[word - other._offset])
+            return true;
+    }
+    return false;
+}
+
+bool VarSet::empty() const
+{
+    for (uint64_t word : _words)
+        if (word != 0)
+            return false;
+    return true;
+}
+
+std::vector<var_id_t> VarSet::ids() const
+{
+    std::vector<var_id_t> res;
+    for_each([&res](var_id_t var){ res.push_back(var); });
+    return res;
+}
+
+std::set<std::string> VarSet::names() const
+{
+    std::set<std::string> res;
+    for (var_id_t id : ids())
+        res.insert(VarTable::name(id));
+    return res;
+}
+
+} // namespace maat
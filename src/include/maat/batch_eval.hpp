@@ -0,0 +1,128 @@
+#ifndef MAAT_BATCH_EVAL_H
+#define MAAT_BATCH_EVAL_H
+
+#include <cstdint>
+#include <initializer_list>
+#include <optional>
+#include <unordered_map>
+#include <vector>
+#include "maat/expression.hpp"
+#include "maat/constraint.hpp"
+#include "maat/varcontext.hpp"
+
+namespace maat
+{
+
+/** \addtogroup expression
+ * \{ */
+
+/** \brief Evaluates a set of expressions and constraints under many
+ * VarContexts at once.
+ *
+ * Expressions are compiled once into a linear tape of instructions. Every
+ * instruction computes one node of the expression DAG for all the contexts
+ * in a tight loop over contiguous values, which avoids the virtual
+ * concretize() calls and per-node cache checks of ExprObject::as_number().
+ * This is typically used to check many candidate models (e.g. mutated
+ * inputs) against path constraints before calling the solver.
+ *
+ * Only expressions of 64 bits or less can be added. Sub-expressions that
+ * can't be evaluated on the tape (wider than 64 bits, floating point
+ * comparisons, ...) are evaluated for each context with as_number().
+ *
+ * Divisions and remainders by zero follow the SMT-LIB semantics used by the
+ * solver instead of raising an error */
+class BatchEvaluator
+{
+private:
+    using slot_t = uint32_t;
+    enum class Opcode: uint8_t
+    {
+        CST,
+        VAR,
+        FALLBACK, ///< Evaluate the expression with as_number() for each context
+        NEG,
+        NOT,
+        ADD,
+        MUL,
+        DIV,
+        SDIV,
+        MOD,
+        SMOD,
+        AND,
+        OR,
+        XOR,
+        SHL,
+        SHR,
+        SAR,
+        EXTRACT,
+        CONCAT,
+        ITE,
+        // Comparisons, the result is 0 or 1
+        EQ,
+        NEQ,
+        LT,
+        LE,
+        SLT,
+        SLE,
+        // Logical operations on comparison results
+        LAND,
+        LOR
+    };
+    /// A tape instruction
+    struct Instr
+    {
+        Opcode op;
+        size_t size; ///< Size of the result in bits
+        slot_t out;
+        slot_t in[4];
+        ucst_t param; ///< Constant value, variable ID, bit offset or condition
+        ExprObject* expr; ///< For FALLBACK only
+    };
+
+    std::vector<Instr> _tape;
+    slot_t _nb_slots;
+    /// Slots of the expressions already compiled
+    std::unordered_map<ExprObject*, slot_t> _slots;
+    /// Keep compiled expressions alive while we hold raw pointers to them
+    std::vector<Expr> _exprs;
+    /// Result slot and size of each output
+    std::vector<std::pair<slot_t, size_t>> _outputs;
+    std::vector<size_t> _constraint_outputs;
+    /// Values of all slots, slot by slot: the value of slot 's' for context 'i' is at s*_nb_lanes + i
+    std::vector<ucst_t> _lanes;
+    size_t _nb_lanes;
+
+public:
+    BatchEvaluator();
+    BatchEvaluator(const BatchEvaluator& other) = delete;
+    BatchEvaluator& operator=(const BatchEvaluator& other) = delete;
+    ~BatchEvaluator() = default;
+public:
+    /// Add an expression to evaluate. Return the index of its values in the results
+    size_t add(const Expr& e);
+    /** \brief Add a constraint to evaluate. Its value is 1 if the constraint is
+     * satisfied and 0 otherwise. Return the index of its values in the results */
+    size_t add(const Constraint& c);
+    /// Evaluate all expressions and constraints in every context of 'ctxs'
+    void evaluate(const std::vector<VarContext>& ctxs);
+public:
+    /// Return the number of contexts used in the last call to evaluate()
+    size_t nb_contexts() const;
+    /** \brief Return the value of output 'idx' in context 'ctx_idx' during
+     * the last call to evaluate(), as an unsigned integer */
+    ucst_t get(size_t idx, size_t ctx_idx) const;
+    /** \brief Return, for each context used in the last call to evaluate(),
+     * whether all the constraints added to the evaluator are satisfied */
+    std::vector<bool> satisfied() const;
+private:
+    std::optional<slot_t> _compile(const Expr& e);
+    slot_t _compile(const Constraint& c);
+    slot_t _emit(Opcode op, size_t size, std::initializer_list<slot_t> in, ucst_t param=0, ExprObject* expr=nullptr);
+    void _execute(const Instr& instr, const std::vector<VarContext>& ctxs);
+};
+
+/** \} */ // doxygen expression group
+
+} // namespace maat
+#endif
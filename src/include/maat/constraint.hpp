@@ -50,7 +50,10 @@ class ConstraintObject: public serial::Serializable
 {
 private:
     // std::nullopt until we get the variables 
+    std::optional<VarSet> _contained_var_ids;
     std::optional<std::set<std::string>> _contained_vars;
+    bool _hashed;
+    hash_t _hash;
 public:
     ConstraintType type; ///< Type of constraint (equal, less than, less or equal, AND, OR, ...)
     Expr left_expr; ///< Left member of the constraint if arithmetic constraint between symbolic expressions
@@ -66,8 +69,19 @@ public:
     /** \brief Return true if the constraint contains at least one of the variables
      * listed in 'var_names' */
     bool contains_vars(const std::set<std::string>& var_names);
+    /** \brief Return true if the constraint contains at least one of the variables
+     * in 'vars' */
+    bool contains_vars(const VarSet& vars);
     /// Returns a reference to the set of abstract variables containted in the constraint
     const std::set<std::string>& contained_vars();
+    /// Returns a reference to the IDs of the abstract variables contained in the constraint
+    const VarSet& contained_var_ids();
+    /** \brief Returns the constraint hash. Like expression hashes, two constraints with the
+     * same hash are considered equal */
+    hash_t hash();
+    /** \brief Return true if the constraint is always true, for example if it compares
+     * two constant expressions or an expression with itself */
+    bool is_tautology();
 public:
     virtual serial::uid_t class_uid() const;
     virtual void dump(serial::Serializer& s) const;
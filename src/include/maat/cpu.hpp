@@ -2,6 +2,9 @@
 #define MAAT_CPU_H
 
 #include <array>
+#include <bitset>
+#include <memory>
+#include <stdexcept>
 #include <vector>
 #include <optional>
 #include "maat/expression.hpp"
@@ -11,6 +14,8 @@
 #include "maat/event.hpp"
 #include "maat/pinst.hpp"
 #include "maat/serializer.hpp"
+#include "maat/simplification.hpp"
+#include "maat/varcontext.hpp"
 
 namespace maat
 {
@@ -38,23 +43,73 @@ using reg_alias_setter_t = std::function<void(CPUContext&, ir::reg_t, const Valu
 using reg_alias_getter_t = std::function<Value(CPUContext&, ir::reg_t)>;
 
 /** The CPU context in Maat's IR. It is basically
- * a mapping between abstract expressions and CPU registers */
+ * a mapping between abstract expressions and CPU registers.
+ *
+ * Registers wider than 64 bits (SIMD registers, ...) can also be stored as
+ * independent 64-bit lanes. They are split into lanes the first time
+ * get_bits() or set_bits() accesses only a part of them, so that partial
+ * accesses only touch the lanes holding the accessed bits. The full value
+ * is rebuilt from the lanes when needed by get()
+ *
+ * Some registers (typically the flags of X86 and X64) can hold lazy values:
+ * the operation that produced them and its operands are recorded by
+ * set_lazy() and the value is computed only when the register is read. Most
+ * flags are overwritten before being read, so their value, which is often a
+ * complex symbolic expression, never gets computed. Copies of the context
+ * compute pending lazy values, so that they are never computed with the
+ * variables of another engine than the one that recorded them */
 class CPUContext: public serial::Serializable
 {
 private:
-    std::vector<Value> regs;
+    /// Number of registers stored in a chunk of the register file
+    static constexpr int reg_chunk_size = 16;
+    /// Size in bits of the lanes of wide registers
+    static constexpr int reg_lane_size = 64;
+    /// Operation whose result is assigned lazily to a register
+    struct lazy_value_t
+    {
+        ir::Op op;
+        Value in0;
+        Value in1; ///< None for unary operations
+        size_t size;
+        /// Used to make the result concrete like the engine does for other
+        /// results. Only the context that recorded the value reads it
+        std::shared_ptr<VarContext> vars;
+        /// Used to simplify the result, null if it shouldn't be simplified
+        std::shared_ptr<ExprSimplifier> simplifier;
+    };
+    /// Lanes are split and merged lazily, only in chunks that are not shared
+    /// with other contexts (see _mutable_chunk())
+    struct reg_chunk_t
+    {
+        std::array<Value, reg_chunk_size> values;
+        /// Lanes of wide registers (lowest first), empty if not split
+        std::array<std::vector<Value>, reg_chunk_size> lanes;
+        /// Registers whose value is out of date with their lanes
+        std::bitset<reg_chunk_size> stale;
+        /// Pending lazy values, null if the register value is up to date
+        std::array<std::shared_ptr<const lazy_value_t>, reg_chunk_size> lazy;
+    };
+    /** Registers are stored in chunks that are shared between copies of the
+     * context (typically snapshots). A chunk is copied only when one of its
+     * registers is modified, so copying a context is cheap */
+    std::vector<std::shared_ptr<reg_chunk_t>> regs;
+    int nb_regs;
 private:
     reg_alias_getter_t alias_getter;
     reg_alias_setter_t alias_setter;
     std::set<ir::reg_t> aliased_regs;
+    std::set<ir::reg_t> lazy_regs;
 public:
     CPUContext(int nb_regs);
-    CPUContext(const CPUContext& other) = default;
-    CPUContext& operator=(const CPUContext& other) = default;
+    CPUContext(const CPUContext& other);
+    CPUContext& operator=(const CPUContext& other);
     virtual ~CPUContext() = default;
 public:
     /// Initialise special handling of alias registers for the given architecture
     void init_alias_getset(Arch::Type arch);
+    /// Initialise the registers that can hold lazy values for the given architecture
+    void init_lazy_regs(Arch::Type arch);
 public:
     /// Assign abstract or concrete expression to register *reg*
     void set(ir::reg_t reg, const Value& value);
@@ -74,6 +129,43 @@ public:
     /// Get current value of register *reg* as an abstract expression
     const Value& get(ir::reg_t reg);
 
+    /** \brief Get bits *high* to *low* (included) of register *reg*. Only the
+     * lanes holding these bits are accessed for wide registers */
+    Value get_bits(ir::reg_t reg, size_t high, size_t low);
+
+    /** \brief Assign *value* to bits *high* to *low* (included) of register *reg*.
+     * Only the lanes holding these bits are modified for wide registers */
+    void set_bits(ir::reg_t reg, size_t high, size_t low, const Value& value);
+
+    /// Return true if register *reg* is wider than 64 bits and can be split in lanes
+    bool is_wide(ir::reg_t reg) const;
+
+    /// Return the size in bits of register *reg* (0 if it has no value yet)
+    size_t reg_size(ir::reg_t reg) const;
+
+    /** \brief Assign to register *reg* the result of operation *op* on *in0* and
+     * *in1*, without computing it. The result is computed the first time the
+     * register is read. If *vars* reports that the result is concrete it is
+     * converted to a concrete value, and it is simplified with *simplifier*
+     * if not null */
+    void set_lazy(
+        ir::reg_t reg,
+        ir::Op op,
+        const Value& in0,
+        const Value& in1,
+        std::shared_ptr<VarContext> vars,
+        std::shared_ptr<ExprSimplifier> simplifier
+    );
+
+    /// Return true if register *reg* can hold lazy values
+    bool is_lazy_reg(ir::reg_t reg) const;
+
+    /// Return true if the value of register *reg* is lazy and not computed yet
+    bool is_lazy(ir::reg_t reg) const;
+
+    /// Return true if operation *op* can be computed lazily by set_lazy()
+    static bool is_lazy_op(ir::Op op);
+
 private:
     // Internal method that handles setting register aliases
     inline void _set_aliased_reg(ir::reg_t reg, const Value& val) __attribute__((always_inline));
@@ -83,6 +175,64 @@ private:
     // Throws cpu_exception on a wrong assignment size, and std::out_of_range
     // if 'reg_idx' is invalid 
     void _check_assignment_size(int reg_idx, size_t size) const;
+    // Return the value of register 'idx'. If it must be rebuilt from its lanes
+    // or computed from a lazy value, its chunk is copied first if it is shared
+    // with another context. Throws std::out_of_range if 'idx' is invalid
+    inline const Value& _reg(int idx)
+    {
+        if (idx < 0 or idx >= nb_regs)
+            throw std::out_of_range("CPUContext: invalid register");
+        int i = idx % reg_chunk_size;
+        const reg_chunk_t& chunk = *regs[idx / reg_chunk_size];
+        if (chunk.lazy[i] == nullptr and not chunk.stale[i])
+            return chunk.values[i];
+        reg_chunk_t& own_chunk = _mutable_chunk(idx);
+        if (own_chunk.lazy[i] != nullptr)
+        {
+            _compute_lazy(*own_chunk.lazy[i], own_chunk.values[i]);
+            own_chunk.lazy[i].reset();
+        }
+        else
+        {
+            _merge_lanes(own_chunk.lanes[i], own_chunk.values[i]);
+            own_chunk.stale[i] = false;
+        }
+        return own_chunk.values[i];
+    }
+    // Same as _reg() but returns a copy of the value and never modifies the context
+    Value _reg_value(int idx) const;
+    // Return a reference to register 'idx' to assign it a new value, copying its
+    // chunk first if it is shared with another context. The lanes and pending lazy
+    // value of the register are discarded. Throws std::out_of_range if 'idx' is invalid
+    inline Value& _mutable_reg(int idx)
+    {
+        reg_chunk_t& chunk = _mutable_chunk(idx);
+        int i = idx % reg_chunk_size;
+        chunk.stale[i] = false;
+        chunk.lanes[i].clear();
+        chunk.lazy[i].reset();
+        return chunk.values[i];
+    }
+    // Return the chunk holding register 'idx', copying it first if it is
+    // shared with another context. Throws std::out_of_range if 'idx' is invalid
+    inline reg_chunk_t& _mutable_chunk(int idx)
+    {
+        if (idx < 0 or idx >= nb_regs)
+            throw std::out_of_range("CPUContext: invalid register");
+        std::shared_ptr<reg_chunk_t>& chunk = regs[idx / reg_chunk_size];
+        if (chunk.use_count() > 1)
+            chunk = std::make_shared<reg_chunk_t>(*chunk);
+        return *chunk;
+    }
+    // Rebuild a register value from its lanes and store it in 'res'
+    static void _merge_lanes(const std::vector<Value>& lanes, Value& res);
+    // Split the value of register 'i' in 'chunk' into lanes if not already done.
+    // 'chunk' must not be shared with another context
+    static void _split_lanes(reg_chunk_t& chunk, int i);
+    // Compute a pending lazy value and store it in 'res'
+    static void _compute_lazy(const lazy_value_t& lazy, Value& res);
+    // Compute all pending lazy values
+    void _resolve_lazy();
 public:
     /// Print the CPU context to a stream
     friend std::ostream& operator<<(std::ostream& os, const CPUContext& ctx);
@@ -139,6 +289,7 @@ private:
     TmpContext tmp_ctx; ///< Temporary values context
 private:
     ProcessedInst processed_inst; ///< Processed instruction
+    bool _lazy_res; ///< The result of the processed instruction is assigned lazily
 
 public:
     CPU(int nb_regs=0); ///< Constructor
@@ -205,6 +356,9 @@ public:
      * output parameters (especially, Param::Type::ADDR parameters are expected
      * to have been resolved already by the engine, with the original addresses expressions
      * now residing in the *auxilliary* field of the ::ProcessedInst::Param parameters) \n
+     * If the result is a symbolic value assigned to a register that can hold lazy
+     * values (see CPUContext::set_lazy()), it is not computed and the *res* field of
+     * **pinst** is left empty \n
      * The method returns a reference to **pinst** */
     ProcessedInst& post_process_inst(const ir::Inst& inst, ProcessedInst& pinst);
 
@@ -27,6 +27,8 @@
 #include "maat/callother.hpp"
 #include "maat/varcontext.hpp"
 #include "maat/serializer.hpp"
+#include "maat/trace.hpp"
+#include "maat/symptr.hpp"
 
 namespace maat
 {
@@ -75,12 +77,22 @@ private:
     std::shared_ptr<SnapshotManager<Snapshot>> snapshots;
     std::shared_ptr<ExprSimplifier> simplifier;
     callother::HandlerMap callother_handlers;
+    // The CPU uses the simplifier for results that it computes lazily
+    friend class ir::CPU;
+    // Symbolic pointer policies simplify pointers before resolving them
+    friend class SymPtrPolicy;
 public:
     std::shared_ptr<Arch> arch;
     std::shared_ptr<VarContext> vars;
     std::shared_ptr<MemEngine> mem;
     ir::CPU cpu;
     event::EventManager hooks;
+    /// Native code coverage and execution trace recorder
+    TraceRecorder trace;
+    /** \brief Policies deciding how memory is accessed through symbolic and
+     * concolic pointers, per address range. Policies are not included in
+     * serialization */
+    SymPtrPolicies symptr_policies;
     std::shared_ptr<PathManager> path;
     std::shared_ptr<env::EnvEmulator> env;
     std::shared_ptr<SymbolManager> symbols;
@@ -135,7 +147,12 @@ public:
     int uid() const; ///< Return the UID of this engine instance
 public:
     /** \brief Continue executing from the current state. Execute at most
-     * 'max_inst' before stopping */
+     * 'max_inst' before stopping.
+     *
+     * Different engines can run concurrently in different threads, as long
+     * as they don't share expressions. Duplicated engines share expressions
+     * and lifters with the original engine, so they must not run concurrently
+     * with it */
     info::Stop run(int max_inst = 0);
     /** \brief Set the instruction pointer to address 'addr' and start 
      * executing from there. Execute at most 'max_inst' before stopping */
@@ -228,6 +245,9 @@ public:
         MemEngine& mem_engine,
         bool treat_as_pcode_store = false
     );
+private:
+    /// Emulation loop of run()
+    info::Stop _run(int max_inst);
 private:
     /** \brief Resolve all Address parameters in the instruction if needed. This method
      * returns 'true' on success and 'false' if an error occured */
@@ -290,6 +310,7 @@ public:
      *
      * This serializes the whole engine state except:
      * - Event hooks
+     * - Coverage and execution trace recorder
      * - Internal expression simplifier
      * - Logger
      * - Library emulation callbacks
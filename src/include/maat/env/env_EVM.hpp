@@ -41,11 +41,32 @@ public:
     virtual void load(maat::serial::Deserializer& d);
 };
 
-/// EVM Stack
+/** \brief EVM Stack
+ *
+ * When snapshots are taken, the stack records an undo entry for every
+ * modification so that it can be rewound to a previous state without
+ * being copied */
 class Stack: public serial::Serializable
 {
+private:
+    /// Undo entry for a stack modification
+    struct UndoOp
+    {
+        enum class Type : uint8_t
+        {
+            PUSH,
+            POP,
+            SET
+        };
+        Type type;
+        int idx; ///< Index of the element that was set (SET only)
+        Value prev_value; ///< Element that was popped or overwritten (POP and SET only)
+    };
 private:
     std::vector<Value> _stack;
+    /// Undo entries for modifications, only recorded if '_journal_enabled' is set
+    std::vector<UndoOp> _journal;
+    bool _journal_enabled = false;
 public:
     Stack() = default;
     virtual ~Stack() = default;
@@ -60,6 +81,14 @@ public:
     void set(const Value& value, int pos);
     /// Push new value at the top of the stack
     void push(const Value& value);
+public:
+    /** \brief Start recording undo entries for modifications, and return the
+     * current position in the journal */
+    size_t journal_mark();
+    /// Undo all modifications recorded after journal position 'mark'
+    void rewind(size_t mark);
+    /// Stop recording undo entries and clear the journal
+    void clear_journal();
 public:
     friend std::ostream& operator<<(std::ostream&, const Stack&);
 private:
@@ -71,15 +100,29 @@ public:
     virtual void load(maat::serial::Deserializer& d);
 };
 
-/// EVM Volatile Memory
+/** \brief EVM Volatile Memory
+ *
+ * When snapshots are taken, the memory records the previous content of
+ * every write so that it can be rewound to a previous state without being
+ * copied */
 class Memory: public serial::Serializable
 {
 friend class Contract;
+private:
+    /// Undo entry for a memory write
+    struct UndoWrite
+    {
+        addr_t addr; ///< Address written to
+        Value prev_value; ///< Content of memory before the write
+    };
 private:
     MemEngine _mem;
     addr_t _size; // Current memory size in the EVM sense
     addr_t _limit; // Limit of internally allocated memory
     addr_t _alloc_size;
+    /// Undo entries for writes, only recorded if '_journal_enabled' is set
+    std::vector<UndoWrite> _journal;
+    bool _journal_enabled;
 protected:
     std::shared_ptr<VarContext> _varctx;
 public:
@@ -98,13 +141,24 @@ public:
 public:
     /// Expand memory if needed to write 'nb_bytes' at 'addr'
     void expand_if_needed(const Value& addr, size_t nb_bytes);
+    /** \brief Expand memory if needed to write 'nb_bytes' at 'addr', and record
+     * the current content for snapshots. This must be called before writing
+     * to the internal memory engine directly */
+    void prepare_write(const Value& addr, size_t nb_bytes);
+public:
+    /** \brief Start recording undo entries for writes, and return the current
+     * position in the journal */
+    size_t journal_mark();
+    /// Undo all writes recorded after journal position 'mark'
+    void rewind(size_t mark);
+    /// Stop recording undo entries and clear the journal
+    void clear_journal();
 public:
     virtual maat::serial::uid_t class_uid() const;
     virtual void dump(maat::serial::Serializer& s) const;
     virtual void load(maat::serial::Deserializer& d);
 };
 
-
 class ValueHash {
   public:
     ::std::size_t operator ()(const Value& value) const
@@ -124,12 +178,26 @@ class ValueEqual {
     }
 };
 
-/// Contract permananent storage
+class KeccakHelper;
+
+/** \brief Contract permananent storage
+ *
+ * When snapshots are taken, the storage records an undo entry for every
+ * write so that it can be rewound to a previous state without being copied */
 class Storage: public serial::Serializable
 {
 public:
     using slots = std::unordered_map<Value, Value, ValueHash, ValueEqual>;
     using const_iterator = slots::const_iterator; 
+private:
+    /// Undo entry for a storage write
+    struct UndoWrite
+    {
+        Value addr; ///< Key written to in the storage slots
+        std::optional<Value> prev_value; ///< Previous value, none if the slot didn't exist
+        size_t history_size; ///< Size of the writes history before the write
+        bool had_symbolic_addresses; ///< Value of '_has_symbolic_addresses' before the write
+    };
 private:
     /// Storage state for concrete addresses
     slots _storage;
@@ -138,14 +206,38 @@ private:
     std::shared_ptr<VarContext> _varctx;
     /// True if at least one address written to was symbolic
     bool _has_symbolic_addresses; 
+    /// Index of the last write to each address in 'writes_history'
+    std::unordered_map<Value, size_t, ValueHash, ValueEqual> _last_write_idx;
+    /// Indexes of writes to abstract addresses in 'writes_history', in increasing order
+    std::vector<size_t> _abstract_writes;
+    /// True if the write indexes must be rebuilt from 'writes_history'
+    bool _index_dirty;
+    /// Undo entries for writes, only recorded if '_journal_enabled' is set
+    std::vector<UndoWrite> _journal;
+    bool _journal_enabled;
 public:
     Storage(std::shared_ptr<VarContext> ctx);
     ~Storage() = default;
 public:
-    /// Get storage word at 'addr'
-    Value read(const Value& addr);
+    /** \brief Get storage word at 'addr'. If 'keccak' is specified, previous
+     * writes to addresses derived from symbolic hashes with provably different
+     * pre-images are considered to not alias 'addr' */
+    Value read(const Value& addr, const KeccakHelper* keccak=nullptr);
     /// Write storage word at 'addr'
     void write(const Value& addr, const Value& val, const Settings& settings);
+public:
+    /** \brief Start recording undo entries for writes, and return the current
+     * position in the journal */
+    size_t journal_mark();
+    /// Undo all writes recorded after journal position 'mark'
+    void rewind(size_t mark);
+    /// Stop recording undo entries and clear the journal
+    void clear_journal();
+private:
+    void _record_undo(const Value& addr);
+    void _record_history(const Value& addr, const Value& val);
+    void _update_index();
+    void _apply_write(Value& res, const Value& addr, size_t history_idx, const KeccakHelper* keccak) const;
 public:
     const_iterator begin() const;
     const_iterator end() const;
@@ -243,6 +335,22 @@ public:
 /// Runtime for a deployed Smart-Contract
 class Contract: public serial::Serializable
 {
+public:
+    /// State of a contract runtime at a given point, used by snapshots
+    struct Mark
+    {
+        Value balance;
+        Value address;
+        size_t stack_mark; ///< Journal position of the stack
+        size_t memory_mark; ///< Journal position of the memory
+        addr_t memory_size;
+        std::shared_ptr<Storage> storage;
+        std::optional<Transaction> transaction;
+        std::optional<Transaction> outgoing_transaction;
+        std::optional<TransactionResult> result_from_last_call;
+        Value consumed_gas;
+        unsigned int code_size;
+    };
 public:
     Value balance; ///< Balance of the contract in WEI
     Value address; ///< Address where the contract is deployed
@@ -268,6 +376,15 @@ public:
 public:
     /// Make this contract a fresh runtime that shares storage with `other`
     void fork_from(const Contract& other);
+public:
+    /** \brief Start journaling the stack and memory, and return the current
+     * state of the runtime. Storage is journaled separately since it
+     * can be shared between runtimes */
+    Mark journal_mark();
+    /// Restore the runtime to the state 'mark'
+    void rewind(const Mark& mark);
+    /// Stop journaling the stack and memory
+    void clear_journal();
 public:
     virtual maat::serial::uid_t class_uid() const;
     virtual void dump(maat::serial::Serializer& s) const;
@@ -283,12 +400,27 @@ void _append_EVM_code(MaatEngine& engine, uint8_t* code, size_t code_size);
 typedef std::shared_ptr<Contract> contract_t;
 
 
-/// Helper class for simulating the KECCAK hash function symbolically
+/** \brief Helper class for simulating the KECCAK hash function symbolically
+ *
+ * When snapshots are taken, the helper records every hash it learns so that
+ * they can be forgotten when restoring a previous state */
 class KeccakHelper: public serial::Serializable
 {
+private:
+    /// Undo entry for a new hash
+    struct UndoInsert
+    {
+        Value hash_input; ///< Key inserted in 'known_hashes'
+        std::string preimage; ///< Key inserted in '_preimages', empty if none
+    };
 private:
     std::string _symbolic_hash_prefix;
     std::unordered_map<Value, Value, ValueHash, ValueEqual> known_hashes;
+    /// Pre-images of symbolic hashes, indexed by the name of the hash variable
+    std::unordered_map<std::string, Value> _preimages;
+    /// Undo entries for new hashes, only recorded if '_journal_enabled' is set
+    std::vector<UndoInsert> _journal;
+    bool _journal_enabled;
 public:
     /// Allow to return symbolic variables when hashing non-concrete values
     bool allow_symbolic_hashes;
@@ -299,6 +431,19 @@ public:
     Value apply(VarContext& ctx, const Value& val, uint8_t* raw_bytes);
     /// Get the prefix used for symbolic hash results
     const std::string& symbolic_hash_prefix() const;
+    /// Return the value whose hash is the symbolic variable 'hash_name', if any
+    std::optional<Value> get_preimage(const std::string& hash_name) const;
+public:
+    /** \brief Start recording undo entries for new hashes, and return the
+     * current position in the journal */
+    size_t journal_mark();
+    /// Forget all hashes recorded after journal position 'mark'
+    void rewind(size_t mark);
+    /// Stop recording undo entries and clear the journal
+    void clear_journal();
+private:
+    std::string _new_hash_name(VarContext& ctx) const;
+    void _record_insert(const Value& hash_input, const std::string& preimage="");
 public:
     virtual maat::serial::uid_t class_uid() const;
     virtual void dump(maat::serial::Serializer& s) const;
@@ -308,12 +453,40 @@ public:
 // Compute the keccak hash of bytes and return the result as a 'Value'
 Value _do_keccak256(uint8_t* in, int size);
 
-/// Specialisation of 'EnvEmulator' for the Ethereum blockchain state
+/** \brief Specialisation of 'EnvEmulator' for the Ethereum blockchain state
+ *
+ * Snapshots are journaled: taking a snapshot only records the small fields
+ * of every contract runtime and a position in the journals of their stack,
+ * memory and storage, and of the keccak helper. Restoring a snapshot undoes
+ * the journaled modifications and removes contracts created after it. The
+ * cost of snapshots is thus proportional to the number of contracts and to
+ * the state modified since the snapshot rather than to the whole blockchain
+ * state */
 class EthereumEmulator: public EnvEmulator
 {
 private:
-    // pair<EnvEmulator snapshot, copy of ethereum>
-    using Snapshot = std::shared_ptr<EthereumEmulator>;
+    /// Information needed to restore the Ethereum state to a snapshot
+    class Snapshot: public serial::Serializable
+    {
+    public:
+        /// Contracts with a uid greater or equal were created after the snapshot
+        int uid_cnt;
+        AbstractCounter current_block_number;
+        AbstractCounter current_block_timestamp;
+        bool static_flag;
+        Value gas_price;
+        bool allow_symbolic_hashes;
+        /// Journal position of the keccak helper
+        size_t keccak_mark;
+        /// Journal position of every storage when the snapshot was taken
+        std::vector<std::pair<std::shared_ptr<Storage>, size_t>> storage_marks;
+        /// State of every contract runtime when the snapshot was taken
+        std::vector<std::pair<int, Contract::Mark>> contract_marks;
+    public:
+        virtual maat::serial::uid_t class_uid() const;
+        virtual void dump(maat::serial::Serializer& s) const;
+        virtual void load(maat::serial::Deserializer& d);
+    };
     std::vector<Snapshot> _snapshots;
 private:
     int _uid_cnt;
@@ -350,6 +523,11 @@ public:
     virtual snapshot_t take_snapshot() override;
     /// Restore a snapshot of the environment
     virtual void restore_snapshot(snapshot_t snapshot, bool remove=false) override;
+private:
+    /// Restore the state to the last snapshot, without removing it
+    void _restore_last_snapshot();
+    /// Stop journaling modifications to the blockchain state
+    void _clear_journals();
 public:
     virtual maat::serial::uid_t class_uid() const override;
     virtual void dump(maat::serial::Serializer& s) const override;
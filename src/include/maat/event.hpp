@@ -2,6 +2,7 @@
 #define MAAT_EVENT_H
 
 #include <list>
+#include <set>
 #include "maat/types.hpp"
 #include "maat/info.hpp"
 #include "maat/arch.hpp"
@@ -106,6 +107,24 @@ enum class Action
 
 Action merge_actions(Action a, Action b);
 
+/// Filter on the values accessed by register and memory events
+enum class ValueFilter
+{
+    ANY, ///< Monitor all accesses
+    ABSTRACT, ///< Monitor accesses where the value or the memory address is abstract
+    CONCRETE ///< Monitor accesses where the value and the memory address are concrete
+};
+
+/// Events recorded by a hook in batch mode, in the order they occured
+using event_batch_t = std::vector<info::Info>;
+
+#ifdef MAAT_PYTHON_BINDINGS
+/** \brief Translate the object returned by a python callback into an action.
+ * A NULL *result* means that the callback raised an exception, which is
+ * printed and cleared. The GIL must be held */
+Action action_from_python_result(MaatEngine& engine, PyObject* result);
+#endif
+
 /// A callback to be executed on an event
 class EventCallback
 {
@@ -113,21 +132,29 @@ public:
     /** \typedef native_cb_t 
      * \brief A callback function taking a pointer to  the MaatEngine */
     using native_cb_t = std::function<Action(MaatEngine&, void*)>;// Action (*)(maat::MaatEngine&, void*);
+    /** \typedef native_batch_cb_t
+     * \brief A callback function taking a pointer to the MaatEngine and the
+     * events recorded by a hook in batch mode */
+    using native_batch_cb_t = std::function<Action(MaatEngine&, const event_batch_t&, void*)>;
     enum class Type
     {
         NATIVE,
+        NATIVE_BATCH,
         PYTHON,
         NONE
     };
 private:
     EventCallback::Type type;
     native_cb_t native_cb;
+    native_batch_cb_t native_batch_cb;
     void* native_cb_data;
 public:
     /// Default constructor
     EventCallback();
     /// Create a callback calling a native function
     EventCallback(native_cb_t cb, void* cb_data=nullptr);
+    /// Create a callback calling a native function on batches of events
+    EventCallback(native_batch_cb_t cb, void* cb_data=nullptr);
     EventCallback(const EventCallback& other);
     EventCallback& operator=(const EventCallback& other);
     EventCallback(EventCallback&& other);
@@ -137,6 +164,9 @@ public:
 public:
     /// Execute callback and return the callback's return value
     Action execute(maat::MaatEngine& engine) const;
+    /** \brief Execute callback on a batch of events and return the callback's
+     * return value. Callbacks that don't take batches are executed once */
+    Action execute(maat::MaatEngine& engine, const event_batch_t& batch) const;
 
 // Callbacks from python
 #ifdef MAAT_PYTHON_BINDINGS
@@ -191,10 +221,12 @@ public:
 };
 
 class EventManager; // Forward declaration
+class AddrHookIndex; // Forward declaration
 /// Generic hook base
 class EventHook
 {
 friend EventManager;
+friend AddrHookIndex;
 public:
     std::string group;
     std::string name;
@@ -206,6 +238,14 @@ protected:
     int _id;
     /// Filter
     AddrFilter filter;
+    /// Registers monitored by register events. Empty to monitor all registers
+    std::set<reg_t> _regs;
+    /// Filter on accessed values for register and memory events
+    ValueFilter _value_filter;
+    /// Number of events to record before executing callbacks, 0 if batching is disabled
+    size_t _batch_size;
+    /// Events recorded and not yet passed to callbacks
+    event_batch_t _batch;
 public:
     EventHook(
         int id,
@@ -232,12 +272,64 @@ public:
     const std::vector<EventCallback>& callbacks();
     /// Register new native callback to the hook
     void add_callback(EventCallback cb);
+public:
+    /// Only trigger register events on the registers in 'regs'. An empty set monitors all registers
+    void set_reg_filter(const std::set<reg_t>& regs);
+    /// Only trigger register and memory events on accesses matching 'filter'
+    void set_value_filter(ValueFilter filter);
+    /** \brief Record events and execute callbacks only once 'batch_size' events
+     * have been recorded, or when the engine stops. A size of 0 disables batching */
+    void set_batch_size(size_t batch_size);
+    /// Return the events recorded in batch mode and not yet passed to callbacks
+    const event_batch_t& pending_events() const;
+    /** \brief Execute callbacks on the pending recorded events, if any. This
+     * doesn't modify the engine's info field unless a callback fails */
+    Action flush(MaatEngine& engine);
 public:
     /// Pretty print to stream
     friend std::ostream& operator<<(std::ostream& os, const EventHook& hook);
 private:
     /// Return true if the filter allows the hook to be triggered. Also returns true if the filter isn't active
     bool check_filter(MaatEngine& engine);
+    /// Return true if the accessed value matches the value filter
+    bool check_value_filter(MaatEngine& engine);
+    /// Execute all callbacks, on 'batch' if not null
+    Action _execute_callbacks(MaatEngine& engine, const event_batch_t* batch);
+};
+
+/** \brief Index of hooks with an active address filter. It allows to get
+ * the hooks monitoring a given address without checking the filter
+ * of every hook. Single addresses are indexed in a hash map, and address
+ * ranges in a list sorted by lower bound */
+class AddrHookIndex
+{
+public:
+    using hook_t = std::shared_ptr<EventHook>;
+private:
+    /// Hooks monitoring a single address
+    std::unordered_map<addr_t, std::vector<hook_t>> points;
+    /// Hooks monitoring an address range, sorted by lower bound
+    std::vector<hook_t> ranges;
+    /// ranges_max[i] is the highest upper bound among ranges[0] to ranges[i]
+    std::vector<addr_t> ranges_max;
+    /// Set when a range was added and 'ranges' must be sorted again
+    bool ranges_dirty;
+public:
+    AddrHookIndex();
+    AddrHookIndex(const AddrHookIndex& other) = default;
+    AddrHookIndex& operator=(const AddrHookIndex& other) = default;
+    ~AddrHookIndex() = default;
+public:
+    /// Return true if 'hook' has a filter that can be indexed
+    static bool can_index(const EventHook& hook);
+    /// Add a hook to the index. The hook must have an active filter
+    void add(hook_t hook);
+    /// Append the hooks whose filter monitors 'addr' to 'res'
+    void get(addr_t addr, std::vector<hook_t>& res);
+    /// Return true if no hook is indexed
+    bool empty() const;
+private:
+    void _sort_ranges();
 };
 
 /** \brief The event manager holds all hooks that have been set
@@ -264,7 +356,13 @@ protected:
 private:
     using when_map_t = std::unordered_map<When, std::list<hook_t>>;
     using hook_map_t = std::unordered_map<Event, when_map_t>;
+    /// Hooks that must be checked for every occurence of their event
     hook_map_t hook_map;
+    /// EXEC hooks with an address filter, indexed by address
+    std::unordered_map<When, AddrHookIndex> exec_index;
+    /// Scratch buffers used to gather the EXEC hooks to trigger
+    std::vector<hook_t> _exec_scratch_indexed;
+    std::vector<hook_t> _exec_scratch_merged;
 public:
     EventManager(); ///< Default constructor
     EventManager(const EventManager& other) = default;
@@ -303,8 +401,9 @@ public:
      * @param when When to trigger the hook
      * @param name hook unique name (optional)
      * @param filter Address filter (optional)
-     * @param group hook group (optional) */
-    void add(
+     * @param group hook group (optional)
+     * @return The new hook */
+    hook_t add(
         event::Event event,
         event::When when,
         std::string name="",
@@ -317,8 +416,9 @@ public:
      * @param callback Callback to execute when the hook is triggered
      * @param name hook unique name (optional)
      * @param filter Address filter (optional)
-     * @param group hook group (optional) */
-    void add(
+     * @param group hook group (optional)
+     * @return The new hook */
+    hook_t add(
         event::Event event,
         event::When when,
         EventCallback callback,
@@ -332,8 +432,9 @@ public:
      * @param callbacks List of callbacks to execute when the hook is triggered
      * @param name hook unique name (optional)
      * @param filter Address filter (optional)
-     * @param group hook group (optional) */
-    void add(
+     * @param group hook group (optional)
+     * @return The new hook */
+    hook_t add(
         event::Event event,
         event::When when,
         const std::vector<EventCallback>& callbacks,
@@ -357,12 +458,19 @@ public:
     void enable_group(std::string group);
     /// Enable hook by ID
     void enable(int id);
+public:
+    /// Return true if a hook in batch mode has recorded events not yet passed to its callbacks
+    bool has_pending_events() const;
+    /// Execute callbacks of hooks in batch mode on their pending recorded events
+    Action flush(MaatEngine& engine);
 public:
     /// Pretty print hooks
     friend std::ostream& operator<<(std::ostream& os, const EventManager& manager);
 private:
     /// Raises a event_exception if a hook with name 'name' already exists
     void _check_unique_name(const std::string& str);
+    /// Register a new hook in 'all_hooks' and in the hook map or index
+    void _add_hook(hook_t hook, When when);
     inline Action _trigger_hooks(
         const std::vector<Event>& events,
         When when,
@@ -373,6 +481,8 @@ private:
         When when,
         MaatEngine& engine
     ) __attribute__((always_inline));
+    /// Trigger EXEC hooks for the address in engine.info.addr
+    Action _trigger_exec_hooks(When when, MaatEngine& engine);
 public: 
     bool has_hooks(
         const std::vector<Event>& events,
@@ -13,6 +13,7 @@
 #include "maat/number.hpp"
 #include "maat/types.hpp"
 #include "maat/serializer.hpp"
+#include "maat/varset.hpp"
 
 namespace maat
 {
@@ -124,7 +125,14 @@ static const uint64_t default_expr_taint_mask = 0xffffffffffffffff;
 
 /** A value set is a strided interval used to represent the 
 * possible range of values that an expression can take. The range is
-* represented by lower and higher bounds that are unsigned values */
+* represented by lower and higher bounds that are unsigned values.
+*
+* The interval is combined with known bits: bits that are known to be
+* 0 or 1 in every possible value. After each operation, the interval is
+* tightened with the known bits and vice-versa (e.g. known low bits
+* give the stride and known high bits bound the interval), which keeps
+* masked and aligned values precise. Known bits are only tracked for
+* expressions of 64 bits or less */
 class ValueSet: public serial::Serializable
 {
     protected:
@@ -138,13 +146,17 @@ class ValueSet: public serial::Serializable
     ucst_t min;  ///< Lower bound
     ucst_t max; ///< Upper bound
     ucst_t stride; ///< Stride
+    ucst_t known_zeros; ///< Bits that are 0 in all possible values
+    ucst_t known_ones; ///< Bits that are 1 in all possible values
 
     ValueSet();
     ValueSet(size_t size);
     ValueSet(size_t size, ucst_t min, ucst_t max, ucst_t stride);
     virtual ~ValueSet() = default;
 
-    void set(ucst_t min, ucst_t max, ucst_t stride);
+    void set(ucst_t min, ucst_t max, ucst_t stride); ///< Set the interval, all bits become unknown
+    /// Add known bits to the value set and tighten the interval accordingly
+    void set_known_bits(ucst_t zeros, ucst_t ones);
     void set_cst(ucst_t val); ///< Set value set as just one constant value
     bool is_cst(); ///< Return true if the value set represents a constant (min==max) 
     void set_all(); ///< Make value set as big as possible (min = vs_min, max = vs_max)
@@ -167,6 +179,7 @@ class ValueSet: public serial::Serializable
     void set_mulh(ValueSet& vs1, ValueSet& vs2);
     void set_div(ValueSet& vs1, ValueSet& vs2);
     void set_concat(ValueSet& high, ValueSet& low);    
+    void set_extract(ValueSet& vs, unsigned int higher, unsigned int lower);
     void set_union(ValueSet& vs1, ValueSet& vs2);
 
 public:
@@ -215,9 +228,17 @@ protected:
     // Concretization
     maat::Number _concrete; ///< The concrete value of the expression
     int _concrete_ctx_id = -1; ///< The ID of the VarContext that was used to concretize the expression
+    uint64_t _concrete_ctx_version = invalid_ctx_version; ///< The version of the variables used to concretize the expression
     // State
     ExprStatus _status;
     int _status_ctx_id; ///< The ID of the VarContext that was used to compute the epression status
+    uint64_t _status_ctx_version = invalid_ctx_version; ///< The version of the variables used to compute the expression status
+    // Variables
+    std::shared_ptr<const VarSet> _var_ids; ///< Symbolic variables contained in the expression, nullptr until computed
+    int _vars_version_ctx_id = -1; ///< The ID of the VarContext in which '_vars_version' was computed
+    uint64_t _vars_version = 0; ///< Latest version among the variables of the expression
+    /// Version used when a cached value was never computed
+    static constexpr uint64_t invalid_ctx_version = 0xffffffffffffffff;
 
 public:
     /// Constructor
@@ -231,6 +252,21 @@ public:
 protected:
     /// Return the concrete value of the expression evaluated in the context 'ctx'
     virtual const maat::Number& concretize(const VarContext* ctx = nullptr){throw runtime_exception("No implementation");};
+    /** \brief Return true if the cached concrete value is valid in 'ctx', that is
+     * if none of the variables of the expression changed since it was computed */
+    bool _concrete_up_to_date(const VarContext& ctx);
+    /// Record that the cached concrete value was computed in 'ctx'
+    void _concrete_computed(const VarContext& ctx);
+    /// Return true if the cached status is valid in 'ctx'
+    bool _status_up_to_date(const VarContext& ctx);
+    /// Record that the cached status was computed in 'ctx'
+    void _status_computed(const VarContext& ctx);
+    /** \brief Return the latest version among the variables of the expression
+     * in 'ctx'. It is computed from the arguments once per context ID, so
+     * that checking a cached value is O(1) */
+    uint64_t _get_vars_version(const VarContext& ctx);
+private:
+    const std::shared_ptr<const VarSet>& _get_var_ids();
 
 public:
     ExprType type; ///< Expression type
@@ -245,6 +281,10 @@ public:
     bool contains_vars(std::set<std::string>& var_names);
     /// Fill 'var_names' with the names of symbolic variables contained in the expression
     void get_vars(std::set<std::string>& var_names);
+    /// Add the IDs of the symbolic variables contained in the expression to 'vars'
+    void get_vars(VarSet& vars);
+    /// Return the IDs of the symbolic variables contained in the expression
+    const VarSet& var_ids();
 
     /// Return the expression hash. Every expression has a unique hash
     virtual hash_t hash(){throw runtime_exception("No implementation");};
@@ -367,6 +407,7 @@ class ExprVar: public ExprObject
 {
 private:
     std::string _name;
+    var_id_t _id; ///< Interned ID of the variable name
     static const int max_name_length = 1024;
 
 protected:
@@ -379,6 +420,8 @@ public:
     virtual ~ExprVar() = default;
     /// Get the variable name
     const std::string& name();
+    /// Get the variable ID (see VarTable)
+    var_id_t id() const;
     virtual hash_t hash();
     virtual void print(std::ostream& out);
     virtual bool is_tainted(ucst_t taint_mask=maat::default_expr_taint_mask);
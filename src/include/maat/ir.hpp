@@ -352,7 +352,9 @@ public:
 
 
 // Interface for cached IR instructions
-/// Get IRMap corresponding to MemEngine identified by `mem_engine_uid`
+/** \brief Get IRMap corresponding to MemEngine identified by `mem_engine_uid`.
+ * Can be called from different threads, but each IRMap must only be used by
+ * one thread at a time */
 IRMap& get_ir_map(int mem_engine_uid);
 
 
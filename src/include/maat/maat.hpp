@@ -9,6 +9,7 @@
 #include "maat/ir.hpp"
 #include "maat/cpu.hpp"
 #include "maat/constraint.hpp"
+#include "maat/batch_eval.hpp"
 #include "maat/lifter.hpp"
 #include "maat/loader.hpp"
 #include "maat/snapshot.hpp"
@@ -20,6 +21,8 @@
 #include "maat/value.hpp"
 #include "maat/config.hpp"
 #include "maat/stats.hpp"
+#include "maat/trace.hpp"
+#include "maat/symptr.hpp"
 #include "maat/serializer.hpp"
 #include "maat/env/env.hpp"
 #include "maat/env/env_EVM.hpp"
@@ -56,13 +56,19 @@ to check for before returning. It is used to reduce the overhead that
 appears when checking a huge memory area of the same type when we want 
 to write only a few bytes. Therefore, for performance reasons, it is possible
 for the functions to return an offset bigger than off+nb_bytes-1, just
-keep that in mind when using it.
+keep that in mind when using it. Scans are done 64 bytes of memory at a 
+time, or 256 bytes at a time on CPUs supporting AVX2.
 */
 class MemStatusBitmap: public serial::Serializable
 {
 private:
-    uint8_t* _bitmap;
+    uint8_t* _bitmap; ///< First byte of the bitmap in '_buf'
     unsigned int _size;
+    uint8_t* _buf; ///< Allocated buffer, with free space before and after the bitmap
+    offset_t _headroom; ///< Free bytes in '_buf' before the bitmap
+    offset_t _capacity; ///< Size of '_buf'
+    unsigned int _first_bit; ///< Bit of the first bitmap byte that represents offset 0
+    offset_t _scan_until(offset_t off, offset_t max, uint8_t fill);
 public:
     /** Constructor */
     MemStatusBitmap();
@@ -74,13 +80,20 @@ public:
     /** Extend the bitmap to make it represent 'nb_bytes' more bytes of
      * memory. The new bytes are inserted at the end of the bitmap.
      * For example if nb_bytes is 16, the actual bitmap size will
-     * be increased by 16/8 = 2 bytes */
+     * be increased by 16/8 = 2 bytes. The bitmap keeps free space after
+     * extensions so that repeated extensions take amortized O(nb_bytes) time */
     void extend_after(offset_t nb_bytes);
     /** Extend the bitmap to make it represent 'nb_bytes' more bytes of
      * memory. The new bytes are inserted at the beginning of the bitmap.
-     * For example if nb_bytes is 16, the actual bitmap size will
-     * be increased by 16/8 = 2 bytes */
+     * The first bitmap byte can represent offset 0 with any of its bits, so
+     * the existing bits are never shifted and this takes amortized
+     * O(nb_bytes) time like extend_after() */
     void extend_before(offset_t nb_bytes);
+    /** Keep only the status of the first 'nb_bytes' bytes of memory. The
+     * status of the bytes after them becomes concrete */
+    void truncate(offset_t nb_bytes);
+    /** Stop representing the first 'nb_bytes' bytes of memory */
+    void shrink_before(offset_t nb_bytes);
     void mark_as_abstract(offset_t off);
     void mark_as_abstract(offset_t start, offset_t end);
     void mark_as_concrete(offset_t off);
@@ -101,13 +114,34 @@ around a buffer that enables to read/write constants of different sizes
 For performance reasons, no checks are performed on the read/write operations
 to make sure that they don't overflow the bounds of the buffer. It is up
 to the caller to verify that the arguments passed are consistent.
+
+The content is stored in a reserved range of address space, with free space
+before and after it (see free_before() and free_after()). Pages are committed
+when the content grows into them, so extensions take O(nb_bytes) time and
+don't move the content: pointers returned by raw_mem_at() stay valid as long
+as the buffer exists. Only an extension that doesn't fit in the free space
+moves the content to a new range. Shrinking the buffer keeps its pages
+committed and zeroes them.
 */
 class MemConcreteBuffer: public serial::Serializable
 {
 private:
     unsigned int _size;
-    uint8_t* _mem;
+    uint8_t* _mem; ///< First byte of the content in '_buf'
+    uint8_t* _buf; ///< Reserved address range holding the content
+    offset_t _headroom; ///< Free bytes in '_buf' before the content
+    offset_t _capacity; ///< Size of '_buf'
+    offset_t _committed_start; ///< Offset in '_buf' of the first committed page
+    offset_t _committed_end; ///< Offset in '_buf' after the last committed page
     Endian _endianness;
+    bool _reserve(offset_t nb_before, offset_t nb_bytes, offset_t nb_after);
+    void _allocate(offset_t nb_bytes, offset_t room, const char* caller);
+    void _relocate(offset_t nb_before, offset_t nb_after, const char* caller);
+    void _commit(offset_t start, offset_t end, const char* caller);
+    void _release();
+public:
+    /// Free space reserved before and after the content of new buffers
+    static constexpr offset_t reserved_growth = 0x10000000;
 public:
     MemConcreteBuffer(Endian endian=Endian::LITTLE); ///< Constructor
     MemConcreteBuffer(offset_t nb_bytes, Endian endian=Endian::LITTLE); ///< Constructor
@@ -122,6 +156,14 @@ public:
     /** Extend the buffer to make it represent 'nb_bytes' more bytes of
      * memory. The new bytes are inserted at the beginning of the buffer */
     void extend_before(offset_t nb_bytes);
+    /// Remove the last 'nb_bytes' bytes of the buffer
+    void shrink_after(offset_t nb_bytes);
+    /// Remove the first 'nb_bytes' bytes of the buffer
+    void shrink_before(offset_t nb_bytes);
+    /// Number of bytes that extend_before() can add without moving the content
+    offset_t free_before() const;
+    /// Number of bytes that extend_after() can add without moving the content
+    offset_t free_after() const;
 
 public:
     /// Read nb_bytes starting at 'off'. 'nb_bytes' must be less or equal to 8
@@ -169,6 +211,10 @@ Abstract expressions are stored in a hashmap <offset : (expr, byte_num)>.
 For read operations, if the value read overlaps between two different
 expressions stored in memory, the class automatically concatenates/extracts
 the corresponding parts
+
+Offsets are stored relative to an origin that moves when the buffer is
+extended or shrunk before its first byte, so that values never have to be
+moved in the hashmap
 */
 
 class MemAbstractBuffer: public serial::Serializable
@@ -178,6 +224,7 @@ public:
     using abstract_mem_t = std::unordered_map<offset_t, std::pair<Expr, uint8_t>>;
 private:
     abstract_mem_t _mem;
+    offset_t _origin; ///< Key in '_mem' of offset 0
     Endian _endianness;
 public:
     MemAbstractBuffer(Endian endian=Endian::LITTLE); ///< Constructor
@@ -187,6 +234,9 @@ public:
     void write(offset_t off, Expr val); ///< Write an abstract value at offset 'off'
     std::pair<Expr, uint8_t>& at(offset_t off); ///< Return the abstract value pair stored at offset 'off'
     void set(offset_t off, std::pair<Expr, uint8_t>& pair); ///< Set the abstract value pair at offset 'off' 
+    void extend_before(offset_t nb_bytes); ///< Add 'nb_bytes' to the offsets of all values
+    void shrink_before(offset_t nb_bytes); ///< Remove the values in the first 'nb_bytes' and subtract 'nb_bytes' from the other offsets
+    void erase(offset_t off, offset_t nb_bytes); ///< Remove the values stored at offsets 'off' to 'off+nb_bytes-1'
 public:
     void _read_optimised_buffer(std::vector<Value>& res, addr_t addr, unsigned int nb_bytes);
 private:
@@ -202,11 +252,16 @@ public:
 be used transparently to write and read both abstract and concrete values.
 To do so, it uses a concrete buffer, an abstract buffer, and a memory status
 bitmap to keep track of what is abstract and what is concrete 
+
+A second bitmap holds the shadow taint of concrete bytes. A byte marked as
+abstract in this bitmap is a concrete byte that is tainted. It is used to
+track taint without creating abstract expressions (see Value)
 */
 class MemSegment: public serial::Serializable
 {
 private:
     MemStatusBitmap _bitmap;
+    MemStatusBitmap _taint_bitmap;
     MemConcreteBuffer _concrete;
     MemAbstractBuffer _abstract;
     bool _is_engine_special_segment;
@@ -236,6 +291,16 @@ public:
     /** \brief Extend the buffer to make it represent 'nb_bytes' more bytes of
      * memory. The new bytes are inserted at the beginning of the segment */
     void extend_before(addr_t nb_bytes);
+    /// Remove the last 'nb_bytes' bytes of the segment
+    void shrink_after(addr_t nb_bytes);
+    /// Remove the first 'nb_bytes' bytes of the segment
+    void shrink_before(addr_t nb_bytes);
+    /** \brief Number of bytes the segment can be extended by before its start
+     * without moving its concrete memory */
+    addr_t free_before();
+    /** \brief Number of bytes the segment can be extended by after its end
+     * without moving its concrete memory */
+    addr_t free_after();
 
 public:
     Value read(addr_t addr, unsigned int nb_bytes); ///< Read memory
@@ -249,6 +314,9 @@ public:
     void symbolic_ptr_read(Value& res, const Expr& addr, ValueSet& addr_value_set, unsigned int nb_bytes, const Expr& base);
 public:
     void _read_optimised_buffer(std::vector<Value>& res, addr_t addr, unsigned int nb_bytes);
+private:
+    void read_shadow_taint(Value& val, offset_t off, unsigned int nb_bytes);
+    void write_shadow_taint(offset_t off, const Value& val);
 public:
     /* Special reading and writing (for snapshoting) */
     abstract_mem_chunk_t abstract_snapshot(addr_t addr, int nb_bytes); // Used for files
@@ -274,6 +342,9 @@ public:
     /** \brief Returns the first address holding an abstract value starting
      * from 'start' and before address 'start+max' */
     addr_t is_concrete_until(addr_t start, addr_t max);
+    /** \brief Returns the first address holding a shadow-tainted concrete value
+     * starting from 'start' and before address 'start+max' */
+    addr_t is_untainted_until(addr_t start, addr_t max);
 
     /** \brief Finds the first address holding a value different that 'byte' 
      * starting from 'start' */
@@ -474,7 +545,10 @@ public:
     virtual ~MemEngine();
 
     /** \brief Map memory from 'start' to 'end' (included), with permissions 'mflags'. 
-    Necessary segments are created in order to fill the map. The map is NOT initialised with zeros */
+    Necessary segments are created in order to fill the map. The map is NOT initialised with zeros.
+    Segments of the same name that are adjacent to the map (e.g. the heap grown by brk())
+    are extended instead of creating new segments, if their concrete memory doesn't have
+    to move. Extensions are recorded in the active snapshot, if any */
     void map(addr_t start, addr_t end, mem_flag_t mflags = mem_flag_rwx, const std::string& map_name = "");
     /** \brief Allocate a new memory map of 'size' bytes. The map wills
      * be aligned according to the 'align' value. Returns the start address of the map */
@@ -502,6 +576,9 @@ public:
     );
     /// Delete segment starting at address 'start'
     void delete_segment(addr_t start);
+    /** \brief Shrink the segment that contains 'start' and 'end' so that it starts
+     * at 'start' and ends at 'end'. Used to undo segment extensions when restoring snapshots */
+    void shrink_segment(addr_t start, addr_t end);
 public:
     std::list<std::shared_ptr<MemSegment>>& segments();
     std::shared_ptr<MemSegment> get_segment_containing(addr_t addr);
@@ -511,6 +588,10 @@ public:
 protected:
     /// Return 'true' if there is a MemSegment that overlaps with [start:end]
     bool has_segment_containing(addr_t start, addr_t end);
+private:
+    /** Extend a segment named 'name' that ends right before 'start' or begins
+     * right after 'end' to cover [start:end]. Return 'false' if there is no such segment */
+    bool _extend_adjacent_segment(addr_t start, addr_t end, const std::string& name);
 
 // Main read/Write interface for the core engine operations (most performant functions)
 public:
@@ -607,7 +688,9 @@ public:
     /// Make a buffer concolic, return the symbolic name of the buffer 
     std::string make_concolic(addr_t addr, unsigned int nb_elems, unsigned int elem_size,  const std::string& basename);
     /** \brief Make a buffer tainted. If 'name' is specified, the buffer is made concolic then tainted, otherwise
-     * the memory contents are tainted without being transformed into symbolic variables */
+     * the memory contents are tainted without being transformed into symbolic variables. In the latter
+     * case concrete contents stay concrete and only their shadow taint is set, so that taint can be
+     * propagated at concrete execution speed */
     std::string make_tainted(addr_t addr, unsigned int nb_elems, unsigned int elem_size, const std::string& basename="");
 
 private:
@@ -626,6 +709,8 @@ public:
 private:
     /// (Internal) Record a memory write in the snapshot manager if it's active
     void record_mem_write(addr_t addr, int nb_bytes);
+    /// (Internal) Save the mapped contents of the memory line starting at 'line' in 'snapshot'
+    void save_mem_line(Snapshot& snapshot, addr_t line);
 
 public:
     /** \brief Returns a raw pointer to the raw concrete memory buffer at address 'addr'.
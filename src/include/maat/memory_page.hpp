@@ -2,6 +2,7 @@
 #define MAAT_MEMORY_PAGE_H
 
 #include <list>
+#include <memory>
 #include <string>
 #include "maat/types.hpp"
 #include "maat/serializer.hpp"
@@ -40,7 +41,7 @@ public:
     PageSet(addr_t start, addr_t end, mem_flag_t f, bool was_once_executable=false);
     virtual ~PageSet() = default;
     bool intersects_with_range(addr_t min, addr_t max) const;
-    bool contains(addr_t addr);
+    bool contains(addr_t addr) const;
 public:
     virtual uid_t class_uid() const;
     virtual void dump(serial::Serializer& s) const;
@@ -52,9 +53,10 @@ class MemPageManager: public serial::Serializable
 {
 private:
     size_t _page_size;
-    std::list<PageSet> _regions;
+    /// Regions are never modified in place so that snapshots can share them
+    std::shared_ptr<const std::list<PageSet>> _regions;
 private:
-    void merge_regions();
+    void merge_regions(std::list<PageSet>& regions);
 public:
     MemPageManager(size_t page_size=0x1000);
     virtual ~MemPageManager() = default;
@@ -75,7 +77,9 @@ public:
     bool is_unmapped(addr_t start, addr_t end);
 public:
     const std::list<PageSet>& regions();
-    void set_regions(std::list<PageSet>&& regions);
+    /// Return the current regions. Taking a reference to them is O(1)
+    std::shared_ptr<const std::list<PageSet>> shared_regions() const;
+    void set_regions(std::shared_ptr<const std::list<PageSet>> regions);
 public:
     friend std::ostream& operator<<(std::ostream& os, MemPageManager& mem);
 public:
@@ -100,7 +104,7 @@ public:
     bool intersects_with_range(addr_t min, addr_t max) const;
     bool contains(addr_t addr) const;
     bool contained_in_range(addr_t min, addr_t max) const;
-    void truncate(std::list<MemMap>& res, addr_t min, addr_t max);
+    void truncate(std::list<MemMap>& res, addr_t min, addr_t max) const;
 public:
     friend bool operator<(const MemMap&, const MemMap&);
 public:
@@ -113,9 +117,10 @@ public:
 class MemMapManager: public serial::Serializable
 {
 private:
-    std::list<MemMap> _maps;
+    /// Maps are never modified in place so that snapshots can share them
+    std::shared_ptr<const std::list<MemMap>> _maps;
 public:
-    MemMapManager() = default;
+    MemMapManager();
     virtual ~MemMapManager() = default;
 public:
     void map(MemMap map);
@@ -123,7 +128,9 @@ public:
     bool is_free(addr_t start, addr_t end) const;
 public:
     const std::list<MemMap>& get_maps() const;
-    void set_maps(std::list<MemMap>&&);
+    /// Return the current maps. Taking a reference to them is O(1)
+    std::shared_ptr<const std::list<MemMap>> shared_maps() const;
+    void set_maps(std::shared_ptr<const std::list<MemMap>> maps);
     const MemMap& get_map_by_name(const std::string& name) const;
 public:
     friend std::ostream& operator<<(std::ostream&, const MemMapManager&);
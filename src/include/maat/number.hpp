@@ -2,9 +2,11 @@
 #define MAAT_NUMBER_H
 
 #include <iostream>
+#include <memory>
 #include "maat/types.hpp"
 #include "maat/exception.hpp"
 #include "maat/serializer.hpp"
+#include "maat/uint256.hpp"
 #include "gmp.h"
 #include "gmpxx.h"
 
@@ -18,14 +20,18 @@ namespace maat
  * 
  * This class is mainly intended to be used internally by Maat's engine.
  * If the number of bits is inferior or equal to 64, the value will be stored in a **cst_t** variable.
- * If the number of bits is superior to 64, the classes uses a multiprecision
- * integer from the GMP library */
+ * If the number of bits is between 65 and 256, the value is stored in a fixed-width
+ * *UInt256* integer. If the number of bits is superior to 256, the classes uses a multiprecision
+ * integer from the GMP library. The multiprecision integer is allocated only
+ * when needed, so that numbers on 256 bits or less are cheap to create and copy */
 class Number : public maat::serial::Serializable 
 {
 public:
     size_t size;
     cst_t cst_;
-    mpz_class mpz_;
+private:
+    UInt256 _wide; ///< Value of numbers between 65 and 256 bits, truncated to 'size'
+    std::unique_ptr<mpz_class> _mpz; ///< nullptr until a multiprecision value is needed
 
 public:
     /// Constructor (defaults size to 64 bits)
@@ -39,16 +45,28 @@ public:
     /// Destructor
     ~Number();
     /// Copy constructor
-    Number(const Number& x) = default;
+    Number(const Number& x);
+    /// Move constructor
+    Number(Number&& x) = default;
     /// Assignement
-    // TODO don't copy mpz if size is < 64 bits !!!
-    Number& operator=(const Number& x) = default;
+    Number& operator=(const Number& x);
     /// Move Assignement
     Number& operator=(Number&& x) = default;
 
 private:
     /// Adjust mpz bits to not exceed size
     void adjust_mpz();
+    /// Return true if the value is stored in '_wide'
+    bool _is_wide() const;
+    /// Multiprecision value of the number, only meaningful if size > 256
+    mpz_class& mpz();
+    const mpz_class& mpz() const;
+    /// Return the value (truncated to 256 bits)
+    UInt256 _get_u256() const;
+    /// Set the value, truncated to the current size
+    void _set_u256(const UInt256& val);
+    /// Set the value, truncated to the current size
+    void _set_mpz_value(const mpz_class& val);
     
 public:
     /// Set the number to simple value 'val'
@@ -62,6 +80,8 @@ public:
     void set(cst_t val);
 
 public:
+    /// Get the number value as a GMP integer
+    mpz_class get_mpz() const;
     /// Get the number value as a 'cst_t', truncate if needed
     cst_t get_cst() const;
     /// Get the number value as a 'ucst_t', truncate if needed
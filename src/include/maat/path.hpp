@@ -5,6 +5,7 @@
 #include "maat/serializer.hpp"
 #include "maat/value.hpp"
 #include <unordered_set>
+#include <unordered_map>
 
 namespace maat
 {
@@ -19,11 +20,15 @@ public:
     using path_snapshot_t = unsigned int;
 private:
     std::vector<Constraint> _constraints;
+    /// Constraints in '_constraints' indexed by hash, used to drop duplicates
+    std::unordered_multimap<hash_t, Constraint> _constraints_by_hash;
 public:
     PathManager() = default;
     virtual ~PathManager() = default;
 public:
-    void add(Constraint constraint); ///< Add a path constraint
+    /** \brief Add a path constraint. Constraints that are always true and
+     * constraints already present in the current path are ignored */
+    void add(Constraint constraint);
     path_snapshot_t take_snapshot(); ///< Snapshot the current path constraints
     void restore_snapshot(path_snapshot_t snap); ///< Restore snapshot
     const std::vector<Constraint>& constraints(); ///< Get current path constraints
@@ -47,7 +52,8 @@ public:
         using value_type        = Constraint;
         using const_pointer     = const Constraint*;  // or also value_type*
         using const_reference   = const Constraint&;  // or also value_type&
-        iterator(Type t, std::vector<Constraint>* c, int idx, std::set<std::string>* v): type(t), m_idx(idx), constraints(c), vars(v) {}
+        iterator(Type t, std::vector<Constraint>* c, int idx, VarSet* v):
+            type(t), m_idx(idx), constraints(c), vars(v) {}
         iterator(const iterator& other) = default;
         iterator& operator=(const iterator& other) = default;
         ~iterator() = default;
@@ -57,7 +63,7 @@ public:
         // TODO use mutable references
         // Use pointers because iterator can't be copied if they contains const references...
         std::vector<Constraint>* constraints;
-        std::set<std::string>* vars;
+        VarSet* vars;
         Type type;
 
         public:
@@ -103,12 +109,12 @@ public:
     class IteratorWrapper
     {
         private:
-        std::set<std::string> vars;
+        VarSet vars;
         std::vector<Constraint>* constraints;
         iterator::Type type;
 
         public:
-        IteratorWrapper(iterator::Type t, const std::set<std::string>& v, std::vector<Constraint>* c):
+        IteratorWrapper(iterator::Type t, const VarSet& v, std::vector<Constraint>* c):
             vars(v), constraints(c), type(t) {}
         IteratorWrapper(const IteratorWrapper& other):
             vars(other.vars), constraints(other.constraints), type(other.type) {}
@@ -139,7 +145,7 @@ public:
     /// Get the minimal set of path constraints that involve variables contained in 'val'
     std::unordered_set<Constraint> get_related_constraints(const Value& val) const;
     // Helper function for get_related_constraints overloads
-    std::unordered_set<Constraint> _get_related_constraints(std::set<std::string> vars) const;
+    std::unordered_set<Constraint> _get_related_constraints(VarSet vars) const;
 
 public:
     virtual serial::uid_t class_uid() const;
@@ -18,7 +18,9 @@ namespace ir
  * 
  * The values held by the member fields depend on the type of operation that was
  * processed. For *in0*, *in1*, *in2*, the current value is computed. For *out*,
- * the FULL value is used (without performing potential bitfield extracts).
+ * the FULL value is used (without performing potential bitfield extracts), except
+ * for partial accesses to wide registers stored in lanes (see CPUContext). In that
+ * case *out* and *res* only hold the bits accessed by the instruction.
  * */
 class ProcessedInst
 {
@@ -51,6 +51,7 @@ enum ClassId : uid_t
     EVM_CONTRACT,
     EVM_KECCAK_HELPER,
     EVM_MEMORY,
+    EVM_SNAPSHOT,
     EVM_STACK,
     EVM_STORAGE,
     EVM_TRANSACTION,
@@ -494,7 +495,7 @@ public:
         K key;
         V val;
         stream() >> bits(size);
-        for (int i = 0; i < size; i++)
+        for (size_t i = 0; i < size; i++)
         {
             *this >> key >> val;
             map[key] = val;
@@ -51,7 +51,8 @@ public:
      * for symbolic pointers. If there are many symbolic memory accesses this can
      * significantly impact runtime performance. The amount of time given to the
      * solver to refine a pointer's range can be tweaked using the
-     * **symptr_refine_timeout** setting */
+     * **symptr_refine_timeout** setting. Value sets whose range is not bigger
+     * than **symptr_max_range** are not refined */
     bool symptr_refine_range;
     /// Timeout in milliseconds for the solver when refining symbolic pointer value sets (see **symptr_refine_range**).
     unsigned int symptr_refine_timeout;
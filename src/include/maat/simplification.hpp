@@ -2,6 +2,10 @@
 #define SIMPLIFICATION_H
 
 #include "maat/expression.hpp"
+#include <atomic>
+#include <cstdint>
+#include <initializer_list>
+#include <memory>
 #include <vector>
 
 
@@ -22,27 +26,147 @@ class ExprSimplifier;
 typedef Expr (*ExprSimplifierFunc)(Expr);
 typedef Expr (*RecExprSimplifierFunc)(Expr, ExprSimplifier&);
 
+/// Return a bitmask with the bits of all expression types in 'types' set
+template <typename... T>
+constexpr uint32_t expr_types(T... types)
+{
+    return (0u | ... | (1u << (int)types));
+}
+
+/// Return a bitmask with the bits of all operations in 'ops' set
+template <typename... T>
+constexpr uint32_t expr_ops(T... ops)
+{
+    return (0u | ... | (1u << (int)ops));
+}
+
+/** \brief Pattern describing the expressions that a simplifier function
+ * might modify. Each field is a bitmask of allowed expression types
+ * or operations (see expr_types() and expr_ops()).
+ *
+ * Patterns only look at the expression's type, its operation, and the
+ * types of its first two arguments. They must match at least all the
+ * expressions that the function can simplify */
+class SimplifierPattern
+{
+public:
+    static constexpr uint32_t any = 0xffffffff;
+    uint32_t types; ///< Types of the expression
+    uint32_t ops; ///< Operations of the expression (for UNOP and BINOP only)
+    uint32_t arg0_types; ///< Types of the first argument
+    uint32_t arg1_types; ///< Types of the second argument
+public:
+    constexpr SimplifierPattern(
+        uint32_t types=any,
+        uint32_t ops=any,
+        uint32_t arg0_types=any,
+        uint32_t arg1_types=any
+    ): types(types), ops(ops), arg0_types(arg0_types), arg1_types(arg1_types){}
+    /// Return true if the pattern matches an expression with the given type, operation and argument types
+    constexpr bool matches(ExprType type, Op op, ExprType arg0, ExprType arg1) const
+    {
+        return (types & (1u << (int)type))
+            and (ops & (1u << (int)op))
+            and (arg0_types & (1u << (int)arg0))
+            and (arg1_types & (1u << (int)arg1));
+    }
+};
+
+/** \brief Bounded cache of simplification results, keyed by the structure
+ * of the expressions before simplification.
+ *
+ * The cache is direct-mapped: each hash has a single slot and new results
+ * evict the previous ones, so memory usage stays bounded no matter how
+ * many expressions are simplified. A memo can be shared between several
+ * simplifiers with set_memo(), but it isn't thread-safe. Copied simplifiers,
+ * and thus duplicated engines, get their own memo.
+ *
+ * Hashes can collide, so a cached result is only returned if the key
+ * expression is structurally identical to the looked up one. Expression
+ * hashes don't depend on taint, so tainted expressions are never cached.
+ * Memory reads only match themselves, because their access counts are
+ * only meaningful for the symbolic memory state they were created in,
+ * which can be restored by snapshots or diverge in duplicated engines */
+class SimplificationMemo
+{
+private:
+    struct Entry
+    {
+        Expr key;
+        Expr result;
+    };
+    std::vector<Entry> _entries;
+    size_t _mask;
+public:
+    /// Default number of cached results
+    static constexpr size_t default_capacity = 4096;
+public:
+    /** \brief Create a memo that holds at most 'capacity' results. The
+     * capacity is rounded up to a power of two */
+    SimplificationMemo(size_t capacity=default_capacity);
+    SimplificationMemo(const SimplificationMemo& other) = delete;
+    SimplificationMemo& operator=(const SimplificationMemo& other) = delete;
+public:
+    /// Return the cached simplification of 'e', or a null pointer
+    Expr get(const Expr& e) const;
+    /// Cache 'result' as the simplification of 'e'
+    void record(const Expr& e, Expr result);
+    /// Remove all cached results
+    void clear();
+    /// Return the maximal number of cached results
+    size_t capacity() const;
+};
+
 /** An expression simplifier can be used to simplify expressions. It holds
  * a list of simplification functions that can be applied successively to 
- * the expression in onrder to simplify it */
+ * the expression in onrder to simplify it.
+ *
+ * Simplifier functions can be registered with patterns describing the
+ * expressions they apply to. The simplifier builds a dispatch table
+ * indexed by expression type, operation and argument types, so that
+ * only the functions whose patterns match are called on an expression */
 class ExprSimplifier
 {
 private:
-    static unsigned int _id_cnt;
+    static std::atomic<unsigned int> _id_cnt;
+    /// Maximal number of simplifier functions handled by the dispatch table
+    static constexpr size_t max_dispatched = 63;
+    /// Set in dispatch table entries that have been computed
+    static constexpr uint64_t dispatch_computed = (uint64_t)1 << 63;
 
 protected:
     unsigned int _id; ///< Unique ID of the simplifier instance
     std::vector<ExprSimplifierFunc> simplifiers;
     std::vector<RecExprSimplifierFunc> rec_simplifiers;
     // vector<RecExprSimplifierFunc> restruct_simplifiers;
+    /// Patterns of each function in 'simplifiers'
+    std::vector<std::vector<SimplifierPattern>> patterns;
+    /** \brief Bitmask of the functions in 'simplifiers' that can apply to
+     * an expression, indexed by expression type, operation and argument types */
+    std::vector<uint64_t> dispatch;
+    /// Cache of simplification results (can be null)
+    std::shared_ptr<SimplificationMemo> memo;
     Expr run_simplifiers(Expr e); ///< Run all simplifier functions once on expression 'e' and return the resulting expression
 
 public:
     ExprSimplifier(); ///< Constructor
+    /** \brief Copy constructor. The copy applies the same simplifications
+     * but has its own memo, so that both simplifiers can be used by
+     * different threads */
+    ExprSimplifier(const ExprSimplifier& other);
     Expr simplify(Expr e, bool mark_as_simplified=true); ///< Simplify the expression 'e'
     void add(ExprSimplifierFunc func); ///< Add a simplifier function to the expression simplifier
+    /// Add a simplifier function that only applies to expressions matching one of 'patterns'
+    void add(ExprSimplifierFunc func, std::initializer_list<SimplifierPattern> patterns);
     void add(RecExprSimplifierFunc func); ///< Add a recursive simplifier function to the expression simplifier
     // void add_restruct(RecExprSimplifierFunc func);
+    /// Cache simplification results in 'memo'. Set to a null pointer to disable caching
+    void set_memo(std::shared_ptr<SimplificationMemo> memo);
+    /// Return the cache of simplification results used by the simplifier (can be null)
+    std::shared_ptr<SimplificationMemo> get_memo() const;
+private:
+    /// Return the bitmask of functions in 'simplifiers' that can apply to 'e'
+    uint64_t _candidates(const Expr& e);
 };
 
 /** \brief Instanciate a new expression simplifier that uses all of Maat's built-in 
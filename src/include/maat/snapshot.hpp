@@ -2,6 +2,7 @@
 #define MAAT_SNAPSHOT_H
 
 #include <vector>
+#include <unordered_set>
 #include "maat/cpu.hpp"
 #include "maat/types.hpp"
 #include "maat/info.hpp"
@@ -21,7 +22,9 @@ namespace maat
 /** \brief Data container class used by the engine for snapshoting.
  * 
  * It holds copies of some objects and states when the snapshot was taken,
- * in particular the CPU state, optional IR state, engine information.
+ * in particular the CPU state, optional IR state, engine information. The
+ * CPU registers, page permissions and mappings are shared with the engine
+ * and only copied when modified, so taking a snapshot is cheap.
  * 
  * It also holds data dynamically added by the engine during execution after
  * the snapshot is taken, typically memory modifications (read/write, segment creation,
@@ -34,16 +37,21 @@ public:
     ir::CPU cpu;
     /// Snapshot id for the symbolic memory engine
     symbolic_mem_snapshot_t symbolic_mem;
-    /// Backup of memory overwritten since snapshot
+    /** \brief Backup of memory overwritten since snapshot. Memory is saved by lines
+     * of 'saved_mem_line_size' bytes, and each line is saved at most once */
     std::list<SavedMemState> saved_mem;
+    /// Start addresses of memory lines already saved in 'saved_mem'
+    std::unordered_set<addr_t> dirty_mem_lines;
     /// List of segments created since snapshot
     std::list<addr_t> created_segments;
+    /// Bounds of segments extended since snapshot, before their extension
+    std::list<std::pair<addr_t, addr_t>> extended_segments;
     /// Pending IR state (optional, used if snapshoting in the middle of native instructions)
     std::optional<ir::IRMap::InstLocation> pending_ir_state;
-    /// Page permissions snapshot
-    std::list<PageSet> page_permissions;
-    /// Mappings snapshot
-    std::list<MemMap> mem_mappings;
+    /// Page permissions snapshot (shared with the memory engine until modified)
+    std::shared_ptr<const std::list<PageSet>> page_permissions;
+    /// Mappings snapshot (shared with the memory engine until modified)
+    std::shared_ptr<const std::list<MemMap>> mem_mappings;
     /// Path constraints
     PathManager::path_snapshot_t path;
     /// Engine info snapshot
@@ -52,6 +60,9 @@ public:
     std::shared_ptr<ProcessInfo> process;
     /// Environment
     int env;
+public:
+    /// Granularity (in bytes) at which overwritten memory is saved
+    static constexpr addr_t saved_mem_line_size = 64;
 public:
     Snapshot() = default;
     Snapshot(const Snapshot& other) = delete;
@@ -59,7 +70,11 @@ public:
     virtual ~Snapshot() = default;
 public:
     void add_saved_mem(SavedMemState&& content);
+    /** \brief Mark the memory line starting at 'line' as dirty. Return true if
+     * the line was clean and its contents must be saved */
+    bool add_dirty_mem_line(addr_t line);
     void add_created_segment(addr_t segment_start);
+    void add_extended_segment(addr_t segment_start, addr_t segment_end);
 public:
     virtual uid_t class_uid() const;
     virtual void dump(serial::Serializer& s) const;
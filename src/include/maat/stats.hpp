@@ -1,6 +1,7 @@
 #ifndef MAAT_STATS_H
 #define MAAT_STATS_H
 
+#include <atomic>
 #include <chrono>
 #include <iostream>
 
@@ -13,24 +14,28 @@ namespace maat{
  * \{ */
 
 /** Global stats recorded by Maat to be used for introspection
- * and optimisations */
+ * and optimisations. Engines running in different threads can
+ * update them concurrently */
 class MaatStats
 {
 private:
-    std::chrono::steady_clock::time_point _time;
+    /// Start time of the current measurement, per thread
+    static inline thread_local std::chrono::steady_clock::time_point _time;
 private:
-    unsigned int _symptr_read_total_time;
-    unsigned int _symptr_read_average_range;
-    unsigned int _symptr_read_count;
-    unsigned int _symptr_write_total_time;
-    unsigned int _symptr_write_average_range;
-    unsigned int _symptr_write_count;
-    unsigned int _executed_inst_count;
-    unsigned int _lifted_inst_count;
-    unsigned int _executed_ir_inst_count;
-    unsigned long long _created_expr_count;
-    unsigned int _solver_total_time;
-    unsigned int _solver_calls_count;
+    std::atomic<unsigned int> _symptr_read_total_time;
+    std::atomic<unsigned int> _symptr_read_average_range;
+    std::atomic<unsigned int> _symptr_read_count;
+    std::atomic<unsigned int> _symptr_write_total_time;
+    std::atomic<unsigned int> _symptr_write_average_range;
+    std::atomic<unsigned int> _symptr_write_count;
+    std::atomic<unsigned int> _executed_inst_count;
+    std::atomic<unsigned int> _lifted_inst_count;
+    std::atomic<unsigned int> _executed_ir_inst_count;
+    std::atomic<unsigned long long> _created_expr_count;
+    std::atomic<unsigned long long> _simplify_memo_hit_count;
+    std::atomic<unsigned long long> _simplify_memo_miss_count;
+    std::atomic<unsigned int> _solver_total_time;
+    std::atomic<unsigned int> _solver_calls_count;
     // TODO(boyan): total/average time spent simplifying symbolic expressions?
 
 public:
@@ -51,6 +56,8 @@ public:
         _lifted_inst_count = 0;
         _executed_ir_inst_count = 0;
         _created_expr_count = 0;
+        _simplify_memo_hit_count = 0;
+        _simplify_memo_miss_count = 0;
         _solver_total_time = 0;
         _solver_calls_count = 0;
     }
@@ -69,8 +76,9 @@ public:
     /// Average time spend refining symbolic pointer reads (in milliseconds)
     unsigned int symptr_read_average_time() const
     {
-        if  (_symptr_read_count != 0)
-            return _symptr_read_total_time/_symptr_read_count;
+        unsigned int count = _symptr_read_count;
+        if  (count != 0)
+            return _symptr_read_total_time/count;
         else
             return 0;
     }
@@ -84,8 +92,9 @@ public:
     /// Average time spend refining symbolic pointer writes (in milliseconds)
     unsigned int symptr_write_average_time() const
     {
-        if  (_symptr_write_count != 0)
-            return _symptr_write_total_time/_symptr_write_count;
+        unsigned int count = _symptr_write_count;
+        if  (count != 0)
+            return _symptr_write_total_time/count;
         else
             return 0;
     }
@@ -104,13 +113,29 @@ public:
     /// Total number of Expr instances created
     unsigned long long created_exprs() const {return _created_expr_count;}
 
+    /// Number of simplifications answered by the simplification memo
+    unsigned long long simplify_memo_hits() const {return _simplify_memo_hit_count;}
+    /// Number of simplifications that were not found in the simplification memo
+    unsigned long long simplify_memo_misses() const {return _simplify_memo_miss_count;}
+    /// Percentage of simplifications answered by the simplification memo
+    unsigned int simplify_memo_hit_rate() const
+    {
+        unsigned long long hits = _simplify_memo_hit_count;
+        unsigned long long total = hits + _simplify_memo_miss_count;
+        if (total != 0)
+            return (hits*100)/total;
+        else
+            return 0;
+    }
+
     /// Total time spent solving symbolic constraints (in milliseconds)
     unsigned int solver_total_time() const {return _solver_total_time;}
     /// Average time spent per call to the solver (in milliseconds)
     unsigned int solver_average_time() const
     {
-        if (_solver_calls_count != 0)
-            return _solver_total_time/_solver_calls_count;
+        unsigned int count = _solver_calls_count;
+        if (count != 0)
+            return _solver_total_time/count;
         else
             return 0;
     }
@@ -162,6 +187,8 @@ public:
     void inc_executed_ir_insts() {_executed_ir_inst_count++;}
 
     void inc_created_exprs() {_created_expr_count++;}
+    void inc_simplify_memo_hits() {_simplify_memo_hit_count++;}
+    void inc_simplify_memo_misses() {_simplify_memo_miss_count++;}
 
     /// Notify that we started to solve constraints with the solver
     void start_solving()
@@ -196,7 +223,10 @@ public:
         os << "Lifted insts: " << stats.lifted_insts() << "\n"; 
         os << "Executed IR insts: " << stats.executed_ir_insts() << "\n\n";
 
-        os << "Created symbolic expressions: " << stats.created_exprs() << "\n\n";
+        os << "Created symbolic expressions: " << stats.created_exprs() << "\n";
+        os << "Simplification memo hits: " << stats.simplify_memo_hits() << "\n";
+        os << "Simplification memo misses: " << stats.simplify_memo_misses() << "\n";
+        os << "Simplification memo hit rate: " << stats.simplify_memo_hit_rate() << " % \n\n";
 
         os << "Solver total time: " << stats.solver_total_time() << " ms \n";
         os << "Solver average time: " << stats.solver_average_time() << " ms \n";
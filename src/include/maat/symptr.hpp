@@ -0,0 +1,145 @@
+#ifndef MAAT_SYMPTR_H
+#define MAAT_SYMPTR_H
+
+#include <memory>
+#include <string>
+#include <vector>
+#include "maat/types.hpp"
+#include "maat/value.hpp"
+#include "maat/varcontext.hpp"
+
+namespace maat
+{
+
+class MaatEngine;
+
+/** \addtogroup engine
+ * \{ */
+
+/** \brief Policy deciding how the engine accesses memory through a pointer
+ * that is not concrete (symbolic or concolic).
+ *
+ * A policy either concretizes the pointer to a single address, or keeps it
+ * symbolic and gives the range of addresses that the access can touch.
+ * Custom policies can be implemented by overriding resolve() and
+ * registered for some address ranges with SymPtrPolicies */
+class SymPtrPolicy
+{
+public:
+    /// Result of the resolution of a pointer by a policy
+    struct Result
+    {
+        enum class Action
+        {
+            CONCRETE, ///< Access memory at 'addr'
+            SYMBOLIC, ///< Access memory symbolically at all addresses in 'range'
+            ERROR ///< The access is not allowed, 'error' holds the reason
+        };
+        Action action;
+        addr_t addr;
+        ValueSet range;
+        std::string error;
+    };
+public:
+    virtual ~SymPtrPolicy() = default;
+    /** \brief Resolve the non-concrete pointer *addr* used to read memory, or
+     * to write it if *is_write* is set */
+    virtual Result resolve(MaatEngine& engine, const Value& addr, bool is_write) = 0;
+protected:
+    /// Return a result concretizing the pointer to *addr*
+    static Result concrete(addr_t addr);
+    /// Return a result keeping the pointer symbolic within *range*
+    static Result symbolic(const ValueSet& range);
+    /// Return a result rejecting the access with *error*
+    static Result error(const std::string& error);
+    /** \brief Concretize *addr* to *value*. The constraint *addr == value* is
+     * added to the path constraints if the engine records them, so that
+     * later solving remains consistent with the access */
+    static Result concretize(MaatEngine& engine, const Value& addr, addr_t value);
+    /// Simplify *e* with the engine's simplifier
+    static Expr simplify(MaatEngine& engine, Expr e);
+};
+
+/** \brief Default policy, honouring the engine settings: *symptr_read* and
+ * *symptr_write* to allow symbolic accesses, *symptr_refine_range* to refine
+ * their range with the solver. Concolic pointers are concretized to their
+ * concolic value when symbolic accesses are disabled */
+class DefaultSymPtrPolicy: public SymPtrPolicy
+{
+public:
+    virtual Result resolve(MaatEngine& engine, const Value& addr, bool is_write);
+};
+
+/** \brief Concretize pointers to their minimal possible value. The value set
+ * of the pointer is refined with the solver only if the *symptr_refine_range*
+ * setting is enabled, otherwise no solver call is made but the minimum can
+ * be a value that the pointer can't take in the current path */
+class MinSymPtrPolicy: public SymPtrPolicy
+{
+public:
+    virtual Result resolve(MaatEngine& engine, const Value& addr, bool is_write);
+};
+
+/** \brief Concretize concolic pointers to their concolic value without calling
+ * the solver. Fully symbolic pointers have no concolic value and are
+ * concretized like MinSymPtrPolicy does */
+class ConcolicSymPtrPolicy: public MinSymPtrPolicy
+{
+public:
+    virtual Result resolve(MaatEngine& engine, const Value& addr, bool is_write);
+};
+
+/** \brief Keep pointers fully symbolic, but limit accesses to at most
+ * *max_range* addresses, which must not be zero. For concolic pointers the range is centered on the
+ * concolic value and computed without calling the solver. Other pointers
+ * are refined with the solver if needed and limited to the lowest addresses
+ * of their refined range. Like the *symptr_limit_range* setting, this loses
+ * the states where the pointer is outside of the range */
+class SymbolicSymPtrPolicy: public SymPtrPolicy
+{
+private:
+    addr_t _max_range;
+public:
+    SymbolicSymPtrPolicy(addr_t max_range);
+    virtual Result resolve(MaatEngine& engine, const Value& addr, bool is_write);
+};
+
+/** \brief Symbolic pointer policies for different address ranges.
+ *
+ * A policy applies to a pointer if its concolic value is in the policy's
+ * range, or, for fully symbolic pointers, if all the possible values of the
+ * pointer are in the range. If several ranges match, the policy added last
+ * is used. Pointers matching no range use the default policy */
+class SymPtrPolicies
+{
+private:
+    struct region_t
+    {
+        addr_t min;
+        addr_t max;
+        std::shared_ptr<SymPtrPolicy> policy;
+    };
+    std::vector<region_t> _regions;
+    std::shared_ptr<SymPtrPolicy> _default;
+public:
+    /// Create with a DefaultSymPtrPolicy and no address range
+    SymPtrPolicies();
+    SymPtrPolicies(const SymPtrPolicies& other) = default;
+    SymPtrPolicies& operator=(const SymPtrPolicies& other) = default;
+    ~SymPtrPolicies() = default;
+public:
+    /// Set the policy used for pointers matching no address range
+    void set_default(std::shared_ptr<SymPtrPolicy> policy);
+    /// Use *policy* for pointers in range [*min*, *max*] (included)
+    void add(addr_t min, addr_t max, std::shared_ptr<SymPtrPolicy> policy);
+    /// Remove all address ranges. The default policy is kept
+    void clear();
+    /// Return the policy to use for pointer *addr*
+    SymPtrPolicy& get(const Value& addr, const VarContext& vars);
+};
+
+/** \} */ // doxygen engine group
+
+} // namespace maat
+
+#endif
@@ -0,0 +1,140 @@
+#ifndef MAAT_TRACE_H
+#define MAAT_TRACE_H
+
+#include <cstdint>
+#include <fstream>
+#include <memory>
+#include <string>
+#include <vector>
+#include "maat/types.hpp"
+
+namespace maat
+{
+
+/** \addtogroup engine
+ * \{ */
+
+/// Compact record of an executed instruction
+struct TraceRecord
+{
+    /// Flags indicating what happened while executing the instruction
+    enum Flags: uint8_t
+    {
+        BRANCH = 1, ///< The instruction performed a native branch operation
+        BRANCH_TAKEN = 2, ///< The branch was taken
+        MEM_READ = 4, ///< The instruction read memory at a concrete address
+        MEM_WRITE = 8 ///< The instruction wrote memory at a concrete address
+    };
+    /// Address of the instruction
+    addr_t pc;
+    /// Address of the last concrete memory access, if any
+    addr_t mem_addr;
+    /// Combination of TraceRecord::Flags
+    uint8_t flags;
+
+    /// Size in bytes of a record once written to a binary trace file
+    static constexpr size_t raw_size = 17;
+    /** \brief Write the record in 'buf' in its binary form: the instruction
+     * address and the memory address as 8-byte little endian integers,
+     * followed by the flags byte. 'buf' must be at least 'raw_size' bytes long */
+    void to_raw(uint8_t* buf) const;
+};
+
+/** \brief Native recorder for code coverage and execution traces.
+ *
+ * Coverage is recorded AFL-style: each basic block address is hashed, and
+ * every executed edge between two basic blocks increments an entry in a fixed
+ * size bitmap. Entries saturate at 255. A basic block starts on the first instruction executed after
+ * an instruction that performed a native branch operation.
+ *
+ * Traces are recorded as one TraceRecord per executed instruction. Records
+ * are stored in a ring buffer holding the most recent records, and can also
+ * be streamed to a binary file.
+ *
+ * The recorder is much faster than hooking Event::EXEC with a callback, and
+ * can be enabled and disabled at any time */
+class TraceRecorder
+{
+private:
+    bool _coverage_enabled;
+    bool _trace_enabled;
+    // Coverage
+    std::vector<uint8_t> _bitmap;
+    unsigned int _bitmap_shift;
+    addr_t _prev_loc;
+    bool _block_start;
+    // Trace
+    std::vector<TraceRecord> _ring;
+    size_t _ring_size;
+    size_t _ring_next;
+    uint64_t _nb_records;
+    std::shared_ptr<std::ofstream> _file;
+    std::vector<uint8_t> _file_buffer;
+    // State for the current instruction
+    TraceRecord _current;
+public:
+    /// Default bitmap size for coverage (64 KiB like AFL)
+    static constexpr size_t default_bitmap_size = 1 << 16;
+    /// Default number of records kept in the trace ring buffer
+    static constexpr size_t default_ring_size = 1 << 16;
+public:
+    TraceRecorder();
+    TraceRecorder(const TraceRecorder& other) = delete;
+    TraceRecorder& operator=(const TraceRecorder& other) = delete;
+    ~TraceRecorder();
+public:
+    /** \brief Start recording coverage in a bitmap of 'bitmap_size' bytes.
+     * 'bitmap_size' must be a power of two greater than 1. The bitmap is reset if its
+     * size changes */
+    void enable_coverage(size_t bitmap_size = default_bitmap_size);
+    /// Stop recording coverage. The bitmap is kept
+    void disable_coverage();
+    /// Return true if coverage is being recorded
+    bool coverage_enabled() const;
+    /// Get the coverage bitmap
+    const std::vector<uint8_t>& coverage_bitmap() const;
+    /// Return the number of bitmap entries that are non-null
+    size_t nb_covered_edges() const;
+    /// Clear the coverage bitmap
+    void reset_coverage();
+public:
+    /** \brief Start recording an execution trace, keeping the last 'ring_size'
+     * records in memory. If 'filename' is not empty, all records are also
+     * appended to this file in binary form (see TraceRecord::to_raw()) */
+    void enable_trace(
+        size_t ring_size = default_ring_size,
+        const std::string& filename = ""
+    );
+    /// Stop recording the execution trace and close the trace file, if any
+    void disable_trace();
+    /// Return true if the execution trace is being recorded
+    bool trace_enabled() const;
+    /// Return the records in the ring buffer, from the oldest to the most recent
+    std::vector<TraceRecord> trace() const;
+    /// Return the total number of records since the trace was enabled
+    uint64_t nb_records() const;
+    /// Clear the ring buffer
+    void clear_trace();
+    /// Write pending records to the trace file
+    void flush();
+public:
+    /// Return true if either coverage or trace is being recorded
+    inline bool is_enabled() const
+    {
+        return _coverage_enabled or _trace_enabled;
+    }
+    /// **INTERNAL**: Record a native branch operation in the current instruction
+    void record_branch(bool taken);
+    /// **INTERNAL**: Record a concrete memory access in the current instruction
+    void record_mem_access(addr_t addr, bool is_write);
+    /// **INTERNAL**: Record that instruction at address 'pc' finished executing
+    void record_inst(addr_t pc);
+private:
+    void _reset_current();
+};
+
+/** \} */ // doxygen group engine
+
+} // namespace maat
+
+#endif
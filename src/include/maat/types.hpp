@@ -14,6 +14,7 @@ typedef uint32_t hash_t; ///< Unique hash identifying an abstract expression obj
 typedef int64_t cst_t; ///< Signed constant integer value
 typedef uint64_t ucst_t; ///< Unsigned constant integer value
 typedef double fcst_t; ///< Float constant value (double precision / 64 bits)
+typedef uint32_t var_id_t; ///< Unique integer identifying a symbolic variable name
 /** \} */
 
 /** \addtogroup memory
@@ -0,0 +1,77 @@
+#ifndef MAAT_UINT256_H
+#define MAAT_UINT256_H
+
+#include <cstdint>
+#include <cstddef>
+#include "gmp.h"
+#include "gmpxx.h"
+
+namespace maat
+{
+
+/** \addtogroup expression
+ * \{ */
+
+/** \brief Fixed-width unsigned integer on 256 bits.
+ *
+ * This class is used internally by *maat::Number* to store values between
+ * 65 and 256 bits without allocating GMP integers. All operations are
+ * computed modulo 2^256 */
+class UInt256
+{
+public:
+    uint64_t limbs[4]; ///< Value limbs, least significant first
+
+public:
+    UInt256(): limbs{0, 0, 0, 0} {}
+    explicit UInt256(uint64_t low): limbs{low, 0, 0, 0} {}
+    UInt256(const UInt256& other) = default;
+    UInt256& operator=(const UInt256& other) = default;
+
+public:
+    /// Return true if the value is zero
+    bool is_zero() const;
+    /// Return the value (0 or 1) of bit 'idx'
+    int get_bit(unsigned int idx) const;
+    /// Set bit 'idx' to 1
+    void set_bit(unsigned int idx);
+    /// Clear all bits starting from bit 'bits'
+    void truncate(size_t bits);
+    /// Extend bit 'bits-1' to all higher bits
+    void sign_extend(size_t bits);
+    /// Return the number of bits set
+    unsigned int popcount() const;
+    /// Return true if the value is strictly less than 'val'
+    bool less_than(uint64_t val) const;
+
+public:
+    friend bool operator==(const UInt256& a, const UInt256& b);
+    friend bool operator!=(const UInt256& a, const UInt256& b);
+    friend bool operator<(const UInt256& a, const UInt256& b);
+    friend UInt256 operator+(const UInt256& a, const UInt256& b);
+    friend UInt256 operator-(const UInt256& a, const UInt256& b);
+    friend UInt256 operator-(const UInt256& a);
+    friend UInt256 operator*(const UInt256& a, const UInt256& b);
+    friend UInt256 operator&(const UInt256& a, const UInt256& b);
+    friend UInt256 operator|(const UInt256& a, const UInt256& b);
+    friend UInt256 operator^(const UInt256& a, const UInt256& b);
+    friend UInt256 operator~(const UInt256& a);
+    friend UInt256 operator<<(const UInt256& a, unsigned int shift);
+    friend UInt256 operator>>(const UInt256& a, unsigned int shift);
+    /// Unsigned division and remainder of 'a' by 'b'. 'b' must not be zero
+    static void divmod(const UInt256& a, const UInt256& b, UInt256& quotient, UInt256& remainder);
+    /// Return a value with the 'bits' lowest bits set
+    static UInt256 ones(size_t bits);
+
+public:
+    /// Convert to a GMP integer
+    mpz_class to_mpz() const;
+    /// Convert the lowest 256 bits of a GMP integer (two's complement if negative)
+    static UInt256 from_mpz(const mpz_class& val);
+};
+
+/** \} */ // doxygen expression group
+
+} // namespace maat
+
+#endif
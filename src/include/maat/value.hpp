@@ -14,6 +14,13 @@ namespace maat
 /** A value is a wrapper class that represent data on a fixed number of bits.
 The data can be either concrete, or abstract. The underlying implementation
 uses the `Expr` and `Number` classes to represent abstract and concrete values.
+
+Concrete values can also carry a shadow taint mask. It allows to track
+data-flow taint without building symbolic expressions: operations on
+concrete values are computed natively and the taint is propagated with
+simple per-operation rules. The mask has one bit per bit of the value for
+values of 64 bits or less, and one bit per byte for wider values (the last
+bit of the mask covers all bytes after the 63rd).
 */
 class Value: public serial::Serializable
 {
@@ -29,10 +36,12 @@ private:
     Expr _expr;
     Number _number;
     Type type;
+    ucst_t _taint; ///< Shadow taint mask (concrete values only)
 
 public:
     Value(); ///< Empty value
     Value(const Value& other) = default; ///< Copy constructor
+    Value(Value&& other) = default; ///< Move constructor
     Value(const Expr& expr); ///< Build value from abstract expression
     Value(const Number& number); ///< Build value from concrete number
     Value(size_t size, cst_t val); ///< Build value from concrete value
@@ -54,6 +63,17 @@ public:
 public:
     bool is_abstract() const;
     bool is_none() const;
+    /// Return true if at least one bit of the value is tainted
+    bool is_tainted() const;
+public:
+    /// Return the shadow taint mask of a concrete value
+    ucst_t shadow_taint() const;
+    /// Set the shadow taint mask of a concrete value
+    void set_shadow_taint(ucst_t mask);
+    /// Taint bits 'high' to 'low' (included) of a concrete value
+    void add_shadow_taint(unsigned int high, unsigned int low);
+    /// Return true if at least one bit between 'high' and 'low' (included) is shadow-tainted
+    bool has_shadow_taint(unsigned int high, unsigned int low) const;
 public:
     bool is_symbolic(const VarContext&) const;
     bool is_concolic(const VarContext&) const;
@@ -112,7 +132,7 @@ public:
         const Value& if_true, const Value& if_false
     );
 public:
-    /// Return true if value is the same as other
+    /// Return true if value is the same as other. The shadow taint is ignored
     bool eq(const Value& other) const;
 public:
     friend std::ostream& operator<<(std::ostream& os, const Value& val);
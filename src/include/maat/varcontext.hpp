@@ -1,11 +1,13 @@
 #ifndef MAAT_VARCONTEXT_H
 #define MAAT_VARCONTEXT_H
 
+#include <atomic>
 #include <map>
 #include <optional>
 #include "maat/number.hpp"
 #include "maat/serializer.hpp"
 #include "maat/types.hpp"
+#include "maat/varset.hpp"
 #include <vector>
 #include <set>
 
@@ -21,11 +23,18 @@ class Value; // Forward decl
 class VarContext: public serial::Serializable
 {
 private:
-    static unsigned int _id_cnt;
+    static std::atomic<unsigned int> _id_cnt;
+    static std::atomic<uint64_t> _version_cnt;
     Endian _endianness;
 private:
-    /** Map concrete values to symbolic variables */
-    std::map<std::string, maat::Number> varmap;
+    /** Concrete values of symbolic variables, indexed by variable ID
+     * (see VarTable) */
+    std::vector<std::optional<maat::Number>> _values;
+    /** Version of each variable, indexed by variable ID. Every change to a
+     * variable gives it a new version that is unique across all contexts */
+    std::vector<uint64_t> _versions;
+private:
+    void _touch(var_id_t var); // Bump the version of a variable
 public:
     unsigned int id; ///< Unique identifier for the VarContext instance
 
@@ -38,12 +47,31 @@ public:
 public:
     void set(const std::string& var, cst_t value); ///< Give a concrete value to a symbolic variable
     void set(const std::string& var, const Number& number); ///< Give a concrete value to a symbolic variable as a *maat::Number* instance
+    void set(var_id_t var, const Number& number); ///< Give a concrete value to a symbolic variable by ID
     cst_t get(const std::string& var) const; ///< Get the concrete value given to a symbolic variable
     const maat::Number& get_as_number(const std::string& var) const;
+    const maat::Number& get_as_number(var_id_t var) const; ///< Get the concrete value given to a symbolic variable by ID
     std::vector<uint8_t> get_as_buffer(std::string var, unsigned int elem_size=1) const;
     std::string get_as_string(std::string var) const;
     void remove(const std::string& var); ///< Remove concrete value for symbolic variable 
+    void remove(var_id_t var); ///< Remove concrete value for symbolic variable by ID
     bool contains(const std::string& var) const; ///< Return true if a concrete value is associated to the symbolic variable
+    /// Return true if a concrete value is associated to the symbolic variable by ID
+    inline bool contains(var_id_t var) const
+    {
+        return var < _values.size() and _values[var].has_value();
+    }
+    /** \brief Return the version of a variable. Variables that were never
+     * set or removed have version 0 */
+    inline uint64_t version(var_id_t var) const
+    {
+        return var < _versions.size() ? _versions[var] : 0;
+    }
+    /** \brief Return the latest version among variables 'vars'. Because
+     * versions are unique, two contexts (or the same context at two different
+     * times) that give the same version to 'vars' assign the same values to all
+     * the variables in 'vars' */
+    uint64_t version(const VarSet& vars) const;
     std::string new_name_from(const std::string& hint) const;
     /** \brief Create a new buffer of symbolic variables.
      * @param name Base name after whom to name variables
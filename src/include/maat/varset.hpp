@@ -0,0 +1,91 @@
+#ifndef MAAT_VARSET_H
+#define MAAT_VARSET_H
+
+#include <cstdint>
+#include <optional>
+#include <set>
+#include <string>
+#include <vector>
+#include "maat/types.hpp"
+
+namespace maat
+{
+
+/** \addtogroup expression
+ * \{ */
+
+/** \brief Global table that interns symbolic variable names.
+ *
+ * Each variable name is associated to a unique and dense integer ID the first
+ * time it is used. IDs are never reused, and are shared by all engines in the
+ * process. Internally, variables are manipulated by ID, and the names are only
+ * used in the API exposed to users and for serialization */
+class VarTable
+{
+public:
+    /// Return the ID of variable 'name', creating it if needed
+    static var_id_t id(const std::string& name);
+    /// Return the ID of variable 'name' if it has already been interned
+    static std::optional<var_id_t> find(const std::string& name);
+    /// Return the name of variable 'id'
+    static const std::string& name(var_id_t id);
+};
+
+/** \brief A set of symbolic variables, represented as a bitset indexed by
+ * variable IDs.
+ *
+ * Only the words between the lowest and highest IDs in the set are stored,
+ * so sets of variables created together (e.g. a symbolic buffer) stay small
+ * even when their IDs are high */
+class VarSet
+{
+private:
+    /// Index of the first word in '_words'
+    var_id_t _offset;
+    std::vector<uint64_t> _words;
+public:
+    VarSet();
+    /// Create a set from variable names. Names that were never interned are ignored
+    VarSet(const std::set<std::string>& names);
+    VarSet(const VarSet& other) = default;
+    VarSet(VarSet&& other) = default;
+    VarSet& operator=(const VarSet& other) = default;
+    VarSet& operator=(VarSet&& other) = default;
+    ~VarSet() = default;
+public:
+    /// Add variable 'var' to the set
+    void insert(var_id_t var);
+    /// Add all variables of 'other' to the set
+    void insert(const VarSet& other);
+    /// Return true if the set contains variable 'var'
+    bool contains(var_id_t var) const;
+    /// Return true if the set has at least one variable in common with 'other'
+    bool intersects(const VarSet& other) const;
+    /// Return true if the set is empty
+    bool empty() const;
+    /// Return the IDs of the variables in the set, in increasing order
+    std::vector<var_id_t> ids() const;
+    /// Call 'func' on the ID of each variable in the set, in increasing order
+    template<typename F>
+    void for_each(F func) const
+    {
+        for (size_t i = 0; i < _words.size(); i++)
+        {
+            uint64_t word = _words[i];
+            for (var_id_t bit = 0; word != 0; bit++, word >>= 1)
+            {
+                if (word & 1)
+                    func((_offset + i)*64 + bit);
+            }
+        }
+    }
+    /// Return the names of the variables in the set
+    std::set<std::string> names() const;
+private:
+    void _grow(var_id_t first_word, var_id_t last_word);
+};
+
+/** \} */ // doxygen expression group
+
+} // namespace maat
+#endif
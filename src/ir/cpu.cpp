@@ -175,9 +175,28 @@ void ProcessedInst::reset()
     in2.set_none();
 }
 
-CPUContext::CPUContext(int nb_regs): alias_setter(nullptr), alias_getter(nullptr)
+CPUContext::CPUContext(int nb_regs): nb_regs(nb_regs), alias_getter(nullptr), alias_setter(nullptr)
 {
-    regs = std::vector<Value>(nb_regs);
+    for (int i = 0; i < nb_regs; i += reg_chunk_size)
+        regs.push_back(std::make_shared<reg_chunk_t>());
+}
+
+CPUContext::CPUContext(const CPUContext& other)
+{
+    *this = other;
+}
+
+CPUContext& CPUContext::operator=(const CPUContext& other)
+{
+    regs = other.regs;
+    nb_regs = other.nb_regs;
+    alias_getter = other.alias_getter;
+    alias_setter = other.alias_setter;
+    aliased_regs = other.aliased_regs;
+    lazy_regs = other.lazy_regs;
+    // The copy might be used by another engine
+    _resolve_lazy();
+    return *this;
 }
 
 void CPUContext::_set_aliased_reg(ir::reg_t reg, const Value& val)
@@ -192,7 +211,7 @@ void CPUContext::set(ir::reg_t reg, const Value& value)
     try
     {
         _check_assignment_size(idx, value.size());
-        regs.at(idx) = value;
+        _mutable_reg(idx) = value;
     }
     catch(const std::out_of_range&)
     {
@@ -210,7 +229,7 @@ void CPUContext::set(ir::reg_t reg, Expr value)
     try
     {
         _check_assignment_size(idx, value->size);
-        regs.at(idx) = value;
+        _mutable_reg(idx) = value;
     }
     catch(const std::out_of_range&)
     {
@@ -227,7 +246,8 @@ void CPUContext::set(ir::reg_t reg, cst_t value)
     int idx(reg);
     try
     {
-        regs.at(idx).set_cst(regs.at(idx).size(), value);
+        Value& reg_val = _mutable_reg(idx);
+        reg_val.set_cst(reg_val.size(), value);
     }
     catch(const std::out_of_range&)
     {
@@ -236,7 +256,7 @@ void CPUContext::set(ir::reg_t reg, cst_t value)
                 << " which doesn't exist in current context"
             );
     }
-    _set_aliased_reg(reg, regs.at(idx));
+    _set_aliased_reg(reg, _reg(idx));
 }
 
 void CPUContext::set(ir::reg_t reg, Number&& value)
@@ -245,7 +265,7 @@ void CPUContext::set(ir::reg_t reg, Number&& value)
     try
     {
         _check_assignment_size(idx, value.size);
-        regs.at(idx) = value;
+        _mutable_reg(idx) = value;
     }
     catch(const std::out_of_range&)
     {
@@ -263,7 +283,7 @@ void CPUContext::set(ir::reg_t reg, const Number& value)
     try
     {
         _check_assignment_size(idx, value.size);
-        regs.at(idx) = value;
+        _mutable_reg(idx) = value;
     }
     catch(const std::out_of_range&)
     {
@@ -277,10 +297,14 @@ void CPUContext::set(ir::reg_t reg, const Number& value)
 
 void CPUContext::_check_assignment_size(int idx, size_t size) const
 {
-    if (not regs.at(idx).is_none() and regs.at(idx).size() != size)
+    if (idx < 0 or idx >= nb_regs)
+        throw std::out_of_range("CPUContext: invalid register");
+    // Don't use _reg() to avoid merging lanes of a value that gets overwritten
+    size_t current_size = reg_size(idx);
+    if (current_size != 0 and current_size != size)
         throw cpu_exception( Fmt()
             << "Can't assign " << std::dec << size << "-bits value to "
-            << regs.at(idx).size() << "-bits register" << "\n" 
+            << current_size << "-bits register" << "\n" 
             >> Fmt::to_str
         );
 }
@@ -296,9 +320,9 @@ const Value& CPUContext::get(ir::reg_t reg)
 
     try
     {
-        if (_is_alias(reg) and reg >= 0 and reg < regs.size())
-            regs[idx] = alias_getter(*this, reg);
-        return regs.at(idx);
+        if (_is_alias(reg) and idx >= 0 and idx < nb_regs)
+            _mutable_reg(idx) = alias_getter(*this, reg);
+        return _reg(idx);
     }
     catch(const std::out_of_range&)
     {
@@ -309,6 +333,241 @@ const Value& CPUContext::get(ir::reg_t reg)
     }
 }
 
+Value CPUContext::_reg_value(int idx) const
+{
+    if (idx < 0 or idx >= nb_regs)
+        throw std::out_of_range("CPUContext: invalid register");
+    int i = idx % reg_chunk_size;
+    const reg_chunk_t& chunk = *regs[idx / reg_chunk_size];
+    Value res;
+    if (chunk.lazy[i] != nullptr)
+        _compute_lazy(*chunk.lazy[i], res);
+    else if (chunk.stale[i])
+        _merge_lanes(chunk.lanes[i], res);
+    else
+        res = chunk.values[i];
+    return res;
+}
+
+void CPUContext::_merge_lanes(const std::vector<Value>& lanes, Value& res)
+{
+    res = lanes.back();
+    for (int l = lanes.size()-2; l >= 0; l--)
+        res.set_concat(res, lanes[l]);
+}
+
+void CPUContext::_split_lanes(reg_chunk_t& chunk, int i)
+{
+    std::vector<Value>& lanes = chunk.lanes[i];
+    const Value& val = chunk.values[i];
+    if (not lanes.empty())
+        return;
+    for (size_t low = 0; low < val.size(); low += reg_lane_size)
+    {
+        size_t high = std::min(low+reg_lane_size, val.size())-1;
+        lanes.push_back(extract(val, high, low));
+    }
+}
+
+void CPUContext::set_lazy(
+    ir::reg_t reg,
+    ir::Op op,
+    const Value& in0,
+    const Value& in1,
+    std::shared_ptr<VarContext> vars,
+    std::shared_ptr<ExprSimplifier> simplifier
+)
+{
+    if (not is_lazy_op(op))
+        throw cpu_exception(Fmt()
+            << "CPUContext::set_lazy(): got unsupported operation " << op
+            >> Fmt::to_str
+        );
+    int idx(reg);
+    try
+    {
+        _mutable_reg(idx);
+        // The result has the size of the register, which must be known already
+        size_t size = reg_size(reg);
+        if (size == 0)
+            throw cpu_exception("CPUContext::set_lazy(): register has no value yet");
+        regs[idx / reg_chunk_size]->lazy[idx % reg_chunk_size] = std::make_shared<lazy_value_t>(
+            lazy_value_t{op, in0, in1, size, vars, simplifier}
+        );
+    }
+    catch(const std::out_of_range&)
+    {
+        throw ir_exception(Fmt()
+                << "CPUContext: Trying to set register " << std::dec << idx
+                << " which doesn't exist in current context" >> Fmt::to_str
+            );
+    }
+}
+
+void CPUContext::_resolve_lazy()
+{
+    for (int idx = 0; idx < nb_regs; idx++)
+        if (regs[idx / reg_chunk_size]->lazy[idx % reg_chunk_size] != nullptr)
+            _reg(idx);
+}
+
+bool CPUContext::is_lazy_reg(ir::reg_t reg) const
+{
+    return lazy_regs.find(reg) != lazy_regs.end();
+}
+
+bool CPUContext::is_lazy(ir::reg_t reg) const
+{
+    int idx(reg);
+    if (idx < 0 or idx >= nb_regs)
+        return false;
+    return regs[idx / reg_chunk_size]->lazy[idx % reg_chunk_size] != nullptr;
+}
+
+bool CPUContext::is_lazy_op(ir::Op op)
+{
+    switch (op)
+    {
+        case ir::Op::INT_CARRY:
+        case ir::Op::INT_SCARRY:
+        case ir::Op::INT_SBORROW:
+        case ir::Op::INT_EQUAL:
+        case ir::Op::INT_NOTEQUAL:
+        case ir::Op::INT_LESS:
+        case ir::Op::INT_SLESS:
+        case ir::Op::INT_LESSEQUAL:
+        case ir::Op::INT_SLESSEQUAL:
+        case ir::Op::BOOL_NEGATE:
+        case ir::Op::BOOL_AND:
+        case ir::Op::BOOL_OR:
+        case ir::Op::BOOL_XOR:
+            return true;
+        default:
+            return false;
+    }
+}
+
+void CPUContext::_compute_lazy(const lazy_value_t& lazy, Value& res)
+{
+    const Value& in0 = lazy.in0;
+    const Value& in1 = lazy.in1;
+    switch (lazy.op)
+    {
+        case ir::Op::INT_CARRY: res.set_carry(in0, in1, lazy.size); break;
+        case ir::Op::INT_SCARRY: res.set_scarry(in0, in1, lazy.size); break;
+        case ir::Op::INT_SBORROW: res.set_sborrow(in0, in1, lazy.size); break;
+        case ir::Op::INT_EQUAL: res.set_equal_to(in0, in1, lazy.size); break;
+        case ir::Op::INT_NOTEQUAL: res.set_notequal_to(in0, in1, lazy.size); break;
+        case ir::Op::INT_LESS: res.set_less_than(in0, in1, lazy.size); break;
+        case ir::Op::INT_SLESS: res.set_sless_than(in0, in1, lazy.size); break;
+        case ir::Op::INT_LESSEQUAL: res.set_lessequal_than(in0, in1, lazy.size); break;
+        case ir::Op::INT_SLESSEQUAL: res.set_slessequal_than(in0, in1, lazy.size); break;
+        case ir::Op::BOOL_NEGATE: res.set_bool_negate(in0, lazy.size); break;
+        case ir::Op::BOOL_AND: res.set_bool_and(in0, in1, lazy.size); break;
+        case ir::Op::BOOL_OR: res.set_bool_or(in0, in1, lazy.size); break;
+        case ir::Op::BOOL_XOR: res.set_bool_xor(in0, in1, lazy.size); break;
+        default:
+            throw runtime_exception("CPUContext::_compute_lazy(): got unsupported operation");
+    }
+    // Same post-processing as MaatEngine::run() does for results computed eagerly
+    if (res.is_abstract())
+    {
+        if (lazy.vars != nullptr and res.expr()->is_concrete(*lazy.vars))
+            res = res.expr()->as_number(*lazy.vars);
+        else if (lazy.simplifier != nullptr)
+            res = lazy.simplifier->simplify(res.expr());
+    }
+}
+
+bool CPUContext::is_wide(ir::reg_t reg) const
+{
+    return reg_size(reg) > reg_lane_size and not _is_alias(reg);
+}
+
+size_t CPUContext::reg_size(ir::reg_t reg) const
+{
+    int idx(reg);
+    if (idx < 0 or idx >= nb_regs)
+        return 0;
+    // The size of a register never changes, so it is valid
+    // even if the value is stale
+    const Value& val = regs[idx / reg_chunk_size]->values[idx % reg_chunk_size];
+    return val.is_none() ? 0 : val.size();
+}
+
+Value CPUContext::get_bits(ir::reg_t reg, size_t high, size_t low)
+{
+    if (not is_wide(reg))
+    {
+        const Value& val = get(reg);
+        if (low == 0 and high == val.size()-1)
+            return val;
+        return extract(val, high, low);
+    }
+
+    int i = reg % reg_chunk_size;
+    // Splitting lanes modifies the chunk, reading them doesn't
+    if (regs[reg / reg_chunk_size]->lanes[i].empty())
+        _split_lanes(_mutable_chunk(reg), i);
+    const std::vector<Value>& lanes = regs[reg / reg_chunk_size]->lanes[i];
+    Value res;
+    for (int l = high/reg_lane_size; l >= (int)(low/reg_lane_size); l--)
+    {
+        const Value& lane = lanes[l];
+        size_t lane_low = l*reg_lane_size;
+        size_t h = std::min(high, lane_low+lane.size()-1) - lane_low;
+        size_t lo = std::max(low, lane_low) - lane_low;
+        Value bits;
+        if (lo == 0 and h == lane.size()-1)
+            bits = lane;
+        else
+            bits.set_extract(lane, h, lo);
+        if (res.is_none())
+            res = std::move(bits);
+        else
+            res.set_concat(res, bits);
+    }
+    return res;
+}
+
+void CPUContext::set_bits(ir::reg_t reg, size_t high, size_t low, const Value& value)
+{
+    if (value.size() != high-low+1)
+        throw cpu_exception(Fmt()
+            << "Can't assign " << std::dec << value.size() << "-bits value to "
+            << high-low+1 << " bits of register" >> Fmt::to_str
+        );
+    if (not is_wide(reg))
+    {
+        Value res;
+        res.set_overwrite(get(reg), value, low);
+        set(reg, res);
+        return;
+    }
+
+    reg_chunk_t& chunk = _mutable_chunk(reg);
+    int i = reg % reg_chunk_size;
+    _split_lanes(chunk, i);
+    std::vector<Value>& lanes = chunk.lanes[i];
+    for (size_t l = low/reg_lane_size; l <= high/reg_lane_size; l++)
+    {
+        Value& lane = lanes[l];
+        size_t lane_low = l*reg_lane_size;
+        size_t h = std::min(high, lane_low+lane.size()-1);
+        size_t lo = std::max(low, lane_low);
+        Value bits;
+        if (lo == low and h == high)
+            bits = value;
+        else
+            bits.set_extract(value, h-low, lo-low);
+        if (bits.size() == lane.size())
+            lane = std::move(bits);
+        else
+            lane.set_overwrite(lane, bits, lo-lane_low);
+    }
+    chunk.stale[i] = true;
+}
+
 serial::uid_t CPUContext::class_uid() const
 {
     return serial::ClassId::CPU_CONTEXT;
@@ -316,22 +575,33 @@ serial::uid_t CPUContext::class_uid() const
 
 void CPUContext::dump(serial::Serializer& s) const
 {
-    s << regs;
+    std::vector<Value> values;
+    for (int i = 0; i < nb_regs; i++)
+        values.push_back(_reg_value(i));
+    s << values;
 }
 
 void CPUContext::load(serial::Deserializer& d)
 {
+    std::vector<Value> values;
+    d >> values;
+    nb_regs = values.size();
     regs.clear();
-    d >> regs;
+    for (int i = 0; i < nb_regs; i++)
+    {
+        if (i % reg_chunk_size == 0)
+            regs.push_back(std::make_shared<reg_chunk_t>());
+        regs.back()->values[i % reg_chunk_size] = std::move(values[i]);
+    }
 }
 
 std::ostream& operator<<(std::ostream& os, const CPUContext& ctx)
 {
-    for (int i = 0; i < ctx.regs.size(); i++)
+    for (int i = 0; i < ctx.nb_regs; i++)
     {
         if (ctx._is_alias(i))
             continue;
-        os << "REG_" << std::dec << i << ": " << ctx.regs[i] << "\n";
+        os << "REG_" << std::dec << i << ": " << ctx._reg_value(i) << "\n";
     }
     return os;
 }
@@ -343,12 +613,12 @@ void CPUContext::print(std::ostream& os, const Arch& arch)
     {
         if (_is_alias(i))
             continue;
-        os << arch.reg_name(i) << ": " << regs[i] << "\n";
+        os << arch.reg_name(i) << ": " << _reg(i) << "\n";
     }
 }
 
 
-CPU::CPU(int nb_regs): _cpu_ctx(CPUContext(nb_regs))
+CPU::CPU(int nb_regs): _cpu_ctx(CPUContext(nb_regs)), _lazy_res(false)
 {}
 
 Expr CPU::_extract_abstract_if_needed(Expr expr, size_t high_bit, size_t low_bit)
@@ -434,17 +704,29 @@ event::Action CPU::_get_param_value(
             }
         }
         // Get register
-        const Value& res = _cpu_ctx.get(param.reg());
         if (
-            (not get_full_register)
-            and res.size() != param.size()
+            _cpu_ctx.is_wide(param.reg())
+            and _cpu_ctx.reg_size(param.reg()) != param.size()
         )
         {
-            dest = _extract_value_bits(res, param.hb, param.lb);
+            // Access only the lanes holding the bits, even for the output
+            // parameter since set_bits() is used to write them back
+            dest = _cpu_ctx.get_bits(param.reg(), param.hb, param.lb);
         }
         else
         {
-            dest.set_value_by_ref(res);
+            const Value& res = _cpu_ctx.get(param.reg());
+            if (
+                (not get_full_register)
+                and res.size() != param.size()
+            )
+            {
+                dest = _extract_value_bits(res, param.hb, param.lb);
+            }
+            else
+            {
+                dest.set_value_by_ref(res);
+            }
         }
 
         if (trigger_events)
@@ -603,6 +885,7 @@ void CPU::_compute_res_value(
         (not pinst.out.is_none())
         and (not inst.out.is_addr())
         and (not dest.is_none())
+        and pinst.out.value().size() != dest.size()
     )
     {
         dest.set_overwrite(pinst.out.value(), dest, inst.out.lb);
@@ -623,12 +906,33 @@ ProcessedInst& CPU::pre_process_inst(
     event::merge_actions(action, _get_param_value(processed_inst.in0, inst.in[0], engine));
     event::merge_actions(action, _get_param_value(processed_inst.in1, inst.in[1], engine));
     event::merge_actions(action, _get_param_value(processed_inst.in2, inst.in[2], engine));
+
+    // The result can be assigned lazily only if no hook can observe the write.
+    // Whether the operands are symbolic is known only once ADDR parameters are
+    // resolved, in post_process_inst()
+    _lazy_res = inst.out.is_reg()
+        and CPUContext::is_lazy_op(inst.op)
+        and _cpu_ctx.is_lazy_reg(inst.out.reg())
+        and inst.out.size() == _cpu_ctx.reg_size(inst.out.reg())
+        and not get_engine_events(engine).has_hooks(
+            {event::Event::REG_W, event::Event::REG_RW},
+            event::When::BEFORE
+        )
+        and not get_engine_events(engine).has_hooks(
+            {event::Event::REG_W, event::Event::REG_RW},
+            event::When::AFTER
+        );
     return processed_inst;
 }
 
 ProcessedInst& CPU::post_process_inst(const ir::Inst& inst, ProcessedInst& pinst)
 {
-    _compute_res_value(pinst.res, inst, pinst);
+    // Concrete results are cheap to compute, only defer symbolic ones
+    _lazy_res = _lazy_res and (pinst.in0.is_abstract() or pinst.in1.is_abstract());
+    if (_lazy_res)
+        pinst.res.set_none();
+    else
+        _compute_res_value(pinst.res, inst, pinst);
     return pinst;
 }
 
@@ -652,24 +956,44 @@ event::Action CPU::apply_semantics(
         and (not inst.out.is_addr())
     )
     {
-        if (inst.out.is_reg())
+        if (inst.out.is_reg() and _lazy_res)
         {
+            _cpu_ctx.set_lazy(
+                inst.out.reg(),
+                inst.op,
+                pinst.in0.value(),
+                pinst.in1.is_none() ? Value() : pinst.in1.value(),
+                engine.vars,
+                engine.settings.force_simplify ? engine.simplifier : nullptr
+            );
+        }
+        else if (inst.out.is_reg())
+        {
+            // Result holds only the bits written for wide registers
+            bool write_bits = _cpu_ctx.is_wide(inst.out.reg())
+                and pinst.res.size() != _cpu_ctx.reg_size(inst.out.reg());
             // TODO: handle errors ??? How ??
             if (get_engine_events(engine).has_hooks(
                 {event::Event::REG_W, event::Event::REG_RW},
                 event::When::BEFORE
             ))
             {
+                Value new_value;
+                if (write_bits)
+                    new_value.set_overwrite(_cpu_ctx.get(inst.out.reg()), pinst.res, inst.out.lb);
                 CPU_HANDLE_EVENT_ACTION(
                     get_engine_events(engine).before_reg_write(
                         engine,
                         inst.out.reg(),
-                        pinst.res
+                        write_bits ? new_value : pinst.res
                     ),
                     action
                 )
             }
-            _cpu_ctx.set(inst.out.reg(), pinst.res);
+            if (write_bits)
+                _cpu_ctx.set_bits(inst.out.reg(), inst.out.hb, inst.out.lb, pinst.res);
+            else
+                _cpu_ctx.set(inst.out.reg(), pinst.res);
             if (get_engine_events(engine).has_hooks(
                 {event::Event::REG_W, event::Event::REG_RW},
                 event::When::AFTER
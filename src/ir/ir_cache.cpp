@@ -1,4 +1,5 @@
 #include "maat/ir.hpp"
+#include <mutex>
 
 namespace maat{
 namespace ir{
@@ -6,12 +7,17 @@ namespace ir{
 namespace cache{
 
 std::unordered_map<int, IRMap> ir_cache;
+// Engines can run in different threads
+std::mutex ir_cache_mutex;
 
 } // namespace cache
 
 
 IRMap& get_ir_map(int mem_engine_uid)
 {
+    // References to elements stay valid when inserting new maps, so
+    // the lock is only needed for the lookup
+    std::lock_guard<std::mutex> lock(cache::ir_cache_mutex);
     auto it = cache::ir_cache.find(mem_engine_uid);
     if (it == cache::ir_cache.end())
     {
@@ -2,10 +2,17 @@
 #include "maat/exception.hpp"
 #include "maat/stats.hpp"
 #include "maat/varcontext.hpp"
+#include <algorithm>
 #include <cassert>
 #include <iostream>
 #include <sstream>
 #include <cstring>
+#include <sys/mman.h>
+#include <unistd.h>
+#if defined(__GNUC__) && (defined(__x86_64__) || defined(__i386__))
+#include <immintrin.h>
+#define MAAT_HAS_AVX2_SCAN
+#endif
 
 namespace maat
 {
@@ -26,7 +33,7 @@ bool PageSet::intersects_with_range(addr_t min, addr_t max) const
     return start <= max && end >= min;
 }
 
-bool PageSet::contains(addr_t addr)
+bool PageSet::contains(addr_t addr) const
 {
     return start <= addr && end >= addr;
 }
@@ -50,7 +57,9 @@ void PageSet::load(serial::Deserializer& d)
 MemPageManager::MemPageManager(size_t ps): _page_size(ps)
 {
     // Add one big region with no permissions
-    _regions.push_back(PageSet(0x0, 0xffffffffffffffff, 0x0));
+    _regions = std::make_shared<const std::list<PageSet>>(
+        std::list<PageSet>{PageSet(0x0, 0xffffffffffffffff, 0x0)}
+    );
 }
 
 size_t MemPageManager::page_size()
@@ -61,7 +70,7 @@ size_t MemPageManager::page_size()
 
 bool MemPageManager::is_mapped(addr_t start, addr_t end)
 {
-    for (const auto& r : _regions)
+    for (const auto& r : *_regions)
     {
         if (r.intersects_with_range(start, end) and r.flags == mem_flag_none)
             return false;
@@ -71,7 +80,7 @@ bool MemPageManager::is_mapped(addr_t start, addr_t end)
 
 bool MemPageManager::is_unmapped(addr_t start, addr_t end)
 {
-    for (const auto& r : _regions)
+    for (const auto& r : *_regions)
     {
         if (r.intersects_with_range(start, end) and r.flags != mem_flag_none)
             return false;
@@ -96,7 +105,7 @@ void MemPageManager::set_flags(addr_t start, addr_t end, mem_flag_t flags)
         end--;
     }
 
-    for( auto& r : _regions)
+    for( PageSet r : *_regions)
     {
         if( r.intersects_with_range(start, end))
         {
@@ -139,19 +148,19 @@ void MemPageManager::set_flags(addr_t start, addr_t end, mem_flag_t flags)
             new_regions.push_back(r);
         }
     }
-    _regions = new_regions;
-    merge_regions(); // Merge contiguous regions with same permissions
+    merge_regions(new_regions); // Merge contiguous regions with same permissions
+    _regions = std::make_shared<const std::list<PageSet>>(std::move(new_regions));
 }
 
-void MemPageManager::merge_regions()
+void MemPageManager::merge_regions(std::list<PageSet>& regions)
 {
     addr_t prev_start = 0;
-    mem_flag_t prev_flags = _regions.front().flags;
-    std::list<PageSet>::iterator it = _regions.begin();
+    mem_flag_t prev_flags = regions.front().flags;
+    std::list<PageSet>::iterator it = regions.begin();
     std::list<PageSet> res;
     int i = 1;
     std::advance(it, 1);
-    for( ; it != _regions.end(); it++)
+    for( ; it != regions.end(); it++)
     {
         if( it->flags != prev_flags )
         {
@@ -160,18 +169,18 @@ void MemPageManager::merge_regions()
             prev_flags = it->flags;
         }
         i++;
-        if( i == _regions.size() )
+        if( i == regions.size() )
         {
             // We reached last region, add it
             res.push_back(PageSet(prev_start, it->end, it->flags));
         }
     }
-    _regions = res;
+    regions = std::move(res);
 }
 
 mem_flag_t MemPageManager::get_flags(addr_t addr)
 {
-    for (PageSet& r : _regions)
+    for (const PageSet& r : *_regions)
     {
         if (r.contains(addr))
         {
@@ -186,7 +195,7 @@ bool MemPageManager::has_flags(addr_t addr, mem_flag_t flags){
 }
 
 bool MemPageManager::was_once_executable(addr_t addr){
-    for( PageSet& r : _regions )
+    for( const PageSet& r : *_regions )
     {
         if( r.contains(addr))
             return r.was_once_executable;
@@ -195,11 +204,16 @@ bool MemPageManager::was_once_executable(addr_t addr){
 }
 
 const std::list<PageSet>& MemPageManager::regions()
+{
+    return *_regions;
+}
+
+std::shared_ptr<const std::list<PageSet>> MemPageManager::shared_regions() const
 {
     return _regions;
 }
 
-void MemPageManager::set_regions(std::list<PageSet>&& regions)
+void MemPageManager::set_regions(std::shared_ptr<const std::list<PageSet>> regions)
 {
     _regions = regions;
 }
@@ -211,13 +225,14 @@ uid_t MemPageManager::class_uid() const
 
 void MemPageManager::dump(serial::Serializer& s) const
 {
-    s << bits(_page_size) << _regions;
+    s << bits(_page_size) << *_regions;
 }
 
 void MemPageManager::load(serial::Deserializer& d)
 {
-    _regions.clear();
-    d >> bits(_page_size) >> _regions;
+    std::list<PageSet> regions;
+    d >> bits(_page_size) >> regions;
+    _regions = std::make_shared<const std::list<PageSet>>(std::move(regions));
 }
 
 std::string _mem_flags_to_string(mem_flag_t flags)
@@ -249,7 +264,7 @@ std::ostream& operator<<(std::ostream& os, MemPageManager& mem)
     os << std::left << std::setw(addr_w) << "-----" << std::left << std::setw(addr_w) << "---" 
        << std::left << std::setw(8) << "-----" << std::endl;
     
-    for( PageSet& r : mem._regions )
+    for( const PageSet& r : *mem._regions )
     {
         if (r.flags != maat::mem_flag_none)
         {
@@ -262,116 +277,201 @@ std::ostream& operator<<(std::ostream& os, MemPageManager& mem)
     return os;
 }
 
-MemStatusBitmap::MemStatusBitmap():_bitmap(nullptr), _size(0){}
-
-MemStatusBitmap::MemStatusBitmap(const MemStatusBitmap& other)
-:_size(other._size)
+/* Make room for 'nb_before' bytes before and 'nb_after' bytes after the
+ * 'size' bytes of data starting at 'buf+headroom' in the zero-initialized
+ * buffer 'buf' of 'capacity' bytes. If there is not enough free space, the
+ * buffer is reallocated with free space as big as the new data on the side
+ * that is extended, so that repeated extensions on the same side take
+ * amortized O(nb_bytes) time. Free space is always zero */
+static void _reserve_buffer(
+    uint8_t*& buf,
+    offset_t& headroom,
+    offset_t& capacity,
+    offset_t size,
+    offset_t nb_before,
+    offset_t nb_after,
+    const char* caller
+)
 {
+    offset_t tailroom = capacity - headroom - size;
+    if (nb_before <= headroom and nb_after <= tailroom)
+        return;
+
+    offset_t new_headroom = nb_before <= headroom ? headroom : size + nb_before*2;
+    offset_t new_tailroom = nb_after <= tailroom ? tailroom : size + nb_after*2;
+    offset_t new_capacity = new_headroom + size + new_tailroom;
+    uint8_t* new_buf;
     try
     {
-        _bitmap = new uint8_t[_size]{0};
-        memcpy(_bitmap, other._bitmap, _size);
+        new_buf = new uint8_t[new_capacity]{0};
     }
-    catch(std::bad_alloc)
+    catch(const std::bad_alloc&)
     {
         throw mem_exception(Fmt()
-            << "Failed to copy MemStatusBitmap of size " << _size
+            << caller << ": Failed to allocate buffer of size " << new_capacity
             >> Fmt::to_str );
     }
+    if (buf != nullptr)
+    {
+        memcpy(new_buf + new_headroom, buf + headroom, size);
+        delete [] buf;
+    }
+    buf = new_buf;
+    headroom = new_headroom;
+    capacity = new_capacity;
 }
 
-MemStatusBitmap::MemStatusBitmap(offset_t nb_bytes)
+/* Return the index of the first byte of 'buf' different from 'val', or
+ * 'len' if all bytes are equal to 'val'. The buffer is compared 8 bytes at
+ * a time, and 32 bytes at a time if the CPU supports AVX2 */
+static offset_t _scalar_find_not_byte(const uint8_t* buf, offset_t len, uint8_t val)
 {
-    // +1 to be sure to not loose bytes if nb_bytes is
-    // not a multiple of 8 
-    // {0} to initialize everything to concrete by default
-    try
+    uint64_t pattern = 0x0101010101010101ULL * val;
+    uint64_t word;
+    offset_t i = 0;
+    for (; i + 8 <= len; i += 8)
     {
-        _size = (nb_bytes/8) + 1;
-        _bitmap = new uint8_t[_size]{0};
+        memcpy(&word, buf+i, 8);
+        if (word != pattern)
+            break;
     }
-    catch(std::bad_alloc)
+    // Find the byte in the last word
+    for (; i < len; i++)
     {
-        throw mem_exception(Fmt()
-            << "Failed to allocate MemStatusBitmap of size " << nb_bytes
-            >> Fmt::to_str );
+        if (buf[i] != val)
+            return i;
     }
+    return len;
 }
 
-void MemStatusBitmap::extend_after(addr_t nb_bytes)
+#ifdef MAAT_HAS_AVX2_SCAN
+__attribute__((target("avx2")))
+static offset_t _avx2_find_not_byte(const uint8_t* buf, offset_t len, uint8_t val)
+{
+    const __m256i pattern = _mm256_set1_epi8((char)val);
+    offset_t i = 0;
+    for (; i + 32 <= len; i += 32)
+    {
+        __m256i chunk = _mm256_loadu_si256((const __m256i*)(buf+i));
+        uint32_t eq = (uint32_t)_mm256_movemask_epi8(_mm256_cmpeq_epi8(chunk, pattern));
+        if (eq != 0xffffffff)
+            return i + __builtin_ctz(~eq);
+    }
+    return i + _scalar_find_not_byte(buf+i, len-i, val);
+}
+#endif
+
+static offset_t _find_not_byte(const uint8_t* buf, offset_t len, uint8_t val)
+{
+#ifdef MAAT_HAS_AVX2_SCAN
+    static const bool has_avx2 = __builtin_cpu_supports("avx2");
+    // Short scans are more common and don't benefit from AVX2
+    if (has_avx2 and len >= 64)
+        return _avx2_find_not_byte(buf, len, val);
+#endif
+    return _scalar_find_not_byte(buf, len, val);
+}
+
+MemStatusBitmap::MemStatusBitmap():
+    _bitmap(nullptr), _size(0), _buf(nullptr), _headroom(0), _capacity(0), _first_bit(0)
+{}
+
+MemStatusBitmap::MemStatusBitmap(const MemStatusBitmap& other)
+:_size(other._size), _headroom(0), _capacity(other._size), _first_bit(other._first_bit)
 {
-    uint8_t* new_bitmap;
-    addr_t new_size = _size + (nb_bytes/8)+1;
     try
     {
-        new_bitmap = new uint8_t[new_size]{0};
+        _buf = new uint8_t[_size]{0};
+        memcpy(_buf, other._bitmap, _size);
+        _bitmap = _buf;
     }
     catch(std::bad_alloc)
     {
         throw mem_exception(Fmt()
-            << "MemStatusBitmap::extend_after(): Failed to allocate MemStatusBitmap of size " 
-            << new_size 
+            << "Failed to copy MemStatusBitmap of size " << _size
             >> Fmt::to_str );
     }
-    memcpy(new_bitmap, _bitmap, _size);
-    delete [] _bitmap;
-    _bitmap = new_bitmap;
-    _size = new_size;
 }
 
-void MemStatusBitmap::extend_before(addr_t nb_bytes)
+MemStatusBitmap::MemStatusBitmap(offset_t nb_bytes): _headroom(0), _first_bit(0)
 {
-    uint8_t* new_bitmap, *ptr;
-    int i = 0;
-    uint8_t rshift, lshift;
-
-    addr_t new_size = _size + (nb_bytes/8)+1;
+    // +1 to be sure to not loose bytes if nb_bytes is
+    // not a multiple of 8 
+    // {0} to initialize everything to concrete by default
     try
     {
-        new_bitmap = new uint8_t[new_size]{0};
+        _size = (nb_bytes/8) + 1;
+        _capacity = _size;
+        _buf = new uint8_t[_size]{0};
+        _bitmap = _buf;
     }
     catch(std::bad_alloc)
     {
         throw mem_exception(Fmt()
-            << "MemStatusBitmap::extend_after(): Failed to allocate MemStatusBitmap of size " 
-            << new_size
-            >> Fmt::to_str
-        );
+            << "Failed to allocate MemStatusBitmap of size " << nb_bytes
+            >> Fmt::to_str );
     }
+}
 
-    if (nb_bytes % 8 == 0)
-    {
-        memcpy(new_bitmap+(nb_bytes/8), _bitmap, _size);
-    }
-    else
+void MemStatusBitmap::extend_after(addr_t nb_bytes)
+{
+    addr_t added = (nb_bytes/8)+1;
+    _reserve_buffer(_buf, _headroom, _capacity, _size, 0, added, "MemStatusBitmap::extend_after()");
+    _bitmap = _buf + _headroom;
+    _size += added;
+}
+
+void MemStatusBitmap::extend_before(addr_t nb_bytes)
+{
+    // The bits before '_first_bit' are free and always zero
+    if (nb_bytes <= _first_bit)
     {
-        /* Copy the bitmap and shift the bytes if nb_bytes is 
-         * not a multiple of 8 */
-        lshift = nb_bytes % 8;
-        rshift = 8 - lshift;
-        ptr = new_bitmap + (nb_bytes/8); // Pointer to the first byte to fill
-        for( i = 0; i < _size; i++){
-            if( i != 0 ){
-                ptr[i] |= (_bitmap[i-1] >> rshift);
-            }
-            ptr[i] |= (_bitmap[i] << lshift);
-        }
+        _first_bit -= nb_bytes;
+        return;
     }
+    addr_t missing = nb_bytes - _first_bit;
+    addr_t added = (missing+7)/8;
+    _reserve_buffer(_buf, _headroom, _capacity, _size, added, 0, "MemStatusBitmap::extend_before()");
+    _headroom -= added;
+    _bitmap = _buf + _headroom;
+    _size += added;
+    _first_bit = added*8 - missing;
+}
 
-    delete [] _bitmap;
-    _bitmap = new_bitmap;
+void MemStatusBitmap::truncate(offset_t nb_bytes)
+{
+    offset_t first_removed = _first_bit + nb_bytes;
+    offset_t new_size = (first_removed/8) + 1;
+    // Clear the removed bits so that free space stays zero
+    _bitmap[first_removed/8] &= (uint8_t)~(0xff << (first_removed%8));
+    memset(_bitmap+new_size, 0, _size-new_size);
     _size = new_size;
 }
 
+void MemStatusBitmap::shrink_before(offset_t nb_bytes)
+{
+    if (nb_bytes == 0)
+        return;
+    // Clear the removed bits so that free space stays zero
+    mark_as_concrete(0, nb_bytes-1);
+    offset_t first_kept = _first_bit + nb_bytes;
+    _headroom += first_kept/8;
+    _bitmap += first_kept/8;
+    _size -= first_kept/8;
+    _first_bit = first_kept%8;
+}
+
 MemStatusBitmap::~MemStatusBitmap()
 {
-    if( _bitmap != nullptr )
-        delete [] _bitmap;
+    if( _buf != nullptr )
+        delete [] _buf;
+    _buf = nullptr;
     _bitmap = nullptr;
 }
 
 void MemStatusBitmap::mark_as_abstract(offset_t off)
 {
+    off += _first_bit;
     offset_t qword = off/8;
     uint8_t mask = 1 << (off%8);
     _bitmap[qword] |= mask;
@@ -379,6 +479,8 @@ void MemStatusBitmap::mark_as_abstract(offset_t off)
 
 void MemStatusBitmap::mark_as_abstract(offset_t start, offset_t end)
 {
+    start += _first_bit;
+    end += _first_bit;
     offset_t qword = start/8, last_qword=end/8;
     uint8_t final_mask = 0xff >> (8-1-(end%8));
     uint8_t first_mask = (0xff << (start%8));
@@ -387,14 +489,13 @@ void MemStatusBitmap::mark_as_abstract(offset_t start, offset_t end)
         return;
     }
     _bitmap[qword++] |= first_mask;
-    while( qword < last_qword ){
-        _bitmap[qword++] = 0xff;
-    }
+    memset(_bitmap+qword, 0xff, last_qword-qword);
     _bitmap[last_qword] |= final_mask;
 }
 
 void MemStatusBitmap::mark_as_concrete(offset_t off)
 {
+    off += _first_bit;
     offset_t qword = off/8;
     uint8_t mask = ~(1 << (off%8));
     _bitmap[qword] &= mask;
@@ -402,6 +503,8 @@ void MemStatusBitmap::mark_as_concrete(offset_t off)
 
 void MemStatusBitmap::mark_as_concrete(offset_t start, offset_t end)
 {
+    start += _first_bit;
+    end += _first_bit;
     offset_t qword = start/8, last_qword=end/8;
     uint8_t first_mask = 0xff >> (8-(start%8));
     uint8_t final_mask = (0xfe << (end%8));
@@ -411,15 +514,13 @@ void MemStatusBitmap::mark_as_concrete(offset_t start, offset_t end)
         return;
     }
     _bitmap[qword++] &= first_mask;
-    while( qword < last_qword )
-    {
-        _bitmap[qword++] = 0x0;
-    }
+    memset(_bitmap+qword, 0x0, last_qword-qword);
     _bitmap[last_qword] &= final_mask;
 }
 
 bool MemStatusBitmap::is_abstract(offset_t off)
 {
+    off += _first_bit;
     offset_t qword = off/8;
     uint8_t mask = 1 << (off%8);
     return _bitmap[qword] & mask;
@@ -427,86 +528,56 @@ bool MemStatusBitmap::is_abstract(offset_t off)
 
 bool MemStatusBitmap::is_concrete(offset_t off)
 {
+    off += _first_bit;
     offset_t qword = off/8;
     uint8_t mask = 1 << (off%8);
     return _bitmap[qword] ^ mask;
 }
 
-/* Return the offset of the first byte that is not abstract */
-offset_t MemStatusBitmap::is_abstract_until(offset_t off , offset_t max)
+/* Return the offset of the first byte, starting from 'off', whose status
+ * bit is not equal to the bits of 'fill'. At least 'max' bytes are checked, 
+ * but whole bitmap bytes are checked so the result can be bigger than 
+ * off+max. If the end of the bitmap is reached, the offset of the first byte
+ * after the bitmap is returned. Offsets are bit indexes in the bitmap, which
+ * are memory offsets plus '_first_bit' */
+offset_t MemStatusBitmap::_scan_until(offset_t off, offset_t max, uint8_t fill)
 {
     offset_t qword = off/8;
-    offset_t max_qword = ((max+off-1)/8)+1;
-    offset_t res = off;
+    offset_t max_qword;
     uint8_t m;
-    // Test the 8 first bytes
-    m = (uint8_t)1 << (off%8);
-    while( m != 0)
-    {
-        if( (_bitmap[qword] & m) == 0 )
-            return res; 
-        res += 1; 
-        m = m << 1; 
-    }
+
+    if (qword >= _size)
+        return off;
+    // Test the first bytes
+    m = (_bitmap[qword] ^ fill) & (uint8_t)(0xff << (off%8));
+    if (m != 0)
+        return qword*8 + __builtin_ctz(m);
     qword++; // Continue from next qword
 
     // Test 8 bytes per 8 bytes
-    while( qword < _size && qword < max_qword && _bitmap[qword] == 0xff)
-    {
-        res += 8;
-        qword++;
-    }
-    // If we reached the end or the max to read return it 
-    if( qword == _size)
-        return res + 7;
-    else if( qword == max_qword )
-        return res;
-    // Else test the 7 last ones one by one
-    m = 1; 
-    while( (m != 0) && ((_bitmap[qword] & m) != 0))
-    {
-        m = m << 1; 
-        res++;
-    }
-    return res;
+    max_qword = (max == 0) ? qword : ((off+max-1)/8)+1;
+    if (max_qword > _size)
+        max_qword = _size;
+    if (qword >= max_qword)
+        return qword*8;
+    qword += _find_not_byte(_bitmap+qword, max_qword-qword, fill);
+    // If we reached the end or the max to read return it
+    if (qword == max_qword)
+        return qword*8;
+    // Else find the first byte with another status
+    return qword*8 + __builtin_ctz((uint8_t)(_bitmap[qword] ^ fill));
 }
 
+/* Return the offset of the first byte that is not abstract */
+offset_t MemStatusBitmap::is_abstract_until(offset_t off , offset_t max)
+{
+    return _scan_until(off+_first_bit, max, 0xff) - _first_bit;
+}
+
+/* Return the offset of the first byte that is not concrete */
 offset_t MemStatusBitmap::is_concrete_until(offset_t off, offset_t max )
 {
-    offset_t qword = off/8;
-    offset_t max_qword = ((off+max-1)/8)+1;
-    offset_t res = off;
-    uint8_t m;
-    // Test the 8 first bytes
-    m = (uint8_t)1 << (off%8);
-    while( m != 0)
-    {
-        if( (_bitmap[qword] & m ) != 0 )
-            return res;
-        res += 1; 
-        m = m << 1; 
-    }
-    qword++; // Continue from next qword
-    
-    // Test 8 bytes per 8 bytes
-    while( qword < _size && qword < max_qword && _bitmap[qword] == 0x0)
-    {
-        res += 8;
-        qword++;
-    }
-    // If we reached the end return it
-    if( qword == _size )
-        return res + 7; 
-    else if( qword == max_qword )
-        return res;
-    // Else test the 7 last ones one by one
-    m = 1; 
-    while( (m != 0) && ((_bitmap[qword] & m) == 0))
-    {
-        m = m << 1;
-        res++;
-    }
-    return res;
+    return _scan_until(off+_first_bit, max, 0x0) - _first_bit;
 }
 
 uid_t MemStatusBitmap::class_uid() const
@@ -516,119 +587,214 @@ uid_t MemStatusBitmap::class_uid() const
 
 void MemStatusBitmap::dump(Serializer& s) const
 {
-    s << bits(_size);
+    s << bits(_size) << bits(_first_bit);
     s << serial::buffer((char*)_bitmap, _size);
 }
 
 void MemStatusBitmap::load(Deserializer& d)
 {
-    if (_bitmap != nullptr)
-        delete [] _bitmap;
+    if (_buf != nullptr)
+        delete [] _buf;
 
-    d >> bits(_size);
-    _bitmap = new uint8_t[_size];
+    d >> bits(_size) >> bits(_first_bit);
+    _buf = new uint8_t[_size];
+    _bitmap = _buf;
+    _headroom = 0;
+    _capacity = _size;
     d >> serial::buffer((char*)_bitmap, _size);
 }
 
+static offset_t _page_size()
+{
+    static const offset_t page_size = sysconf(_SC_PAGESIZE);
+    return page_size;
+}
+
+static offset_t _page_align_down(offset_t off)
+{
+    return off & ~(_page_size()-1);
+}
+
+static offset_t _page_align_up(offset_t off)
+{
+    return _page_align_down(off + _page_size() - 1);
+}
+
 MemConcreteBuffer::MemConcreteBuffer(Endian endian)
-:_mem(nullptr), _endianness(endian){}
+:_size(0), _mem(nullptr), _buf(nullptr), _headroom(0), _capacity(0),
+_committed_start(0), _committed_end(0), _endianness(endian){}
 
 MemConcreteBuffer::MemConcreteBuffer(const MemConcreteBuffer& other)
-:_endianness(other._endianness), _size(other._size)
+:_size(0), _mem(nullptr), _buf(nullptr), _headroom(0), _capacity(0),
+_committed_start(0), _committed_end(0), _endianness(other._endianness)
 {
-    try
-    {
-        _mem = new uint8_t[_size]{0};
+    _allocate(other._size, reserved_growth, "MemConcreteBuffer::MemConcreteBuffer()");
+    if (_size > 0)
         memcpy(_mem, other._mem, _size);
-    }
-    catch(const std::bad_alloc&)
-    {
-        throw mem_exception(Fmt()
-            << "Failed to copy MemConcreteBuffer of size " << _size
-            >> Fmt::to_str );
-    }
 }
 
 MemConcreteBuffer::MemConcreteBuffer(offset_t nb_bytes, Endian endian)
-:_endianness(endian)
+:_size(0), _mem(nullptr), _buf(nullptr), _headroom(0), _capacity(0),
+_committed_start(0), _committed_end(0), _endianness(endian)
 {
-    try
+    _allocate(nb_bytes, reserved_growth, "MemConcreteBuffer::MemConcreteBuffer()");
+}
+
+MemConcreteBuffer::~MemConcreteBuffer()
+{
+    _release();
+}
+
+/* Reserve address space for 'nb_bytes' bytes of content with 'nb_before' and
+ * 'nb_after' free bytes around it, and commit the pages of the content. The
+ * other pages can't be accessed until they are committed. Return false if
+ * the memory can't be allocated */
+bool MemConcreteBuffer::_reserve(offset_t nb_before, offset_t nb_bytes, offset_t nb_after)
+{
+    offset_t headroom = _page_align_up(nb_before);
+    offset_t content = _page_align_up(std::max<offset_t>(nb_bytes, 1));
+    offset_t capacity = headroom + content + _page_align_up(nb_after);
+    void* buf = mmap(nullptr, capacity, PROT_NONE, MAP_PRIVATE | MAP_ANONYMOUS | MAP_NORESERVE, -1, 0);
+    if (buf == MAP_FAILED)
+        return false;
+    if (mprotect((uint8_t*)buf + headroom, content, PROT_READ | PROT_WRITE) != 0)
     {
-        _size = nb_bytes;
-        _mem = new uint8_t[nb_bytes]{0};
+        munmap(buf, capacity);
+        return false;
     }
-    catch(const std::bad_alloc&)
+    _buf = (uint8_t*)buf;
+    _capacity = capacity;
+    _headroom = headroom;
+    _mem = _buf + _headroom;
+    _committed_start = headroom;
+    _committed_end = headroom + content;
+    return true;
+}
+
+/* Allocate 'nb_bytes' zero bytes with 'room' free bytes before and after
+ * them, or without free space if the address space can't be reserved */
+void MemConcreteBuffer::_allocate(offset_t nb_bytes, offset_t room, const char* caller)
+{
+    if (not _reserve(room, nb_bytes, room) and not _reserve(0, nb_bytes, 0))
     {
         throw mem_exception(Fmt()
-            << "Failed to allocate MemConcreteBuffer of size " << nb_bytes
+            << caller << ": Failed to allocate buffer of size " << nb_bytes
             >> Fmt::to_str );
     }
+    _size = nb_bytes;
 }
 
-MemConcreteBuffer::~MemConcreteBuffer()
+/* Move the content to a new range with room for 'nb_before' more bytes
+ * before it and 'nb_after' more bytes after it. The side that grows gets
+ * at least as much free space as the new content, so that relocations
+ * are amortized */
+void MemConcreteBuffer::_relocate(offset_t nb_before, offset_t nb_after, const char* caller)
 {
-    if( _mem != nullptr )
-        delete [] _mem;
-    _mem = nullptr;
-}
+    uint8_t* old_buf = _buf;
+    uint8_t* old_mem = _mem;
+    offset_t old_capacity = _capacity;
+    offset_t room = std::max(reserved_growth, _size + nb_before + nb_after);
+    offset_t before = nb_before > 0 ? nb_before + room : free_before();
+    offset_t after = nb_after > 0 ? nb_after + room : free_after();
 
-void MemConcreteBuffer::extend_after(addr_t nb_bytes)
-{
-    uint8_t* new_mem;
-    addr_t new_size = _size + nb_bytes;
-    try
-    {
-        new_mem = new uint8_t[new_size]{0};
-    }
-    catch(std::bad_alloc)
+    if (
+        not _reserve(before, _size, after)
+        and not _reserve(nb_before, _size, nb_after)
+    )
     {
         throw mem_exception(Fmt()
-            << "MemConcreteBuffer::extend_after(): Failed to allocate MemConcreteBuffer of size " 
-            << new_size
+            << caller << ": Failed to allocate buffer of size "
+            << _size + nb_before + nb_after
             >> Fmt::to_str );
     }
-    memcpy(new_mem, _mem, _size);
-    delete [] _mem;
-    _mem = new_mem;
-    _size = new_size;
+    if (old_buf != nullptr)
+    {
+        memcpy(_mem, old_mem, _size);
+        munmap(old_buf, old_capacity);
+    }
 }
 
-void MemConcreteBuffer::extend_before(addr_t nb_bytes)
+/* Commit the pages holding bytes 'start' to 'end' (excluded) of the
+ * reserved range. Committed pages are contiguous and hold the content,
+ * and their bytes outside of the content are always zero */
+void MemConcreteBuffer::_commit(offset_t start, offset_t end, const char* caller)
 {
-    uint8_t* new_mem;
-    addr_t new_size = _size + nb_bytes;
-    try
+    start = _page_align_down(start);
+    end = _page_align_up(end);
+    if (start < _committed_start)
     {
-        new_mem = new uint8_t[new_size]{0};
+        if (mprotect(_buf + start, _committed_start - start, PROT_READ | PROT_WRITE) != 0)
+            throw mem_exception(Fmt() << caller << ": Failed to commit memory" >> Fmt::to_str);
+        _committed_start = start;
     }
-    catch(std::bad_alloc)
+    if (end > _committed_end)
     {
-        throw mem_exception(Fmt()
-            << "MemConcreteBuffer::extend_before(): Failed to allocate MemConcreteBuffer of size " 
-            << new_size
-            >> Fmt::to_str );
+        if (mprotect(_buf + _committed_end, end - _committed_end, PROT_READ | PROT_WRITE) != 0)
+            throw mem_exception(Fmt() << caller << ": Failed to commit memory" >> Fmt::to_str);
+        _committed_end = end;
     }
-    memcpy(new_mem + nb_bytes, _mem, _size);
-    delete [] _mem;
-    _mem = new_mem;
-    _size = new_size;
+}
+
+void MemConcreteBuffer::_release()
+{
+    if (_buf != nullptr)
+        munmap(_buf, _capacity);
+    _buf = nullptr;
+    _mem = nullptr;
+}
+
+void MemConcreteBuffer::extend_after(addr_t nb_bytes)
+{
+    if (nb_bytes > free_after())
+        _relocate(0, nb_bytes, "MemConcreteBuffer::extend_after()");
+    _commit(_headroom + _size, _headroom + _size + nb_bytes, "MemConcreteBuffer::extend_after()");
+    _size += nb_bytes;
+}
+
+void MemConcreteBuffer::extend_before(addr_t nb_bytes)
+{
+    if (nb_bytes > free_before())
+        _relocate(nb_bytes, 0, "MemConcreteBuffer::extend_before()");
+    _commit(_headroom - nb_bytes, _headroom, "MemConcreteBuffer::extend_before()");
+    _headroom -= nb_bytes;
+    _mem = _buf + _headroom;
+    _size += nb_bytes;
+}
+
+void MemConcreteBuffer::shrink_after(offset_t nb_bytes)
+{
+    // Pages stay committed so that pointers to them remain valid
+    _size -= nb_bytes;
+    memset(_mem + _size, 0, nb_bytes);
+}
+
+void MemConcreteBuffer::shrink_before(offset_t nb_bytes)
+{
+    // Pages stay committed so that pointers to them remain valid
+    memset(_mem, 0, nb_bytes);
+    _headroom += nb_bytes;
+    _mem = _buf + _headroom;
+    _size -= nb_bytes;
+}
+
+offset_t MemConcreteBuffer::free_before() const
+{
+    return _headroom;
+}
+
+offset_t MemConcreteBuffer::free_after() const
+{
+    return _capacity - _headroom - _size;
 }
 
 // Return the first offset where the byte is different than 'val'
 offset_t MemConcreteBuffer::is_identical_until(offset_t start, offset_t end, uint8_t val)
 {
-    offset_t tmp = start;
-
-    if (start == end)
+    if (end > _size)
+        end = _size;
+    if (start >= end)
         return start;
-
-    while( *(uint8_t*)((uint8_t*)_mem+(tmp)) == val)
-    {
-        tmp++;
-        if (tmp >= end)
-            break;
-    };
-    return tmp;
+    return start + _find_not_byte(_mem+start, end-start, val);
 }
 
 uint64_t MemConcreteBuffer::read(offset_t off, int nb_bytes)
@@ -765,11 +931,10 @@ void MemConcreteBuffer::dump(Serializer& s) const
 
 void MemConcreteBuffer::load(Deserializer& d)
 {
-    if (_mem != nullptr)
-        delete [] _mem;
-
-    d >> bits(_size);
-    _mem = new uint8_t[_size];
+    unsigned int size;
+    _release();
+    d >> bits(size);
+    _allocate(size, reserved_growth, "MemConcreteBuffer::load()");
     d >> serial::buffer((char*)_mem, _size);
     d >> bits(_endianness);
 }
@@ -793,7 +958,7 @@ expressions stored in memory, the class automatically concatenates/extracts
 the corresponding parts.
 */
 
-MemAbstractBuffer::MemAbstractBuffer(Endian endian):_endianness(endian){}
+MemAbstractBuffer::MemAbstractBuffer(Endian endian):_origin(0), _endianness(endian){}
 
 
 Expr MemAbstractBuffer::_read_little_endian(offset_t off, unsigned int nb_bytes)
@@ -945,6 +1110,7 @@ Expr MemAbstractBuffer::_read_big_endian(offset_t off, unsigned int nb_bytes)
 
 Expr MemAbstractBuffer::read(offset_t off, unsigned int nb_bytes)
 {
+    off += _origin;
     if (_endianness == Endian::LITTLE)
         return _read_little_endian(off, nb_bytes);
     else
@@ -956,6 +1122,7 @@ void MemAbstractBuffer::_read_optimised_buffer(std::vector<Value>& res, offset_t
     if (_endianness != Endian::BIG)
         throw mem_exception("MemAbstractBuffer::_read_optimised_buffer(): only implemented for big endian");
 
+    off += _origin;
     int i = 0;
     int off_byte, low_byte; 
     Expr tmp=nullptr;
@@ -1012,6 +1179,7 @@ void MemAbstractBuffer::_read_optimised_buffer(std::vector<Value>& res, offset_t
 
 void MemAbstractBuffer::write(offset_t off, Expr e)
 {
+    off += _origin;
     for( offset_t i = 0; i < (e->size/8); i++ )
     {
         if (_endianness == Endian::LITTLE)
@@ -1028,7 +1196,7 @@ uid_t MemAbstractBuffer::class_uid() const
 
 void MemAbstractBuffer::dump(Serializer& s) const
 {
-    s << bits(_endianness);
+    s << bits(_endianness) << bits(_origin);
     s << bits(_mem.size());
     for (auto const& [key, val]: _mem)
     {
@@ -1044,7 +1212,7 @@ void MemAbstractBuffer::load(Deserializer& d)
     offset_t off;
     uint8_t byte;
     Expr expr;
-    d >> bits(_endianness);
+    d >> bits(_endianness) >> bits(_origin);
     _mem.clear();
     d >> bits(nb_elems);
     for (int i = 0; i < nb_elems; i++)
@@ -1059,6 +1227,7 @@ void MemAbstractBuffer::load(Deserializer& d)
 MemSegment::MemSegment(addr_t s, addr_t e, const std::string& n, bool special, Endian endian):
     start(s), end(e),
     _bitmap(MemStatusBitmap(e-s+1)), 
+    _taint_bitmap(MemStatusBitmap(e-s+1)),
     _concrete(MemConcreteBuffer(e-s+1, endian)),
     _abstract(MemAbstractBuffer(endian)), 
     _is_engine_special_segment(special),
@@ -1078,6 +1247,7 @@ bool MemSegment::is_engine_special_segment()
 void MemSegment::extend_after(addr_t nb_bytes)
 {
     _bitmap.extend_after(nb_bytes);
+    _taint_bitmap.extend_after(nb_bytes);
     _concrete.extend_after(nb_bytes);
     end = end + nb_bytes;
 }
@@ -1088,10 +1258,48 @@ void MemSegment::extend_before(addr_t nb_bytes)
         throw runtime_exception("MemSegment::extend_before() got too many bytes (will go beyond the 0 address)");
     
     _bitmap.extend_before(nb_bytes);
+    _taint_bitmap.extend_before(nb_bytes);
     _concrete.extend_before(nb_bytes);
+    _abstract.extend_before(nb_bytes);
     start = start - nb_bytes;
 }
 
+void MemSegment::shrink_after(addr_t nb_bytes)
+{
+    if (nb_bytes >= size())
+        throw runtime_exception("MemSegment::shrink_after(): can't remove all bytes of the segment");
+
+    offset_t new_size = size() - nb_bytes;
+    _bitmap.truncate(new_size);
+    _taint_bitmap.truncate(new_size);
+    _concrete.shrink_after(nb_bytes);
+    _abstract.erase(new_size, nb_bytes);
+    end = end - nb_bytes;
+}
+
+void MemSegment::shrink_before(addr_t nb_bytes)
+{
+    if (nb_bytes >= size())
+        throw runtime_exception("MemSegment::shrink_before(): can't remove all bytes of the segment");
+
+    _bitmap.shrink_before(nb_bytes);
+    _taint_bitmap.shrink_before(nb_bytes);
+    _concrete.shrink_before(nb_bytes);
+    _abstract.shrink_before(nb_bytes);
+    start = start + nb_bytes;
+}
+
+addr_t MemSegment::free_before()
+{
+    // Can't extend beyond the 0 address
+    return std::min<addr_t>(_concrete.free_before(), start);
+}
+
+addr_t MemSegment::free_after()
+{
+    return _concrete.free_after();
+}
+
 bool MemSegment::contains(addr_t addr)
 {
     return addr >= start && addr <= end;
@@ -1250,6 +1458,8 @@ void MemSegment::read(Value& res, addr_t addr, unsigned int nb_bytes)
                 tmp2.set_cst(bytes_to_read*8, _concrete.read(from, bytes_to_read));
             else
                 tmp2 = _concrete.read_as_value(from, bytes_to_read);
+            if (_taint_bitmap.is_concrete_until(from, bytes_to_read) < from+bytes_to_read)
+                read_shadow_taint(tmp2, from, bytes_to_read);
 
             /* Update result */
             if (res.is_none())
@@ -1306,7 +1516,11 @@ void MemSegment::_read_optimised_buffer(std::vector<Value>& res, addr_t addr, un
             nb_bytes -= bytes_to_read; // Update the number of bytes left to read
             // Read 1-byte concrete values
             for (int i = 0; i < bytes_to_read; i++)
+            {
                 res.push_back(Value(8, _concrete.read(from+i, 1)));
+                if (_taint_bitmap.is_abstract(from+i))
+                    res.back().set_shadow_taint(0xff);
+            }
         }
         else
         {
@@ -1355,12 +1569,32 @@ abstract_mem_chunk_t MemSegment::abstract_snapshot(addr_t addr, int nb_bytes)
 
 std::pair<Expr, uint8_t>& MemAbstractBuffer::at(offset_t off)
 {
-    return _mem[off];
+    return _mem[_origin+off];
 }
 
 void MemAbstractBuffer::set(offset_t off, std::pair<Expr, uint8_t>& pair)
 {
-    _mem[off] = pair;
+    _mem[_origin+off] = pair;
+}
+
+void MemAbstractBuffer::extend_before(offset_t nb_bytes)
+{
+    // Keys can wrap around, only their differences matter
+    _origin -= nb_bytes;
+}
+
+void MemAbstractBuffer::shrink_before(offset_t nb_bytes)
+{
+    erase(0, nb_bytes);
+    _origin += nb_bytes;
+}
+
+void MemAbstractBuffer::erase(offset_t off, offset_t nb_bytes)
+{
+    if (_mem.empty())
+        return;
+    for (offset_t i = 0; i < nb_bytes; i++)
+        _mem.erase(_origin+off+i);
 }
 
 void MemSegment::abstract_snapshot(addr_t& addr, int& nb_bytes, abstract_mem_chunk_t& snap){
@@ -1372,6 +1606,13 @@ void MemSegment::abstract_snapshot(addr_t& addr, int& nb_bytes, abstract_mem_chu
         {
             snap.push_back(_abstract.at(off+i));
         }
+        else if (_taint_bitmap.is_abstract(off+i))
+        {
+            // Save shadow taint as a tainted constant byte
+            Expr byte = exprcst(8, _concrete.read(off+i, 1));
+            byte->make_tainted();
+            snap.push_back(std::make_pair(byte, 0));
+        }
         else
         {
             snap.push_back(std::make_pair(nullptr, 0));
@@ -1399,10 +1640,12 @@ void MemSegment::write(addr_t addr, const Value& val, VarContext& ctx)
             // expression is actually concrete
             _bitmap.mark_as_concrete(off, off+(e->size/8)-1);
         }
+        _taint_bitmap.mark_as_concrete(off, off+(e->size/8)-1);
     }
     else
     {
         _bitmap.mark_as_concrete(off, off+(val.size()/8)-1);
+        write_shadow_taint(off, val);
     }
 
     /* ALWAYS Add concrete value if possible (even if its tainted
@@ -1438,6 +1681,7 @@ void MemSegment::write(addr_t addr, uint8_t* src, int nb_bytes)
     }
     _concrete.write_buffer(off, src, nb_bytes);
     _bitmap.mark_as_concrete(off, off+nb_bytes-1);
+    _taint_bitmap.mark_as_concrete(off, off+nb_bytes-1);
 }
 
 void MemSegment::write(addr_t addr, cst_t val, unsigned int nb_bytes)
@@ -1445,6 +1689,7 @@ void MemSegment::write(addr_t addr, cst_t val, unsigned int nb_bytes)
     offset_t off = addr - start;
     _concrete.write(off, val, nb_bytes);
     _bitmap.mark_as_concrete(off, off+nb_bytes-1);
+    _taint_bitmap.mark_as_concrete(off, off+nb_bytes-1);
 }
 
 void MemSegment::write_from_concrete_snapshot(addr_t addr, cst_t val, int nb_bytes)
@@ -1461,11 +1706,25 @@ void MemSegment::write_from_abstract_snapshot(addr_t addr, abstract_mem_chunk_t&
     for (it = snap.begin(); it != snap.end() && addr+i <= end; it++)
     {
         if( it->first == nullptr )
+        {
+            _bitmap.mark_as_concrete(off+i);
+            _taint_bitmap.mark_as_concrete(off+i);
+        }
+        else if (
+            it->first->is_type(ExprType::CST) and it->first->size == 8
+            and it->first->is_tainted()
+        )
+        {
+            // Shadow-tainted byte, its concrete value was restored by
+            // write_from_concrete_snapshot()
             _bitmap.mark_as_concrete(off+i);
+            _taint_bitmap.mark_as_abstract(off+i);
+        }
         else
         {
             _abstract.set(off+i, *it);
             _bitmap.mark_as_abstract(off+i);
+            _taint_bitmap.mark_as_concrete(off+i);
         }
         i++;
     }
@@ -1500,6 +1759,45 @@ addr_t MemSegment::is_concrete_until(addr_t addr1, addr_t max)
     return start + _bitmap.is_concrete_until(addr1-start, adjusted_max);
 }
 
+addr_t MemSegment::is_untainted_until(addr_t addr1, addr_t max)
+{
+    addr_t adjusted_max = (max < end-addr1)? max: end-addr1;
+    return start + _taint_bitmap.is_concrete_until(addr1-start, adjusted_max);
+}
+
+void MemSegment::read_shadow_taint(Value& val, offset_t off, unsigned int nb_bytes)
+{
+    for (unsigned int i = 0; i < nb_bytes; i++)
+    {
+        if (not _taint_bitmap.is_abstract(off+i))
+            continue;
+        if (_endianness == Endian::LITTLE)
+            val.add_shadow_taint(i*8+7, i*8);
+        else
+            val.add_shadow_taint(val.size()-1-i*8, val.size()-8-i*8);
+    }
+}
+
+void MemSegment::write_shadow_taint(offset_t off, const Value& val)
+{
+    unsigned int nb_bytes = val.size()/8;
+    if (val.shadow_taint() == 0)
+    {
+        _taint_bitmap.mark_as_concrete(off, off+nb_bytes-1);
+        return;
+    }
+    for (unsigned int i = 0; i < nb_bytes; i++)
+    {
+        bool tainted = (_endianness == Endian::LITTLE)?
+            val.has_shadow_taint(i*8+7, i*8) :
+            val.has_shadow_taint(val.size()-1-i*8, val.size()-8-i*8);
+        if (tainted)
+            _taint_bitmap.mark_as_abstract(off+i);
+        else
+            _taint_bitmap.mark_as_concrete(off+i);
+    }
+}
+
 // Return first address where the byte is different than "byte"
 addr_t MemSegment::is_identical_until(addr_t addr, cst_t byte)
 {
@@ -1516,7 +1814,7 @@ uid_t MemSegment::class_uid() const
 
 void MemSegment::dump(Serializer& s) const
 {
-    s << _bitmap << _concrete << _abstract
+    s << _bitmap << _taint_bitmap << _concrete << _abstract
       << bits(_is_engine_special_segment)
       << bits(start) << bits(end) << name
       << bits(_endianness);
@@ -1524,7 +1822,7 @@ void MemSegment::dump(Serializer& s) const
 
 void MemSegment::load(Deserializer& d)
 {
-    d >> _bitmap >> _concrete >> _abstract
+    d >> _bitmap >> _taint_bitmap >> _concrete >> _abstract
       >> bits(_is_engine_special_segment)
       >> bits(start) >> bits(end) >> name
       >> bits(_endianness);
@@ -1648,6 +1946,8 @@ void MemEngine::map(addr_t start, addr_t end, mem_flag_t mflags, const std::stri
 
     for (auto& t : to_create)
     {
+        if (_extend_adjacent_segment(std::get<0>(t), std::get<1>(t), map_name))
+            continue;
         new_segment(std::get<0>(t), std::get<1>(t), std::get<2>(t), map_name);
     }
 
@@ -1658,6 +1958,32 @@ void MemEngine::map(addr_t start, addr_t end, mem_flag_t mflags, const std::stri
     mappings.map(MemMap(start, end, mflags, map_name));
 }
 
+bool MemEngine::_extend_adjacent_segment(addr_t start, addr_t end, const std::string& name)
+{
+    for (auto& seg : _segments)
+    {
+        if (seg->is_engine_special_segment() or seg->name != name)
+            continue;
+        // Extend only if the concrete memory doesn't move, so that raw
+        // pointers to it remain valid
+        if (seg->end < start and seg->end+1 == start and seg->free_after() >= end-start+1)
+        {
+            if (_snapshots->active())
+                _snapshots->back().add_extended_segment(seg->start, seg->end);
+            seg->extend_after(end-start+1);
+            return true;
+        }
+        else if (seg->start > end and end+1 == seg->start and seg->free_before() >= end-start+1)
+        {
+            if (_snapshots->active())
+                _snapshots->back().add_extended_segment(seg->start, seg->end);
+            seg->extend_before(end-start+1);
+            return true;
+        }
+    }
+    return false;
+}
+
 addr_t MemEngine::allocate(
     addr_t init_base, addr_t size, addr_t align,
     mem_flag_t flags, const std::string& name
@@ -1770,6 +2096,23 @@ void MemEngine::delete_segment(addr_t start)
     }
 }
 
+void MemEngine::shrink_segment(addr_t start, addr_t end)
+{
+    std::shared_ptr<MemSegment> segment = get_segment_containing(start);
+    if (segment == nullptr or not segment->contains(end))
+    {
+        throw runtime_exception(Fmt()
+            << "MemEngine::shrink_segment(): no segment contains 0x"
+            << std::hex << start << "-0x" << end
+            >> Fmt::to_str
+        );
+    }
+    if (segment->end > end)
+        segment->shrink_after(segment->end - end);
+    if (segment->start < start)
+        segment->shrink_before(start - segment->start);
+}
+
 std::list<std::shared_ptr<MemSegment>>& MemEngine::segments()
 {
     return _segments;
@@ -2587,9 +2930,19 @@ void MemEngine::make_tainted_no_var(addr_t addr, unsigned int nb_elems, unsigned
     }
     for( unsigned int i = 0; i < nb_elems; i++)
     {
-        e = read(addr_val + i*elem_size, elem_size).as_expr();
-        e->make_tainted();
-        write(addr_val + i*elem_size, e);
+        Value val = read(addr_val + i*elem_size, elem_size);
+        if (val.is_abstract())
+        {
+            e = val.expr();
+            e->make_tainted();
+            write(addr_val + i*elem_size, e);
+        }
+        else
+        {
+            // Concrete contents only get shadow taint
+            val.set_shadow_taint(default_expr_taint_mask);
+            write(addr_val + i*elem_size, val);
+        }
     }
 }
 
@@ -2783,6 +3136,8 @@ void MemEngine::check_status(addr_t start, addr_t end, bool& is_symbolic, bool&
     {
         if( segment->contains(start) )
         {
+            if (segment->is_untainted_until(start, end-start+1) < end+1)
+                is_tainted = true;
             if( (start_sym = segment->is_concrete_until(start, end)) < end+1 )
             {
                 // If not full concrete check the not concrete bytes
@@ -2849,10 +3204,8 @@ std::ostream& operator<<(std::ostream& os, MemEngine& mem)
 
 void MemEngine::record_mem_write(addr_t addr, int nb_bytes)
 {
-    size_t bytes_to_write;
- 
     /* If snapshots enabled record the write */
-    if (_snapshots->active())
+    if (_snapshots->active() and nb_bytes > 0)
     {
         // If we just created a segment and write to it, we don't care about
         // snapshoting its content because it will be deleted when rewinding the
@@ -2872,20 +3225,48 @@ void MemEngine::record_mem_write(addr_t addr, int nb_bytes)
             }
         }
 
-        
+        // Save memory by lines so that each location is saved at most once
+        // per snapshot, no matter how many times it gets overwritten
+        Snapshot& snapshot = _snapshots->back();
+        addr_t line = addr & ~(Snapshot::saved_mem_line_size-1);
+        addr_t last_line = (addr+nb_bytes-1) & ~(Snapshot::saved_mem_line_size-1);
+        while (true)
+        {
+            if (snapshot.add_dirty_mem_line(line))
+                save_mem_line(snapshot, line);
+            if (line == last_line)
+                break;
+            line += Snapshot::saved_mem_line_size;
+        }
+    }
+}
+
+void MemEngine::save_mem_line(Snapshot& snapshot, addr_t line)
+{
+    addr_t line_end = line + Snapshot::saved_mem_line_size - 1;
+    for (auto& segment : _segments)
+    {
+        if (not segment->intersects_with_range(line, line_end))
+            continue;
+        // Save only the part of the line that is mapped in this segment
+        addr_t start = std::max(line, segment->start);
+        addr_t end = std::min(line_end, segment->end);
         // Do snapshots by chunks of 8, it's more efficient this way
         // than using a single multi-precision number
-        while (nb_bytes > 0)
+        for (addr_t chunk = start; ; chunk += 8)
         {
-            bytes_to_write = nb_bytes>8 ? 8 : nb_bytes;
-            _snapshots->back().add_saved_mem(SavedMemState{
-                bytes_to_write, // size
-                addr, // addr
-                concrete_snapshot(addr, bytes_to_write), // concrete content
-                abstract_snapshot(addr, bytes_to_write) // abstract content
+            int chunk_size = (end-chunk) >= 8 ? 8 : end-chunk+1;
+            addr_t tmp_addr = chunk;
+            int tmp_size = chunk_size;
+            cst_t concrete = segment->concrete_snapshot(tmp_addr, tmp_size);
+            snapshot.add_saved_mem(SavedMemState{
+                (size_t)chunk_size, // size
+                chunk, // addr
+                concrete, // concrete content
+                segment->abstract_snapshot(chunk, chunk_size) // abstract content
             });
-            nb_bytes -= bytes_to_write;
-            addr += bytes_to_write;
+            if (end - chunk < 8)
+                break;
         }
     }
 }
@@ -31,7 +31,7 @@ bool MemMap::contains(addr_t addr) const
     return start <= addr && end >= addr;
 }
 
-void MemMap::truncate(std::list<MemMap>& res, addr_t min, addr_t max)
+void MemMap::truncate(std::list<MemMap>& res, addr_t min, addr_t max) const
 {
     if (min > end || max < start)
     {
@@ -78,10 +78,14 @@ void MemMap::load(serial::Deserializer& d)
 
 
 
+MemMapManager::MemMapManager():
+    _maps(std::make_shared<const std::list<MemMap>>())
+{}
+
 void MemMapManager::map(MemMap new_map)
 {
     std::list<MemMap> new_maps;
-    for (MemMap& old_map : _maps)
+    for (const MemMap& old_map : *_maps)
     {
         if (old_map.contained_in_range(new_map.start, new_map.end))
         {
@@ -104,14 +108,14 @@ void MemMapManager::map(MemMap new_map)
     if (new_map.name.empty())
         new_map.name = "map_anon";
     new_maps.push_back(new_map);
-    _maps = new_maps;
-    _maps.sort();
+    new_maps.sort();
+    _maps = std::make_shared<const std::list<MemMap>>(std::move(new_maps));
 }
 
 void MemMapManager::unmap(addr_t start, addr_t end)
 {
     std::list<MemMap> new_maps;
-    for (MemMap& old_map : _maps)
+    for (const MemMap& old_map : *_maps)
     {
         if (old_map.contained_in_range(start, end))
             continue; // This old map is replace by the new one
@@ -120,23 +124,28 @@ void MemMapManager::unmap(addr_t start, addr_t end)
             old_map.truncate(new_maps, start, end);
         }
     }
-    _maps = new_maps;
-    _maps.sort();
+    new_maps.sort();
+    _maps = std::make_shared<const std::list<MemMap>>(std::move(new_maps));
 }
 
 const std::list<MemMap>& MemMapManager::get_maps() const
+{
+    return *_maps;
+}
+
+std::shared_ptr<const std::list<MemMap>> MemMapManager::shared_maps() const
 {
     return _maps;
 }
 
-void MemMapManager::set_maps(std::list<MemMap>&& m)
+void MemMapManager::set_maps(std::shared_ptr<const std::list<MemMap>> maps)
 {
-    _maps = m;
+    _maps = maps;
 }
 
 const MemMap& MemMapManager::get_map_by_name(const std::string& name) const
 {
-    for (const auto& m : _maps)
+    for (const auto& m : *_maps)
     {
         if (m.name == name)
             return m;
@@ -149,7 +158,7 @@ const MemMap& MemMapManager::get_map_by_name(const std::string& name) const
 
 bool MemMapManager::is_free(addr_t start, addr_t end) const
 {
-    for (const MemMap& map : _maps)
+    for (const MemMap& map : *_maps)
         if (map.intersects_with_range(start, end))
             return false;
     return true;
@@ -180,12 +189,14 @@ uid_t MemMapManager::class_uid() const
 
 void MemMapManager::dump(serial::Serializer& s) const
 {
-    s << _maps;
+    s << *_maps;
 }
 
 void MemMapManager::load(serial::Deserializer& d)
 {
-    d >> _maps;
+    std::list<MemMap> maps;
+    d >> maps;
+    _maps = std::make_shared<const std::list<MemMap>>(std::move(maps));
 }
 
 } // namespace maat
\ No newline at end of file
@@ -124,6 +124,8 @@ Serializable* Deserializer::Factory::new_object(uid_t class_uid)
             return new env::LinuxEmulator(Arch::Type::NONE);
         case ClassId::EVM_CONTRACT:
             return new env::EVM::Contract();
+        case ClassId::EVM_STORAGE:
+            return new env::EVM::Storage(nullptr);
         case ClassId::EXPR_BINOP:
             return new ExprBinop();
         case ClassId::EXPR_CONCAT:
@@ -0,0 +1,63 @@
+#ifndef MAAT_BENCH_H
+#define MAAT_BENCH_H
+
+#include <cstdint>
+#include <functional>
+#include <ostream>
+#include <string>
+#include <vector>
+
+namespace bench
+{
+
+/// Result of a single benchmark
+struct Result
+{
+    std::string name;
+    uint64_t iterations; ///< Number of times the benchmark function was called
+    double total_ns; ///< Total time spent in the benchmark function
+    uint64_t items; ///< Number of items processed (instructions, bytes, ...)
+    std::string unit; ///< What the items are
+    std::string error; ///< Set if the benchmark failed
+    bool skipped; ///< Set if the benchmark couldn't run in this build, 'error' holds the reason
+
+    /// Average time of one iteration, 0 if the benchmark didn't run
+    double ns_per_iteration() const;
+    /// Throughput in items per second, 0 if it can't be measured
+    double items_per_second() const;
+};
+
+/** \brief Runs benchmarks and gathers their results.
+ *
+ * A benchmark is a function that performs some work and returns the number
+ * of items it processed. It is called once to warm up, then repeatedly until
+ * it has run for at least 'min_time' seconds (at least once). Exceptions
+ * raised by the function are recorded in the result and don't stop the other
+ * benchmarks. Setup that can fail must therefore happen inside the function */
+class Runner
+{
+private:
+    double _min_time;
+    std::vector<std::string> _filters;
+    std::vector<Result> _results;
+public:
+    Runner(double min_time, const std::vector<std::string>& filters);
+    /// Return true if benchmark 'name' matches the filters given on the command line
+    bool enabled(const std::string& name) const;
+    /// Run benchmark 'name' if enabled. 'unit' describes the items returned by 'func'
+    void run(const std::string& name, const std::string& unit, std::function<uint64_t()> func);
+    /// Record benchmark 'name' as skipped because of 'reason'
+    void skip(const std::string& name, const std::string& reason);
+    const std::vector<Result>& results() const;
+    /// Print the results as a JSON document
+    void dump_json(std::ostream& os) const;
+};
+
+void bench_expression(Runner& runner);
+void bench_memory(Runner& runner);
+void bench_engine(Runner& runner);
+void bench_solver(Runner& runner);
+
+} // namespace bench
+
+#endif
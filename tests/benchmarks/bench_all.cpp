@@ -0,0 +1,225 @@
+#include "bench.hpp"
+#include <chrono>
+#include <cstdlib>
+#include <cstring>
+#include <ctime>
+#include <fstream>
+#include <iomanip>
+#include <iostream>
+#include <sstream>
+
+using std::cout;
+using std::endl;
+using std::string;
+
+namespace bench
+{
+
+double Result::ns_per_iteration() const
+{
+    return iterations == 0 ? 0 : total_ns / iterations;
+}
+
+double Result::items_per_second() const
+{
+    // Runs faster than the clock resolution have no meaningful throughput
+    return total_ns <= 0 ? 0 : items / (total_ns / 1e9);
+}
+
+Runner::Runner(double min_time, const std::vector<string>& filters):
+    _min_time(min_time), _filters(filters)
+{}
+
+bool Runner::enabled(const string& name) const
+{
+    if (_filters.empty())
+        return true;
+    for (const string& f : _filters)
+    {
+        if (name.find(f) != string::npos)
+            return true;
+    }
+    return false;
+}
+
+void Runner::run(const string& name, const string& unit, std::function<uint64_t()> func)
+{
+    if (not enabled(name))
+        return;
+
+    Result res{name, 0, 0, 0, unit, "", false};
+    cout << "  " << std::left << std::setw(36) << name << std::flush;
+    try
+    {
+        // Warm up caches and lazy initialisations
+        func();
+        // Always run at least one batch so that the timings are defined
+        uint64_t batch = 1;
+        do
+        {
+            auto begin = std::chrono::steady_clock::now();
+            for (uint64_t i = 0; i < batch; i++)
+                res.items += func();
+            auto end = std::chrono::steady_clock::now();
+            res.total_ns += std::chrono::duration<double, std::nano>(end - begin).count();
+            res.iterations += batch;
+            batch *= 2;
+        }
+        while (res.total_ns < _min_time*1e9);
+    }
+    catch (const std::exception& e)
+    {
+        res.error = e.what();
+    }
+
+    if (res.error.empty())
+    {
+        std::stringstream ss;
+        ss << std::right << std::setw(14) << std::fixed << std::setprecision(1)
+           << res.ns_per_iteration() << " ns/iter " << std::setw(14) << std::setprecision(0)
+           << res.items_per_second() << " " << unit << "/s";
+        cout << ss.str() << endl;
+    }
+    else
+        cout << "error: " << res.error << endl;
+    _results.push_back(res);
+}
+
+void Runner::skip(const string& name, const string& reason)
+{
+    if (not enabled(name))
+        return;
+    cout << "  " << std::left << std::setw(36) << name << "skipped: " << reason << endl;
+    _results.push_back(Result{name, 0, 0, 0, "", reason, true});
+}
+
+const std::vector<Result>& Runner::results() const
+{
+    return _results;
+}
+
+static string _json_escape(const string& str)
+{
+    std::stringstream ss;
+    for (char c : str)
+    {
+        if (c == '"' or c == '\\')
+            ss << '\\' << c;
+        else if ((unsigned char)c < 0x20)
+            ss << "\\u" << std::hex << std::setw(4) << std::setfill('0') << (int)c;
+        else
+            ss << c;
+    }
+    return ss.str();
+}
+
+void Runner::dump_json(std::ostream& os) const
+{
+    char date[32];
+    std::time_t now = std::time(nullptr);
+    std::strftime(date, sizeof(date), "%Y-%m-%dT%H:%M:%SZ", std::gmtime(&now));
+
+    os << std::dec << std::defaultfloat << std::setprecision(10);
+    os << "{\n  \"context\": {\n"
+       << "    \"date\": \"" << date << "\",\n"
+#ifdef __VERSION__
+       << "    \"compiler\": \"" << _json_escape(__VERSION__) << "\",\n"
+#endif
+#ifdef NDEBUG
+       << "    \"build_type\": \"release\",\n"
+#else
+       << "    \"build_type\": \"debug\",\n"
+#endif
+       << "    \"min_time\": " << _min_time << "\n"
+       << "  },\n  \"benchmarks\": [";
+    for (size_t i = 0; i < _results.size(); i++)
+    {
+        const Result& r = _results[i];
+        os << (i == 0 ? "\n" : ",\n") << "    {\"name\": \"" << _json_escape(r.name) << "\"";
+        if (r.skipped)
+            os << ", \"skipped\": \"" << _json_escape(r.error) << "\"";
+        else if (not r.error.empty())
+            os << ", \"error\": \"" << _json_escape(r.error) << "\"";
+        else
+        {
+            os << ", \"iterations\": " << r.iterations
+               << ", \"real_time_ns\": " << r.ns_per_iteration()
+               << ", \"items\": " << r.items
+               << ", \"items_per_second\": " << r.items_per_second()
+               << ", \"unit\": \"" << _json_escape(r.unit) << "\"";
+        }
+        os << "}";
+    }
+    os << "\n  ]\n}\n";
+}
+
+} // namespace bench
+
+void usage(const char* prog)
+{
+    cout << "Usage: " << prog << " [--json FILE] [--min-time SECONDS] [FILTER ...]\n"
+         << "  --json FILE          Write the results as JSON to FILE ('-' for stdout)\n"
+         << "  --min-time SECONDS   Minimal time to run each benchmark (default: 0.5)\n"
+         << "  FILTER               Only run benchmarks whose name contains FILTER\n"
+         << "Benchmarks load their resources from 'tests/resources', run this\n"
+         << "binary from the root of the repository" << endl;
+}
+
+int main(int argc, char ** argv)
+{
+    string bold = "\033[1m";
+    string def = "\033[0m";
+    string json_file;
+    double min_time = 0.5;
+    std::vector<string> filters;
+
+    for (int i = 1; i < argc; i++)
+    {
+        if (!strcmp(argv[i], "--json") and i+1 < argc)
+            json_file = argv[++i];
+        else if (!strcmp(argv[i], "--min-time") and i+1 < argc)
+            min_time = std::atof(argv[++i]);
+        else if (!strcmp(argv[i], "-h") or !strcmp(argv[i], "--help"))
+        {
+            usage(argv[0]);
+            return 0;
+        }
+        else
+            filters.push_back(argv[i]);
+    }
+
+    // Keep stdout clean for the JSON document
+    std::streambuf* cout_buf = cout.rdbuf();
+    if (json_file == "-")
+        cout.rdbuf(std::cerr.rdbuf());
+
+    cout << bold << "\nRunning Maat benchmarks" << def << endl
+         <<   "=======================" << endl << endl;
+
+    bench::Runner runner(min_time, filters);
+    bench::bench_expression(runner);
+    bench::bench_memory(runner);
+    bench::bench_engine(runner);
+    bench::bench_solver(runner);
+
+    cout.rdbuf(cout_buf);
+    if (json_file == "-")
+        runner.dump_json(cout);
+    else if (not json_file.empty())
+    {
+        std::ofstream out(json_file);
+        if (not out.is_open())
+        {
+            std::cerr << "Failed to open " << json_file << endl;
+            return 1;
+        }
+        runner.dump_json(out);
+    }
+
+    for (const auto& r : runner.results())
+    {
+        if (not r.error.empty() and not r.skipped)
+            return 1;
+    }
+    return 0;
+}
@@ -0,0 +1,263 @@
+#include "bench.hpp"
+#include "maat/engine.hpp"
+#include "maat/env/env_EVM.hpp"
+#include "maat/exception.hpp"
+#include "maat/lifter.hpp"
+#include "maat/stats.hpp"
+#include <fstream>
+#include <string>
+#include <vector>
+
+namespace bench
+{
+
+using namespace maat;
+using namespace maat::event;
+
+static std::vector<uint8_t> _read_resource(const std::string& path)
+{
+    std::ifstream file(path, std::ios::binary | std::ios::ate);
+    if (not file.is_open())
+        throw runtime_exception(Fmt() << "Failed to open resource " << path >> Fmt::to_str);
+    std::streamsize size = file.tellg();
+    file.seekg(0, std::ios::beg);
+    std::vector<uint8_t> buffer(size);
+    if (not file.read((char*)buffer.data(), size))
+        throw runtime_exception(Fmt() << "Failed to read resource " << path >> Fmt::to_str);
+    return buffer;
+}
+
+// Run the engine and return the number of executed instructions. Internal
+// errors are raised so that the benchmark is reported as failed instead of
+// measuring an aborted run
+static uint64_t _run(MaatEngine& engine, int max_inst=0)
+{
+    unsigned int before = MaatStats::instance().executed_insts();
+    info::Stop stop = engine.run(max_inst);
+    if (stop == info::Stop::FATAL)
+        throw runtime_exception("Emulation stopped because of a fatal error");
+    return MaatStats::instance().executed_insts() - before;
+}
+
+// Restore the engine to 'snapshot' and run it
+static uint64_t _run_from_snapshot(MaatEngine& engine, MaatEngine::snapshot_t snapshot, int max_inst=0)
+{
+    engine.restore_snapshot(snapshot);
+    return _run(engine, max_inst);
+}
+
+static std::unique_ptr<MaatEngine> _new_snapshot_engine()
+{
+    auto engine = std::make_unique<MaatEngine>(Arch::Type::X86);
+    engine->log.set_level(Log::ERROR);
+    engine->mem->map(0x10000, 0x1ffff, mem_flag_rw);
+    return engine;
+}
+
+static void _bench_snapshots(Runner& runner)
+{
+    // Engines are created in the benchmarks so that setup errors are
+    // reported like other failures
+    std::unique_ptr<MaatEngine> engine;
+    Expr var = exprvar(32, "var");
+
+    runner.run("snapshot/take_restore_concrete", "snapshots", [&]() -> uint64_t {
+        if (engine == nullptr)
+            engine = _new_snapshot_engine();
+        engine->take_snapshot();
+        for (int i = 0; i < 16; i++)
+            engine->mem->write(0x10000 + i*0x100, (cst_t)i, 4);
+        engine->cpu.ctx().set(X86::EAX, 0x1234);
+        engine->cpu.ctx().set(X86::EBX, 0x5678);
+        engine->restore_last_snapshot(true);
+        return 1;
+    });
+
+    runner.run("snapshot/take_restore_symbolic", "snapshots", [&]() -> uint64_t {
+        if (engine == nullptr)
+            engine = _new_snapshot_engine();
+        engine->take_snapshot();
+        for (int i = 0; i < 16; i++)
+            engine->mem->write(0x10000 + i*0x100, var + i);
+        engine->cpu.ctx().set(X86::EAX, var);
+        engine->cpu.ctx().set(X86::EBX, var ^ 0xff);
+        engine->restore_last_snapshot(true);
+        return 1;
+    });
+}
+
+static void _bench_lifting(Runner& runner, const std::string& name, CPUMode mode, const std::vector<uint8_t>& inst_bytes, int nb_inst_in_bytes)
+{
+    if (not runner.enabled(name))
+        return;
+    // Straight-line code, so that it is lifted as a single block
+    const int repeat = 64;
+    std::vector<uint8_t> code;
+    for (int i = 0; i < repeat; i++)
+        code.insert(code.end(), inst_bytes.begin(), inst_bytes.end());
+    const unsigned int nb_inst = repeat*nb_inst_in_bytes;
+    Logger logger;
+    logger.set_level(Log::ERROR);
+    std::shared_ptr<Lifter> lifter;
+
+    runner.run(name, "insts", [&]() -> uint64_t {
+        if (lifter == nullptr)
+            lifter = std::make_shared<Lifter>(mode);
+        ir::IRMap ir_map;
+        if (not lifter->lift_block(logger, ir_map, 0x1000, code.data(), code.size(), nb_inst))
+            throw runtime_exception("Failed to lift benchmark code");
+        return nb_inst;
+    });
+}
+
+static void _bench_lifters(Runner& runner)
+{
+    // add eax,ebx; xor ecx,edx; lea esi,[edi+eax*4+8]; imul eax,ecx; mov [ebp-4],eax; shr eax,2
+    _bench_lifting(runner, "lift/x86", CPUMode::X86, {
+        0x01, 0xd8, 0x31, 0xd1, 0x8d, 0x74, 0x87, 0x08,
+        0x0f, 0xaf, 0xc1, 0x89, 0x45, 0xfc, 0xc1, 0xe8, 0x02
+    }, 6);
+    // Same instructions on 64-bit registers
+    _bench_lifting(runner, "lift/x64", CPUMode::X64, {
+        0x48, 0x01, 0xd8, 0x48, 0x31, 0xd1, 0x48, 0x8d, 0x74, 0x87, 0x08,
+        0x48, 0x0f, 0xaf, 0xc1, 0x48, 0x89, 0x45, 0xfc, 0x48, 0xc1, 0xe8, 0x02
+    }, 6);
+    // PUSH1 1; PUSH1 2; ADD; DUP1; MUL; POP
+    _bench_lifting(runner, "lift/evm", CPUMode::EVM, {
+        0x60, 0x01, 0x60, 0x02, 0x01, 0x80, 0x02, 0x50
+    }, 6);
+}
+
+// Emulate the md5 function extracted from tests/resources/md5/md5.elf, it
+// doesn't require a loader backend
+static void _bench_md5_function(Runner& runner)
+{
+    const std::string name = "emu/x86_md5_function";
+    if (not runner.enabled(name))
+        return;
+
+    std::unique_ptr<MaatEngine> engine;
+    MaatEngine::snapshot_t snapshot = 0;
+    runner.run(name, "insts", [&]() -> uint64_t {
+        if (engine == nullptr)
+        {
+            engine = std::make_unique<MaatEngine>(Arch::Type::X86);
+            engine->log.set_level(Log::ERROR);
+            std::vector<uint8_t> md5 = _read_resource("tests/resources/md5/md5_0x08048960_546.bin");
+            std::vector<uint8_t> memcpy_code = _read_resource("tests/resources/md5/memcpy_0x0806ae50_115.bin");
+            std::vector<uint8_t> rodata = _read_resource("tests/resources/md5/rodata_0x80ab000_0x2fff.bin");
+            engine->mem->map(0x8048950, 0x8050000);
+            engine->mem->write_buffer(0x8048960, md5.data(), md5.size());
+            engine->mem->map(0x806ae50, 0x8070000);
+            engine->mem->write_buffer(0x806ae50, memcpy_code.data(), memcpy_code.size());
+            engine->mem->map(0x80a0000, 0x80df000);
+            engine->mem->write_buffer(0x80ab000, rodata.data(), rodata.size());
+            engine->mem->map(0xffff0000, 0xffffe000);
+            engine->mem->map(0x11000, 0x12000);
+
+            // md5("qcsikxrystkgqwuacwlgaqzcqqdsvqdo")
+            std::string input("qcsikxrystkgqwuacwlgaqzcqqdsvqdo");
+            engine->cpu.ctx().set(X86::ESP, 0xffffd15c);
+            engine->cpu.ctx().set(X86::EBP, 0xffffd15c);
+            engine->cpu.ctx().set(X86::EIP, 0x8048960);
+            engine->mem->write_buffer(0x11000, (uint8_t*)input.data(), input.size());
+            engine->mem->write(0xffffd15c+4, 0x11000, 4);
+            engine->mem->write(0xffffd15c+8, input.size(), 4);
+            engine->hooks.add(Event::EXEC, When::BEFORE, "", AddrFilter(0x8048b81));
+            snapshot = engine->take_snapshot();
+        }
+        return _run_from_snapshot(*engine, snapshot);
+    });
+}
+
+#ifdef MAAT_HAS_LOADER_BACKEND
+// Emulate a Linux binary from tests/resources. 'max_inst' bounds the
+// emulation for programs that use unsupported features
+static void _bench_linux_binary(
+    Runner& runner,
+    const std::string& name,
+    const std::string& path,
+    const std::vector<loader::CmdlineArg>& args,
+    int max_inst
+)
+{
+    if (not runner.enabled(name))
+        return;
+
+    std::unique_ptr<MaatEngine> engine;
+    MaatEngine::snapshot_t snapshot = 0;
+    runner.run(name, "insts", [&]() -> uint64_t {
+        if (engine == nullptr)
+        {
+            engine = std::make_unique<MaatEngine>(Arch::Type::X86, env::OS::LINUX);
+            engine->log.set_level(Log::ERROR);
+            engine->load(path, loader::Format::ELF32, 0, args, {}, {}, {}, {}, false);
+            snapshot = engine->take_snapshot();
+        }
+        return _run_from_snapshot(*engine, snapshot, max_inst);
+    });
+}
+#endif
+
+static void _bench_evm(Runner& runner)
+{
+    const std::string name = "emu/evm_hello_world";
+    if (not runner.enabled(name))
+        return;
+
+    // Call update("lala...") in the contract
+    std::string str_tx_data("3d7403a30000000000000000000000000000000000000000000000000000000000000020000000000000000000000000000000000000000000000000000000000000003a226c616c616c616c616c616c616c616c616c616c616c616c616c6161616161616161616161616161616161616161616161616161616161616122000000000000");
+    std::vector<char> hex_tx_data(str_tx_data.begin(), str_tx_data.end());
+    std::vector<Value> tx_data;
+    for (auto b : env::EVM::hex_string_to_bytes(hex_tx_data))
+        tx_data.push_back(Value(8, b));
+
+    std::unique_ptr<MaatEngine> engine;
+    MaatEngine::snapshot_t snapshot = 0;
+    runner.run(name, "insts", [&]() -> uint64_t {
+        if (engine == nullptr)
+        {
+            engine = std::make_unique<MaatEngine>(Arch::Type::EVM);
+            engine->log.set_level(Log::ERROR);
+            engine->load(
+                "tests/resources/smart_contracts/HelloWorld.bin",
+                loader::Format::NONE,
+                0,
+                {},
+                {{"address","1234568"}, {"deployer","AAABBBCFF0000000000000454F"}},
+                {}, {}, {}
+            );
+            snapshot = engine->take_snapshot();
+        }
+        engine->restore_snapshot(snapshot);
+        env::EVM::get_contract_for_engine(*engine)->transaction = env::EVM::Transaction(
+            Value(160, 1), // origin
+            Value(160, 1), // sender
+            Number(160, 2), // recipient
+            Value(256, 0), // value
+            tx_data, // data
+            Value(256, 50), // gas_price
+            Value(256, 46546516351) // gas_limit
+        );
+        return _run(*engine);
+    });
+}
+
+void bench_engine(Runner& runner)
+{
+    _bench_snapshots(runner);
+    _bench_lifters(runner);
+    _bench_md5_function(runner);
+#ifdef MAAT_HAS_LOADER_BACKEND
+    _bench_linux_binary(runner, "emu/x86_md5_elf", "tests/resources/md5/md5.elf",
+        {loader::CmdlineArg("maat benchmark")}, 0);
+    // No 32-bit libc is bundled, imported functions use Maat's emulated libc
+    _bench_linux_binary(runner, "emu/x86_ls", "tests/resources/x86_elf/ls", {}, 500000);
+#else
+    runner.skip("emu/x86_md5_elf", "no loader backend");
+    runner.skip("emu/x86_ls", "no loader backend");
+#endif
+    _bench_evm(runner);
+}
+
+} // namespace bench
@@ -0,0 +1,69 @@
+#include "bench.hpp"
+#include "maat/expression.hpp"
+#include "maat/simplification.hpp"
+#include "maat/varcontext.hpp"
+
+namespace bench
+{
+
+using namespace maat;
+
+// Build an expression tree of 'depth' levels mixing the most common operations
+// found in lifted code. 'seed' changes the constants so that successive
+// expressions are different and don't hit the simplifier's cache
+static Expr _build_expr(Expr a, Expr b, int depth, uint64_t seed)
+{
+    Expr e = a;
+    for (int i = 0; i < depth; i++)
+    {
+        e = (e + (b * exprcst(32, seed+i))) ^ (e >> 3);
+        e = concat(extract(e, 31, 16), extract(e + 1, 15, 0)) & exprcst(32, 0xffff00ff);
+    }
+    return e;
+}
+
+void bench_expression(Runner& runner)
+{
+    Expr a = exprvar(32, "a"), b = exprvar(32, "b");
+    uint64_t seed = 0;
+    // Nodes created by _build_expr() per level
+    const int depth = 8, nodes_per_level = 10;
+
+    runner.run("expr/create", "exprs", [&]() -> uint64_t {
+        Expr e = _build_expr(a, b, depth, seed++);
+        return depth*nodes_per_level;
+    });
+
+    runner.run("expr/create_hash", "exprs", [&]() -> uint64_t {
+        Expr e = _build_expr(a, b, depth, seed++);
+        e->hash();
+        return depth*nodes_per_level;
+    });
+
+    std::shared_ptr<ExprSimplifier> simp = NewDefaultExprSimplifier();
+    runner.run("expr/simplify", "exprs", [&]() -> uint64_t {
+        Expr e = _build_expr(a, b, depth, seed++);
+        e = simp->simplify(e);
+        return 1;
+    });
+
+    // Arithmetic identities that the simplifier rewrites
+    runner.run("expr/simplify_identities", "exprs", [&]() -> uint64_t {
+        Expr c = exprcst(32, seed++);
+        Expr e = ((a + c) - c) ^ (b ^ exprcst(32, 0)) | (a & exprcst(32, 0));
+        e = extract(concat(e, b), 63, 32) * exprcst(32, 1);
+        e = simp->simplify(e);
+        return 1;
+    });
+
+    VarContext ctx;
+    ctx.set("a", 0x12345678);
+    ctx.set("b", 0xdeadbeef);
+    runner.run("expr/concretize", "exprs", [&]() -> uint64_t {
+        Expr e = _build_expr(a, b, depth, seed++);
+        e->as_uint(ctx);
+        return 1;
+    });
+}
+
+} // namespace bench
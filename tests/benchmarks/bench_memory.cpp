@@ -0,0 +1,106 @@
+#include "bench.hpp"
+#include "maat/memory.hpp"
+#include "maat/settings.hpp"
+#include "maat/varcontext.hpp"
+#include <memory>
+#include <vector>
+
+namespace bench
+{
+
+using namespace maat;
+
+void bench_memory(Runner& runner)
+{
+    const addr_t base = 0x100000, size = 0x100000;
+    const int nb_accesses = 4096;
+    // Created by the first benchmark that runs, so that setup errors are
+    // reported like other failures
+    std::unique_ptr<MemEngine> mem_engine;
+    auto get_mem = [&]() -> MemEngine& {
+        if (mem_engine == nullptr)
+        {
+            mem_engine = std::make_unique<MemEngine>(std::make_shared<VarContext>(), 64);
+            mem_engine->map(base, base+size-1, mem_flag_rw, "Bench");
+        }
+        return *mem_engine;
+    };
+
+    runner.run("mem/concrete_write_8", "accesses", [&]() -> uint64_t {
+        MemEngine& mem = get_mem();
+        for (int i = 0; i < nb_accesses; i++)
+            mem.write(base + i*8, (cst_t)i, 8);
+        return nb_accesses;
+    });
+
+    runner.run("mem/concrete_read_8", "accesses", [&]() -> uint64_t {
+        MemEngine& mem = get_mem();
+        for (int i = 0; i < nb_accesses; i++)
+            mem.read(base + i*8, 8);
+        return nb_accesses;
+    });
+
+    // Unaligned accesses over more than one status bitmap byte
+    runner.run("mem/concrete_read_32_unaligned", "accesses", [&]() -> uint64_t {
+        MemEngine& mem = get_mem();
+        for (int i = 0; i < nb_accesses; i++)
+            mem.read(base + i*13, 32);
+        return nb_accesses;
+    });
+
+    // Large concrete copies like file loading or stack setup
+    std::vector<uint8_t> buffer(0x10000, 0x41);
+    runner.run("mem/write_buffer_64k", "bytes", [&]() -> uint64_t {
+        MemEngine& mem = get_mem();
+        mem.write_buffer(base, buffer.data(), buffer.size());
+        return buffer.size();
+    });
+
+    runner.run("mem/read_buffer_4k", "bytes", [&]() -> uint64_t {
+        MemEngine& mem = get_mem();
+        mem.read_buffer(base, 0x1000);
+        return 0x1000;
+    });
+
+    // Symbolic accesses, in a separate area so that they don't slow down
+    // the concrete benchmarks
+    const addr_t sym_base = base + size/2;
+    std::vector<Expr> vars;
+    for (int i = 0; i < 256; i++)
+        vars.push_back(exprvar(32, "var_" + std::to_string(i)));
+
+    runner.run("mem/symbolic_write_4", "accesses", [&]() -> uint64_t {
+        MemEngine& mem = get_mem();
+        for (int i = 0; i < (int)vars.size(); i++)
+            mem.write(sym_base + i*4, vars[i]);
+        return vars.size();
+    });
+
+    runner.run("mem/symbolic_read_4", "accesses", [&]() -> uint64_t {
+        MemEngine& mem = get_mem();
+        for (int i = 0; i < (int)vars.size(); i++)
+            mem.read(sym_base + i*4, 4);
+        return vars.size();
+    });
+
+    // Mixed concrete/symbolic reads that must be concatenated
+    runner.run("mem/mixed_read_8", "accesses", [&]() -> uint64_t {
+        MemEngine& mem = get_mem();
+        for (int i = 0; i < (int)vars.size(); i++)
+            mem.read(sym_base + i*4 - 2, 8);
+        return vars.size();
+    });
+
+    // Symbolic pointer read in a 256 bytes range
+    Settings settings;
+    Expr ptr = exprcst(64, base) + (concat(exprcst(56, 0), extract(exprvar(32, "idx"), 7, 0)));
+    ValueSet range = ptr->value_set();
+    runner.run("mem/symbolic_ptr_read_4", "accesses", [&]() -> uint64_t {
+        MemEngine& mem = get_mem();
+        Value res;
+        mem.symbolic_ptr_read(res, ptr, range, 4, settings);
+        return 1;
+    });
+}
+
+} // namespace bench
@@ -0,0 +1,58 @@
+#include "bench.hpp"
+#include "maat/solver.hpp"
+#include "maat/varcontext.hpp"
+
+namespace bench
+{
+
+using namespace maat;
+
+void bench_solver(Runner& runner)
+{
+#ifdef MAAT_HAS_SOLVER_BACKEND
+    // Created by the first benchmark that runs, so that setup errors are
+    // reported like other failures
+    std::unique_ptr<solver::Solver> sol;
+    auto get_solver = [&]() -> solver::Solver& {
+        if (sol == nullptr)
+            sol = solver::new_solver();
+        return *sol;
+    };
+    Expr a = exprvar(32, "a"), b = exprvar(32, "b");
+    cst_t seed = 0;
+
+    // Simple linear constraint, dominated by the round-trip to the solver
+    runner.run("solver/linear_sat", "queries", [&]() -> uint64_t {
+        get_solver().reset();
+        sol->add(a*3 + 7 == exprcst(32, seed++));
+        if (not sol->check())
+            throw runtime_exception("solver/linear_sat: unexpected unsat");
+        sol->get_model();
+        return 1;
+    });
+
+    runner.run("solver/nonlinear_sat", "queries", [&]() -> uint64_t {
+        get_solver().reset();
+        sol->add(((a ^ (b << 3)) * (b | 1)) == exprcst(32, 0x1234567 + seed++));
+        sol->add(a != b);
+        if (not sol->check())
+            throw runtime_exception("solver/nonlinear_sat: unexpected unsat");
+        sol->get_model();
+        return 1;
+    });
+
+    runner.run("solver/unsat", "queries", [&]() -> uint64_t {
+        get_solver().reset();
+        sol->add((a & 0xff) == exprcst(32, 0x100 + (seed++ & 0xff)));
+        if (sol->check())
+            throw runtime_exception("solver/unsat: unexpected sat");
+        return 1;
+    });
+#else
+    runner.skip("solver/linear_sat", "no solver backend");
+    runner.skip("solver/nonlinear_sat", "no solver backend");
+    runner.skip("solver/unsat", "no solver backend");
+#endif
+}
+
+} // namespace bench
@@ -13,11 +13,13 @@ void test_ir();
 void test_archX86();
 void test_archX64();
 void test_events();
+void test_engine();
 void test_snapshots();
 void test_solver();
 void test_loader();
 void test_serialization();
 void test_archEVM();
+void test_trace();
 
 
 int main(int argc, char ** argv)
@@ -48,6 +50,7 @@ int main(int argc, char ** argv)
                 test_symbolic_memory();
                 test_ir();
                 test_events();
+                test_engine();
                 test_snapshots();
                 test_archX86();
                 test_archX64();
@@ -55,6 +58,7 @@ int main(int argc, char ** argv)
                 test_solver();
                 test_loader();
                 test_serialization();
+                test_trace();
                 
                 /* TODO
                 test_archARM64();
@@ -84,6 +88,8 @@ int main(int argc, char ** argv)
                         test_archEVM();
                     else if( !strcmp(argv[i], "event"))
                         test_events();
+                    else if( !strcmp(argv[i], "engine"))
+                        test_engine();
                     else if( !strcmp(argv[i], "snap"))
                         test_snapshots();
                     else if( !strcmp(argv[i], "solver"))
@@ -92,6 +98,8 @@ int main(int argc, char ** argv)
                         test_loader();
                     else if( !strcmp(argv[i], "serial"))
                         test_serialization();
+                    else if( !strcmp(argv[i], "trace"))
+                        test_trace();
                     /*
                     else if( !strcmp(argv[i], "ARM64"))
                         test_archARM64();
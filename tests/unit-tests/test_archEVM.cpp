@@ -858,6 +858,49 @@ namespace test{
             return res;
         }
 
+        unsigned int test_storage_symbolic_keys()
+        {
+            unsigned int nb = 0;
+            auto ctx = std::make_shared<VarContext>();
+            Settings settings;
+            Storage storage(ctx);
+            KeccakHelper helper;
+            helper.allow_symbolic_hashes = true;
+            Value k1 = exprvar(256, "key1"), k2 = exprvar(256, "key2");
+
+            // Mapping entries in slots 0 and 1: keccak(key . slot)
+            Value h1 = helper.apply(*ctx, concat(k1, Value(256, 0)), nullptr);
+            Value h2 = helper.apply(*ctx, concat(k2, Value(256, 1)), nullptr);
+            Value h3 = helper.apply(*ctx, concat(k2, Value(256, 0)), nullptr);
+            nb += _assert(not h1.eq(h2) and not h1.eq(h3), "Storage: symbolic hashes should be different variables");
+
+            storage.write(h1, Value(256, 0x11), settings);
+            storage.write(h2, Value(256, 0x22), settings);
+            storage.write(h1 + Value(256, 1), Value(256, 0x33), settings);
+            // Writes to other slots and other struct members don't alias
+            nb += _assert(storage.read(h1, &helper).as_uint() == 0x11, "Storage: failed to skip disjoint mapping slots");
+            nb += _assert(storage.read(h1).is_abstract(), "Storage: skipped writes without keccak helper");
+            // Same mapping slot with different keys might alias
+            storage.write(h3, Value(256, 0x44), settings);
+            Value res = storage.read(h1, &helper);
+            nb += _assert(res.is_abstract(), "Storage: skipped write that can alias");
+
+            // The most recent write takes precedence
+            Storage storage2(ctx);
+            Value x = exprvar(256, "x"), y = exprvar(256, "y");
+            storage2.write(Value(256, 5), Value(256, 1), settings);
+            storage2.write(x, Value(256, 2), settings);
+            storage2.write(y, Value(256, 3), settings);
+            ctx->set("x", Number(256, 5));
+            ctx->set("y", Number(256, 5));
+            nb += _assert(storage2.read(Value(256, 5)).as_number(*ctx).get_ucst() == 3, "Storage: wrong precedence of symbolic writes");
+            ctx->set("y", Number(256, 6));
+            nb += _assert(storage2.read(Value(256, 5)).as_number(*ctx).get_ucst() == 2, "Storage: wrong precedence of symbolic writes");
+            ctx->set("x", Number(256, 6));
+            nb += _assert(storage2.read(Value(256, 5)).as_number(*ctx).get_ucst() == 1, "Storage: wrong precedence of symbolic writes");
+            return nb;
+        }
+
         unsigned int test_keccak(MaatEngine& engine)
         {
             unsigned int nb = 0;
@@ -993,6 +1036,7 @@ void test_archEVM()
     total += test_sload(engine);
     total += test_sstore(engine);
     total += test_keccak_helper();
+    total += test_storage_symbolic_keys();
     total += test_keccak(engine);
     total += test_env_snapshots();
 
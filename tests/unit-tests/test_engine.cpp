@@ -0,0 +1,118 @@
+#include "maat/engine.hpp"
+#include "maat/ir.hpp"
+#include "maat/stats.hpp"
+#include "maat/varcontext.hpp"
+#include <thread>
+#include <vector>
+
+namespace test
+{
+namespace engine
+{
+
+    using namespace maat;
+
+    unsigned int _assert(bool val, const std::string& msg)
+    {
+        if( !val)
+        {
+            std::cout << "\nFail: " << msg << std::endl;
+            throw test_exception();
+        }
+        return 1;
+    }
+
+    // Program that adds register 1 to register 0 and stores the
+    // result at the address in register 2, 'nb_insts' times
+    void add_sum_program(MaatEngine& engine, addr_t addr, int nb_insts)
+    {
+        for (int i = 0; i < nb_insts; i++)
+        {
+            ir::AsmInst asm_inst(addr+i, 1);
+            asm_inst.add_inst(ir::Inst(ir::Op::INT_ADD, ir::Reg(0, 31, 0), ir::Reg(0, 31, 0), ir::Reg(1, 31, 0)));
+            asm_inst.add_inst(ir::Inst(ir::Op::STORE, ir::Param::None(), ir::Param::None(), ir::Reg(2, 31, 0), ir::Reg(0, 31, 0)));
+            asm_inst.add_inst(ir::Inst(ir::Op::INT_ADD, ir::Reg(2, 31, 0), ir::Reg(2, 31, 0), ir::Cst(4, 31, 0)));
+            ir::get_ir_map(engine.mem->uid()).add(asm_inst);
+        }
+    }
+
+    unsigned int concurrent_run()
+    {
+        unsigned int nb = 0;
+        const int nb_engines = 2;
+        const int nb_insts = 0x40;
+        const int nb_runs = 50;
+        std::vector<std::unique_ptr<MaatEngine>> engines;
+        std::vector<std::string> var_names;
+        std::vector<int> ok(nb_engines, 1);
+
+        for (int i = 0; i < nb_engines; i++)
+        {
+            engines.push_back(std::make_unique<MaatEngine>(Arch::Type::NONE));
+            MaatEngine& engine = *engines.back();
+            engine.mem->map(0x0, 0xfff);
+            engine.mem->map(0x10000, 0x10fff);
+            add_sum_program(engine, 0x0, nb_insts);
+            var_names.push_back("inc" + std::to_string(i));
+            engine.vars->set(var_names.back(), i+1);
+        }
+
+        // Each engine runs the program several times with a symbolic increment
+        auto run_engine = [&](int i)
+        {
+            MaatEngine& engine = *engines[i];
+            Expr inc = exprvar(32, var_names[i]);
+            for (int run = 0; run < nb_runs; run++)
+            {
+                engine.cpu.ctx().set(0, exprcst(32, run));
+                engine.cpu.ctx().set(1, inc);
+                engine.cpu.ctx().set(2, exprcst(32, 0x10000));
+                if (engine.run_from(0x0, nb_insts) != info::Stop::INST_COUNT)
+                    ok[i] = 0;
+                ucst_t expected = run + nb_insts*(i+1);
+                if (engine.cpu.ctx().get(0).as_uint(*engine.vars) != expected
+                    or engine.mem->read(0x10000 + (nb_insts-1)*4, 4).as_uint(*engine.vars) != expected
+                )
+                    ok[i] = 0;
+            }
+        };
+
+        unsigned int executed_insts = MaatStats::instance().executed_insts();
+        std::vector<std::thread> threads;
+        for (int i = 0; i < nb_engines; i++)
+            threads.emplace_back(run_engine, i);
+        for (auto& thread : threads)
+            thread.join();
+
+        for (int i = 0; i < nb_engines; i++)
+            nb += _assert(ok[i], "MaatEngine: wrong result when running engines concurrently");
+        nb += _assert(
+            MaatStats::instance().executed_insts() - executed_insts == nb_engines*nb_runs*nb_insts,
+            "MaatStats: lost updates when running engines concurrently"
+        );
+
+        return nb;
+    }
+
+} // namespace engine
+} // namespace test
+
+using namespace test::engine;
+
+// All unit tests
+void test_engine()
+{
+    unsigned int total = 0;
+    std::string green = "\033[1;32m";
+    std::string def = "\033[0m";
+    std::string bold = "\033[1m";
+
+    std::cout   << bold << "[" << green << "+"
+                << def << bold << "]" << def
+                << " Testing engine... " << std::flush;
+
+    total += concurrent_run();
+
+    std::cout   << "\t\t" << total << "/" << total << green << "\t\tOK"
+                << def << std::endl;
+}
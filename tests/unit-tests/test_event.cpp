@@ -307,6 +307,64 @@ ir::get_ir_map(engine.mem->uid()).add(asm_inst);
         return nb;
     }
 
+    unsigned int exec_event_many_filters(MaatEngine& engine)
+    {
+        unsigned int nb = 0;
+        ir::AsmInst asm_inst;
+        std::vector<int> triggered;
+
+        ADD_ASM_INST(0x500, ir::Inst(ir::Op::COPY, ir::Reg(0, 31, 0), ir::Cst(10, 31, 0)))
+        ADD_ASM_INST(0x501, ir::Inst(ir::Op::COPY, ir::Reg(1, 31, 0), ir::Cst(11, 31, 0)))
+        ADD_ASM_INST(0x502, ir::Inst(ir::Op::COPY, ir::Reg(2, 31, 0), ir::Cst(12, 31, 0)))
+        ADD_ASM_INST(0x503, ir::Inst(ir::Op::COPY, ir::Reg(3, 31, 0), ir::Cst(13, 31, 0)))
+
+        auto record = [](MaatEngine& engine, void* data)
+        {
+            std::vector<int>* triggered = (std::vector<int>*)data;
+            triggered->push_back(engine.info.addr.value());
+            return Action::CONTINUE;
+        };
+
+        engine.hooks.disable_all();
+        // Unfiltered hook, must be triggered first on every instruction
+        engine.hooks.add(Event::EXEC, When::BEFORE, EventCallback(record, &triggered), "", AddrFilter(), "many_filters");
+        // Lots of hooks on addresses that are never executed
+        for (addr_t addr = 0x10000; addr < 0x12000; addr += 4)
+        {
+            engine.hooks.add(Event::EXEC, When::BEFORE, EventCallback(record, &triggered), "", AddrFilter(addr), "many_filters");
+            engine.hooks.add(Event::EXEC, When::BEFORE, EventCallback(record, &triggered), "", AddrFilter(addr, addr+2), "many_filters");
+        }
+        // Hooks that are triggered
+        engine.hooks.add(Event::EXEC, When::BEFORE, EventCallback(record, &triggered), "", AddrFilter(0x502), "many_filters");
+        engine.hooks.add(Event::EXEC, When::BEFORE, EventCallback(record, &triggered), "", AddrFilter(0x400, 0x501), "many_filters");
+        engine.hooks.add(Event::EXEC, When::BEFORE, EventCallback(record, &triggered), "", AddrFilter(0x501, 0x502), "many_filters");
+        engine.hooks.add(Event::EXEC, When::BEFORE, EventCallback(record, &triggered), "", AddrFilter(0x0, 0xffffffff), "many_filters");
+        engine.hooks.add(Event::EXEC, When::BEFORE, "halt_0x503", AddrFilter(0x503), "many_filters");
+
+        engine.run_from(0x500);
+        nb += _assert(engine.info.stop == info::Stop::HOOK, "MaatEngine: event hook failed");
+        nb += _assert(engine.cpu.ctx().get(engine.arch->pc()).as_uint() == 0x503, "MaatEngine: event hook failed");
+        std::vector<int> expected = {
+            0x500, 0x500, 0x500,
+            0x501, 0x501, 0x501, 0x501,
+            0x502, 0x502, 0x502, 0x502,
+            0x503, 0x503
+        };
+        nb += _assert(triggered == expected, "MaatEngine: event hook failed");
+
+        // Disabled indexed hooks are not triggered
+        triggered.clear();
+        engine.hooks.disable_group("many_filters");
+        engine.hooks.enable("halt_0x503");
+        engine.run_from(0x500);
+        nb += _assert(engine.info.stop == info::Stop::HOOK, "MaatEngine: event hook failed");
+        nb += _assert(engine.cpu.ctx().get(engine.arch->pc()).as_uint() == 0x503, "MaatEngine: event hook failed");
+        nb += _assert(triggered.empty(), "MaatEngine: event hook failed");
+
+        engine.hooks.disable_all();
+        return nb;
+    }
+
     unsigned int branch_events(MaatEngine& engine)
     {
         unsigned int nb = 0;
@@ -482,6 +540,65 @@ ir::get_ir_map(engine.mem->uid()).add(asm_inst);
         return nb;
     }
 
+    unsigned int batched_events(MaatEngine& engine)
+    {
+        unsigned int nb = 0;
+        ir::AsmInst asm_inst;
+        std::vector<std::vector<addr_t>> batches;
+        std::vector<addr_t> triggered;
+
+        ADD_ASM_INST(0x600, ir::Inst(ir::Op::COPY, ir::Reg(0, 31, 0), ir::Cst(10, 31, 0)))
+        ADD_ASM_INST(0x601, ir::Inst(ir::Op::COPY, ir::Reg(1, 31, 0), ir::Reg(4, 31, 0)))
+        ADD_ASM_INST(0x602, ir::Inst(ir::Op::COPY, ir::Reg(2, 31, 0), ir::Cst(12, 31, 0)))
+        ADD_ASM_INST(0x603, ir::Inst(ir::Op::COPY, ir::Reg(0, 31, 0), ir::Cst(13, 31, 0)))
+        ADD_ASM_INST(0x604, ir::Inst(ir::Op::COPY, ir::Reg(1, 31, 0), ir::Cst(14, 31, 0)))
+        ADD_ASM_INST(0x605, ir::Inst(ir::Op::COPY, ir::Reg(0, 31, 0), ir::Cst(15, 31, 0)))
+
+        engine.cpu.ctx().set(4, exprvar(32, "batch_var"));
+
+        auto record_batch = [](MaatEngine& engine, const event_batch_t& batch, void* data)
+        {
+            std::vector<std::vector<addr_t>>* batches = (std::vector<std::vector<addr_t>>*)data;
+            std::vector<addr_t> addrs;
+            for (const info::Info& i : batch)
+                addrs.push_back(i.addr.value());
+            batches->push_back(addrs);
+            return Action::CONTINUE;
+        };
+
+        // Batches of 4 register writes on registers 0 and 1 only. Remaining
+        // events are passed to the callback when the engine stops
+        engine.hooks.disable_all();
+        EventManager::hook_t hook = engine.hooks.add(
+            Event::REG_W, When::AFTER, EventCallback(record_batch, &batches), "batch"
+        );
+        hook->set_reg_filter({0, 1});
+        hook->set_batch_size(4);
+        engine.run_from(0x600, 6);
+        nb += _assert(engine.info.stop == info::Stop::INST_COUNT, "MaatEngine: batched event hook failed");
+        nb += _assert(hook->pending_events().empty(), "MaatEngine: batched event hook failed");
+        std::vector<std::vector<addr_t>> expected = {
+            {0x600, 0x601, 0x603, 0x604},
+            {0x605}
+        };
+        nb += _assert(batches == expected, "MaatEngine: batched event hook failed");
+
+        // Only trigger on abstract values
+        auto record = [](MaatEngine& engine, void* data)
+        {
+            std::vector<addr_t>* triggered = (std::vector<addr_t>*)data;
+            triggered->push_back(engine.info.addr.value());
+            return Action::CONTINUE;
+        };
+        engine.hooks.disable_all();
+        hook = engine.hooks.add(Event::REG_W, When::AFTER, EventCallback(record, &triggered), "abstract");
+        hook->set_value_filter(ValueFilter::ABSTRACT);
+        engine.run_from(0x600, 6);
+        nb += _assert(triggered == std::vector<addr_t>{0x601}, "MaatEngine: event value filter failed");
+
+        engine.hooks.disable_all();
+        return nb;
+    }
 
 } // namespace events
 } // namespace test
@@ -511,8 +628,10 @@ void test_events()
     total += reg_events(engine);
     total += mem_events(engine);
     total += exec_event(engine);
+    total += exec_event_many_filters(engine);
     total += branch_events(engine);
     total += path_event(engine);
+    total += batched_events(engine);
 
     std::cout   << "\t\t" << total << "/" << total << green << "\t\tOK" 
                 << def << std::endl;
@@ -2,6 +2,8 @@
 #include "maat/varcontext.hpp"
 #include "maat/exception.hpp"
 #include "maat/constraint.hpp"
+#include "maat/path.hpp"
+#include "maat/batch_eval.hpp"
 #include <iostream>
 #include <string>
 #include <sstream>
@@ -372,6 +374,120 @@ namespace test
             return 1; 
         }
 
+        unsigned int number_copies()
+        {
+            unsigned int nb = 0;
+            Number  n1(128, "123456789abcdef0123456789abcdef", 16),
+                    n2(n1),
+                    n3(32, 0x1234);
+
+            // Copies of big numbers don't share their value
+            n2.set_add(n2, Number(128, 1));
+            nb += _assert(n1.equal_to(Number(128, "123456789abcdef0123456789abcdef", 16)), "Number: copy modified original");
+            nb += _assert(n2.equal_to(Number(128, "123456789abcdef0123456789abcdf0", 16)), "Number: wrong addition");
+
+            // Assign small and big numbers to each other
+            n2 = n3;
+            nb += _assert(n2.size == 32 and n2.get_ucst() == 0x1234, "Number: wrong assignment");
+            n2 = n1;
+            nb += _assert(n2.equal_to(n1), "Number: wrong assignment");
+            n3 = std::move(n2);
+            nb += _assert(n3.equal_to(n1), "Number: wrong move assignment");
+            Number n4(256);
+            nb += _assert(n4.is_null(), "Number: big number not initialized to zero");
+            n4 = Number(256);
+            nb += _assert(n4.is_null(), "Number: big number not initialized to zero");
+            return nb;
+        }
+
+        unsigned int wide_numbers()
+        {
+            unsigned int nb = 0;
+            uint64_t seed = 0x123456789;
+            auto rand64 = [&seed](){
+                seed = seed * 6364136223846793005ULL + 1442695040888963407ULL;
+                return seed ^ (seed >> 29);
+            };
+            // Compare wide Number operations against GMP results
+            for (size_t size : {65, 128, 200, 256, 320})
+            {
+                mpz_class mod = mpz_class(1) << size;
+                auto to_signed = [&](const mpz_class& v){
+                    return mpz_tstbit(v.get_mpz_t(), size-1) ? mpz_class(v - mod) : v;
+                };
+                auto check = [&](const Number& res, const mpz_class& expected, const std::string& op){
+                    mpz_class tmp;
+                    mpz_fdiv_r_2exp(tmp.get_mpz_t(), expected.get_mpz_t(), size);
+                    return _assert(res.size == size and res.get_mpz() == tmp, "Number: wrong wide " + op);
+                };
+                for (int i = 0; i < 50; i++)
+                {
+                    std::stringstream ss1, ss2;
+                    for (int j = 0; j < 5; j++)
+                    {
+                        ss1 << std::hex << std::setw(16) << std::setfill('0') << rand64();
+                        ss2 << std::hex << std::setw(16) << std::setfill('0') << rand64();
+                    }
+                    Number n1(size, ss1.str(), 16), n2(size, ss2.str(), 16), n3(size);
+                    // Make small and negative divisors frequent
+                    if (i % 4 == 1)
+                        n2.set_mpz(rand64() % 1000 + 1);
+                    else if (i % 4 == 2)
+                        n2.set_neg(n2);
+                    mpz_class a = n1.get_mpz(), b = n2.get_mpz(), r;
+
+                    n3.set_add(n1, n2); nb += check(n3, a+b, "add");
+                    n3.set_sub(n1, n2); nb += check(n3, a-b, "sub");
+                    n3.set_mul(n1, n2); nb += check(n3, a*b, "mul");
+                    n3.set_and(n1, n2); nb += check(n3, a&b, "and");
+                    n3.set_xor(n1, n2); nb += check(n3, a^b, "xor");
+                    n3.set_neg(n1); nb += check(n3, -a, "neg");
+                    n3.set_div(n1, n2); nb += check(n3, a/b, "div");
+                    n3.set_rem(n1, n2); nb += check(n3, a%b, "rem");
+                    mpz_tdiv_q(r.get_mpz_t(), to_signed(a).get_mpz_t(), to_signed(b).get_mpz_t());
+                    n3.set_sdiv(n1, n2); nb += check(n3, r, "sdiv");
+                    mpz_tdiv_r(r.get_mpz_t(), to_signed(a).get_mpz_t(), to_signed(b).get_mpz_t());
+                    n3.set_srem(n1, n2); nb += check(n3, r, "srem");
+                    nb += _assert(n1.less_than(n2) == (a < b), "Number: wrong wide less_than");
+                    nb += _assert(n1.sless_than(n2) == (to_signed(a) < to_signed(b)), "Number: wrong wide sless_than");
+
+                    unsigned int shift = rand64() % size;
+                    Number n_shift(size, shift);
+                    n3.set_shl(n1, n_shift); nb += check(n3, a << shift, "shl");
+                    n3.set_shr(n1, n_shift); nb += check(n3, a >> shift, "shr");
+                    mpz_fdiv_q_2exp(r.get_mpz_t(), to_signed(a).get_mpz_t(), shift);
+                    n3.set_sar(n1, n_shift); nb += check(n3, r, "sar");
+
+                    mpz_powm(r.get_mpz_t(), a.get_mpz_t(), mpz_class(shift).get_mpz_t(), mod.get_mpz_t());
+                    n3.set_exp(n1, n_shift); nb += check(n3, r, "exp");
+
+                    n3.set_extract(n1, size-1, shift);
+                    nb += _assert(n3.size == size-shift and n3.get_mpz() == (a >> shift), "Number: wrong wide extract");
+                    n3.set_sext(size+40, n1);
+                    nb += _assert(n3.get_mpz() == (to_signed(a) < 0 ? a + (((mpz_class(1) << 40)-1) << size) : a), "Number: wrong wide sext");
+                }
+            }
+
+            // Shifting by the size or more
+            Number n1(256, "-1", 10), n2(256, 256), n3;
+            n3.set_sar(n1, n2);
+            nb += _assert(n3.equal_to(n1), "Number: wrong wide sar");
+            n3.set_shl(n1, n2);
+            nb += _assert(n3.is_null(), "Number: wrong wide shl");
+
+            // Division by zero
+            try
+            {
+                n3.set_div(n1, Number(256, 0));
+                nb += _assert(false, "Number: wide division by zero didn't raise an exception");
+            }
+            catch (const expression_exception& e)
+            {
+                nb++;
+            }
+            return nb;
+        }
+
         unsigned int big_numbers()
         {
             unsigned int nb = 0;
@@ -486,26 +602,29 @@ namespace test
             vs2.set_cst(0x00123456);
             vs3.set_or(vs1, vs2);
             nb += _assert( vs3.min == 0xab123456, "Wrong strided interval computation"); 
-            nb += _assert( vs3.max == 0xffffffff, "Wrong strided interval computation"); 
-            nb += _assert( vs3.stride == 1, "Wrong strided interval computation"); 
+            nb += _assert( vs3.max == 0xfffffffe, "Wrong strided interval computation"); 
+            nb += _assert( vs3.stride == 8, "Wrong strided interval computation"); 
             
             vs1 = ValueSet(64, 0x1200000034000000, 0xff000000350000ff, 8);
             vs2 = ValueSet(64, 0x1234, 0xffff, 8);
+            vs3 = ValueSet(64);
             vs3.set_or(vs1, vs2);
             nb += _assert( vs3.min == 0x1200000034001234, "Wrong strided interval computation"); 
-            nb += _assert( vs3.max == 0xff0000003500ffff, "Wrong strided interval computation"); 
-            nb += _assert( vs3.stride == 1, "Wrong strided interval computation"); 
+            nb += _assert( vs3.max == 0xff0000003500fffc, "Wrong strided interval computation"); 
+            nb += _assert( vs3.stride == 8, "Wrong strided interval computation"); 
 
             // Xor
             vs1 = ValueSet(64, 0x1200000034000000, 0xff000000350000ff, 8);
             vs2 = ValueSet(64, 0x1234, 0xffff, 8);
+            vs3 = ValueSet(64);
             vs3.set_xor(vs1, vs2);
-            nb += _assert( vs3.min == 0x1200000034000000, "Wrong strided interval computation"); 
-            nb += _assert( vs3.max == 0xff0000003500ffff, "Wrong strided interval computation"); 
-            nb += _assert( vs3.stride == 1, "Wrong strided interval computation"); 
+            nb += _assert( vs3.min == 0x1200000034000004, "Wrong strided interval computation"); 
+            nb += _assert( vs3.max == 0xff0000003500fffc, "Wrong strided interval computation"); 
+            nb += _assert( vs3.stride == 8, "Wrong strided interval computation"); 
 
             // Add
             // Add Without overflow
+            vs3 = ValueSet(32);
             vs1 = ValueSet(32, 0x300, 0x400, 4);
             vs2 = ValueSet(32, 0x1000, 0x2004, 6);
             vs3.set_add(vs1, vs2);
@@ -519,8 +638,8 @@ namespace test
             vs2 = ValueSet(32, 0x1000, 0x0000f000, 6);
             vs3.set_add(vs1, vs2);
             nb += _assert( vs3.min == 0, "Wrong strided interval computation"); 
-            nb += _assert( vs3.max == 0xffffffff, "Wrong strided interval computation"); 
-            nb += _assert( vs3.stride == 1, "Wrong strided interval computation");
+            nb += _assert( vs3.max == 0xfffffffe, "Wrong strided interval computation"); 
+            nb += _assert( vs3.stride == 2, "Wrong strided interval computation");
 
             // Add With both bounds overflow
             vs1 = ValueSet(32, 0xffff1100, 0xffff11ff, 1);
@@ -559,8 +678,8 @@ namespace test
             vs3 = ValueSet(32);
             vs3.set_shl(vs1, vs2);
             nb += _assert( vs3.min == 0, "Wrong strided interval computation"); 
-            nb += _assert( vs3.max == 0xfffffffe, "Wrong strided interval computation"); 
-            nb += _assert( vs3.stride == 1, "Wrong strided interval computation");
+            nb += _assert( vs3.max == 0xffe1fffc, "Wrong strided interval computation"); 
+            nb += _assert( vs3.stride == 4, "Wrong strided interval computation");
 
             // Shl 32 bits with no bits shifted out
             vs1 = ValueSet(32, 0x00800000, 0x00800008, 2);
@@ -569,7 +688,7 @@ namespace test
             vs3.set_shl(vs1, vs2);
             nb += _assert( vs3.min == 0x01000000, "Wrong strided interval computation"); 
             nb += _assert( vs3.max == 0x08000080, "Wrong strided interval computation"); 
-            nb += _assert( vs3.stride == 1, "Wrong strided interval computation");
+            nb += _assert( vs3.stride == 4, "Wrong strided interval computation");
 
             // Shl 32 bits with constant shift
             vs1 = ValueSet(32, 0x00800000, 0x00800008, 2);
@@ -605,7 +724,7 @@ namespace test
             vs2.set_cst(0x4);
             vs3 = ValueSet(64);
             vs3.set_sar(vs1, vs2);
-            nb += _assert( vs3.min == 0x0f00000000000000, "Wrong strided interval computation"); 
+            nb += _assert( vs3.min == 0xff00000000000000, "Wrong strided interval computation"); 
             nb += _assert( vs3.max == 0xfff0000000000000, "Wrong strided interval computation"); 
             nb += _assert( vs3.stride == 0x200, "Wrong strided interval computation");
 
@@ -634,7 +753,7 @@ namespace test
             vs3.set_mul(vs1, vs2);
             nb += _assert( vs3.min == 0x00242424, "Wrong strided interval computation"); 
             nb += _assert( vs3.max == 0x006c6c6c, "Wrong strided interval computation"); 
-            nb += _assert( vs3.stride == 1, "Wrong strided interval computation");
+            nb += _assert( vs3.stride == 2, "Wrong strided interval computation");
 
             // Mul on 32 bits with overflow
             vs1 = ValueSet(32, 0x00121212, 0x00242424, 2);
@@ -642,8 +761,8 @@ namespace test
             vs3 = ValueSet(32);
             vs3.set_mul(vs1, vs2);
             nb += _assert( vs3.min == 0, "Wrong strided interval computation"); 
-            nb += _assert( vs3.max == 0xffffffff, "Wrong strided interval computation"); 
-            nb += _assert( vs3.stride == 1, "Wrong strided interval computation");
+            nb += _assert( vs3.max == 0xfffffffe, "Wrong strided interval computation"); 
+            nb += _assert( vs3.stride == 2, "Wrong strided interval computation");
             
             // Mul on 32 bits with constant
             vs1 = ValueSet(32, 0x00121212, 0x00242424, 2);
@@ -661,7 +780,7 @@ namespace test
             vs3.set_mul(vs1, vs2);
             nb += _assert( vs3.min == 0x0024242400000000, "Wrong strided interval computation"); 
             nb += _assert( vs3.max == 0x006c6c6c00000000, "Wrong strided interval computation"); 
-            nb += _assert( vs3.stride == 1, "Wrong strided interval computation");
+            nb += _assert( vs3.stride == 0x2000, "Wrong strided interval computation");
 
             // Mul on 64 bits with overflow
             vs1 = ValueSet(64, 0x0012121200000000, 0x0024242400000000, 2);
@@ -669,8 +788,8 @@ namespace test
             vs3 = ValueSet(64);
             vs3.set_mul(vs1, vs2);
             nb += _assert( vs3.min == 0, "Wrong strided interval computation"); 
-            nb += _assert( vs3.max == 0xffffffffffffffff, "Wrong strided interval computation"); 
-            nb += _assert( vs3.stride == 1, "Wrong strided interval computation");
+            nb += _assert( vs3.max == 0xfffffffffffffffe, "Wrong strided interval computation"); 
+            nb += _assert( vs3.stride == 2, "Wrong strided interval computation");
             
             // Mul on 64 bits with constant
             vs1 = ValueSet(64, 0x0012121200000000, 0x0024242400000000, 0x2000);
@@ -761,8 +880,300 @@ namespace test
             // And
             nb += _assert( e2->value_set().min == 0, "Wrong value set for expression"); 
             nb += _assert( e2->value_set().max == 0x0000ffffffff0000, "Wrong value set for expression"); 
-            nb += _assert( e2->value_set().stride == 1, "Wrong value set for expression");
+            nb += _assert( e2->value_set().stride == 0x10000, "Wrong value set for expression");
+
+            return nb;
+        }
 
+        bool _in_value_set(ValueSet& vs, ucst_t val)
+        {
+            return vs.contains(val)
+                and (val & vs.known_zeros) == 0
+                and (val & vs.known_ones) == vs.known_ones;
+        }
+
+        Expr _random_vs_expr(ucst_t& seed, int depth)
+        {
+            seed = seed*6364136223846793005ULL + 1442695040888963407ULL;
+            ucst_t r = seed >> 33;
+            if (depth == 0 or r%5 == 0)
+            {
+                if (r%3 == 0)
+                    return exprcst(32, (cst_t)(seed >> 13));
+                return exprvar(32, std::string("vs_var") + std::to_string(r%3));
+            }
+            Expr a = _random_vs_expr(seed, depth-1);
+            Expr b = _random_vs_expr(seed, depth-1);
+            switch ((r>>4)%12)
+            {
+                case 0: return a + b;
+                case 1: return a * b;
+                case 2: return a & exprcst(32, (cst_t)(seed >> 20));
+                case 3: return a | b;
+                case 4: return a ^ b;
+                case 5: return shl(a, exprcst(32, r%40));
+                case 6: return shr(a, b & exprcst(32, 0x7));
+                case 7: return sar(a, exprcst(32, r%40));
+                case 8: return -a;
+                case 9: return ~b;
+                case 10: return concat(extract(a, 31, 16), extract(b, 15, 0));
+                default: return ITE(a, ITECond::LT, b, a, b);
+            }
+        }
+
+        unsigned int known_bits()
+        {
+            unsigned int nb = 0;
+            Expr    v1 = exprvar(64, "var1"),
+                    v2 = exprvar(32, "var2"),
+                    e1 = (v1 & exprcst(64, 0xfffffffffffffff0)) + exprcst(64, 0x1008),
+                    e2 = shl(v2 & exprcst(32, 0xff), exprcst(32, 3)),
+                    e3 = concat(exprcst(32, 0x1234), extract(v2, 7, 0)),
+                    e4 = (v2 & exprcst(32, 0xfff0)) | exprcst(32, 0x10000);
+
+            // Aligned pointer
+            nb += _assert( e1->value_set().stride == 0x10, "Wrong known bits for expression");
+            nb += _assert( e1->value_set().known_zeros == 0x7, "Wrong known bits for expression");
+            nb += _assert( e1->value_set().known_ones == 0x8, "Wrong known bits for expression");
+            // Masked index
+            nb += _assert( e2->value_set().min == 0, "Wrong known bits for expression");
+            nb += _assert( e2->value_set().max == 0x7f8, "Wrong known bits for expression");
+            nb += _assert( e2->value_set().stride == 8, "Wrong known bits for expression");
+            // Extract and concat
+            nb += _assert( e3->value_set().min == 0x123400, "Wrong known bits for expression");
+            nb += _assert( e3->value_set().max == 0x1234ff, "Wrong known bits for expression");
+            // Or with disjoint constant
+            nb += _assert( e4->value_set().min == 0x10000, "Wrong known bits for expression");
+            nb += _assert( e4->value_set().max == 0x1fff0, "Wrong known bits for expression");
+            nb += _assert( e4->value_set().stride == 0x10, "Wrong known bits for expression");
+
+            // Value sets must contain all possible values
+            ucst_t seed = 0xdeadbeef;
+            for (int i = 0; i < 300; i++)
+            {
+                Expr e = _random_vs_expr(seed, 4);
+                for (int j = 0; j < 10; j++)
+                {
+                    VarContext ctx;
+                    for (int k = 0; k < 3; k++)
+                    {
+                        seed = seed*6364136223846793005ULL + 1442695040888963407ULL;
+                        // Use small values often to trigger edge cases
+                        cst_t val = (seed >> 60) < 4 ? (cst_t)(seed >> 62) : (cst_t)(seed >> 16);
+                        ctx.set(std::string("vs_var") + std::to_string(k), val);
+                    }
+                    nb += _assert(
+                        _in_value_set(e->value_set(), e->as_uint(ctx)),
+                        "Value set doesn't contain expression value"
+                    );
+                }
+            }
+            return nb;
+        }
+
+        unsigned int path_constraints()
+        {
+            unsigned int nb = 0;
+            PathManager path;
+            Expr    v1 = exprvar(32, "var1"),
+                    v2 = exprvar(32, "var2"),
+                    v3 = exprvar(32, "var3");
+
+            // Tautologies are ignored
+            path.add(v1 == v1);
+            path.add(ULE(v2, v2));
+            path.add(exprcst(32, 1) == exprcst(32, 1));
+            path.add(exprcst(32, -1) < exprcst(32, 2));
+            path.add((v1 != v2) || (v3 == v3));
+            nb += _assert(path.constraints().empty(), "PathManager: recorded constraint that is always true");
+            path.add(v1 != v1);
+            path.add(ULT(exprcst(32, -1), exprcst(32, 2)));
+            nb += _assert(path.constraints().size() == 2, "PathManager: dropped constraint that is always false");
+
+            // Duplicates are ignored
+            path = PathManager();
+            path.add(v1 == v2);
+            path.add(v1 == v2);
+            path.add(v1 == (v2+1));
+            nb += _assert(path.constraints().size() == 2, "PathManager: recorded duplicate constraint");
+            PathManager::path_snapshot_t snap = path.take_snapshot();
+            path.add(v2 < v3);
+            path.add(v2 < v3);
+            nb += _assert(path.constraints().size() == 3, "PathManager: recorded duplicate constraint");
+            path.restore_snapshot(snap);
+            nb += _assert(path.constraints().size() == 2, "PathManager: failed to restore snapshot");
+            path.add(v2 < v3);
+            nb += _assert(path.constraints().size() == 3, "PathManager: constraint ignored after restoring snapshot");
+
+            // Related constraints
+            path.add(exprvar(32, "var4") != 0);
+            nb += _assert(path.get_related_constraints(v1 == 1).size() == 3, "PathManager: wrong related constraints");
+            nb += _assert(path.get_related_constraints(v3).size() == 3, "PathManager: wrong related constraints");
+            nb += _assert(path.get_related_constraints(exprvar(32, "var4")).size() == 1, "PathManager: wrong related constraints");
+            nb += _assert(path.get_related_constraints(exprvar(32, "var5")).empty(), "PathManager: wrong related constraints");
+
+            return nb;
+        }
+
+        unsigned int var_ids()
+        {
+            unsigned int nb = 0;
+            Expr    v1 = exprvar(32, "var_id_a"),
+                    v2 = exprvar(32, "var_id_b");
+            var_id_t id1 = std::static_pointer_cast<ExprVar>(v1)->id(),
+                     id2 = std::static_pointer_cast<ExprVar>(v2)->id();
+            nb += _assert(id1 != id2, "VarTable: different variables have the same ID");
+            nb += _assert(VarTable::id("var_id_a") == id1, "VarTable: variable ID changed");
+            nb += _assert(VarTable::name(id2) == "var_id_b", "VarTable: wrong variable name");
+            nb += _assert(not VarTable::find("var_id_never_used").has_value(), "VarTable: found unknown variable");
+
+            // Sets with IDs far apart
+            VarSet s1, s2;
+            s1.insert(id1);
+            s1.insert(id1 + 1000);
+            s2.insert(id2);
+            nb += _assert(s1.contains(id1 + 1000), "VarSet: missing variable");
+            nb += _assert(not s1.contains(id1 + 500), "VarSet: wrong variable");
+            nb += _assert(not s1.intersects(s2), "VarSet: wrong intersection");
+            s2.insert(id1 + 1000);
+            nb += _assert(s1.intersects(s2), "VarSet: wrong intersection");
+            VarSet s3;
+            (v1 + v2)->get_vars(s3);
+            nb += _assert(s3.names() == std::set<std::string>{"var_id_a", "var_id_b"}, "VarSet: wrong variables");
+
+            // Context accessed by ID
+            VarContext ctx;
+            ctx.set(id1, Number(32, 10));
+            nb += _assert(ctx.contains("var_id_a"), "VarContext: missing variable");
+            nb += _assert(ctx.get("var_id_a") == 10, "VarContext: wrong value");
+            nb += _assert(not ctx.contains(id2), "VarContext: wrong variable");
+            nb += _assert(v1->as_uint(ctx) == 10, "VarContext: wrong concretization");
+            ctx.remove(id1);
+            nb += _assert(v1->is_symbolic(ctx), "VarContext: variable not removed");
+            return nb;
+        }
+
+        unsigned int var_versions()
+        {
+            unsigned int nb = 0;
+            Expr    v1 = exprvar(32, "var_version_a"),
+                    v2 = exprvar(32, "var_version_b"),
+                    e1 = v1 + 1,
+                    e2 = v2 * 2,
+                    e3 = e1 + e2;
+            VarContext ctx;
+            ctx.set("var_version_a", 1);
+            ctx.set("var_version_b", 2);
+            nb += _assert(e3->as_uint(ctx) == 6, "Wrong concretization");
+
+            // Changing a variable only changes the version of expressions using it
+            uint64_t version2 = ctx.version(e2->var_ids());
+            uint64_t version3 = ctx.version(e3->var_ids());
+            ctx.set("var_version_a", 5);
+            nb += _assert(ctx.version(e2->var_ids()) == version2, "VarContext: version changed for unmodified variable");
+            nb += _assert(ctx.version(e3->var_ids()) != version3, "VarContext: version didn't change for modified variable");
+            nb += _assert(e1->as_uint(ctx) == 6, "Wrong concretization after context update");
+            nb += _assert(e2->as_uint(ctx) == 4, "Wrong concretization after context update");
+            nb += _assert(e3->as_uint(ctx) == 10, "Wrong concretization after context update");
+
+            // Copies of the context don't share updates
+            VarContext ctx2 = ctx;
+            ctx2.set("var_version_b", 10);
+            nb += _assert(e3->as_uint(ctx2) == 26, "Wrong concretization in copied context");
+            nb += _assert(e3->as_uint(ctx) == 10, "Wrong concretization in original context");
+            nb += _assert(e1->as_uint(ctx2) == 6, "Wrong concretization in copied context");
+            ctx.update_from(ctx2);
+            nb += _assert(e3->as_uint(ctx) == 26, "Wrong concretization after update_from()");
+
+            // Removed variables
+            ctx.remove("var_version_a");
+            nb += _assert(e3->is_symbolic(ctx), "Wrong status after removing variable");
+            nb += _assert(e2->is_concolic(ctx), "Wrong status after removing variable");
+            nb += _assert(e2->as_uint(ctx) == 20, "Wrong concretization after removing variable");
+            ctx.set("var_version_a", 0);
+            nb += _assert(e3->is_concolic(ctx), "Wrong status after setting variable");
+            nb += _assert(e3->as_uint(ctx) == 21, "Wrong concretization after setting variable");
+            return nb;
+        }
+
+        unsigned int batch_evaluation()
+        {
+            unsigned int nb = 0;
+            Expr    v1 = exprvar(32, "batch_a"),
+                    v2 = exprvar(32, "batch_b"),
+                    v3 = exprvar(8, "batch_c"),
+                    v4 = exprvar(64, "batch_d"),
+                    shift = concat(exprcst(24, 0), v3);
+            std::vector<Expr> exprs = {
+                v1 + v2*3,
+                (v1 ^ ~v2) - v1,
+                -v1 & (v2 | 0xff00),
+                shl(v1, shift), shr(v2, shift), sar(v1, shift),
+                concat(v3, extract(v1, 23, 0)),
+                extract(v4, 63, 16) + extract(v4, 55, 8),
+                sdiv(v1, exprcst(32, -3)), smod(v1, exprcst(32, 7)), v2 / 13, v2 % 10,
+                ITE(v1, ITECond::SLT, v2, v3, v3 + 1),
+                ITE(v3, ITECond::LE, exprcst(8, 0x80), v4, v4*v4),
+                // Sub-expression bigger than 64 bits
+                extract(concat(v4, v1), 71, 8),
+            };
+            Constraint c1 = v1 < v2, c2 = ULT(v3, 0x10) || v1 == v2;
+
+            BatchEvaluator eval;
+            std::vector<size_t> idx;
+            for (auto& e : exprs)
+                idx.push_back(eval.add(e));
+            size_t c1_idx = eval.add(c1);
+            eval.add(c2);
+
+            std::vector<VarContext> ctxs;
+            ucst_t seed = 0x1234567;
+            for (int i = 0; i < 100; i++)
+            {
+                VarContext ctx;
+                seed = seed*6364136223846793005ULL + 1442695040888963407ULL;
+                ctx.set("batch_a", (int32_t)(seed >> 16));
+                ctx.set("batch_b", (int32_t)(seed >> 8));
+                ctx.set("batch_c", (cst_t)(seed >> 40) & 0x3f);
+                ctx.set("batch_d", (cst_t)seed);
+                ctxs.push_back(ctx);
+            }
+            eval.evaluate(ctxs);
+            nb += _assert(eval.nb_contexts() == ctxs.size(), "BatchEvaluator: wrong number of contexts");
+
+            std::vector<bool> sat = eval.satisfied();
+            for (int i = 0; i < ctxs.size(); i++)
+            {
+                for (int j = 0; j < exprs.size(); j++)
+                    nb += _assert(
+                        eval.get(idx[j], i) == exprs[j]->as_uint(ctxs[i]),
+                        "BatchEvaluator: wrong value for expression"
+                    );
+                bool c1_sat = v1->as_int(ctxs[i]) < v2->as_int(ctxs[i]);
+                bool c2_sat = v3->as_uint(ctxs[i]) < 0x10 or v1->as_uint(ctxs[i]) == v2->as_uint(ctxs[i]);
+                nb += _assert(eval.get(c1_idx, i) == c1_sat, "BatchEvaluator: wrong value for constraint");
+                nb += _assert(sat[i] == (c1_sat and c2_sat), "BatchEvaluator: wrong satisfied constraints");
+            }
+
+            // Division by zero doesn't raise errors
+            BatchEvaluator eval2;
+            eval2.add(v1 / v2);
+            eval2.add(v1 % v2);
+            VarContext ctx;
+            ctx.set("batch_a", 42);
+            ctx.set("batch_b", 0);
+            eval2.evaluate({ctx});
+            nb += _assert(eval2.get(0, 0) == 0xffffffff, "BatchEvaluator: wrong division by zero");
+            nb += _assert(eval2.get(1, 0) == 42, "BatchEvaluator: wrong remainder by zero");
+
+            // Missing variable
+            ctx.remove("batch_a");
+            try
+            {
+                eval2.evaluate({ctx});
+                nb += _assert(false, "BatchEvaluator: evaluated expression with missing variable");
+            }
+            catch (const expression_exception& e){}
             return nb;
         }
     } // namespace expression
@@ -786,10 +1197,17 @@ void test_expression()
     total += taint();
     total += concretization();
     total += floating_point();
+    total += number_copies();
+    total += wide_numbers();
     total += big_numbers();
     total += change_varctx();
     total += strided_interval();
     total += value_set();
+    total += known_bits();
+    total += path_constraints();
+    total += var_ids();
+    total += var_versions();
+    total += batch_evaluation();
 
     // Return res
     std::cout << "\t" << total << "/" << total << green << "\t\tOK" << def << std::endl;
@@ -1,4 +1,7 @@
 #include "maat/ir.hpp"
+#include "maat/cpu.hpp"
+#include "maat/varcontext.hpp"
+#include "maat/engine.hpp"
 #include "maat/exception.hpp"
 
 #include <cassert>
@@ -26,6 +29,125 @@ namespace test
             return 1; 
         }
 
+        unsigned int cpu_wide_registers()
+        {
+            unsigned int nb = 0;
+            ir::CPUContext ctx(4);
+            std::string hex = "";
+            for (int i = 0; i < 8; i++)
+                hex += "1111111122222222";
+            Value full(512, hex, 16), expected;
+
+            ctx.set(0, Value(64, 1));
+            ctx.set(1, full);
+            nb += _assert(not ctx.is_wide(0), "CPUContext: is_wide() failed");
+            nb += _assert(ctx.is_wide(1), "CPUContext: is_wide() failed");
+            nb += _assert(ctx.reg_size(1) == 512, "CPUContext: reg_size() failed");
+
+            // Partial reads
+            nb += _assert(ctx.get_bits(1, 31, 0).as_uint() == 0x22222222, "CPUContext: get_bits() failed");
+            nb += _assert(ctx.get_bits(1, 127, 64).as_uint() == 0x1111111122222222, "CPUContext: get_bits() failed");
+            nb += _assert(ctx.get_bits(1, 95, 32).as_uint() == 0x2222222211111111, "CPUContext: get_bits() failed");
+            nb += _assert(ctx.get_bits(1, 511, 0).eq(full), "CPUContext: get_bits() failed");
+            nb += _assert(ctx.get_bits(0, 7, 0).as_uint() == 1, "CPUContext: get_bits() failed");
+
+            // Partial writes
+            ir::CPUContext copy = ctx;
+            ctx.set_bits(1, 95, 32, Value(64, 0xaaaaaaaabbbbbbbb));
+            expected.set_overwrite(full, Value(64, 0xaaaaaaaabbbbbbbb), 32);
+            nb += _assert(ctx.get(1).eq(expected), "CPUContext: set_bits() failed");
+            nb += _assert(ctx.get_bits(1, 63, 0).as_uint() == 0xbbbbbbbb22222222, "CPUContext: set_bits() failed");
+            nb += _assert(copy.get(1).eq(full), "CPUContext: set_bits() modified a copy of the context");
+
+            ctx.set_bits(1, 191, 128, exprvar(64, "var0"));
+            nb += _assert(not ctx.get_bits(1, 127, 0).is_abstract(), "CPUContext: set_bits() failed");
+            nb += _assert(ctx.get_bits(1, 191, 128).as_expr()->eq(exprvar(64, "var0")), "CPUContext: set_bits() failed");
+            nb += _assert(ctx.get(1).is_abstract(), "CPUContext: set_bits() failed");
+            VarContext varctx(0);
+            varctx.set("var0", 0x1111111122222222);
+            nb += _assert(ctx.get(1).as_number(varctx).equal_to(expected.as_number()), "CPUContext: set_bits() failed");
+
+            ctx.set(1, full);
+            nb += _assert(ctx.get_bits(1, 191, 128).as_uint() == 0x1111111122222222, "CPUContext: set() after set_bits() failed");
+
+            ctx.set_bits(0, 15, 8, Value(8, 0xff));
+            nb += _assert(ctx.get(0).as_uint() == 0xff01, "CPUContext: set_bits() failed");
+
+            return nb;
+        }
+
+        unsigned int cpu_lazy_flags()
+        {
+            unsigned int nb = 0;
+            MaatEngine engine(Arch::Type::X86);
+            ir::CPUContext& ctx = engine.cpu.ctx();
+            Expr a = exprvar(32, "a"), b = exprvar(32, "b");
+            event::Action action = event::Action::CONTINUE;
+
+            // CF = INT_CARRY(EAX, EBX)
+            ir::Inst carry(ir::Op::INT_CARRY, ir::Reg(X86::CF, 8), ir::Reg(X86::EAX, 32), ir::Reg(X86::EBX, 32));
+            auto exec = [&](const ir::Inst& inst)
+            {
+                ir::ProcessedInst& pinst = engine.cpu.pre_process_inst(inst, action, engine);
+                engine.cpu.post_process_inst(inst, pinst);
+                engine.cpu.apply_semantics(inst, pinst, engine);
+            };
+
+            // Concrete operands are computed eagerly
+            ctx.set(X86::EAX, 0xffffffff);
+            ctx.set(X86::EBX, 1);
+            exec(carry);
+            nb += _assert(not ctx.is_lazy(X86::CF), "CPU: concrete flag shouldn't be lazy");
+            nb += _assert(ctx.get(X86::CF).as_uint() == 1, "CPU: wrong concrete flag value");
+
+            // Symbolic operands are computed when reading the flag
+            ctx.set(X86::EAX, a);
+            ctx.set(X86::EBX, b);
+            exec(carry);
+            nb += _assert(ctx.is_lazy(X86::CF), "CPU: symbolic flag should be lazy");
+            ir::CPUContext copy = ctx;
+            nb += _assert(not copy.is_lazy(X86::CF), "CPU: copy kept a lazy flag");
+            nb += _assert(ctx.is_lazy(X86::CF), "CPU: copying computed the lazy flag of the original");
+            engine.vars->set("a", 0xffffffff);
+            engine.vars->set("b", 2);
+            nb += _assert(ctx.get(X86::CF).as_uint(*engine.vars) == 1, "CPU: wrong lazy flag value");
+            nb += _assert(not ctx.is_lazy(X86::CF), "CPU: flag still lazy after being read");
+            nb += _assert(copy.get(X86::CF).as_uint(*engine.vars) == 1, "CPU: wrong lazy flag value in copy");
+            engine.vars->set("b", 0);
+            nb += _assert(ctx.get(X86::CF).as_uint(*engine.vars) == 0, "CPU: wrong lazy flag value");
+
+            // Overwriting a lazy flag discards it, reading EFLAGS computes it
+            exec(carry);
+            ctx.set(X86::CF, 1);
+            nb += _assert(not ctx.is_lazy(X86::CF), "CPU: overwritten flag still lazy");
+            nb += _assert((ctx.get(X86::EFLAGS).as_uint() & 1) == 1, "CPU: wrong EFLAGS value");
+            exec(carry);
+            engine.vars->set("b", 1);
+            nb += _assert((ctx.get(X86::EFLAGS).as_uint(*engine.vars) & 1) == 1, "CPU: wrong EFLAGS value");
+            nb += _assert(not ctx.is_lazy(X86::CF), "CPU: flag still lazy after reading EFLAGS");
+
+            // Shadow taint of concrete flags is kept in EFLAGS
+            Value tainted_flag(8, 1);
+            tainted_flag.set_shadow_taint(0xff);
+            ctx.set(X86::CF, 0);
+            ctx.set(X86::ZF, tainted_flag);
+            Value eflags = ctx.get(X86::EFLAGS);
+            nb += _assert(not eflags.is_abstract(), "CPU: concrete EFLAGS should be concrete");
+            nb += _assert(eflags.as_uint() == 0x42, "CPU: wrong EFLAGS value");
+            nb += _assert(eflags.shadow_taint() == 0x40, "CPU: EFLAGS lost the taint of ZF");
+            ctx.set(X86::ZF, 0);
+            nb += _assert(not ctx.get(X86::EFLAGS).is_tainted(), "CPU: untainted EFLAGS is tainted");
+
+            // Other registers and operations are never lazy
+            ir::Inst add(ir::Op::INT_ADD, ir::Reg(X86::ECX, 32), ir::Reg(X86::EAX, 32), ir::Reg(X86::EBX, 32));
+            exec(add);
+            nb += _assert(not ctx.is_lazy(X86::ECX), "CPU: non-flag register shouldn't be lazy");
+            nb += _assert(not ctx.is_lazy_reg(X86::EAX), "CPU: is_lazy_reg() failed");
+            nb += _assert(ctx.is_lazy_reg(X86::ZF), "CPU: is_lazy_reg() failed");
+
+            return nb;
+        }
+
         /* TODO, add this text when implementing IR Context
         unsigned int ir_context()
         {
@@ -97,6 +219,8 @@ void test_ir(){
     
     // Start testing 
     cout << bold << "[" << green << "+" << def << bold << "]" << def << std::left << std::setw(34) << " Testing ir module... " << std::flush;  
+    total += cpu_wide_registers();
+    total += cpu_lazy_flags();
     // TODO: total += ir_context();
     // total += block_map();
     // Return res
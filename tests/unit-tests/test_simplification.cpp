@@ -1,10 +1,12 @@
 #include "maat/expression.hpp"
 #include "maat/simplification.hpp"
 #include "maat/exception.hpp"
+#include "maat/stats.hpp"
 #include <iostream>
 #include <string>
 #include <sstream>
 #include <iomanip>
+#include <random>
 
 namespace test
 {
@@ -302,6 +304,136 @@ namespace test
             //nb += _assert_simplify(, , s);
             return nb; 
         }
+
+        Expr _random_expr(std::mt19937& gen, int depth)
+        {
+            // No divisions because constant folding would divide by zero
+            std::vector<Op> binops = {
+                Op::ADD, Op::MUL, Op::AND, Op::OR, Op::XOR,
+                Op::SHL, Op::SHR, Op::SAR
+            };
+            std::vector<cst_t> csts = {0, 1, -1, 2, 0xff, 0xffff0000, 31, 32};
+            if (depth == 0 or gen()%4 == 0)
+            {
+                if (gen()%2 == 0)
+                    return exprvar(32, std::string("rand") + std::to_string(gen()%3));
+                return exprcst(32, csts[gen()%csts.size()]);
+            }
+            switch (gen()%6)
+            {
+                case 0:
+                    return gen()%2 == 0 ? -_random_expr(gen, depth-1) : ~_random_expr(gen, depth-1);
+                case 1:
+                    return concat(
+                        extract(_random_expr(gen, depth-1), 31, 16),
+                        extract(_random_expr(gen, depth-1), 15, 0)
+                    );
+                case 2:
+                    return ITE(
+                        _random_expr(gen, depth-1), ITECond::EQ, _random_expr(gen, depth-1),
+                        _random_expr(gen, depth-1), _random_expr(gen, depth-1)
+                    );
+                default:
+                    return exprbinop(
+                        binops[gen()%binops.size()],
+                        _random_expr(gen, depth-1),
+                        _random_expr(gen, depth-1)
+                    );
+            }
+        }
+
+        unsigned int dispatch_patterns()
+        {
+            unsigned int nb = 0;
+            // Same functions as NewDefaultExprSimplifier() but without patterns, so
+            // that they are tried on every expression
+            ExprSimplifier all = ExprSimplifier();
+            all.add(es_constant_folding);
+            all.add(es_neutral_elements);
+            all.add(es_absorbing_elements);
+            all.add(es_arithmetic_properties);
+            all.add(es_involution);
+            all.add(es_extract_patterns);
+            all.add(es_basic_transform);
+            all.add(es_logical_properties);
+            all.add(es_concat_patterns);
+            all.add(es_arithmetic_factorize);
+            all.add(es_basic_ite);
+            all.add(es_ite_patterns);
+            all.add(es_generic_factorize);
+            std::shared_ptr<ExprSimplifier> dispatched = NewDefaultExprSimplifier();
+
+            // Expressions are generated twice because simplification modifies them
+            std::mt19937 gen1(1234), gen2(1234);
+            for (int i = 0; i < 500; i++)
+            {
+                Expr e1 = all.simplify(_random_expr(gen1, 4));
+                Expr e2 = dispatched->simplify(_random_expr(gen2, 4));
+                nb += _assert(e1->eq(e2), "Simplification with dispatch patterns gave a different result");
+            }
+            return nb;
+        }
+
+        unsigned int simplification_memo()
+        {
+            unsigned int nb = 0;
+            std::shared_ptr<ExprSimplifier> no_memo = NewDefaultExprSimplifier();
+            no_memo->set_memo(nullptr);
+            // Two simplifiers sharing the same small memo
+            std::shared_ptr<SimplificationMemo> memo = std::make_shared<SimplificationMemo>(100);
+            std::shared_ptr<ExprSimplifier> s1 = NewDefaultExprSimplifier();
+            std::shared_ptr<ExprSimplifier> s2 = NewDefaultExprSimplifier();
+            s1->set_memo(memo);
+            s2->set_memo(memo);
+            nb += _assert(memo->capacity() == 128, "SimplificationMemo: capacity not rounded to power of two");
+
+            MaatStats::instance().reset();
+            std::mt19937 gen1(42), gen2(42), gen3(42);
+            for (int i = 0; i < 300; i++)
+            {
+                Expr e1 = no_memo->simplify(_random_expr(gen1, 4));
+                Expr e2 = s1->simplify(_random_expr(gen2, 4));
+                Expr e3 = s2->simplify(_random_expr(gen3, 4));
+                nb += _assert(e1->eq(e2), "Simplification with memo gave a different result");
+                nb += _assert(e1->eq(e3), "Simplification with shared memo gave a different result");
+            }
+            // The second simplifier should reuse the results of the first one
+            nb += _assert(MaatStats::instance().simplify_memo_hits() > 0, "SimplificationMemo: no hits recorded");
+            nb += _assert(MaatStats::instance().simplify_memo_misses() > 0, "SimplificationMemo: no misses recorded");
+
+            // Tainted expressions must not be cached
+            Expr x = exprvar(32, "memo_x"), y = exprvar(32, "memo_y");
+            Expr tx = exprvar(32, "memo_x", Taint::TAINTED);
+            memo->clear();
+            s1->simplify((x + y) + exprcst(32, 0));
+            Expr res = s2->simplify((tx + y) + exprcst(32, 0));
+            nb += _assert(res->is_tainted(), "SimplificationMemo: tainted expression got untainted result");
+            res = s2->simplify((x + y) + exprcst(32, 0));
+            nb += _assert(not res->is_tainted(), "SimplificationMemo: untainted expression got tainted result");
+
+            // Distinct memory reads must not be matched
+            memo->clear();
+            s1->simplify(exprmem(32, x, 1) + y);
+            s1->simplify((x + y) + exprcst(32, 0));
+            MaatStats::instance().reset();
+            s2->simplify(exprmem(32, x, 1) + y);
+            nb += _assert(MaatStats::instance().simplify_memo_hits() == 0, "SimplificationMemo: matched distinct memory reads");
+            s2->simplify((x + y) + exprcst(32, 0));
+            nb += _assert(MaatStats::instance().simplify_memo_hits() == 1, "SimplificationMemo: identical expression not matched");
+
+            // Copies of a simplifier get their own memo
+            ExprSimplifier s3(*s1);
+            nb += _assert(s3.get_memo() != memo, "ExprSimplifier: copy shares memo");
+            nb += _assert(s3.get_memo()->capacity() == memo->capacity(), "ExprSimplifier: copy has a different memo capacity");
+            std::mt19937 gen4(43), gen5(43);
+            for (int i = 0; i < 100; i++)
+            {
+                Expr e1 = no_memo->simplify(_random_expr(gen4, 4));
+                Expr e2 = s3.simplify(_random_expr(gen5, 4));
+                nb += _assert(e1->eq(e2), "Simplification with copied simplifier gave a different result");
+            }
+            return nb;
+        }
     }
 }
 
@@ -347,6 +479,8 @@ void test_simplification(){
     total += basic_ite_condition(simp);
     total += ite_patterns(simp);
     total += advanced(simp);
+    total += dispatch_patterns();
+    total += simplification_memo();
 
     std::cout   << "\t" << total << "/" << total << green << "\t\tOK" 
                 << def << std::endl;
@@ -4,6 +4,7 @@
 #include "maat/snapshot.hpp"
 #include "maat/engine.hpp"
 #include "maat/exception.hpp"
+#include "maat/env/env_EVM.hpp"
 #include <iostream>
 #include <string>
 #include <sstream>
@@ -110,6 +111,238 @@ namespace test
         }
         
         
+        // Snapshot manager that lets tests take snapshots without an engine
+        class TestSnapshotManager: public SnapshotManager<Snapshot>
+        {
+        public:
+            using SnapshotManager<Snapshot>::emplace_back;
+        };
+
+        unsigned int dirty_mem()
+        {
+            std::shared_ptr<TestSnapshotManager> snapshots = std::make_shared<TestSnapshotManager>();
+            MemEngine mem(std::make_shared<VarContext>(), 32, snapshots);
+            unsigned int nb = 0;
+
+            mem.map(0x1000, 0x1fff);
+            Snapshot& snapshot = snapshots->emplace_back();
+
+            // Overwriting the same location saves it only once
+            for (int i = 0; i < 1000; i++)
+            {
+                mem.write(0x1100, i, 8);
+                mem.write(0x1108, exprcst(64, i));
+            }
+            nb += _assert(snapshot.dirty_mem_lines.size() == 1, "Snapshot: wrong number of dirty memory lines");
+            nb += _assert(snapshot.saved_mem.size() == Snapshot::saved_mem_line_size/8, "Snapshot: memory line saved more than once");
+
+            // Write crossing a line boundary
+            mem.write(0x113c, 0xdeadbeefcafebabe, 8);
+            nb += _assert(snapshot.dirty_mem_lines.size() == 2, "Snapshot: wrong number of dirty memory lines");
+            nb += _assert(snapshot.saved_mem.size() == 2*Snapshot::saved_mem_line_size/8, "Snapshot: wrong number of saved memory chunks");
+
+            // Lines partially mapped are saved only for mapped bytes
+            mem.new_segment(0x3000, 0x3003);
+            mem.write(0x3001, 0xaaaa, 2);
+            nb += _assert(snapshot.dirty_mem_lines.size() == 3, "Snapshot: wrong number of dirty memory lines");
+            nb += _assert(snapshot.saved_mem.back().addr == 0x3000 and snapshot.saved_mem.back().size == 4, "Snapshot: wrong saved memory chunk for partially mapped line");
+
+            return nb;
+        }
+
+        unsigned int restore_dirty_mem()
+        {
+            MaatEngine engine = MaatEngine(Arch::Type::NONE);
+            Expr e1 = exprvar(64, "var0");
+            unsigned int nb = 0;
+
+            engine.mem->map(0x1000, 0x1fff);
+            engine.mem->new_segment(0x3000, 0x3003);
+            engine.mem->write(0x1100, 0x1122334455667788, 8);
+            engine.mem->write(0x1108, e1);
+            engine.mem->write(0x3000, 0x12345678, 4);
+            engine.take_snapshot();
+
+            for (int i = 0; i < 1000; i++)
+            {
+                engine.mem->write(0x1100, i, 8);
+                engine.mem->write(0x1108, exprcst(64, i));
+            }
+            engine.mem->write(0x113c, 0xdeadbeefcafebabe, 8);
+            engine.mem->write(0x3001, 0xaaaa, 2);
+            engine.restore_last_snapshot();
+            nb += _assert(engine.mem->read(0x1100, 8).as_uint() == 0x1122334455667788, "Snapshot: failed to restore dirty memory");
+            nb += _assert(engine.mem->read(0x1108, 8).as_expr()->eq(e1), "Snapshot: failed to restore dirty memory");
+            nb += _assert(engine.mem->read(0x113c, 8).as_uint() == 0, "Snapshot: failed to restore dirty memory");
+            nb += _assert(engine.mem->read(0x3000, 4).as_uint() == 0x12345678, "Snapshot: failed to restore partially mapped memory line");
+
+            // Lines are saved again after restoring the snapshot
+            engine.mem->write(0x1100, 0x4141414141414141, 8);
+            engine.restore_last_snapshot(true);
+            nb += _assert(engine.mem->read(0x1100, 8).as_uint() == 0x1122334455667788, "Snapshot: failed to restore dirty memory");
+
+            return nb;
+        }
+
+        unsigned int shared_state()
+        {
+            MaatEngine engine = MaatEngine(Arch::Type::NONE);
+            unsigned int nb = 0;
+
+            engine.mem->map(0x1000, 0x1fff, mem_flag_rw, "map1");
+            engine.cpu.ctx().set(0, 0x1234);
+            engine.cpu.ctx().set(17, exprvar(32, "var0"));
+            engine.take_snapshot();
+
+            // Restoring the same snapshot several times
+            for (int i = 0; i < 2; i++)
+            {
+                engine.cpu.ctx().set(0, 0x42);
+                engine.cpu.ctx().set(17, 0x43);
+                engine.mem->map(0x3000, 0x3fff, mem_flag_rwx, "map2");
+                engine.mem->page_manager.set_flags(0x1000, 0x1fff, mem_flag_r);
+                engine.restore_last_snapshot();
+
+                nb += _assert(engine.cpu.ctx().get(0).as_uint() == 0x1234, "Snapshot: failed to restore shared register");
+                nb += _assert(engine.cpu.ctx().get(17).as_expr()->eq(exprvar(32, "var0")), "Snapshot: failed to restore shared register");
+                nb += _assert(engine.mem->page_manager.get_flags(0x1000) == mem_flag_rw, "Snapshot: failed to restore page permissions");
+                nb += _assert(engine.mem->page_manager.get_flags(0x3000) == mem_flag_none, "Snapshot: failed to restore page permissions");
+                nb += _assert(engine.mem->mappings.is_free(0x3000, 0x3fff), "Snapshot: failed to restore mappings");
+                nb += _assert(engine.mem->mappings.get_map_by_name("map1").start == 0x1000, "Snapshot: failed to restore mappings");
+            }
+
+            // Copies of the CPU don't share modifications
+            engine.cpu.ctx().set(1, 0x8);
+            ir::CPU cpu_copy = engine.cpu;
+            cpu_copy.ctx().set(0, 0x5678);
+            nb += _assert(engine.cpu.ctx().get(0).as_uint() == 0x1234, "CPU: copy shares register modifications");
+            engine.cpu.ctx().set(1, 0x9);
+            nb += _assert(cpu_copy.ctx().get(1).as_uint() == 0x8, "CPU: copy shares register modifications");
+
+            return nb;
+        }
+
+        unsigned int segment_growth()
+        {
+            MaatEngine engine = MaatEngine(Arch::Type::NONE);
+            unsigned int nb = 0;
+
+            engine.mem->map(0x10000, 0x10fff, mem_flag_rw, "Heap");
+            engine.mem->write(0x10000, 0x1122334455667788, 8);
+            engine.mem->write(0x10ff8, exprvar(64, "var0"));
+            size_t nb_segments = engine.mem->segments().size();
+            engine.take_snapshot();
+
+            // Extensions are undone when restoring the snapshot
+            for (int i = 0; i < 2; i++)
+            {
+                engine.mem->map(0x11000, 0x12fff, mem_flag_rw, "Heap");
+                engine.mem->map(0xf000, 0xffff, mem_flag_rw, "Heap");
+                nb += _assert(engine.mem->segments().size() == nb_segments, "Snapshot: segment wasn't extended");
+                engine.mem->write(0x12ff8, 0xdeadbeefcafebabe, 8);
+                engine.mem->write(0xf000, exprvar(64, "var1"));
+                engine.mem->write(0x10000, 0x4141414141414141, 8);
+                engine.mem->write(0x10ff8, 0x4242424242424242, 8);
+                engine.restore_last_snapshot();
+
+                std::shared_ptr<MemSegment> heap = engine.mem->get_segment_containing(0x10000);
+                nb += _assert(engine.mem->segments().size() == nb_segments, "Snapshot: failed to restore segments");
+                nb += _assert(heap->start == 0x10000 && heap->end == 0x10fff, "Snapshot: failed to restore segment bounds");
+                nb += _assert(engine.mem->get_segment_containing(0x11000) == nullptr, "Snapshot: failed to restore segment bounds");
+                nb += _assert(engine.mem->read(0x10000, 8).as_uint() == 0x1122334455667788, "Snapshot: failed to restore extended segment");
+                nb += _assert(engine.mem->read(0x10ff8, 8).as_expr()->eq(exprvar(64, "var0")), "Snapshot: failed to restore extended segment");
+            }
+
+            // Memory is cleared when extending the segment again
+            engine.mem->map(0x11000, 0x12fff, mem_flag_rw, "Heap");
+            engine.mem->map(0xf000, 0xffff, mem_flag_rw, "Heap");
+            nb += _assert(engine.mem->read(0x12ff8, 8).as_uint() == 0, "Snapshot: failed to clear extended memory");
+            nb += _assert(engine.mem->read(0xf000, 8).as_uint() == 0, "Snapshot: failed to clear extended memory");
+            engine.restore_last_snapshot();
+
+            // Segments created and then extended after the snapshot are deleted
+            engine.mem->map(0x20000, 0x20fff, mem_flag_rw, "Stack");
+            engine.mem->map(0x21000, 0x21fff, mem_flag_rw, "Stack");
+            engine.mem->write(0x21000, 0x1234, 2);
+            engine.restore_last_snapshot(true);
+            nb += _assert(engine.mem->segments().size() == nb_segments, "Snapshot: failed to delete created segment");
+            nb += _assert(engine.mem->get_segment_containing(0x20000) == nullptr, "Snapshot: failed to delete created segment");
+            nb += _assert(engine.mem->mappings.is_free(0x20000, 0x21fff), "Snapshot: failed to restore mappings");
+
+            return nb;
+        }
+
+        unsigned int ethereum_state()
+        {
+            using namespace maat::env::EVM;
+            unsigned int nb = 0;
+            EthereumEmulator eth;
+            Settings settings;
+            auto ctx = std::make_shared<VarContext>();
+            contract_t c1 = std::make_shared<Contract>();
+            c1->storage = std::make_shared<Storage>(ctx);
+            c1->memory = Memory(ctx);
+            int uid1 = eth.add_contract(c1);
+
+            c1->storage->write(Value(256, 1), Value(256, 0x11), settings);
+            c1->stack.push(Value(256, 1));
+            c1->stack.push(Value(256, 2));
+            c1->memory.write(Value(256, 0), Value(256, 0xaa));
+            env::EnvEmulator::snapshot_t s1 = eth.take_snapshot();
+
+            // Modify storage, stack, memory, balance, hashes and create
+            // contracts after the snapshot
+            c1->storage->write(Value(256, 1), Value(256, 0x22), settings);
+            c1->storage->write(Value(256, 2), Value(256, 0x33), settings);
+            c1->balance = Value(256, 1000);
+            c1->stack.pop(2);
+            c1->stack.push(Value(256, 3));
+            c1->memory.write(Value(256, 0), Value(256, 0xbb));
+            c1->memory.write(Value(256, 0x2000), Value(256, 0xcc));
+            Value hash = eth.keccak_helper.apply(*ctx, exprvar(256, "preimage"), nullptr);
+            int uid2 = eth.new_runtime_for_contract(uid1);
+            env::EnvEmulator::snapshot_t s2 = eth.take_snapshot();
+            c1->storage->write(Value(256, 2), Value(256, 0x44), settings);
+            c1->stack.set(Value(256, 4), 0);
+
+            eth.restore_snapshot(s2);
+            nb += _assert(c1->storage->read(Value(256, 2)).as_uint() == 0x33, "EVM snapshot: failed to restore storage");
+            nb += _assert(c1->stack.get(0).as_uint() == 3, "EVM snapshot: failed to restore stack");
+            nb += _assert(eth.get_contract_by_uid(uid2) != nullptr, "EVM snapshot: removed contract created before snapshot");
+
+            eth.restore_snapshot(s1, true);
+            nb += _assert(c1->storage->read(Value(256, 1)).as_uint() == 0x11, "EVM snapshot: failed to restore storage");
+            nb += _assert(c1->storage->read(Value(256, 2)).as_uint() == 0, "EVM snapshot: failed to restore storage");
+            nb += _assert(eth.get_contract_by_uid(uid1)->balance.as_uint() == 0, "EVM snapshot: failed to restore balance");
+            nb += _assert(eth.get_contract_by_uid(uid1) == c1, "EVM snapshot: restored contract isn't the same object");
+            nb += _assert(c1->stack.size() == 2, "EVM snapshot: failed to restore stack");
+            nb += _assert(c1->stack.get(0).as_uint() == 2, "EVM snapshot: failed to restore stack");
+            nb += _assert(c1->stack.get(1).as_uint() == 1, "EVM snapshot: failed to restore stack");
+            nb += _assert(c1->memory.size() == 32, "EVM snapshot: failed to restore memory size");
+            nb += _assert(c1->memory.read(Value(256, 0), 32).as_uint() == 0xaa, "EVM snapshot: failed to restore memory");
+            nb += _assert(c1->memory.read(Value(256, 0x2000), 32).as_uint() == 0, "EVM snapshot: failed to restore memory");
+            nb += _assert(
+                not eth.keccak_helper.get_preimage(hash.as_expr()->name()).has_value(),
+                "EVM snapshot: failed to restore keccak hashes"
+            );
+            try
+            {
+                eth.get_contract_by_uid(uid2);
+                nb += _assert(false, "EVM snapshot: didn't remove contract created after snapshot");
+            }
+            catch (const env_exception& e)
+            {
+                nb++;
+            }
+
+            // Writes without snapshots are not journaled
+            c1->storage->write(Value(256, 1), Value(256, 0x55), settings);
+            c1->stack.push(Value(256, 5));
+            nb += _assert(c1->storage->journal_mark() == 0, "EVM snapshot: journal not cleared");
+            nb += _assert(c1->stack.journal_mark() == 0, "EVM snapshot: journal not cleared");
+            return nb;
+        }
+
         unsigned int snapshot_X86()
         {
             unsigned int nb = 0;
@@ -256,6 +489,11 @@ void test_snapshots()
     maat::MaatConfig::instance().add_explicit_sleigh_dir(MAAT_SLEIGH_DIR);
 
     total += basic();
+    total += dirty_mem();
+    total += restore_dirty_mem();
+    total += shared_state();
+    total += segment_growth();
+    total += ethereum_state();
     total += snapshot_X86();
 
     std::cout   << "\t\t" << total << "/" << total << green << "\t\tOK" 
@@ -456,6 +456,76 @@ namespace test{
 
             return nb;
         }
+
+        unsigned int symptr_policies()
+        {
+            unsigned int nb = 0;
+            MaatEngine engine(Arch::Type::NONE);
+            engine.settings.symptr_refine_range = false;
+            engine.vars->set("var1", 0x1010);
+            Value concolic(exprvar(64, "var1") & 0xfff0),
+                  symbolic(exprvar(64, "var2") & 0xff00 | 0x10);
+            SymPtrPolicy::Result res;
+
+            // Default policy follows the settings
+            DefaultSymPtrPolicy def;
+            res = def.resolve(engine, concolic, false);
+            nb += _assert(res.action == SymPtrPolicy::Result::Action::SYMBOLIC, "DefaultSymPtrPolicy: wrong action");
+            nb += _assert(res.range.min == 0 and res.range.max == 0xfff0, "DefaultSymPtrPolicy: wrong range");
+            engine.settings.symptr_write = false;
+            res = def.resolve(engine, concolic, true);
+            nb += _assert(res.action == SymPtrPolicy::Result::Action::CONCRETE, "DefaultSymPtrPolicy: wrong action");
+            nb += _assert(res.addr == 0x1010, "DefaultSymPtrPolicy: wrong address");
+            res = def.resolve(engine, symbolic, true);
+            nb += _assert(res.action == SymPtrPolicy::Result::Action::ERROR, "DefaultSymPtrPolicy: wrong action");
+            engine.settings.symptr_write = true;
+
+            // Concretization adds a path constraint
+            ConcolicSymPtrPolicy conc;
+            res = conc.resolve(engine, concolic, false);
+            nb += _assert(res.action == SymPtrPolicy::Result::Action::CONCRETE, "ConcolicSymPtrPolicy: wrong action");
+            nb += _assert(res.addr == 0x1010, "ConcolicSymPtrPolicy: wrong address");
+            nb += _assert(engine.path->constraints().size() == 1, "ConcolicSymPtrPolicy: missing path constraint");
+            res = conc.resolve(engine, symbolic, false);
+            nb += _assert(res.action == SymPtrPolicy::Result::Action::CONCRETE, "ConcolicSymPtrPolicy: wrong action");
+            nb += _assert(res.addr == 0x10, "ConcolicSymPtrPolicy: wrong address");
+
+            MinSymPtrPolicy min;
+            res = min.resolve(engine, concolic, false);
+            nb += _assert(res.action == SymPtrPolicy::Result::Action::CONCRETE, "MinSymPtrPolicy: wrong action");
+            nb += _assert(res.addr == 0, "MinSymPtrPolicy: wrong address");
+
+            // Limited symbolic range, centered on the concolic value
+            SymbolicSymPtrPolicy sym(0x100);
+            res = sym.resolve(engine, concolic, false);
+            nb += _assert(res.action == SymPtrPolicy::Result::Action::SYMBOLIC, "SymbolicSymPtrPolicy: wrong action");
+            nb += _assert(res.range.min == 0xf90 and res.range.max == 0x1080, "SymbolicSymPtrPolicy: wrong range");
+            res = sym.resolve(engine, symbolic, false);
+            nb += _assert(res.range.min == 0x10 and res.range.max == 0x10, "SymbolicSymPtrPolicy: wrong range");
+            // Range clamped to the end of the value set stays aligned
+            engine.vars->set("var1", 0xffe0);
+            res = sym.resolve(engine, concolic, false);
+            nb += _assert(res.range.min == 0xff00 and res.range.max == 0xfff0, "SymbolicSymPtrPolicy: wrong range");
+            engine.vars->set("var1", 0x1010);
+
+            // Policy selection by address range
+            auto region_policy = std::make_shared<ConcolicSymPtrPolicy>();
+            nb += _assert(dynamic_cast<DefaultSymPtrPolicy*>(&engine.symptr_policies.get(concolic, *engine.vars)) != nullptr,
+                "SymPtrPolicies: wrong default policy");
+            engine.symptr_policies.add(0x1000, 0x1fff, region_policy);
+            nb += _assert(&engine.symptr_policies.get(concolic, *engine.vars) == region_policy.get(),
+                "SymPtrPolicies: wrong policy for concolic pointer");
+            nb += _assert(&engine.symptr_policies.get(symbolic, *engine.vars) != region_policy.get(),
+                "SymPtrPolicies: wrong policy for symbolic pointer");
+            engine.symptr_policies.add(0, 0xffff, region_policy);
+            nb += _assert(&engine.symptr_policies.get(symbolic, *engine.vars) == region_policy.get(),
+                "SymPtrPolicies: wrong policy for symbolic pointer");
+            engine.symptr_policies.clear();
+            nb += _assert(&engine.symptr_policies.get(concolic, *engine.vars) != region_policy.get(),
+                "SymPtrPolicies: clear() failed");
+
+            return nb;
+        }
     }
 }
 
@@ -478,6 +548,7 @@ void test_symbolic_memory(){
     total += basic_symbolic_write_big_endian();
     total += basic_symbolic_read();
     total += basic_symbolic_read_big_endian();
+    total += symptr_policies();
 #ifdef MAAT_HAS_SOLVER_BACKEND
     total += refine_value_set();
 #endif
@@ -0,0 +1,180 @@
+#include "maat/engine.hpp"
+#include "maat/trace.hpp"
+#include "maat/ir.hpp"
+#include "maat/exception.hpp"
+#include <algorithm>
+#include <filesystem>
+#include <fstream>
+
+namespace test
+{
+namespace trace
+{
+
+    using namespace maat;
+    using namespace maat::event;
+
+    unsigned int _assert(bool val, const std::string& msg)
+    {
+        if( !val)
+        {
+            std::cout << "\nFail: " << msg << std::endl;
+            throw test_exception();
+        }
+        return 1;
+    }
+
+#define ADD_ASM_INST(addr, pcode_inst) \
+asm_inst = ir::AsmInst(addr, 1); \
+asm_inst.add_inst(pcode_inst); \
+ir::get_ir_map(engine.mem->uid()).add(asm_inst);
+
+    void setup_code(MaatEngine& engine)
+    {
+        ir::AsmInst asm_inst;
+        ADD_ASM_INST(0x700, ir::Inst(ir::Op::LOAD, ir::Reg(2, 31, 0), ir::Param::None(), ir::Reg(0, 31, 0)))
+        ADD_ASM_INST(0x701, ir::Inst(ir::Op::STORE, ir::Param::None(), ir::Param::None(), ir::Reg(1, 31, 0), ir::Cst(42, 31, 0)))
+        ADD_ASM_INST(0x702, ir::Inst(ir::Op::CBRANCH, std::nullopt, ir::Addr(0x710, 32), ir::Reg(3, 31, 0)))
+        ADD_ASM_INST(0x703, ir::Inst(ir::Op::BRANCH, std::nullopt, ir::Addr(0x710, 32)))
+
+        engine.cpu.ctx().set(0, 0x60000);
+        engine.cpu.ctx().set(1, 0x61000);
+        engine.cpu.ctx().set(3, 0);
+        engine.hooks.add(Event::EXEC, When::BEFORE, "", AddrFilter(0x710));
+    }
+
+    unsigned int coverage(MaatEngine& engine)
+    {
+        unsigned int nb = 0;
+
+        engine.trace.enable_coverage(1 << 10);
+        nb += _assert(engine.trace.coverage_enabled(), "TraceRecorder: coverage not enabled");
+        nb += _assert(engine.trace.coverage_bitmap().size() == 1 << 10, "TraceRecorder: wrong bitmap size");
+        nb += _assert(engine.trace.nb_covered_edges() == 0, "TraceRecorder: bitmap not empty");
+        engine.run_from(0x700);
+        nb += _assert(engine.info.stop == info::Stop::HOOK, "TraceRecorder: failed to run code");
+        // Blocks starting at 0x700 and 0x703
+        nb += _assert(engine.trace.nb_covered_edges() == 2, "TraceRecorder: wrong number of covered edges");
+
+        engine.trace.reset_coverage();
+        nb += _assert(engine.trace.nb_covered_edges() == 0, "TraceRecorder: failed to reset coverage");
+
+        // Hit counts of hot edges saturate instead of wrapping to 0
+        for (int i = 0; i < 300; i++)
+        {
+            engine.trace.record_branch(true);
+            engine.trace.record_inst(0x800);
+        }
+        const std::vector<uint8_t>& bitmap = engine.trace.coverage_bitmap();
+        nb += _assert(engine.trace.nb_covered_edges() == 2, "TraceRecorder: hot edge not counted as covered");
+        nb += _assert(*std::max_element(bitmap.begin(), bitmap.end()) == 0xff, "TraceRecorder: hit count didn't saturate");
+        engine.trace.reset_coverage();
+
+        engine.trace.disable_coverage();
+        engine.run_from(0x700);
+        nb += _assert(engine.trace.nb_covered_edges() == 0, "TraceRecorder: coverage recorded while disabled");
+
+        nb += _assert(not engine.trace.is_enabled(), "TraceRecorder: recorder shouldn't be enabled");
+        try
+        {
+            engine.trace.enable_coverage(1000);
+            nb += _assert(false, "TraceRecorder: accepted bitmap size that is not a power of two");
+        }
+        catch(const runtime_exception& e){}
+
+        return nb;
+    }
+
+    unsigned int trace_ring(MaatEngine& engine)
+    {
+        unsigned int nb = 0;
+
+        engine.trace.enable_trace();
+        engine.run_from(0x700);
+        std::vector<TraceRecord> records = engine.trace.trace();
+        nb += _assert(records.size() == 4, "TraceRecorder: wrong number of records");
+        nb += _assert(records[0].pc == 0x700, "TraceRecorder: wrong record");
+        nb += _assert(records[0].flags == TraceRecord::MEM_READ, "TraceRecorder: wrong record");
+        nb += _assert(records[0].mem_addr == 0x60000, "TraceRecorder: wrong record");
+        nb += _assert(records[1].pc == 0x701, "TraceRecorder: wrong record");
+        nb += _assert(records[1].flags == TraceRecord::MEM_WRITE, "TraceRecorder: wrong record");
+        nb += _assert(records[1].mem_addr == 0x61000, "TraceRecorder: wrong record");
+        nb += _assert(records[2].pc == 0x702, "TraceRecorder: wrong record");
+        nb += _assert(records[2].flags == TraceRecord::BRANCH, "TraceRecorder: wrong record");
+        nb += _assert(records[3].pc == 0x703, "TraceRecorder: wrong record");
+        nb += _assert(records[3].flags == (TraceRecord::BRANCH | TraceRecord::BRANCH_TAKEN), "TraceRecorder: wrong record");
+
+        // Ring buffer keeps only the most recent records
+        engine.trace.enable_trace(3);
+        engine.run_from(0x700);
+        records = engine.trace.trace();
+        nb += _assert(engine.trace.nb_records() == 4, "TraceRecorder: wrong number of records");
+        nb += _assert(records.size() == 3, "TraceRecorder: wrong number of records");
+        nb += _assert(records[0].pc == 0x701, "TraceRecorder: wrong record");
+        nb += _assert(records[1].pc == 0x702, "TraceRecorder: wrong record");
+        nb += _assert(records[2].pc == 0x703, "TraceRecorder: wrong record");
+
+        engine.trace.clear_trace();
+        nb += _assert(engine.trace.trace().empty(), "TraceRecorder: failed to clear trace");
+        engine.trace.disable_trace();
+
+        return nb;
+    }
+
+    unsigned int trace_file(MaatEngine& engine)
+    {
+        unsigned int nb = 0;
+        std::filesystem::path filename = std::filesystem::temp_directory_path() / "maat_test_trace.bin";
+
+        engine.trace.enable_trace(0, filename.string());
+        engine.run_from(0x700);
+        engine.trace.disable_trace();
+
+        std::ifstream file(filename, std::ios::binary);
+        std::vector<uint8_t> contents(
+            (std::istreambuf_iterator<char>(file)),
+            std::istreambuf_iterator<char>()
+        );
+        nb += _assert(contents.size() == 4*TraceRecord::raw_size, "TraceRecorder: wrong trace file size");
+        uint8_t expected[TraceRecord::raw_size];
+        TraceRecord{0x701, 0x61000, TraceRecord::MEM_WRITE}.to_raw(expected);
+        nb += _assert(
+            std::equal(expected, expected+TraceRecord::raw_size, contents.begin() + TraceRecord::raw_size),
+            "TraceRecorder: wrong record in trace file"
+        );
+        nb += _assert(contents[TraceRecord::raw_size] == 0x01 and contents[TraceRecord::raw_size+1] == 0x07, "TraceRecorder: wrong record in trace file");
+        file.close();
+        std::filesystem::remove(filename);
+
+        return nb;
+    }
+
+} // namespace trace
+} // namespace test
+
+using namespace test::trace;
+
+// All unit tests
+void test_trace()
+{
+    maat::MaatEngine engine(maat::Arch::Type::NONE);
+    engine.mem->map(0x60000, 0x70000);
+    engine.mem->map(0x0, 0x2000);
+    setup_code(engine);
+
+    unsigned int total = 0;
+    std::string green = "\033[1;32m";
+    std::string def = "\033[0m";
+    std::string bold = "\033[1m";
+
+    std::cout   << bold << "[" << green << "+"
+                << def << bold << "]" << def
+                << " Testing trace recorder... " << std::flush;
+
+    total += coverage(engine);
+    total += trace_ring(engine);
+    total += trace_file(engine);
+
+    std::cout   << "\t" << total << "/" << total << green << "\t\tOK"
+                << def << std::endl;
+}